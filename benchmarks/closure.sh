@@ -0,0 +1,62 @@
+#!/usr/bin/env bash
+# Compares the tree and closure engines on given programs, by default on the examples and on
+# synthetic programs which make many calls (fib) and recurse DEPTH calls deep (2000 by default).
+# Options in OPTIONS are passed to both engines, e.g. OPTIONS="--memoize -O2".
+# Usage: [INTERPRETER=path] [TIMEOUT=seconds] [DEPTH=n] [OPTIONS=...] benchmarks/closure.sh [program.lil...]
+
+root="$(cd "$(dirname "$0")/.." && pwd)"
+interpreter="${INTERPRETER:-$root/bin/interpreter}"
+limit="${TIMEOUT:-10}"
+depth="${DEPTH:-2000}"
+read -r -a options <<< "${OPTIONS:-}"
+work="$(mktemp -d)"
+trap 'rm -rf "$work"' EXIT
+TIMEFORMAT=%R
+
+if [ "$#" -eq 0 ]; then
+  cat > "$work/fib.lil" << EOF
+fn fib(n: f32): f32 { ret if(n < 2, n, fib(n - 1) + fib(n - 2)); }
+
+fn main(): f32
+{
+  print("" : fib(22));
+  ret 0;
+}
+EOF
+  cat > "$work/depth.lil" << EOF
+fn depth(n: f32): f32 { ret if(n == 0, 0, 1 + depth(n - 1)); }
+
+fn main(): f32
+{
+  print("" : depth($depth));
+  ret 0;
+}
+EOF
+  set -- "$root"/examples/*.lil "$work/fib.lil" "$work/depth.lil"
+fi
+
+# Prints run time of the program with given engine, or timeout, whose output is not compared.
+measure()
+{
+  local seconds
+  seconds=$( { time timeout "$limit" "$interpreter" --engine="$1" "${options[@]}" "$2" > "$3" 2>&1; } 2>&1 )
+  if [ "$?" -eq 124 ]; then
+    rm -f "$3"
+    echo timeout
+  else
+    echo "${seconds}s"
+  fi
+}
+
+printf "%-32s %12s %12s\n" program tree closure
+for program in "$@"; do
+  name="$(basename "$program" .lil)"
+
+  tree=$(measure tree "$program" "$work/$name.tree")
+  closure=$(measure closure "$program" "$work/$name.closure")
+
+  if [ -f "$work/$name.tree" ] && [ -f "$work/$name.closure" ]; then
+    cmp -s "$work/$name.tree" "$work/$name.closure" || echo "$name: output differs" >&2
+  fi
+  printf "%-32s %12s %12s\n" "$name" "$tree" "$closure"
+done
@@ -0,0 +1,24 @@
+#!/usr/bin/env bash
+# Compares interpreted and ahead-of-time translated execution of given programs.
+# Usage: [INTERPRETER=path] [CXX=compiler] benchmarks/emit-cpp.sh program.lil...
+set -e
+
+root="$(cd "$(dirname "$0")/.." && pwd)"
+interpreter="${INTERPRETER:-$root/bin/interpreter}"
+cxx="${CXX:-c++}"
+work="$(mktemp -d)"
+trap 'rm -rf "$work"' EXIT
+TIMEFORMAT=%R
+
+printf "%-32s %12s %12s %12s\n" program interpreted translate+build translated
+for program in "$@"; do
+  name="$(basename "$program" .lil)"
+
+  interpreted=$( { time "$interpreter" "$program" > "$work/$name.expected"; } 2>&1 )
+  build=$( { time { "$interpreter" --emit-cpp="$work/$name.cpp" "$program" &&
+    "$cxx" -std=c++17 -O2 -I "$root/runtime" "$work/$name.cpp" -o "$work/$name"; }; } 2>&1 )
+  translated=$( { time "$work/$name" > "$work/$name.out" || true; } 2>&1 )
+
+  cmp -s "$work/$name.expected" "$work/$name.out" || echo "$name: output differs" >&2
+  printf "%-32s %11ss %11ss %11ss\n" "$name" "$interpreted" "$build" "$translated"
+done
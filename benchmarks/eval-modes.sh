@@ -0,0 +1,25 @@
+#!/usr/bin/env bash
+# Compares lazy and strict (--eval=strict) evaluation of given programs, examples by default.
+# Usage: [INTERPRETER=path] [TIMEOUT=seconds] benchmarks/eval-modes.sh [program.lil...]
+
+root="$(cd "$(dirname "$0")/.." && pwd)"
+interpreter="${INTERPRETER:-$root/bin/interpreter}"
+limit="${TIMEOUT:-10}"
+work="$(mktemp -d)"
+trap 'rm -rf "$work"' EXIT
+TIMEFORMAT=%R
+
+if [ "$#" -eq 0 ]; then
+  set -- "$root"/examples/*.lil
+fi
+
+printf "%-32s %12s %12s\n" program lazy strict
+for program in "$@"; do
+  name="$(basename "$program" .lil)"
+
+  lazy=$( { time timeout "$limit" "$interpreter" "$program" > "$work/$name.lazy" 2>&1; } 2>&1 )
+  strict=$( { time timeout "$limit" "$interpreter" --eval=strict "$program" > "$work/$name.strict" 2> /dev/null; } 2>&1 )
+
+  cmp -s "$work/$name.lazy" "$work/$name.strict" || echo "$name: output differs" >&2
+  printf "%-32s %11ss %11ss\n" "$name" "$lazy" "$strict"
+done
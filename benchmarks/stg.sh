@@ -0,0 +1,66 @@
+#!/usr/bin/env bash
+# Compares the stg engine with the tree and stack engines on given programs, by default on the
+# examples and on synthetic programs which make many calls (fib) and recurse DEPTH calls deep
+# (10000 by default), where the stg engine evaluates every argument once.
+# Options in OPTIONS are passed to all engines, e.g. OPTIONS="--memoize -O2".
+# Usage: [INTERPRETER=path] [TIMEOUT=seconds] [DEPTH=n] [OPTIONS=...] benchmarks/stg.sh [program.lil...]
+
+root="$(cd "$(dirname "$0")/.." && pwd)"
+interpreter="${INTERPRETER:-$root/bin/interpreter}"
+limit="${TIMEOUT:-10}"
+depth="${DEPTH:-10000}"
+read -r -a options <<< "${OPTIONS:-}"
+work="$(mktemp -d)"
+trap 'rm -rf "$work"' EXIT
+TIMEFORMAT=%R
+
+if [ "$#" -eq 0 ]; then
+  cat > "$work/fib.lil" << EOF
+fn fib(n: f32): f32 { ret if(n < 2, n, fib(n - 1) + fib(n - 2)); }
+
+fn main(): f32
+{
+  print("" : fib(22));
+  ret 0;
+}
+EOF
+  cat > "$work/depth.lil" << EOF
+fn depth(n: f32): f32 { ret if(n == 0, 0, 1 + depth(n - 1)); }
+
+fn main(): f32
+{
+  print("" : depth($depth));
+  ret 0;
+}
+EOF
+  set -- "$root"/examples/*.lil "$work/fib.lil" "$work/depth.lil"
+fi
+
+# Prints run time of the program with given engine, or timeout, whose output is not compared.
+measure()
+{
+  local seconds
+  seconds=$( { time timeout "$limit" "$interpreter" --engine="$1" "${options[@]}" "$2" > "$3" 2>&1; } 2>&1 )
+  if [ "$?" -eq 124 ]; then
+    rm -f "$3"
+    echo timeout
+  else
+    echo "${seconds}s"
+  fi
+}
+
+printf "%-32s %12s %12s %12s\n" program tree stack stg
+for program in "$@"; do
+  name="$(basename "$program" .lil)"
+
+  tree=$(measure tree "$program" "$work/$name.tree")
+  stack=$(measure stack "$program" "$work/$name.stack")
+  stg=$(measure stg "$program" "$work/$name.stg")
+
+  for engine in tree stack; do
+    if [ -f "$work/$name.$engine" ] && [ -f "$work/$name.stg" ]; then
+      cmp -s "$work/$name.$engine" "$work/$name.stg" || echo "$name: output of $engine and stg differs" >&2
+    fi
+  done
+  printf "%-32s %12s %12s %12s\n" "$name" "$tree" "$stack" "$stg"
+done
@@ -0,0 +1,86 @@
+#!/usr/bin/env bash
+# Measures tokenizer throughput on a source of at least SIZE megabytes (64 by default) made of copies of
+# given programs, examples by default, read from a stream, from a string and from a mapped file.
+# The tokenizer is built with a small driver from the sources of the repository.
+# Usage: [CXX=compiler] [CXXFLAGS=flags] [SIZE=MB] benchmarks/tokenizer.sh [program.lil...]
+set -e
+
+root="$(cd "$(dirname "$0")/.." && pwd)"
+cxx="${CXX:-c++}"
+read -r -a flags <<< "${CXXFLAGS:--O3}"
+size="${SIZE:-64}"
+work="$(mktemp -d)"
+trap 'rm -rf "$work"' EXIT
+TIMEFORMAT=%R
+
+if [ "$#" -eq 0 ]; then
+  set -- "$root"/examples/*.lil
+fi
+
+cat > "$work/driver.cpp" << 'EOF'
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "Tokenizer.hpp"
+
+std::size_t count(Tokenizer& tokenizer)
+{
+  std::size_t tokens = 0;
+  while(tokenizer.peek().type != TokenType::EOT)
+  {
+    tokenizer.nextToken();
+    tokens++;
+  }
+  return tokens;
+}
+
+int main(int argc, char* argv[])
+{
+  if(argc != 3)
+    return 1;
+
+  const std::string mode = argv[1];
+  if(mode == "file")
+  {
+    SourceFile file{argv[2]};
+    Tokenizer tokenizer{file.getText()};
+    std::cout << count(tokenizer) << "\n";
+    return 0;
+  }
+
+  std::ifstream input{argv[2]};
+  if(mode == "stream")
+  {
+    Tokenizer tokenizer{input};
+    std::cout << count(tokenizer) << "\n";
+    return 0;
+  }
+
+  std::stringstream buffer{};
+  buffer << input.rdbuf();
+  const auto text = buffer.str();
+  Tokenizer tokenizer{std::string_view{text}};
+  std::cout << count(tokenizer) << "\n";
+  return 0;
+}
+EOF
+"$cxx" -std=c++17 "${flags[@]}" -I "$root/include" "$work/driver.cpp" "$root/src/Stream.cpp" \
+  "$root/src/Tokenizer.cpp" -o "$work/driver"
+
+cat "$@" > "$work/source.lil"
+while [ "$(stat -c %s "$work/source.lil")" -lt $((size * 1024 * 1024)) ]; do
+  cat "$work/source.lil" "$work/source.lil" > "$work/next.lil"
+  mv "$work/next.lil" "$work/source.lil"
+done
+bytes="$(stat -c %s "$work/source.lil")"
+tokens="$("$work/driver" text "$work/source.lil")"
+echo "$((bytes / 1024 / 1024)) MB, $tokens tokens"
+
+# The string is read in full before tokenizing, like the stream, so both include reading the file.
+printf "%-32s %12s %12s\n" source time throughput
+for mode in stream text file; do
+  seconds=$( { time "$work/driver" "$mode" "$work/source.lil" > /dev/null; } 2>&1 )
+  printf "%-32s %11ss %7s MB/s\n" "$mode" "$seconds" "$(awk "BEGIN { printf \"%.1f\", $bytes / 1048576 / $seconds }")"
+done
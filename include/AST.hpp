@@ -1,10 +1,13 @@
 #pragma once
 
+#include <cstdint>
+#include <iterator>
 #include <list>
 #include <memory>
 #include <sstream>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "Token.hpp"
 #include "Visitor.hpp"
@@ -140,9 +143,20 @@ public:
 class CallNode : public ExpressionNode
 {
 public:
+  CallNode(): cachedCallee_(nullptr) {}
   virtual ~CallNode() = default;
 
   virtual const std::list<std::shared_ptr<ExpressionNode>>& getArguments() const = 0;
+
+  /*
+   * Monomorphic inline cache of calls through function values: body of the last
+   * function called here, whose arity matched the arguments. Bodies are owned by
+   * the same program, so the pointer never dangles while the node is alive.
+   */
+  const BlockNode* getCachedCallee() const { return cachedCallee_; }
+  void setCachedCallee(const BlockNode* body) const { cachedCallee_ = body; }
+private:
+  mutable const BlockNode* cachedCallee_;
 };
 
 class ProgramNode : public Node
@@ -236,6 +250,29 @@ private:
   std::unique_ptr<ExpressionNode> rightOperand_;
 };
 
+/*
+ * Binary operation on operands proven to be numbers. Derived node kinds fix the
+ * operator at compile time (see NumericNodes.hpp), so evaluation does not dispatch on it.
+ * Integer operations have operands proven to be integers, on which evaluating
+ * with int64 gives the same number (see IntegerRangeAnalyser).
+ */
+class NumericBinaryOpNode : public BinaryOpNode
+{
+public:
+  NumericBinaryOpNode(std::unique_ptr<ExpressionNode> leftOperand,
+    const BinaryOperator& op, std::unique_ptr<ExpressionNode> rightOperand, bool integer):
+      BinaryOpNode(std::move(leftOperand), op, std::move(rightOperand)), integer_(integer) {}
+
+  bool isInteger() const { return integer_; }
+
+  virtual double evaluate(double left, double right) const = 0;
+  virtual std::int64_t evaluateInteger(std::int64_t left, std::int64_t right) const = 0;
+
+  void accept(Visitor& visitor) const override { visitor.visit(*this); }
+private:
+  bool integer_;
+};
+
 class FunctionResultCallNode : public CallNode
 {
 public:
@@ -307,18 +344,21 @@ class VariableDeclarationNode : public StatementNode
 {
 public:
   VariableDeclarationNode(const std::string& name, 
-    const TypeName& type, std::unique_ptr<ExpressionNode> value):
-      name_(name), type_(type), value_(std::move(value)) {}
+    const TypeName& type, std::unique_ptr<ExpressionNode> value, bool shared = false):
+      name_(name), type_(type), value_(std::move(value)), shared_(shared) {}
 
   const std::string& getName() const { return name_; }
   const TypeName& getType() const { return type_; }
   const std::shared_ptr<ExpressionNode>& getValue() const { return value_; }
+  // Shared variables are evaluated at most once, their value is then reused by every read.
+  bool isShared() const { return shared_; }
 
   void accept(Visitor& visitor) const override { visitor.visit(*this); }
 private:
   std::string name_;
   TypeName type_;
   std::shared_ptr<ExpressionNode> value_;
+  bool shared_;
 };
 
 class AssignmentNode : public StatementNode
@@ -351,6 +391,45 @@ private:
   std::unique_ptr<ExpressionNode> value_;
 };
 
+/*
+ * Return of a self-recursive function whose only recursive call is a branch of
+ * if, recognized by LoopRecognizer. Parameters are loop variables: while the
+ * condition selects the call, they take the values of its arguments, otherwise
+ * the other branch is the result. Condition and arguments only combine the
+ * parameters and literals with operators and if. Visitors which do not know the
+ * node see the return it replaces.
+ */
+class LoopNode : public ReturnNode
+{
+public:
+  LoopNode(std::unique_ptr<FunctionCallNode> branch, std::vector<std::string> parameters, bool recursesWhenTrue):
+    ReturnNode(std::move(branch)), parameters_(std::move(parameters)), recursesWhenTrue_(recursesWhenTrue),
+      condition_(), result_(), call_()
+  {
+    const auto& args = static_cast<const FunctionCallNode&>(getValue()).getArguments();
+    condition_ = args.front().get();
+    const auto& whenTrue = **std::next(args.begin());
+    const auto& whenFalse = *args.back();
+    call_ = &static_cast<const FunctionCallNode&>(recursesWhenTrue ? whenTrue : whenFalse);
+    result_ = recursesWhenTrue ? &whenFalse : &whenTrue;
+  }
+
+  const std::vector<std::string>& getParameters() const { return parameters_; }
+  const ExpressionNode& getCondition() const { return *condition_; }
+  bool recursesWhenTrue() const { return recursesWhenTrue_; }
+  const ExpressionNode& getResult() const { return *result_; }
+  // New values of the parameters, in their order.
+  const std::list<std::shared_ptr<ExpressionNode>>& getArguments() const { return call_->getArguments(); }
+
+  void accept(Visitor& visitor) const override { visitor.visit(*this); }
+private:
+  std::vector<std::string> parameters_;
+  bool recursesWhenTrue_;
+  const ExpressionNode* condition_;
+  const ExpressionNode* result_;
+  const FunctionCallNode* call_;
+};
+
 class BlockNode : public StatementNode
 {
 public:
@@ -396,3 +475,13 @@ public:
 private:
   std::unique_ptr<ExpressionNode> functionCall_;
 };
+
+inline void Visitor::visit(const NumericBinaryOpNode& node)
+{
+  visit(static_cast<const BinaryOpNode&>(node));
+}
+
+inline void Visitor::visit(const LoopNode& node)
+{
+  visit(static_cast<const ReturnNode&>(node));
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <list>
+#include <memory>
+
+#include "AST.hpp"
+#include "Visitor.hpp"
+
+/*
+ * Creates deep copy of a tree. Transformation passes derive from it and override
+ * visits of the nodes they rewrite, everything else is copied as it is. Loops are
+ * copied without the overrides, as rewriting them could break their invariants.
+ */
+class ASTCloner : public Visitor
+{
+public:
+  virtual ~ASTCloner() = default;
+
+  template<typename T>
+  std::unique_ptr<T> clone(const T& node)
+  {
+    node.accept(*this);
+    return std::unique_ptr<T>(static_cast<T*>(result_.release()));
+  }
+
+  void visit(const AssignmentNode&) override;
+  void visit(const BinaryOpNode&) override;
+  void visit(const BlockNode&) override;
+  void visit(const FunctionCallNode&) override;
+  void visit(const FunctionCallStatementNode&) override;
+  void visit(const FunctionDeclarationNode&) override;
+  void visit(const FunctionResultCallNode&) override;
+  void visit(const LambdaCallNode&) override;
+  void visit(const LambdaNode&) override;
+  void visit(const NumericLiteralNode&) override;
+  void visit(const ProgramNode&) override;
+  void visit(const ReturnNode&) override;
+  void visit(const StringLiteralNode&) override;
+  void visit(const UnaryNode&) override;
+  void visit(const VariableDeclarationNode&) override;
+  void visit(const VariableNode&) override;
+  void visit(const NumericBinaryOpNode&) override;
+  void visit(const LoopNode&) override;
+
+protected:
+  std::list<std::shared_ptr<ExpressionNode>> cloneArguments(const std::list<std::shared_ptr<ExpressionNode>>& args);
+
+  template<typename T>
+  void setResult(std::unique_ptr<T> node, const Node& original)
+  {
+    node->setMark(original.getMark());
+    result_ = std::move(node);
+  }
+
+  std::unique_ptr<Node> result_;
+};
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "Visitor.hpp"
+
+/*
+ * Computes structural hash of a subtree. Hash depends only on the shape of the
+ * tree, names, operators and literal values, so it is stable between runs.
+ */
+class ASTHasher : public Visitor
+{
+public:
+  ASTHasher();
+
+  std::uint64_t getHash() const { return hash_; }
+
+  void visit(const AssignmentNode&) override;
+  void visit(const BinaryOpNode&) override;
+  void visit(const BlockNode&) override;
+  void visit(const FunctionCallNode&) override;
+  void visit(const FunctionCallStatementNode&) override;
+  void visit(const FunctionDeclarationNode&) override;
+  void visit(const FunctionResultCallNode&) override;
+  void visit(const LambdaCallNode&) override;
+  void visit(const LambdaNode&) override;
+  void visit(const NumericLiteralNode&) override;
+  void visit(const ProgramNode&) override;
+  void visit(const ReturnNode&) override;
+  void visit(const StringLiteralNode&) override;
+  void visit(const UnaryNode&) override;
+  void visit(const VariableDeclarationNode&) override;
+  void visit(const VariableNode&) override;
+
+  void add(std::uint64_t value);
+  void add(double value);
+  void add(const std::string& value);
+
+private:
+  std::uint64_t hash_;
+};
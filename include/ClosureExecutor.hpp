@@ -0,0 +1,112 @@
+#pragma once
+
+#include "Visitor.hpp"
+#include "Context.hpp"
+#include "Executor.hpp"
+#include "MemoTable.hpp"
+#include "JitCompiler.hpp"
+#include "Speculator.hpp"
+#include "Value.h"
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+/*
+ * Evaluates programs like Executor, but first compiles every node of the program
+ * into a closure, which has its operator, builtin and child closures bound, so
+ * evaluation does not dispatch on node kinds again. Variables remain lazy: their
+ * expressions are kept and run through their closures when forced.
+ * Visiting a node other than program compiles and evaluates it in the global scope.
+ */
+class ClosureExecutor : public Visitor
+{
+public:
+  ClosureExecutor(const ExecutorOptions& options = {});
+
+  ClosureExecutor(const ClosureExecutor&) = delete;
+
+  const std::unique_ptr<Value>& getValue() const { return value_; }
+  int getExitCode() const { return exitCode_; }
+  std::string getStandardOut() const { return stdout_; }
+  const std::shared_ptr<MemoTable>& getMemoTable() const { return memoTable_; }
+  const std::shared_ptr<JitCompiler>& getJit() const { return jit_; }
+  const std::shared_ptr<Speculator>& getSpeculator() const { return speculator_; }
+
+  std::size_t getCompiled() const { return code_.size(); }
+
+  void visit(const AssignmentNode& node) override { evaluate(node); }
+  void visit(const BinaryOpNode& node) override { evaluate(node); }
+  void visit(const BlockNode& node) override { evaluate(node); }
+  void visit(const FunctionCallNode& node) override { evaluate(node); }
+  void visit(const FunctionCallStatementNode& node) override { evaluate(node); }
+  void visit(const FunctionDeclarationNode& node) override { evaluate(node); }
+  void visit(const FunctionResultCallNode& node) override { evaluate(node); }
+  void visit(const LambdaCallNode& node) override { evaluate(node); }
+  void visit(const LambdaNode& node) override { evaluate(node); }
+  void visit(const NumericLiteralNode& node) override { evaluate(node); }
+  void visit(const ProgramNode&) override;
+  void visit(const ReturnNode& node) override { evaluate(node); }
+  void visit(const StringLiteralNode& node) override { evaluate(node); }
+  void visit(const UnaryNode& node) override { evaluate(node); }
+  void visit(const VariableDeclarationNode& node) override { evaluate(node); }
+  void visit(const VariableNode& node) override { evaluate(node); }
+  void visit(const NumericBinaryOpNode& node) override { evaluate(node); }
+
+  /*
+   * State of a single evaluation of a body or an expression, which Executor
+   * would keep in an executor: its context, where print writes and the value
+   * returned by the body.
+   */
+  struct Activation
+  {
+    Activation(Context& context, std::string& output): context(context), output(output), returned(false), result() {}
+
+    Context& context;
+    std::string& output;
+    bool returned;
+    std::unique_ptr<Value> result;
+  };
+
+  using Code = std::function<std::unique_ptr<Value>(Activation&)>;
+
+private:
+  friend class ClosureCompiler;
+
+  const Code& compile(const Node& node);
+  void evaluate(const Node& node);
+  std::unique_ptr<Value> run(const Node& node, Activation& activation);
+
+  std::unique_ptr<Value> readVariable(const VariableNode& node, Activation& activation);
+  std::unique_ptr<Value> force(const RuntimeVariableAnalyser& variable);
+  std::unique_ptr<Value> call(const FunctionCallNode& node, Activation& activation);
+  std::unique_ptr<Value> callFunction(const FunctionCallNode& node, const RuntimeFunctionAnalyser& function,
+    Activation& activation);
+  std::unique_ptr<Value> callMemoized(const FunctionCallNode& node, const RuntimeFunctionAnalyser& function,
+    Activation& activation);
+  std::vector<double> forceArguments(const FunctionCallNode& node, Context& context);
+  std::unique_ptr<Value> callValue(const CallNode& node, const std::string& name, const Value& value,
+    Activation& activation);
+  std::unique_ptr<Value> callBody(const BlockNode& body, Activation& activation);
+  void bindArguments(const CallNode& node, const std::list<std::pair<std::string, TypeName>>& parameters,
+    Context& context);
+  std::unique_ptr<RuntimeVariableSymbol> bindArgument(const std::pair<std::string, TypeName>& parameter,
+    const std::shared_ptr<ExpressionNode>& value, const Context& context, std::shared_ptr<const Context>& argContext);
+  void assign(const AssignmentNode& node, Activation& activation);
+
+  std::unordered_map<const Node*, Code> code_;
+  Context context_;
+  std::unique_ptr<Value> value_;
+  std::string stdout_;
+  // Output of evaluations which Executor runs in nested executors and drops.
+  std::string discarded_;
+  int exitCode_;
+  std::shared_ptr<MemoTable> memoTable_;
+  std::shared_ptr<JitCompiler> jit_;
+  std::shared_ptr<Speculator> speculator_;
+  std::unordered_set<std::string> reassigned_;
+  ForcedVariables forced_;
+};
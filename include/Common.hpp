@@ -2,6 +2,9 @@
 
 #include <string>
 
+#include "Mark.hpp"
+
 class Node;
 
 [[noreturn]] void reportError(const std::string& message, const Node& node);
+[[noreturn]] void reportError(const std::string& message, const Mark& mark);
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <list>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+
+#include "ASTCloner.hpp"
+#include "PurityAnalyser.hpp"
+
+/*
+ * Replaces repeated numeric subexpressions of function and lambda bodies with
+ * shared temporaries. Temporaries are lazy and evaluated at most once, so
+ * expressions which are never demanded are still never evaluated.
+ * Pass has to be run on the whole program after semantic analysis.
+ */
+class CommonSubexpressionEliminator : public ASTCloner
+{
+public:
+  CommonSubexpressionEliminator();
+
+  // Analysis of the program the pass runs on, so that the pass does not repeat it.
+  void setPurity(std::shared_ptr<const PurityAnalyser> purity) { analysis_ = std::move(purity); }
+
+  std::size_t getEliminated() const { return eliminated_; }
+
+  void visit(const FunctionDeclarationNode&) override;
+  void visit(const LambdaNode&) override;
+  void visit(const ProgramNode&) override;
+
+private:
+  using Statements = std::list<std::unique_ptr<StatementNode>>;
+  using Arguments = std::list<std::pair<std::string, TypeName>>;
+
+  std::unique_ptr<BlockNode> eliminate(const BlockNode& body, const Arguments& arguments);
+  bool eliminateOne(Statements& statements, const Arguments& arguments);
+
+  std::shared_ptr<const PurityAnalyser> analysis_;
+  std::shared_ptr<const PurityAnalyser> purity_;
+  std::set<std::string> functions_;
+  std::set<std::string> numericFunctions_;
+  std::size_t temporaries_;
+  std::size_t eliminated_;
+};
@@ -3,16 +3,25 @@
 #include <string>
 #include <memory>
 #include <unordered_map>
-#include <deque>
 #include <list>
 #include <optional>
 #include <functional>
+#include <set>
+#include <utility>
+#include <cstdint>
 
 #include "AST.hpp"
 
 class RuntimeSymbol;
 class RuntimeVariableSymbol;
 class RuntimeFunctionSymbol;
+class Value;
+
+// Holds value of shared variable once it has been forced.
+struct ValueCell
+{
+  std::unique_ptr<Value> value;
+};
 
 class RuntimeSymbolVisitor
 {
@@ -23,6 +32,13 @@ public:
   virtual void visit(RuntimeFunctionSymbol&) = 0;
 };
 
+/*
+ * Scopes form a persistent chain, each pointing to the one it was entered from, so
+ * copies and clones of a context share their scopes and cost the same at any depth.
+ * Scope shared with another context is copied before it is changed. Each scope also
+ * records which names are bound in it and in the scopes below, except the global one,
+ * so lookup of a global name does not walk the whole chain.
+ */
 class Context
 {
 public:
@@ -34,11 +50,23 @@ public:
   void leaveScope();
   void addSymbol(const std::string& name, std::shared_ptr<RuntimeSymbol> symbol);
   std::optional<std::reference_wrapper<RuntimeSymbol>> lookup(const std::string& name, int maxDepth = 0) const;
+  // Finds a symbol which is going to be changed, copying what other contexts share with this one.
+  std::optional<std::reference_wrapper<RuntimeSymbol>> lookupForUpdate(const std::string& name);
 
 private:
-  std::deque<std::unordered_map<std::string, std::shared_ptr<RuntimeSymbol>>> scopes_;
+  struct Scope;
+
+  std::shared_ptr<Scope> scope_;
+  Scope* global_;
 };
 
+/*
+ * Variables whose values are being computed, identified by their expression and
+ * captured context, which clones and aliases of a variable share. Variable forced
+ * again before its value is known depends on itself.
+ */
+using ForcedVariables = std::set<std::pair<const ExpressionNode*, const Context*>>;
+
 class RuntimeVariableAnalyser: public RuntimeSymbolVisitor
 {
 public:
@@ -48,6 +76,8 @@ public:
   std::optional<TypeName> getType() const { return type_; }
   const std::shared_ptr<ExpressionNode>& getValue() const { return value_; }
   const Context& getContext() const { return context_->get(); }
+  const std::shared_ptr<ValueCell>& getCell() const { return cell_; }
+  const Mark& getMark() const { return mark_; }
 
   void visit(RuntimeVariableSymbol&) override;
   void visit(RuntimeFunctionSymbol&) override;
@@ -55,7 +85,35 @@ private:
   bool symbolValid_;
   std::optional<TypeName> type_;
   std::shared_ptr<ExpressionNode> value_;
+  Mark mark_;
   std::optional<std::reference_wrapper<const Context>> context_;
+  std::shared_ptr<ValueCell> cell_;
+};
+
+/*
+ * Keeps a variable in ForcedVariables while its value is computed and removes it
+ * when destroyed, also when the computation fails. Variable which is already there
+ * depends on itself, it is reported at its binding.
+ */
+class ForcedVariableGuard
+{
+public:
+  ForcedVariableGuard(): forced_(nullptr), key_() {}
+  ForcedVariableGuard(ForcedVariables& forced, const RuntimeVariableAnalyser& variable);
+  ForcedVariableGuard(ForcedVariableGuard&& other) noexcept: forced_(other.forced_), key_(other.key_)
+  {
+    other.forced_ = nullptr;
+  }
+  ~ForcedVariableGuard() { release(); }
+
+  ForcedVariableGuard(const ForcedVariableGuard&) = delete;
+  ForcedVariableGuard& operator=(const ForcedVariableGuard&) = delete;
+  ForcedVariableGuard& operator=(ForcedVariableGuard&& other) noexcept;
+
+  void release();
+private:
+  ForcedVariables* forced_;
+  ForcedVariables::value_type key_;
 };
 
 class RuntimeFunctionAnalyser: public RuntimeSymbolVisitor
@@ -79,15 +137,49 @@ private:
   std::shared_ptr<BlockNode> body_;
 };
 
+// Binds another name to the expression, context and cell of a variable, functions are not aliased.
+class VariableAliaser : public RuntimeSymbolVisitor
+{
+public:
+  VariableAliaser(const std::string& name, const TypeName& type): name_(name), type_(type), alias_() {}
+
+  std::unique_ptr<RuntimeVariableSymbol>& getAlias() { return alias_; }
+
+  void visit(RuntimeVariableSymbol&) override;
+  void visit(RuntimeFunctionSymbol&) override {}
+private:
+  const std::string& name_;
+  TypeName type_;
+  std::unique_ptr<RuntimeVariableSymbol> alias_;
+};
+
+/*
+ * Replaces expression of a variable. Variable gets a new cell, so that the value is
+ * computed once, when the variable is next forced, instead of on every read. Captured
+ * context never changes, so every read would compute the same value.
+ */
 class ValueChanger : public RuntimeSymbolVisitor
 {
 public:
-  ValueChanger(std::shared_ptr<ExpressionNode> value): value_(std::move(value)) {}
+  ValueChanger(std::shared_ptr<ExpressionNode> value, const Mark& mark): value_(std::move(value)), mark_(mark) {}
 
   void visit(RuntimeVariableSymbol&) override;
   void visit(RuntimeFunctionSymbol&) override;
 private:
   std::shared_ptr<ExpressionNode> value_;
+  Mark mark_;
+};
+
+// Sets variable to result of compound assignment, see RuntimeVariableSymbol::setNumber.
+class NumberChanger : public RuntimeSymbolVisitor
+{
+public:
+  NumberChanger(double value): value_(value) {}
+
+  void visit(RuntimeVariableSymbol&) override;
+  void visit(RuntimeFunctionSymbol&) override {}
+private:
+  double value_;
 };
 
 class RuntimeSymbol
@@ -103,24 +195,46 @@ class RuntimeVariableSymbol : public RuntimeSymbol
 {
 public:
   RuntimeVariableSymbol(const std::string& name, const TypeName& type,
-          std::shared_ptr<ExpressionNode> value, const Context& context):
-    name_(name), type_(type), value_(std::move(value)), context_(context)
+          std::shared_ptr<ExpressionNode> value, const Context& context, 
+          std::shared_ptr<ValueCell> cell = nullptr):
+    name_(name), type_(type), value_(std::move(value)), mark_(value_->getMark()),
+    context_(std::make_shared<const Context>(context)), cell_(std::move(cell))
+  {}
+  // Captured context is never modified, so it can be shared by clones of the symbol.
+  RuntimeVariableSymbol(const std::string& name, const TypeName& type,
+          std::shared_ptr<ExpressionNode> value, std::shared_ptr<const Context> context, 
+          std::shared_ptr<ValueCell> cell):
+    name_(name), type_(type), value_(std::move(value)), mark_(value_->getMark()), context_(std::move(context)),
+    cell_(std::move(cell))
   {}
 
   const std::string& getName() const { return name_; }
   const TypeName& getType() const { return type_; }
   const std::shared_ptr<ExpressionNode>& getValue() const { return value_; }
-  const Context& getContext() const { return context_; }
+  const Context& getContext() const { return *context_; }
+  const std::shared_ptr<ValueCell>& getCell() const { return cell_; }
+  // Where the variable was bound, which is the expression itself unless set otherwise.
+  const Mark& getMark() const { return mark_; }
+  void setMark(const Mark& mark) { mark_ = mark; }
 
-  void setValue(std::shared_ptr<ExpressionNode> value) { value_ = std::move(value); }
+  void setValue(std::shared_ptr<ExpressionNode> value, const Mark& mark, std::shared_ptr<ValueCell> cell)
+  { 
+    value_ = std::move(value); 
+    mark_ = mark;
+    cell_ = std::move(cell);
+  }
+  void setNumber(double value);
 
   std::shared_ptr<RuntimeSymbol> clone(const Context& context) const override;
+  std::unique_ptr<RuntimeVariableSymbol> alias(const std::string& name, const TypeName& type) const;
   void accept(RuntimeSymbolVisitor& visitor) override { visitor.visit(*this); };
 private:
   std::string name_;
   TypeName type_;
   std::shared_ptr<ExpressionNode> value_;
-  Context context_;
+  Mark mark_;
+  std::shared_ptr<const Context> context_;
+  std::shared_ptr<ValueCell> cell_;
 };
 
 class RuntimeFunctionSymbol : public RuntimeSymbol
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "Visitor.hpp"
+#include "AST.hpp"
+
+#include <list>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/*
+ * Translates program into C++ source, which evaluates it with the runtime of
+ * runtime/lil_runtime.hpp. Bodies and expressions evaluated lazily (values of
+ * variables and assignments, arguments of calls) become functions of their own,
+ * other expressions are translated into statements of the enclosing function,
+ * which evaluate operands in the same order as Executor.
+ */
+class CppEmitter : public Visitor
+{
+public:
+  CppEmitter();
+
+  std::string getSource() const;
+  std::size_t getFunctions() const { return counter_; }
+
+  void visit(const AssignmentNode&) override;
+  void visit(const BinaryOpNode&) override;
+  void visit(const BlockNode&) override;
+  void visit(const FunctionCallNode&) override;
+  void visit(const FunctionCallStatementNode&) override;
+  void visit(const FunctionDeclarationNode&) override;
+  void visit(const FunctionResultCallNode&) override;
+  void visit(const LambdaCallNode&) override;
+  void visit(const LambdaNode&) override;
+  void visit(const NumericLiteralNode&) override;
+  void visit(const ProgramNode&) override;
+  void visit(const ReturnNode&) override;
+  void visit(const StringLiteralNode&) override;
+  void visit(const UnaryNode&) override;
+  void visit(const VariableDeclarationNode&) override;
+  void visit(const VariableNode&) override;
+
+private:
+  // Function being emitted; lazily evaluated expressions found in it are emitted in the meantime.
+  struct Function
+  {
+    Function(): body(), temporaries(0), indent("  ") {}
+
+    std::stringstream body;
+    std::size_t temporaries;
+    std::string indent;
+  };
+
+  std::string emitCode(const ExpressionNode& node);
+  std::string emitBody(const BlockNode& node);
+  std::string emitParameters(const std::list<std::pair<std::string, TypeName>>& parameters);
+  std::string emitArguments(const std::list<std::shared_ptr<ExpressionNode>>& arguments);
+  std::string emitExpression(const ExpressionNode& node);
+
+  std::string temporary();
+  std::ostream& line();
+  const std::string& name(const std::string& identifier);
+
+  std::stringstream declarations_;
+  std::stringstream definitions_;
+  std::vector<Function> functions_;
+  std::unordered_map<const Node*, std::string> emitted_;
+  std::unordered_map<std::string, std::string> names_;
+  std::vector<std::string> nameList_;
+  std::string main_;
+  std::string result_;
+  std::size_t counter_;
+};
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <set>
+#include <string>
+
+#include "ASTCloner.hpp"
+
+/*
+ * Removes functions unreachable from main and from global variables, variables
+ * which are never referenced and statements following return. Variables are
+ * evaluated lazily, so dropping one that is not read never skips any effect.
+ */
+class DeadCodeEliminator : public ASTCloner
+{
+public:
+  DeadCodeEliminator();
+
+  std::size_t getRemovedFunctions() const { return removedFunctions_; }
+  std::size_t getRemovedVariables() const { return removedVariables_; }
+  std::size_t getRemovedStatements() const { return removedStatements_; }
+
+  void visit(const BlockNode&) override;
+  void visit(const ProgramNode&) override;
+
+private:
+  // Names which functions may resolve in the caller's scope.
+  std::set<std::string> globalNames_;
+  std::size_t removedFunctions_;
+  std::size_t removedVariables_;
+  std::size_t removedStatements_;
+};
@@ -2,23 +2,72 @@
 
 #include "Visitor.hpp"
 #include "Context.hpp"
+#include "MemoTable.hpp"
+#include "JitCompiler.hpp"
+#include "Profile.hpp"
+#include "Speculator.hpp"
 #include "Value.h"
 
+#include <cstdint>
 #include <string>
 #include <stack>
+#include <unordered_set>
 #include <sstream>
 
+struct ExecutorOptions
+{
+  ExecutorOptions(): memoize(false), memoCapacity(1024), stackLimit(256), jit(false), speculate(false),
+    speculationBudget(32), strict(false), profile(), feedback() {}
+
+  bool memoize;
+  std::size_t memoCapacity;
+  // Memory available to the evaluation stack of StackExecutor, in MiB.
+  std::size_t stackLimit;
+  // Compile numeric functions to native code, calls which are not memoized run it.
+  bool jit;
+  // Evaluate cheap variable and argument expressions when they are bound, instead of when forced.
+  bool speculate;
+  // Steps a single speculative evaluation may take before it is abandoned.
+  std::size_t speculationBudget;
+  /*
+   * Evaluate variables and arguments of Executor when they are bound (call by value),
+   * see StrictModeChecker for programs whose behaviour this may change.
+   */
+  bool strict;
+  // Profile which Executor records execution of the program into.
+  std::shared_ptr<Profile> profile;
+  // Profile of previous runs, which guides the JIT and speculation.
+  std::shared_ptr<Profile> feedback;
+};
+
+/*
+ * Binds literal argument without a context, or variable argument to the binding
+ * of the variable in given context, so neither needs a thunk. Returns null for
+ * other arguments and for names of functions.
+ */
+std::unique_ptr<RuntimeVariableSymbol> bindDirectly(const std::pair<std::string, TypeName>& parameter,
+  const std::shared_ptr<ExpressionNode>& value, const Context& context);
+
 class Executor : public Visitor
 {
 public:
-  Executor(): value_(), context_(), returnStack_(), stdout_(), exitCode_(0) {}
-  Executor(const Context& context): value_(), context_(context), returnStack_(), stdout_(), exitCode_(0) {}
+  Executor(): value_(), context_(), returnStack_(), returned_(false), stdout_(), exitCode_(0), memoTable_(), jit_(),
+    speculator_(), strict_(false), reassigned_(), discarding_(false), profile_(),
+    forced_(std::make_shared<ForcedVariables>()) {}
+  Executor(const Context& context): value_(), context_(context), returnStack_(), returned_(false), stdout_(), exitCode_(0), memoTable_(), jit_(),
+    speculator_(), strict_(false), reassigned_(), discarding_(false), profile_(),
+    forced_(std::make_shared<ForcedVariables>()) {}
+  Executor(const ExecutorOptions& options);
 
   Executor(const Executor&) = delete;
 
   const std::unique_ptr<Value>& getValue() const { return value_; }
   int getExitCode() const { return exitCode_; }
   std::string getStandardOut() const { return stdout_.str(); }
+  const std::shared_ptr<MemoTable>& getMemoTable() const { return memoTable_; }
+  const std::shared_ptr<JitCompiler>& getJit() const { return jit_; }
+  const std::shared_ptr<Speculator>& getSpeculator() const { return speculator_; }
+  const std::shared_ptr<Profile>& getProfile() const { return profile_; }
 
   void visit(const AssignmentNode&) override;
   void visit(const BinaryOpNode&) override;
@@ -36,19 +85,44 @@ public:
   void visit(const UnaryNode&) override;
   void visit(const VariableDeclarationNode&) override;
   void visit(const VariableNode&) override;
+  void visit(const NumericBinaryOpNode&) override;
+  void visit(const LoopNode&) override;
 
 private:
+  // Creates executor evaluating in given context, which shares runtime state with parent.
+  Executor(const Context& context, const Executor& parent);
+
+  std::int64_t evaluateInteger(const NumericBinaryOpNode&);
+  std::int64_t evaluateIntegerOperand(const ExpressionNode&, const NumericBinaryOpNode&);
   void handlePrint(const FunctionCallNode&);
   void handleIf(const FunctionCallNode&);
+  std::unique_ptr<Value> force(const RuntimeVariableAnalyser&);
   void handleVariableCall(const FunctionCallNode&, const RuntimeVariableAnalyser&);
   void handleFunctionCall(const FunctionCallNode&, const RuntimeFunctionAnalyser&);
+  void handleMemoizedCall(const FunctionCallNode&, const RuntimeFunctionAnalyser&);
+  std::vector<double> forceArguments(const FunctionCallNode&);
+  std::vector<std::unique_ptr<RuntimeVariableSymbol>> bindArguments(const CallNode&,
+    const RuntimeFunctionAnalyser::ArgumentsList&);
+  std::unique_ptr<RuntimeVariableSymbol> bindArgument(const std::pair<std::string, TypeName>&,
+    const std::shared_ptr<ExpressionNode>&, const Context&, std::shared_ptr<const Context>&);
+  std::unique_ptr<RuntimeVariableSymbol> bindValue(const std::string&, const TypeName&,
+    const std::shared_ptr<ExpressionNode>&, const Context&, std::shared_ptr<ValueCell>);
   void callValue(const CallNode& node, const std::string& name, const Value& value);
 
-  void assertValueType(const Value& value, const TypeName& type, const std::string& activity, const Node& node) const;
-
   std::unique_ptr<Value> value_;
   Context context_;
   std::stack<std::unique_ptr<Value>> returnStack_;
+  // Set by return statement until the enclosing block stops executing.
+  bool returned_;
   std::ostringstream stdout_;
   int exitCode_;
+  std::shared_ptr<MemoTable> memoTable_;
+  std::shared_ptr<JitCompiler> jit_;
+  std::shared_ptr<Speculator> speculator_;
+  bool strict_;
+  std::shared_ptr<const std::unordered_set<std::string>> reassigned_;
+  // Set while evaluating strict bindings, whose output is dropped like output of forced variables.
+  bool discarding_;
+  std::shared_ptr<Profile> profile_;
+  std::shared_ptr<ForcedVariables> forced_;
 };
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+
+#include "ASTCloner.hpp"
+#include "Profile.hpp"
+#include "PurityAnalyser.hpp"
+
+/*
+ * Profile-guided inliner. Direct calls of top-level functions which ran at least
+ * threshold times are replaced by the body of the function, if it only returns a
+ * small expression without calls (except if) and lambdas, and if the arguments do
+ * not call anything either. Parameters are substituted by the arguments, which
+ * the interpreter would evaluate in the caller's scope on every read anyway, and
+ * names the body reads are looked up in the caller's scope in both cases.
+ * Pass has to be run on the whole program after semantic analysis.
+ */
+class Inliner : public ASTCloner
+{
+public:
+  Inliner(std::shared_ptr<Profile> profile, std::uint64_t threshold = 16);
+
+  // Analysis of the program the pass runs on, so that the pass does not repeat it.
+  void setPurity(std::shared_ptr<const PurityAnalyser> purity) { analysis_ = std::move(purity); }
+
+  std::size_t getInlined() const { return inlined_; }
+
+  void visit(const FunctionCallNode&) override;
+  void visit(const ProgramNode&) override;
+  void visit(const VariableNode&) override;
+
+private:
+  struct Inlinable
+  {
+    const FunctionDeclarationNode* function;
+    const ExpressionNode* result;
+  };
+
+  std::shared_ptr<Profile> profile_;
+  std::uint64_t threshold_;
+  std::shared_ptr<const PurityAnalyser> analysis_;
+  std::shared_ptr<const PurityAnalyser> purity_;
+  std::map<std::string, Inlinable> inlinable_;
+  // Arguments substituted for parameters while the body of a function is inlined.
+  std::map<std::string, const ExpressionNode*> arguments_;
+  std::size_t inlined_;
+};
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+
+#include "AST.hpp"
+
+// Closed interval of integers.
+struct IntegerRange
+{
+  std::int64_t min;
+  std::int64_t max;
+};
+
+/*
+ * Proves that expressions evaluate to integers in a range, which numbers represent
+ * exactly and never as negative zero. Ranges come from literals and from operators
+ * whose results are integers regardless of operands (bitwise operations, shifts,
+ * comparisons, logical operations), which then bound arithmetic on them. Names are
+ * never assumed to keep a range, since dynamic scoping may rebind them. A binary
+ * operation is exact when evaluating it with int64 on such operands gives the same
+ * number as evaluating it on doubles, including the casts to unsigned int.
+ */
+class IntegerRangeAnalyser
+{
+public:
+  IntegerRangeAnalyser();
+
+  std::optional<IntegerRange> getRange(const ExpressionNode& node);
+  bool isExact(const BinaryOpNode& node);
+
+private:
+  std::unordered_map<const ExpressionNode*, std::optional<IntegerRange>> ranges_;
+};
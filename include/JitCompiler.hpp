@@ -0,0 +1,47 @@
+#pragma once
+
+#include "AST.hpp"
+#include "Profile.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <unordered_map>
+
+/*
+ * Baseline compiler of numeric functions into x86-64 machine code. A function is
+ * compiled when it is memoizable (pure, numeric and strict in all arguments, see
+ * PurityAnalyser), so its arguments can be evaluated before the call, and its body
+ * returns an expression built only of its parameters, literals, arithmetic,
+ * comparisons, logical operations, if and calls of other compiled functions.
+ * Every node is translated by a fixed template, intermediate values are kept in
+ * slots of the native frame. Other functions are left to the interpreter.
+ * Code is generated only on Linux x86-64, elsewhere nothing is compiled.
+ * Branches of if are laid out by their frequency in the profile, if given one.
+ */
+class JitCompiler
+{
+public:
+  // Arguments are passed as an array of numbers, in order of parameters.
+  using NativeFunction = double (*)(const double* arguments);
+
+  JitCompiler(std::shared_ptr<Profile> feedback = nullptr);
+  ~JitCompiler();
+
+  JitCompiler(const JitCompiler&) = delete;
+  JitCompiler& operator=(const JitCompiler&) = delete;
+
+  static bool isSupported();
+
+  void compile(const ProgramNode& program);
+  // Native code of function with given body, or nullptr when it was not compiled.
+  NativeFunction lookup(const BlockNode* body) const;
+
+  std::size_t getCompiled() const { return functions_.size(); }
+  std::size_t getCodeSize() const { return size_; }
+
+private:
+  std::unordered_map<const BlockNode*, NativeFunction> functions_;
+  std::shared_ptr<Profile> feedback_;
+  void* code_;
+  std::size_t size_;
+};
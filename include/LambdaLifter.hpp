@@ -0,0 +1,48 @@
+#pragma once
+
+#include <list>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+
+#include "ASTCloner.hpp"
+#include "PurityAnalyser.hpp"
+
+/*
+ * Turns lambdas bound to local variables, which are only ever called directly, into
+ * top-level functions taking free variables of the lambda as additional arguments.
+ * Calls through such variables become direct calls and no closure is created for them.
+ * Lambdas that escape (are passed, returned or captured) are left untouched.
+ * Pass has to be run on the whole program after semantic analysis.
+ */
+class LambdaLifter : public ASTCloner
+{
+public:
+  LambdaLifter();
+
+  // Analysis of the program the pass runs on, so that the pass does not repeat it.
+  void setPurity(std::shared_ptr<const PurityAnalyser> purity) { analysis_ = std::move(purity); }
+
+  std::size_t getLifted() const { return lifted_; }
+
+  void visit(const FunctionDeclarationNode&) override;
+  void visit(const ProgramNode&) override;
+
+private:
+  struct LiftedLambda
+  {
+    std::string name;
+    std::list<std::pair<std::string, TypeName>> freeVariables;
+  };
+
+  using Arguments = std::list<std::pair<std::string, TypeName>>;
+
+  std::unique_ptr<BlockNode> lift(const BlockNode& body, const Arguments& arguments);
+
+  std::shared_ptr<const PurityAnalyser> analysis_;
+  std::shared_ptr<const PurityAnalyser> purity_;
+  std::set<std::string> functions_;
+  std::list<std::unique_ptr<FunctionDeclarationNode>> liftedFunctions_;
+  std::size_t lifted_;
+};
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <vector>
+
+#include "AST.hpp"
+#include "Context.hpp"
+#include "Visitor.hpp"
+
+/*
+ * Runs a loop (see LoopNode) on numbers, for every engine. Parameters are read
+ * from the engine when the loop first needs them: run returns the variable whose
+ * value is missing, the engine forces it, passes its value to setValue and runs
+ * the loop again, which only repeats evaluation of the condition and arguments.
+ * Once run returns null, the condition selected the result. After the first
+ * iteration all parameters are known and their values are updated in place, so
+ * no scope or thunk is created per iteration.
+ */
+class LoopEvaluator : public Visitor
+{
+public:
+  LoopEvaluator(const LoopNode& loop);
+
+  const VariableNode* run();
+  // Value of the variable returned by run.
+  void setValue(double value);
+
+  // Result of a loop which iterated reads the final values of the parameters.
+  bool hasIterated() const { return iterated_; }
+  const std::vector<double>& getValues() const { return values_; }
+  // Binds parameters to their final values in the current scope of the context.
+  void bindParameters(Context& context) const;
+
+  void visit(const AssignmentNode&) override {}
+  void visit(const BinaryOpNode& node) override;
+  void visit(const BlockNode&) override {}
+  void visit(const FunctionCallNode& node) override;
+  void visit(const FunctionCallStatementNode&) override {}
+  void visit(const FunctionDeclarationNode&) override {}
+  void visit(const FunctionResultCallNode&) override {}
+  void visit(const LambdaCallNode&) override {}
+  void visit(const LambdaNode&) override {}
+  void visit(const NumericLiteralNode& node) override { value_ = node.getValue(); }
+  void visit(const ProgramNode&) override {}
+  void visit(const ReturnNode&) override {}
+  void visit(const StringLiteralNode&) override {}
+  void visit(const UnaryNode& node) override;
+  void visit(const VariableDeclarationNode&) override {}
+  void visit(const VariableNode& node) override;
+  void visit(const NumericBinaryOpNode& node) override;
+
+private:
+  struct Missing
+  {
+    const VariableNode* variable;
+    std::size_t index;
+  };
+
+  double evaluate(const ExpressionNode& expression);
+
+  const LoopNode& loop_;
+  std::vector<double> values_;
+  std::vector<double> next_;
+  std::vector<bool> known_;
+  std::size_t missing_;
+  bool iterated_;
+  double value_;
+};
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <memory>
+#include <set>
+#include <string>
+
+#include "ASTCloner.hpp"
+#include "PurityAnalyser.hpp"
+
+/*
+ * Turns self-recursive functions, which only return if(condition, f(...), result)
+ * or if(condition, result, f(...)), into loops (see LoopNode). The condition and
+ * the arguments of the recursive call may only combine parameters and literals
+ * with operators and if, the result must not refer to the function. Parameters
+ * have to be numeric and those the arguments read have to be forced by every call
+ * which recurses, so that evaluating the arguments eagerly cannot change what the
+ * program does.
+ * Passes which substitute into function bodies see loops as plain returns.
+ * Pass has to be run on the whole program after semantic analysis.
+ */
+class LoopRecognizer : public ASTCloner
+{
+public:
+  LoopRecognizer();
+
+  // Analysis of the program the pass runs on, so that the pass does not repeat it.
+  void setPurity(std::shared_ptr<const PurityAnalyser> purity) { analysis_ = std::move(purity); }
+
+  std::size_t getRecognized() const { return recognized_; }
+
+  void visit(const FunctionDeclarationNode&) override;
+  void visit(const ProgramNode&) override;
+
+private:
+  std::shared_ptr<const PurityAnalyser> analysis_;
+  std::shared_ptr<const PurityAnalyser> purity_;
+  std::size_t recognized_;
+};
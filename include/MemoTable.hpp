@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+class BlockNode;
+class ProgramNode;
+
+/*
+ * Bounded cache of results of pure numeric functions, entries are evicted in
+ * least recently used order. Functions are identified by fingerprint, which
+ * covers function's body and its callees, so entries can outlive the program
+ * run and still be matched against unchanged functions.
+ */
+class MemoTable
+{
+public:
+  MemoTable(std::size_t capacity);
+
+  void addFunction(const BlockNode* function, std::uint64_t fingerprint);
+  bool isMemoizable(const BlockNode* function) const;
+
+  std::optional<double> lookup(const BlockNode* function, const std::vector<double>& arguments);
+  void insert(const BlockNode* function, const std::vector<double>& arguments, double result);
+
+  // Loads entries from cache file written by save, missing or malformed files are ignored.
+  // Only entries of functions registered before are loaded, so stale entries do not evict live ones.
+  bool load(const std::string& path);
+  // Writes entries of functions registered in this run, other entries are treated as stale.
+  bool save(const std::string& path) const;
+
+  std::size_t getCapacity() const { return capacity_; }
+  std::size_t getSize() const { return entries_.size(); }
+  std::size_t getHits() const { return hits_; }
+  std::size_t getMisses() const { return misses_; }
+  std::size_t getEvictions() const { return evictions_; }
+
+private:
+  struct Key
+  {
+    std::uint64_t function;
+    std::vector<double> arguments;
+
+    bool operator==(const Key& other) const;
+  };
+
+  struct KeyHash
+  {
+    std::size_t operator()(const Key& key) const;
+  };
+
+  using Entry = std::pair<Key, double>;
+
+  void insert(Key key, double result);
+
+  std::size_t capacity_;
+  std::unordered_map<const BlockNode*, std::uint64_t> functions_;
+  std::unordered_set<std::uint64_t> fingerprints_;
+  std::list<Entry> entries_;
+  std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> index_;
+  std::size_t hits_;
+  std::size_t misses_;
+  std::size_t evictions_;
+};
+
+// Registers pure numeric functions of the program in given table.
+void registerMemoizableFunctions(MemoTable& table, const ProgramNode& program);
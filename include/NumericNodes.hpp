@@ -0,0 +1,25 @@
+#pragma once
+
+#include <memory>
+
+#include "AST.hpp"
+#include "Operators.hpp"
+
+template<BinaryOperator Op>
+class NumericBinaryNode : public NumericBinaryOpNode
+{
+public:
+  NumericBinaryNode(std::unique_ptr<ExpressionNode> leftOperand, std::unique_ptr<ExpressionNode> rightOperand,
+    bool integer):
+      NumericBinaryOpNode(std::move(leftOperand), Op, std::move(rightOperand), integer) {}
+
+  double evaluate(double left, double right) const override { return evaluateBinary(Op, left, right); }
+
+  std::int64_t evaluateInteger(std::int64_t left, std::int64_t right) const override
+  {
+    return evaluateIntegerBinary(Op, left, right);
+  }
+};
+
+std::unique_ptr<NumericBinaryOpNode> makeNumericBinaryNode(std::unique_ptr<ExpressionNode> leftOperand,
+  const BinaryOperator& op, std::unique_ptr<ExpressionNode> rightOperand, bool integer = false);
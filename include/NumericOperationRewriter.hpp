@@ -0,0 +1,28 @@
+#pragma once
+
+#include "ASTCloner.hpp"
+#include "IntegerRangeAnalyser.hpp"
+#include "TypeChecker.hpp"
+
+/*
+ * Replaces binary operations whose operands were typed as numbers by semantic analysis
+ * with numeric node kinds, which the executor evaluates without generic type dispatch.
+ * Other passes preserve these node kinds, so rewriting is done on the analysed tree.
+ * Operations which are exact on integers are marked to be evaluated on int64.
+ */
+class NumericOperationRewriter : public ASTCloner
+{
+public:
+  NumericOperationRewriter(const TypeTable& types);
+
+  std::size_t getRewritten() const { return rewritten_; }
+  std::size_t getIntegers() const { return integers_; }
+
+  void visit(const BinaryOpNode&) override;
+
+private:
+  TypeChecker typeChecker_;
+  IntegerRangeAnalyser ranges_;
+  std::size_t rewritten_;
+  std::size_t integers_;
+};
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+
+#include "AST.hpp"
+
+/*
+ * Semantics of numeric operators, shared by the executor and by passes
+ * which evaluate expressions ahead of time. Definitions are inline, so that
+ * operations with operator known at compile time do not dispatch on it.
+ */
+inline double evaluateBinary(const BinaryOperator& operation, double l, double r)
+{
+  switch(operation)
+  {
+    case BinaryOperator::Addition:
+      return l + r;
+    case BinaryOperator::BinaryAnd:
+      return static_cast<unsigned int>(l) & static_cast<unsigned int>(r);
+    case BinaryOperator::BinaryOr:
+      return static_cast<unsigned int>(l) | static_cast<unsigned int>(r);
+    case BinaryOperator::BinaryXor:
+      return static_cast<unsigned int>(l) ^ static_cast<unsigned int>(r);
+    case BinaryOperator::Division:
+      return l / r;
+    case BinaryOperator::Equal:
+      return l == r ? 1 : 0;
+    case BinaryOperator::Greater:
+      return l > r ? 1 : 0;
+    case BinaryOperator::GreaterEq:
+      return l >= r ? 1 : 0;
+    case BinaryOperator::Less:
+      return l < r ? 1 : 0;
+    case BinaryOperator::LessEq:
+      return l <= r ? 1 : 0;
+    case BinaryOperator::LogicalAnd:
+      return l && r;
+    case BinaryOperator::LogicalOr:
+      return l || r;
+    case BinaryOperator::Modulo:
+      return std::fmod(l, r);
+    case BinaryOperator::Multiplication:
+      return l * r;
+    case BinaryOperator::NotEqual:
+      return l != r ? 1 : 0;
+    case BinaryOperator::ShiftLeft:
+      return static_cast<unsigned int>(l) << static_cast<unsigned int>(r);
+    case BinaryOperator::ShiftRight:
+      return static_cast<unsigned int>(l) >> static_cast<unsigned int>(r);
+    case BinaryOperator::Subtraction:
+      return l - r;
+  }
+
+  return l; // Unreachable
+}
+
+/*
+ * Integer counterpart of evaluateBinary, for operands on which it gives the same
+ * number (see IntegerRangeAnalyser): operands of bitwise operations fit unsigned
+ * int and shifts are shorter than its width, so the casts above do not change them.
+ */
+inline std::int64_t evaluateIntegerBinary(const BinaryOperator& operation, std::int64_t l, std::int64_t r)
+{
+  switch(operation)
+  {
+    case BinaryOperator::Addition:
+      return l + r;
+    case BinaryOperator::BinaryAnd:
+      return l & r;
+    case BinaryOperator::BinaryOr:
+      return l | r;
+    case BinaryOperator::BinaryXor:
+      return l ^ r;
+    case BinaryOperator::Division:
+      return l / r; // Never exact, kept for completeness
+    case BinaryOperator::Equal:
+      return l == r ? 1 : 0;
+    case BinaryOperator::Greater:
+      return l > r ? 1 : 0;
+    case BinaryOperator::GreaterEq:
+      return l >= r ? 1 : 0;
+    case BinaryOperator::Less:
+      return l < r ? 1 : 0;
+    case BinaryOperator::LessEq:
+      return l <= r ? 1 : 0;
+    case BinaryOperator::LogicalAnd:
+      return l && r;
+    case BinaryOperator::LogicalOr:
+      return l || r;
+    case BinaryOperator::Modulo:
+      return l % r;
+    case BinaryOperator::Multiplication:
+      return l * r;
+    case BinaryOperator::NotEqual:
+      return l != r ? 1 : 0;
+    case BinaryOperator::ShiftLeft:
+      return (l << r) & 0xFFFFFFFF;
+    case BinaryOperator::ShiftRight:
+      return l >> r;
+    case BinaryOperator::Subtraction:
+      return l - r;
+  }
+
+  return l; // Unreachable
+}
+
+inline double evaluateUnary(const UnaryOperator& operation, double term)
+{
+  switch(operation)
+  {
+    case UnaryOperator::BinaryNegation:
+      return ~static_cast<unsigned int>(term);
+    case UnaryOperator::LogicalNot:
+      return term == 0 ? 1 : 0;
+    case UnaryOperator::Minus:
+      return -term;
+  }
+
+  return term; // Unreachable
+}
+
+inline double evaluateAssignment(const AssignmentOperator& operation, double oldValue, double rhs)
+{
+  switch(operation)
+  {
+    case AssignmentOperator::PlusEq:
+      return oldValue + rhs;
+    case AssignmentOperator::MinusEq:
+      return oldValue - rhs;
+    case AssignmentOperator::MulEq:
+      return oldValue * rhs;
+    case AssignmentOperator::DivEq:
+      return oldValue / rhs;
+    case AssignmentOperator::OrEq:
+      return static_cast<unsigned int>(oldValue) | static_cast<unsigned int>(rhs);
+    case AssignmentOperator::AndEq:
+      return static_cast<unsigned int>(oldValue) & static_cast<unsigned int>(rhs);
+    case AssignmentOperator::XorEq:
+      return static_cast<unsigned int>(oldValue) ^ static_cast<unsigned int>(rhs);
+    case AssignmentOperator::ShiftLeftEq:
+      return static_cast<unsigned int>(oldValue) << static_cast<unsigned int>(rhs);
+    case AssignmentOperator::ShiftRightEq:
+      return static_cast<unsigned int>(oldValue) >> static_cast<unsigned int>(rhs);
+    case AssignmentOperator::Assign:
+      return rhs;
+  }
+
+  return oldValue; // Unreachable
+}
+
+inline bool isTrue(double condition)
+{
+  return std::fabs(condition) > 0.0001;
+}
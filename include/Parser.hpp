@@ -4,6 +4,7 @@
 #include <list>
 #include <memory>
 #include <optional>
+#include <string_view>
 
 #include "AST.hpp"
 #include "Tokenizer.hpp"
@@ -12,8 +13,10 @@ class Parser
 {
 public:
   Parser(std::istream& stream);
+  // Text has to outlive the parser.
+  Parser(std::string_view text);
 
-  std::unique_ptr<Node> parseProgram();
+  std::unique_ptr<ProgramNode> parseProgram();
   std::unique_ptr<ExpressionNode> parseStringExpression();
   std::unique_ptr<ExpressionNode> parseLogicalExpression();
   std::unique_ptr<ExpressionNode> parseUnaryLogical();
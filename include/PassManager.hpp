@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <string>
+#include <typeindex>
+#include <unordered_map>
+#include <vector>
+
+#include "AST.hpp"
+#include "Profile.hpp"
+#include "Visitor.hpp"
+
+/*
+ * Caches results of analyses of the current program. Analysis is a visitor which
+ * is run on the whole program, like PurityAnalyser or SemanticAnalyser. Results
+ * are kept until a pass replaces the program, then they are computed again on
+ * the first request.
+ */
+class AnalysisManager
+{
+public:
+  AnalysisManager(): results_(), computed_(0), reused_(0) {}
+
+  template<typename Analysis>
+  std::shared_ptr<const Analysis> get(const ProgramNode& program)
+  {
+    auto& result = results_[std::type_index(typeid(Analysis))];
+    if(result)
+      ++reused_;
+    else
+    {
+      auto analysis = std::make_shared<Analysis>();
+      program.accept(*analysis);
+      result = analysis;
+      ++computed_;
+    }
+    return std::static_pointer_cast<const Analysis>(result);
+  }
+
+  void invalidate() { results_.clear(); }
+
+  std::size_t getComputed() const { return computed_; }
+  std::size_t getReused() const { return reused_; }
+
+private:
+  std::unordered_map<std::type_index, std::shared_ptr<Visitor>> results_;
+  std::size_t computed_;
+  std::size_t reused_;
+};
+
+// Transformation of a whole program.
+class Pass
+{
+public:
+  virtual ~Pass() = default;
+
+  // Transformed program, or null if the pass left the program as it was.
+  virtual std::unique_ptr<ProgramNode> run(const ProgramNode& program, AnalysisManager& analyses) = 0;
+  // What the pass did, for statistics.
+  virtual std::string getSummary() const = 0;
+};
+
+struct PassOptions
+{
+  PassOptions(): specializationCapacity(64), feedback() {}
+
+  std::size_t specializationCapacity;
+  // Profile guiding the passes, inlining is skipped without one.
+  std::shared_ptr<Profile> feedback;
+};
+
+/*
+ * Runs passes over a program in the order they were added, after the program has
+ * passed semantic analysis. Every pass is timed and the number of nodes of the
+ * program is counted before and after it. Numeric rewriting needs semantic analysis,
+ * so it can only be the first pass. Passes are registered by name:
+ *   numeric       rewrite operations on numbers to numeric nodes (NumericOperationRewriter)
+ *   inline        inline hot calls guided by the profile (Inliner)
+ *   specialize    specialize functions for constant arguments (Specializer)
+ *   lift-lambdas  turn lambdas which are only called into functions (LambdaLifter)
+ *   loops         run self-recursive functions with accumulators as loops (LoopRecognizer)
+ *   cse           share repeated subexpressions (CommonSubexpressionEliminator)
+ *   dce           remove unreachable code (DeadCodeEliminator)
+ */
+class PassManager
+{
+public:
+  struct Report
+  {
+    std::string name;
+    double milliseconds;
+    std::size_t nodesBefore;
+    std::size_t nodesAfter;
+    std::string summary;
+  };
+
+  PassManager(const PassOptions& options = PassOptions{});
+
+  // Names of passes of given optimization level from 0 to 3, in the order they should run.
+  static std::optional<std::vector<std::string>> getLevel(int level);
+  static bool isRegistered(const std::string& name);
+
+  // Adds pass with given name, returns false if there is no such pass or if it cannot run at this point.
+  bool add(const std::string& name);
+  std::unique_ptr<ProgramNode> run(std::unique_ptr<ProgramNode> program);
+
+  AnalysisManager& getAnalyses() { return analyses_; }
+  const std::vector<Report>& getReports() const { return reports_; }
+
+private:
+  PassOptions options_;
+  std::vector<std::pair<std::string, std::unique_ptr<Pass>>> passes_;
+  AnalysisManager analyses_;
+  std::vector<Report> reports_;
+};
+
+// Number of nodes of the tree.
+std::size_t countNodes(const Node& node);
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+#include "AST.hpp"
+
+/*
+ * Execution profile of a program: how many times each call site ran and which
+ * functions it called, how often each if took either branch, and how many lazy
+ * bindings of each expression were made and forced. Sites are identified by the
+ * function they are in, their kind, structural hash of their subtree (see ASTHasher)
+ * and the number of equal sites before them in the function, not by their Mark,
+ * so a profile stays valid when the source is reformatted or other functions are
+ * edited. Counters are recorded for nodes of the program given to addProgram,
+ * which also matches nodes of another program to the counters of a loaded profile.
+ */
+class Profile
+{
+public:
+  struct Branches
+  {
+    std::uint64_t whenTrue;
+    std::uint64_t whenFalse;
+  };
+
+  Profile();
+
+  // Indexes sites of the program, only its nodes are recorded and looked up.
+  void addProgram(const ProgramNode& program);
+
+  void recordCall(const Node& site);
+  void recordBranch(const FunctionCallNode& site, bool condition);
+  void recordTarget(const CallNode& site, const BlockNode& body);
+  void recordBinding(const ExpressionNode& expression);
+  void recordForce(const ExpressionNode& expression);
+
+  // Queries return nothing for sites the profile knows nothing about.
+  std::optional<std::uint64_t> getCalls(const Node& site) const;
+  std::optional<Branches> getBranches(const FunctionCallNode& site) const;
+  // Name of the only function called from the site.
+  std::optional<std::string> getTarget(const CallNode& site) const;
+  // Forces per lazy binding of the expression, may exceed one for bindings read repeatedly.
+  std::optional<double> getForceRate(const ExpressionNode& expression) const;
+
+  bool load(const std::string& path);
+  bool save(const std::string& path) const;
+
+  std::size_t getSites() const { return sites_.size() + bindings_.size(); }
+  std::size_t getMatched() const;
+
+private:
+  struct Counters
+  {
+    Counters(): known(false), first(0), second(0), targets(), mark() {}
+
+    // Set for counters which were loaded or recorded.
+    bool known;
+    std::uint64_t first;
+    std::uint64_t second;
+    std::map<std::string, std::uint64_t> targets;
+    Mark mark;
+  };
+
+  const Counters* find(const std::unordered_map<const Node*, Counters*>& index, const Node& node) const;
+  Counters* find(std::unordered_map<const Node*, Counters*>& index, const Node& node);
+
+  // Ordered by key, so the same program always produces the same file.
+  std::map<std::string, Counters> counters_;
+  std::unordered_map<const Node*, Counters*> sites_;
+  std::unordered_map<const Node*, Counters*> bindings_;
+  std::unordered_map<const BlockNode*, std::string> bodies_;
+};
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <deque>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "AST.hpp"
+#include "Visitor.hpp"
+
+/*
+ * Determines which top-level functions are pure (do not print, do not touch
+ * non-local variables and do not call anything that is not pure) and in which
+ * arguments they are strict, i.e. which arguments are forced on every path.
+ * Closed functions do not depend on the scope of their caller.
+ * Analysis has to be run on the whole program.
+ */
+class PurityAnalyser : public Visitor
+{
+public:
+  PurityAnalyser();
+
+  bool isPure(const std::string& function) const;
+  bool isMemoizable(const std::string& function) const;
+  bool isShadowed(const std::string& name) const;
+  // Whether function, and everything it calls, only uses its own locals and top-level functions.
+  bool isClosed(const std::string& function) const;
+  // Whether some function assigns given name without declaring it, i.e. in the caller's scope.
+  bool isAssignedNonLocally(const std::string& name) const;
+  std::vector<bool> getStrictArguments(const std::string& function) const;
+  std::set<std::string> getCallees(const std::string& function) const;
+  // Which of given variables are certainly forced by statements of block, starting at given one.
+  std::set<std::string> getForced(const BlockNode& block, const StatementNode& first,
+    const std::set<std::string>& names) const;
+
+  void visit(const AssignmentNode&) override;
+  void visit(const BinaryOpNode&) override;
+  void visit(const BlockNode&) override;
+  void visit(const FunctionCallNode&) override;
+  void visit(const FunctionCallStatementNode&) override;
+  void visit(const FunctionDeclarationNode&) override;
+  void visit(const FunctionResultCallNode&) override;
+  void visit(const LambdaCallNode&) override;
+  void visit(const LambdaNode&) override;
+  void visit(const NumericLiteralNode&) override;
+  void visit(const ProgramNode&) override;
+  void visit(const ReturnNode&) override;
+  void visit(const StringLiteralNode&) override;
+  void visit(const UnaryNode&) override;
+  void visit(const VariableDeclarationNode&) override;
+  void visit(const VariableNode&) override;
+
+private:
+  struct FunctionInfo
+  {
+    FunctionInfo(): declaration(nullptr), numeric(false), locallyPure(true), pure(false),
+      locallyClosed(true), closed(false), callees(), strictArguments() {}
+
+    // Valid only during analysis.
+    const FunctionDeclarationNode* declaration;
+    bool numeric;
+    bool locallyPure;
+    bool pure;
+    bool locallyClosed;
+    bool closed;
+    std::set<std::string> callees;
+    std::vector<bool> strictArguments;
+  };
+
+  bool isLocal(const std::string& name) const;
+  void computePurity();
+  void computeStrictness();
+
+  std::map<std::string, FunctionInfo> functions_;
+  std::set<std::string> localNames_;
+  std::set<std::string> nonLocalAssignments_;
+  std::deque<std::set<std::string>> scopes_;
+  FunctionInfo* current_;
+};
+
+// Given analysis of the program if there is one, otherwise the program is analysed.
+std::shared_ptr<const PurityAnalyser> analysePurity(const ProgramNode& program,
+  const std::shared_ptr<const PurityAnalyser>& given);
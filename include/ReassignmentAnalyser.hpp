@@ -0,0 +1,13 @@
+#pragma once
+
+#include <string>
+#include <unordered_set>
+
+#include "AST.hpp"
+
+/*
+ * Names of variables which are assigned a new expression with = anywhere in the
+ * program. The new expression is evaluated in the context of the binding, so
+ * bindings of these names cannot drop their context even if their value is known.
+ */
+std::unordered_set<std::string> findReassignedNames(const ProgramNode& program);
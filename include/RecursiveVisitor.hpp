@@ -0,0 +1,39 @@
+#pragma once
+
+#include "AST.hpp"
+#include "Visitor.hpp"
+
+/*
+ * Visits every node of a tree, children in the order they appear in. Analyses
+ * which collect something from a tree derive from it and override visits of the
+ * nodes they care about, calling the base to descend further. Specialized node
+ * kinds are visited as their generic counterparts.
+ */
+class RecursiveVisitor : public Visitor
+{
+public:
+  virtual ~RecursiveVisitor() = default;
+
+  void visit(const AssignmentNode&) override;
+  void visit(const BinaryOpNode&) override;
+  void visit(const BlockNode&) override;
+  void visit(const FunctionCallNode&) override;
+  void visit(const FunctionCallStatementNode&) override;
+  void visit(const FunctionDeclarationNode&) override;
+  void visit(const FunctionResultCallNode&) override;
+  void visit(const LambdaCallNode&) override;
+  void visit(const LambdaNode&) override;
+  void visit(const NumericLiteralNode&) override;
+  void visit(const ProgramNode&) override;
+  void visit(const ReturnNode&) override;
+  void visit(const StringLiteralNode&) override;
+  void visit(const UnaryNode&) override;
+  void visit(const VariableDeclarationNode&) override;
+  void visit(const VariableNode&) override;
+
+protected:
+  // Called for every node before its children are visited.
+  virtual void enter(const Node&) {}
+
+  void visitArguments(const CallNode& node);
+};
@@ -3,6 +3,7 @@
 #include "AST.hpp"
 #include "Visitor.hpp"
 #include "Symbol.hpp"
+#include "TypeChecker.hpp"
 
 #include <optional>
 #include <stack>
@@ -12,6 +13,8 @@ class SemanticAnalyser : public Visitor
 public:
   SemanticAnalyser();
 
+  // Types of all checked expressions, valid as long as the analysed tree.
+  const TypeTable& getTypes() const { return types_; }
 
   void visit(const AssignmentNode&) override;
   void visit(const BinaryOpNode&) override;
@@ -42,7 +45,9 @@ private:
   };
 
   void addBuildInSymbols();
+  void setType(const ExpressionNode& node, const std::optional<TypeName>& type);
 
   SymbolTable symbols_;
+  TypeTable types_;
   std::stack<ReturnInfo> hasReturn_;
 };
\ No newline at end of file
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <list>
+#include <map>
+#include <memory>
+#include <optional>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "ASTCloner.hpp"
+#include "Profile.hpp"
+#include "PurityAnalyser.hpp"
+
+/*
+ * Partial evaluator. Direct calls of top-level functions with numeric literals
+ * as arguments are redirected to residual copies of the function, in which these
+ * arguments are replaced by their values and folded into the body. Residual
+ * functions are cached per function and constant arguments, at most given number
+ * of them is created. Residual function calls itself, or functions which recursively
+ * call it, with other constants through the original function, so that recursion
+ * is not unrolled into residual functions. Calls of lambdas with literal arguments are specialized in
+ * place and constant operations, including if with known condition, are folded.
+ * Calls which never ran according to the profile are not specialized, so that
+ * the residual functions are spent on the calls that did.
+ * Pass has to be run on the whole program after semantic analysis.
+ */
+class Specializer : public ASTCloner
+{
+public:
+  Specializer(std::size_t capacity = 64, std::shared_ptr<Profile> feedback = nullptr);
+
+  // Analysis of the program the pass runs on, so that the pass does not repeat it.
+  void setPurity(std::shared_ptr<const PurityAnalyser> purity) { analysis_ = std::move(purity); }
+
+  std::size_t getSpecialized() const { return specialized_; }
+
+  void visit(const BinaryOpNode&) override;
+  void visit(const FunctionCallNode&) override;
+  void visit(const LambdaCallNode&) override;
+  void visit(const ProgramNode&) override;
+  void visit(const UnaryNode&) override;
+  void visit(const VariableNode&) override;
+  void visit(const NumericBinaryOpNode&) override;
+  void visit(const LoopNode&) override;
+
+private:
+  using Arguments = std::list<std::pair<std::string, TypeName>>;
+  using Pattern = std::vector<std::optional<double>>;
+
+  std::optional<std::string> specialize(const FunctionDeclarationNode& function, const Pattern& pattern);
+  Pattern getPattern(const Arguments& parameters, const std::set<std::string>& fixable,
+    const std::list<std::shared_ptr<ExpressionNode>>& args) const;
+  bool isClosedCallee(const std::string& name) const;
+  bool reaches(const std::string& caller, const std::string& callee) const;
+  bool isCold(const CallNode& node) const;
+  void fold(const BinaryOpNode& node, bool numeric);
+
+  std::shared_ptr<const PurityAnalyser> analysis_;
+  std::shared_ptr<const PurityAnalyser> purity_;
+  std::map<std::string, const FunctionDeclarationNode*> functions_;
+  // Parameters which can be replaced by constants in body of each function.
+  std::map<std::string, std::set<std::string>> fixable_;
+  std::map<std::pair<std::string, Pattern>, std::string> cache_;
+  std::list<std::unique_ptr<FunctionDeclarationNode>> residualFunctions_;
+  std::map<std::string, double> constants_;
+  // Residual functions whose bodies are being specialized.
+  std::vector<std::pair<std::string, Pattern>> enclosing_;
+  std::size_t capacity_;
+  std::shared_ptr<Profile> feedback_;
+  std::size_t specialized_;
+};
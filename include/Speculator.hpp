@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "AST.hpp"
+#include "Context.hpp"
+#include "Profile.hpp"
+
+/*
+ * Optimistic evaluation of lazy bindings. Expression bound to a variable or an
+ * argument is evaluated right away, if it only combines literals and variables
+ * with operators and if it does not take more steps than the budget allows.
+ * Any call (except if), error or running out of budget aborts the attempt and
+ * the binding is left lazy, so divergent and failing expressions are still
+ * evaluated only when forced. Sites which keep aborting are not tried anymore,
+ * neither are sites whose bindings were rarely forced according to the profile.
+ */
+class Speculator
+{
+public:
+  Speculator(std::size_t budget, std::shared_ptr<Profile> feedback = nullptr);
+
+  // Literal with the value of expression in given context, null if the attempt was aborted.
+  std::shared_ptr<ExpressionNode> speculate(const std::shared_ptr<ExpressionNode>& expression, const Context& context);
+
+  // Context of bindings to speculated values, which does not matter to literals.
+  const std::shared_ptr<const Context>& getContext() const { return context_; }
+  // Speculated bindings of names reassigned in the program keep a copy of the context.
+  void addProgram(const ProgramNode& program);
+  bool isReassigned(const std::string& name) const { return reassigned_.count(name) != 0; }
+
+  std::size_t getBudget() const { return budget_; }
+  std::size_t getAttempts() const { return attempts_; }
+  std::size_t getAborted() const { return aborted_; }
+  std::size_t getDisabled() const { return disabled_; }
+
+private:
+  struct Site
+  {
+    std::size_t succeeded;
+    std::size_t aborted;
+    bool disabled;
+  };
+
+  std::size_t budget_;
+  std::shared_ptr<const Context> context_;
+  std::unordered_map<const ExpressionNode*, Site> sites_;
+  std::unordered_set<std::string> reassigned_;
+  std::shared_ptr<Profile> feedback_;
+  std::size_t attempts_;
+  std::size_t aborted_;
+  std::size_t disabled_;
+};
@@ -0,0 +1,156 @@
+#pragma once
+
+#include "Visitor.hpp"
+#include "Context.hpp"
+#include "Executor.hpp"
+#include "LoopEvaluator.hpp"
+#include "MemoTable.hpp"
+#include "Value.h"
+
+#include <list>
+#include <stack>
+#include <string>
+#include <vector>
+
+/*
+ * Evaluates programs like Executor, but keeps continuations in a growable stack
+ * of frames instead of recursing on the native stack. Visiting a node either
+ * produces its value or pushes a frame, which is resumed once the value of
+ * the subexpression it waits for is known. Evaluations which Executor performs
+ * in a nested executor (forcing variables, calling closures) run in segments,
+ * holding their own context, return values and output.
+ * Depth of the evaluation is limited by the memory budget of the stack only.
+ */
+class StackExecutor : public Visitor
+{
+public:
+  StackExecutor(const ExecutorOptions& options = {});
+
+  StackExecutor(const StackExecutor&) = delete;
+
+  const std::unique_ptr<Value>& getValue() const { return segments_.front().value; }
+  int getExitCode() const { return exitCode_; }
+  std::string getStandardOut() const { return segments_.front().output; }
+  const std::shared_ptr<MemoTable>& getMemoTable() const { return memoTable_; }
+
+  std::size_t getMaxDepth() const { return maxDepth_; }
+  std::size_t getStackLimit() const { return stackLimit_; }
+  // Calls active at the point where evaluation stopped, from the innermost one.
+  std::vector<std::string> getStackTrace() const;
+
+  void visit(const AssignmentNode&) override;
+  void visit(const BinaryOpNode&) override;
+  void visit(const BlockNode&) override;
+  void visit(const FunctionCallNode&) override;
+  void visit(const FunctionCallStatementNode&) override;
+  void visit(const FunctionDeclarationNode&) override;
+  void visit(const FunctionResultCallNode&) override;
+  void visit(const LambdaCallNode&) override;
+  void visit(const LambdaNode&) override;
+  void visit(const LoopNode&) override;
+  void visit(const NumericLiteralNode&) override;
+  void visit(const ProgramNode&) override;
+  void visit(const ReturnNode&) override;
+  void visit(const StringLiteralNode&) override;
+  void visit(const UnaryNode&) override;
+  void visit(const VariableDeclarationNode&) override;
+  void visit(const VariableNode&) override;
+  void visit(const NumericBinaryOpNode&) override;
+
+private:
+  enum class FrameKind
+  {
+    Assignment,
+    Binary,
+    NumericBinary,
+    Block,
+    Print,
+    If,
+    Call,
+    MemoizedArgument,
+    MemoizedCall,
+    VariableCall,
+    ResultCall,
+    ClosureCall,
+    LambdaCall,
+    Main,
+    Return,
+    Loop,
+    Unary,
+    Force
+  };
+
+  struct Frame
+  {
+    Frame(FrameKind kind, const Node& node): kind(kind), node(&node), stage(0), name(nullptr), statement(), argument(),
+      operand(), number(0), arguments(), body(nullptr), loop(), cell(), returnType(TypeName::Void), forced() {}
+
+    FrameKind kind;
+    const Node* node;
+    std::size_t stage;
+    // Name of called function, for stack traces.
+    const std::string* name;
+    std::list<std::unique_ptr<StatementNode>>::const_iterator statement;
+    std::list<std::shared_ptr<ExpressionNode>>::const_iterator argument;
+    std::unique_ptr<Value> operand;
+    double number;
+    std::vector<double> arguments;
+    const BlockNode* body;
+    // Loop which waits for the value of a parameter or for its result.
+    std::unique_ptr<LoopEvaluator> loop;
+    std::shared_ptr<ValueCell> cell;
+    TypeName returnType;
+    // Variable whose value the frame waits for.
+    ForcedVariableGuard forced;
+  };
+
+  /*
+   * State of an evaluation which Executor would perform in a separate executor.
+   * Arguments of memoized calls are evaluated in the context of the caller, which
+   * they leave unchanged, so such segments borrow it instead of copying.
+   */
+  struct Segment
+  {
+    Segment(Context* borrowed): owned(), context(borrowed), returnStack(), returned(false), output(), value() {}
+    Segment(Context context): owned(std::make_unique<Context>(std::move(context))), context(owned.get()),
+      returnStack(), returned(false), output(), value() {}
+
+    std::unique_ptr<Context> owned;
+    Context* context;
+    std::stack<std::unique_ptr<Value>> returnStack;
+    // Set by return statement until the enclosing block stops executing.
+    bool returned;
+    std::string output;
+    std::unique_ptr<Value> value;
+  };
+
+  void run(std::size_t base);
+  void resume(Frame& frame);
+  Frame& pushFrame(FrameKind kind, const Node& node);
+  void popFrame() { frames_.pop_back(); }
+  void enterSegment(Segment segment, const Node& node);
+  std::unique_ptr<Value> leaveSegment();
+  void checkStackLimit(const Node& node) const;
+  void force(Frame& frame, const RuntimeVariableAnalyser& variable, const Node& node);
+  std::unique_ptr<Value> leaveForced(Frame& frame);
+
+  Segment& segment() { return segments_.back(); }
+  Context& context() { return *segments_.back().context; }
+
+  void bindArguments(const CallNode& node, const std::list<std::pair<std::string, TypeName>>& parameters);
+  void handleFunctionCall(const FunctionCallNode& node, const RuntimeFunctionAnalyser& functionAnalyser);
+  void handleMemoizedCall(Frame& frame);
+  void finishMemoizedCall(Frame& frame);
+  void callValue(const CallNode& node, const std::string& name, const Value& value);
+  void runLoop(Frame& frame);
+
+  // Declared before the frames, whose guards remove variables from it when the frames are destroyed.
+  ForcedVariables forced_;
+  std::vector<Frame> frames_;
+  std::vector<Segment> segments_;
+  const Node* control_;
+  int exitCode_;
+  std::shared_ptr<MemoTable> memoTable_;
+  std::size_t stackLimit_;
+  std::size_t maxDepth_;
+};
@@ -0,0 +1,277 @@
+#pragma once
+
+#include "Visitor.hpp"
+#include "Executor.hpp"
+#include "LoopEvaluator.hpp"
+#include "MemoTable.hpp"
+#include "Value.h"
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/*
+ * Evaluates programs like Executor, as a graph reduction machine in the style of
+ * the spineless tagless G-machine. The program is first compiled into code with
+ * identifiers resolved to numbers. Variables and arguments are bound to thunks
+ * allocated on the heap, forcing a thunk pushes an update frame, which overwrites
+ * it with its value, so every later read (from any environment which shares it)
+ * gets the value without evaluating the expression again. A thunk under evaluation
+ * is blackholed and entering it again is reported as a loop. Functions and lambdas
+ * evaluate to closures of code and environment, which are applied to thunks of
+ * arguments (eval/apply). Continuations are kept in a stack of frames, so depth
+ * of the evaluation does not depend on the native stack.
+ * Environments are persistent: captured environments share scopes with the
+ * live one, scopes are copied only when a shared one is modified.
+ * Visiting a node other than program compiles and evaluates it in the global scope.
+ */
+class StgExecutor : public Visitor
+{
+public:
+  StgExecutor(const ExecutorOptions& options = {});
+
+  StgExecutor(const StgExecutor&) = delete;
+
+  std::unique_ptr<Value> getValue() const;
+  int getExitCode() const { return exitCode_; }
+  std::string getStandardOut() const { return stdout_; }
+  const std::shared_ptr<MemoTable>& getMemoTable() const { return memoTable_; }
+
+  std::size_t getAllocated() const { return allocated_; }
+  std::size_t getUpdated() const { return updated_; }
+  // Reads of thunks which were already updated with their values.
+  std::size_t getShared() const { return shared_; }
+  std::size_t getMaxDepth() const { return maxDepth_; }
+
+  void visit(const AssignmentNode& node) override { evaluate(node); }
+  void visit(const BinaryOpNode& node) override { evaluate(node); }
+  void visit(const BlockNode& node) override { evaluate(node); }
+  void visit(const FunctionCallNode& node) override { evaluate(node); }
+  void visit(const FunctionCallStatementNode& node) override { evaluate(node); }
+  void visit(const FunctionDeclarationNode& node) override { evaluate(node); }
+  void visit(const FunctionResultCallNode& node) override { evaluate(node); }
+  void visit(const LambdaCallNode& node) override { evaluate(node); }
+  void visit(const LambdaNode& node) override { evaluate(node); }
+  void visit(const NumericLiteralNode& node) override { evaluate(node); }
+  void visit(const ProgramNode&) override;
+  void visit(const ReturnNode& node) override { evaluate(node); }
+  void visit(const StringLiteralNode& node) override { evaluate(node); }
+  void visit(const UnaryNode& node) override { evaluate(node); }
+  void visit(const VariableDeclarationNode& node) override { evaluate(node); }
+  void visit(const VariableNode& node) override { evaluate(node); }
+  void visit(const NumericBinaryOpNode& node) override { evaluate(node); }
+
+private:
+  friend class StgCompiler;
+
+  struct Code;
+  struct Lambda;
+  struct Closure;
+  struct Thunk;
+  struct Scope;
+  using Env = std::shared_ptr<Scope>;
+
+  // Value in weak head normal form.
+  struct Object
+  {
+    Object(): type(TypeName::Void), number(0), string(), closure() {}
+    explicit Object(double number): type(TypeName::F32), number(number), string(), closure() {}
+
+    TypeName type;
+    double number;
+    std::shared_ptr<const std::string> string;
+    std::shared_ptr<const Closure> closure;
+  };
+
+  enum class Op
+  {
+    Number,
+    String,
+    Variable,
+    Binary,
+    NumericBinary,
+    Unary,
+    Print,
+    If,
+    Call,
+    ResultCall,
+    LambdaCall,
+    Lambda,
+    Block,
+    Return,
+    Loop,
+    Declare,
+    Define,
+    Assign,
+    Evaluate
+  };
+
+  struct Code
+  {
+    Code(Op op, const Node& node): op(op), node(&node), object(), name(-1), children(), lambda(nullptr) {}
+
+    Op op;
+    const Node* node;
+    // Value of literals.
+    Object object;
+    int name;
+    // Operands, arguments, statements or the value of a declaration.
+    std::vector<const Code*> children;
+    const Lambda* lambda;
+  };
+
+  // Code of a function or lambda, shared by all of its closures.
+  struct Lambda
+  {
+    Lambda(): name(), returnType(TypeName::Void), parameters(), body(nullptr), block(nullptr), arguments(nullptr) {}
+
+    std::string name;
+    TypeName returnType;
+    std::vector<std::pair<int, TypeName>> parameters;
+    const Code* body;
+    std::shared_ptr<BlockNode> block;
+    const std::list<std::pair<std::string, TypeName>>* arguments;
+  };
+
+  struct Closure
+  {
+    Closure(const Lambda& lambda, Env env): lambda(&lambda), env(std::move(env)) {}
+
+    const Lambda* lambda;
+    Env env;
+  };
+
+  enum class ThunkState
+  {
+    Unevaluated,
+    Blackhole,
+    Evaluated
+  };
+
+  /*
+   * Heap object of a variable. Its environment is kept after the update, as
+   * assignment replaces the value of a variable with expression evaluated in it.
+   */
+  struct Thunk
+  {
+    Thunk(const Code* code, Env env, const Node& binding): state(ThunkState::Unevaluated), code(code),
+      binding(&binding), env(std::move(env)), value() {}
+    Thunk(Object value, Env env): state(ThunkState::Evaluated), code(nullptr), binding(nullptr), env(std::move(env)),
+      value(std::move(value)) {}
+
+    ThunkState state;
+    const Code* code;
+    // Declaration, assignment or argument which created the thunk.
+    const Node* binding;
+    Env env;
+    Object value;
+  };
+
+  // Name bound either to a thunk or, for declared functions, to their code.
+  struct Binding
+  {
+    int name;
+    std::shared_ptr<Thunk> thunk;
+    const Lambda* function;
+  };
+
+  /*
+   * Names bound in a scope and in its ancestors, except the global scope, are
+   * kept as a bit set, so lookups of other names go straight to the global scope.
+   */
+  struct Scope
+  {
+    Scope(Env parent);
+    Scope(const Scope& scope);
+    ~Scope();
+
+    Env parent;
+    std::vector<Binding> bindings;
+    std::uint64_t names;
+    Scope* global;
+  };
+
+  enum class FrameKind
+  {
+    Update,
+    Binary,
+    Unary,
+    Print,
+    If,
+    Call,
+    MemoizedArgument,
+    MemoizedCall,
+    VariableCall,
+    ResultCall,
+    ClosureCall,
+    Block,
+    Return,
+    Loop,
+    Assignment
+  };
+
+  struct Frame
+  {
+    Frame(FrameKind kind, const Code& code): kind(kind), code(&code), stage(0), env(), output(nullptr), thunk(),
+      operand(), arguments(), lambda(nullptr), loop() {}
+
+    FrameKind kind;
+    const Code* code;
+    std::size_t stage;
+    // Environment and output restored when the frame is left.
+    Env env;
+    std::string* output;
+    std::shared_ptr<Thunk> thunk;
+    Object operand;
+    std::vector<double> arguments;
+    const Lambda* lambda;
+    std::unique_ptr<LoopEvaluator> loop;
+  };
+
+  const Code& compile(const Node& node);
+  int intern(const std::string& name);
+  void evaluate(const Node& node);
+  void run(const Code& code);
+
+  void eval(const Code& code);
+  void resume(Frame& frame);
+  Frame& pushFrame(FrameKind kind, const Code& code);
+  void popFrame() { frames_.pop_back(); }
+
+  const Binding* lookup(int name) const;
+  Binding& lookupForUpdate(int name, const Code& code);
+  void addBinding(Binding binding);
+  void enterScope();
+  void leaveScope();
+
+  void enter(const std::shared_ptr<Thunk>& thunk, const Code& code);
+  void call(const Code& code, const Lambda& function);
+  void callMemoized(Frame& frame);
+  void callValue(const Code& code, const std::string& name, const Object& callee);
+  void bindArguments(const Code& code, const Lambda& lambda, bool extendEnv);
+  void applyBinary(const Code& code, const Object& left, const Object& right);
+  void runLoop(Frame& frame);
+
+  std::deque<Code> code_;
+  std::deque<Lambda> lambdas_;
+  std::unordered_map<const Node*, const Code*> compiled_;
+  std::unordered_map<std::string, int> names_;
+  std::vector<Frame> frames_;
+  const Code* control_;
+  Env env_;
+  Object value_;
+  std::string* output_;
+  std::string stdout_;
+  // Output of forced thunks and memoized arguments, which Executor drops.
+  std::string discarded_;
+  int exitCode_;
+  std::shared_ptr<MemoTable> memoTable_;
+  std::size_t stackLimit_;
+  std::size_t allocated_;
+  std::size_t updated_;
+  std::size_t shared_;
+  std::size_t maxDepth_;
+};
@@ -1,26 +1,81 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdio>
 #include <iostream>
+#include <string>
+#include <string_view>
 
 #include "Mark.hpp"
 
+/*
+ * Source text scanned with a pointer to its current character. Text is either
+ * given by the caller, who has to keep it alive while the stream is used, or read
+ * at once from an input stream, so that sources can still come from pipes.
+ */
 class Stream
 {
 public:
-  Stream(std::istream& stream): is_(stream), mark_() {}
+  Stream(std::istream& stream);
+  Stream(std::string_view text);
 
   Stream(const Stream&) = delete;
   Stream(Stream&&) = delete;
   Stream& operator=(const Stream&) = delete;
   Stream& operator=(Stream&&) = delete;
 
-  bool eof() const;
-  char peek() const;
-  const Mark& getMark() const;
+  bool eof() const { return current_ == end_; }
+  char peek() const { return current_ != end_ ? *current_ : static_cast<char>(EOF); }
+  const Mark& getMark() const { return mark_; }
+
+  // Offset of the current character, getText returns text from an earlier offset up to it.
+  std::size_t getOffset() const { return static_cast<std::size_t>(current_ - begin_); }
+  std::string_view getText(std::size_t from) const { return {begin_ + from, getOffset() - from}; }
 
   void unget();
-  int advance();
+
+  int advance()
+  {
+    if(current_ != end_)
+      ++current_;
+    const int c = current_ != end_ ? static_cast<unsigned char>(*current_) : EOF;
+
+    if(c == '\n')
+      mark_.newLine();
+    else
+      mark_.advance();
+
+    return c;
+  }
+
 private:
-  std::istream& is_;
+  std::string buffer_;
+  const char* begin_;
+  const char* current_;
+  const char* end_;
   Mark mark_;
 };
+
+/*
+ * Text of a source file, which is mapped into memory. Files which cannot be
+ * mapped, like pipes, are read instead. Text stays valid while the object lives.
+ */
+class SourceFile
+{
+public:
+  SourceFile(const std::string& path);
+  ~SourceFile();
+
+  SourceFile(const SourceFile&) = delete;
+  SourceFile& operator=(const SourceFile&) = delete;
+
+  bool isOpen() const { return open_; }
+  std::string_view getText() const { return text_; }
+
+private:
+  bool open_;
+  void* mapping_;
+  std::size_t size_;
+  std::string buffer_;
+  std::string_view text_;
+};
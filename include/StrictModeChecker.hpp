@@ -0,0 +1,55 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "AST.hpp"
+#include "PurityAnalyser.hpp"
+#include "Visitor.hpp"
+
+/*
+ * Finds places where strict evaluation (ExecutorOptions::strict) may change the
+ * behaviour of a program: variables and arguments which are not certainly forced,
+ * but whose expressions call functions, so evaluating them up front could diverge
+ * or fail where lazy evaluation never would, and arguments of values assigned to a
+ * variable which read the variable itself. The check is conservative: reads by
+ * functions which resolve names in the caller's scope are not seen, arguments of
+ * function values are always reported. Checker has to be run on the whole program.
+ */
+class StrictModeChecker : public Visitor
+{
+public:
+  StrictModeChecker();
+
+  const std::vector<std::string>& getWarnings() const { return warnings_; }
+
+  void visit(const AssignmentNode&) override;
+  void visit(const BinaryOpNode&) override;
+  void visit(const BlockNode&) override;
+  void visit(const FunctionCallNode&) override;
+  void visit(const FunctionCallStatementNode&) override;
+  void visit(const FunctionDeclarationNode&) override;
+  void visit(const FunctionResultCallNode&) override;
+  void visit(const LambdaCallNode&) override;
+  void visit(const LambdaNode&) override;
+  void visit(const NumericLiteralNode&) override {}
+  void visit(const ProgramNode&) override;
+  void visit(const ReturnNode&) override;
+  void visit(const StringLiteralNode&) override {}
+  void visit(const UnaryNode&) override;
+  void visit(const VariableDeclarationNode&) override;
+  void visit(const VariableNode&) override {}
+
+private:
+  void checkArguments(const CallNode& node, const std::string& name, const std::vector<bool>& strict);
+  void warn(const std::string& message, const Node& node);
+
+  PurityAnalyser purity_;
+  std::map<std::string, const FunctionDeclarationNode*> functions_;
+  // Declaration visited last, checked by the enclosing block.
+  const VariableDeclarationNode* declaration_;
+  // Variable whose new value is visited.
+  const std::string* assigned_;
+  std::vector<std::string> warnings_;
+};
@@ -1,7 +1,7 @@
 #pragma once
 
-#include <set>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 
 #include "Stream.hpp"
@@ -11,13 +11,14 @@ class Tokenizer
 {
 public:
   Tokenizer(std::istream& stream);
+  // Text has to outlive the tokenizer.
+  Tokenizer(std::string_view text);
 
   bool end() const;
   const Token& peek() const;
   const Mark& getMark() const { return stream_.getMark(); }
   Token nextToken();
 private:
-  const static std::set<std::string> keywords_;
   const static std::unordered_map<std::string, TokenType> keywordTokenTypes_;
 
   Stream stream_;
@@ -1,34 +1,24 @@
 #pragma once
 
-#include "Visitor.hpp"
+#include <optional>
+#include <unordered_map>
+
 #include "AST.hpp"
-#include "Symbol.hpp"
 
-class TypeChecker : public Visitor
+// Types of expressions, computed once by semantic analysis.
+using TypeTable = std::unordered_map<const ExpressionNode*, TypeName>;
+
+/*
+ * Gives type of an expression from the table filled by SemanticAnalyser. Type has
+ * no value when it cannot be deduced statically, e.g. when variable was called.
+ */
+class TypeChecker
 {
 public:
-  TypeChecker(const SymbolTable& symbols): type_(), symbols_(symbols) {}
-
-  const std::optional<TypeName>& getType() const;
+  TypeChecker(const TypeTable& types): types_(types) {}
 
-  void visit(const AssignmentNode&) override;
-  void visit(const BinaryOpNode&) override;
-  void visit(const BlockNode&) override;
-  void visit(const FunctionCallNode&) override;
-  void visit(const FunctionCallStatementNode&) override;
-  void visit(const FunctionDeclarationNode&) override;
-  void visit(const FunctionResultCallNode&) override;
-  void visit(const LambdaCallNode&) override;
-  void visit(const LambdaNode&) override;
-  void visit(const NumericLiteralNode&) override;
-  void visit(const ProgramNode&) override;
-  void visit(const ReturnNode&) override;
-  void visit(const StringLiteralNode&) override;
-  void visit(const UnaryNode&) override;
-  void visit(const VariableDeclarationNode&) override;
-  void visit(const VariableNode&) override;
+  std::optional<TypeName> getType(const ExpressionNode& node) const;
 
 private:
-  std::optional<TypeName> type_;
-  const SymbolTable& symbols_;
-};
\ No newline at end of file
+  const TypeTable& types_;
+};
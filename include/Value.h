@@ -42,6 +42,8 @@ public:
   Number(double value): Value(TypeName::F32), value_(value) {}
 
   double getValue() const { return value_; }
+  // Numbers held in cells of variables are updated in place by compound assignment.
+  void setValue(double value) { value_ = value; }
 
   std::unique_ptr<Value> clone() const override;
   void accept(ValueVisitor& visitor) const override { visitor.visit(*this); }
@@ -137,4 +139,19 @@ private:
   std::optional<std::list<std::pair<std::string, TypeName>>> arguments_;
   std::shared_ptr<BlockNode> body_;
   std::optional<Context> context_;
+};
+
+// Refers to the function value instead of copying its parts like FunctionValueAnalyser.
+class FunctionValueResolver : public ValueVisitor
+{
+public:
+  FunctionValueResolver(): function_(nullptr) {}
+
+  const Function* getFunction() const { return function_; }
+
+  void visit(const Number&) override { function_ = nullptr; }
+  void visit(const String&) override { function_ = nullptr; }
+  void visit(const Function& func) override { function_ = &func; }
+private:
+  const Function* function_;
 };
\ No newline at end of file
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "AST.hpp"
+#include "Value.h"
+
+/*
+ * Operations on runtime values shared by evaluation engines. Operands of
+ * unexpected types are reported as errors at given node.
+ */
+void assertValueType(const Value& value, const TypeName& type, const std::string& activity, const Node& node);
+
+/*
+ * Function value called by the node, without copying its arguments and context.
+ * Arity is validated only when the callee's body differs from the one cached at
+ * the call site, see CallNode::getCachedCallee.
+ */
+const Function& resolveCallee(const CallNode& node, const std::string& name, const Value& value);
+
+std::unique_ptr<Value> applyBinaryOperation(const BinaryOpNode& node, const Value& left, const Value& right);
+// Falls back to generic operation when dynamic scoping bound an operand to non-number.
+std::unique_ptr<Value> applyNumericBinaryOperation(const NumericBinaryOpNode& node, const Value& left, const Value& right);
+std::unique_ptr<Value> applyUnaryOperation(const UnaryNode& node, const Value& term);
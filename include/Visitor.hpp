@@ -9,6 +9,8 @@ class FunctionDeclarationNode;
 class FunctionResultCallNode;
 class LambdaCallNode;
 class LambdaNode;
+class LoopNode;
+class NumericBinaryOpNode;
 class NumericLiteralNode;
 class ProgramNode;
 class ReturnNode;
@@ -38,4 +40,8 @@ public:
   virtual void visit(const UnaryNode&) = 0;
   virtual void visit(const VariableDeclarationNode&) = 0;
   virtual void visit(const VariableNode&) = 0;
+
+  // Specialized node kinds are visited as their generic counterparts unless overridden.
+  virtual void visit(const NumericBinaryOpNode&);
+  virtual void visit(const LoopNode&);
 };
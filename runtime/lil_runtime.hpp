@@ -0,0 +1,597 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+/*
+ * Runtime of programs translated to C++ by the interpreter (--emit-cpp). It keeps
+ * the semantics of the interpreter: names are resolved dynamically in contexts,
+ * variables hold unevaluated expressions together with the context they were
+ * declared in, and functions called through values run in the context captured
+ * by the value. Translated expressions and bodies are plain functions, names are
+ * numbered by the translator.
+ */
+namespace lil
+{
+
+enum class Type
+{
+  F32,
+  Function,
+  Void,
+  String
+};
+
+enum class Operator
+{
+  Addition,
+  Subtraction,
+  Multiplication,
+  Division,
+  Modulo,
+  LogicalAnd,
+  LogicalOr,
+  BinaryAnd,
+  BinaryOr,
+  BinaryXor,
+  ShiftLeft,
+  ShiftRight,
+  Greater,
+  GreaterEq,
+  Less,
+  LessEq,
+  Equal,
+  NotEqual
+};
+
+enum class UnaryOperator
+{
+  BinaryNegation,
+  Minus,
+  LogicalNot
+};
+
+enum class AssignmentOperator
+{
+  PlusEq,
+  MinusEq,
+  MulEq,
+  DivEq,
+  AndEq,
+  OrEq,
+  XorEq,
+  ShiftLeftEq,
+  ShiftRightEq
+};
+
+inline const char* typeName(Type type)
+{
+  switch(type)
+  {
+    case Type::F32: return "f32";
+    case Type::Function: return "function";
+    case Type::Void: return "void";
+    case Type::String: return "string";
+  }
+
+  return ""; // Unreachable
+}
+
+class Context;
+struct Activation;
+struct Value;
+
+using Code = Value (*)(Activation&);
+using Body = void (*)(Activation&);
+
+struct Parameter
+{
+  int name;
+  Type type;
+};
+
+using Parameters = std::vector<Parameter>;
+
+struct Arguments
+{
+  const Code* codes;
+  std::size_t size;
+};
+
+struct Closure
+{
+  Type returnType;
+  const Parameters* parameters;
+  Body body;
+  std::shared_ptr<const Context> context;
+};
+
+struct Value
+{
+  Value(): type(Type::Void), number(0), string(), function() {}
+
+  Type type;
+  double number;
+  std::string string;
+  // Closures are never changed once created, so copies of a value share it.
+  std::shared_ptr<const Closure> function;
+};
+
+inline Value number(double value)
+{
+  Value result{};
+  result.type = Type::F32;
+  result.number = value;
+  return result;
+}
+
+inline Value string(std::string value)
+{
+  Value result{};
+  result.type = Type::String;
+  result.string = std::move(value);
+  return result;
+}
+
+// Holds value of shared variable once it has been forced.
+struct Cell
+{
+  Cell(): forced(false), value() {}
+
+  bool forced;
+  Value value;
+};
+
+/*
+ * Variable holds expression (or a literal number, once assigned by compound assignment)
+ * and the context it is evaluated in. Function symbols keep their body and parameters.
+ */
+struct Symbol
+{
+  Symbol(): function(false), type(Type::Void), code(nullptr), literal(0), context(), cell(), parameters(nullptr),
+    body(nullptr) {}
+
+  bool function;
+  Type type;
+  Code code;
+  double literal;
+  std::shared_ptr<const Context> context;
+  std::shared_ptr<Cell> cell;
+  const Parameters* parameters;
+  Body body;
+};
+
+class Context
+{
+public:
+  Context(): scopes_(1) {}
+
+  void enterScope() { scopes_.emplace_back(); }
+  void leaveScope() { scopes_.pop_back(); }
+
+  // As in the interpreter, a name declared twice in one scope keeps the first symbol.
+  void addSymbol(int name, std::shared_ptr<Symbol> symbol)
+  {
+    auto& scope = scopes_.back();
+    for(const auto& entry : scope)
+    {
+      if(entry.first == name)
+        return;
+    }
+    scope.emplace_back(name, std::move(symbol));
+  }
+
+  Symbol* lookup(int name) const
+  {
+    for(auto scope = scopes_.rbegin(); scope != scopes_.rend(); ++scope)
+    {
+      for(const auto& entry : *scope)
+      {
+        if(entry.first == name)
+          return entry.second.get();
+      }
+    }
+    return nullptr;
+  }
+
+  // Variables are copied, so that assignments to the clone are not seen here. Function symbols never change.
+  Context clone() const
+  {
+    Context context{};
+    context.scopes_.resize(scopes_.size());
+    for(std::size_t i = 0; i < scopes_.size(); ++i)
+    {
+      auto& scope = context.scopes_[i];
+      scope.reserve(scopes_[i].size());
+      for(const auto& entry : scopes_[i])
+      {
+        auto symbol = entry.second->function ? entry.second : std::make_shared<Symbol>(*entry.second);
+        scope.emplace_back(entry.first, std::move(symbol));
+      }
+    }
+    return context;
+  }
+
+private:
+  std::vector<std::vector<std::pair<int, std::shared_ptr<Symbol>>>> scopes_;
+};
+
+/*
+ * Single evaluation of an expression or a body: its context, where print writes
+ * and the value returned by the body.
+ */
+struct Activation
+{
+  Activation(Context& context, std::string& output): context(context), output(output), result() {}
+
+  Context& context;
+  std::string& output;
+  Value result;
+};
+
+// Output of evaluations which the interpreter runs in nested executors and drops.
+inline std::string& discarded()
+{
+  static std::string output{};
+  return output;
+}
+
+[[noreturn]] inline void fail(const char* mark, const std::string& message)
+{
+  throw std::runtime_error(std::string{"ERROR ("} + mark + "): " + message);
+}
+
+inline void expect(const Value& value, Type type, const std::string& activity, const char* mark)
+{
+  if(value.type != type)
+    fail(mark, "Cannot perform " + activity + " with value of type " + typeName(value.type) + "!");
+}
+
+inline const char* operatorName(Operator operation)
+{
+  static const char* const names[] = {"Addition", "Subtraction", "Multiplication", "Division", "Modulo",
+    "LogicalAnd", "LogicalOr", "BinaryAnd", "BinaryOr", "BinaryXor", "ShiftLeft", "ShiftRight",
+    "Greater", "GreaterEq", "Less", "LessEq", "Equal", "NotEqual"};
+  return names[static_cast<int>(operation)];
+}
+
+inline const char* operatorName(UnaryOperator operation)
+{
+  static const char* const names[] = {"BinaryNegation", "Minus", "LogicalNot"};
+  return names[static_cast<int>(operation)];
+}
+
+inline const char* operatorName(AssignmentOperator operation)
+{
+  static const char* const names[] = {"PlusEq", "MinusEq", "MulEq", "DivEq", "AndEq", "OrEq", "XorEq",
+    "ShiftLeftEq", "ShiftRightEq"};
+  return names[static_cast<int>(operation)];
+}
+
+inline bool isTrue(double condition)
+{
+  return std::fabs(condition) > 0.0001;
+}
+
+inline double apply(Operator operation, double l, double r)
+{
+  switch(operation)
+  {
+    case Operator::Addition: return l + r;
+    case Operator::Subtraction: return l - r;
+    case Operator::Multiplication: return l * r;
+    case Operator::Division: return l / r;
+    case Operator::Modulo: return std::fmod(l, r);
+    case Operator::LogicalAnd: return l && r;
+    case Operator::LogicalOr: return l || r;
+    case Operator::BinaryAnd: return static_cast<unsigned int>(l) & static_cast<unsigned int>(r);
+    case Operator::BinaryOr: return static_cast<unsigned int>(l) | static_cast<unsigned int>(r);
+    case Operator::BinaryXor: return static_cast<unsigned int>(l) ^ static_cast<unsigned int>(r);
+    case Operator::ShiftLeft: return static_cast<unsigned int>(l) << static_cast<unsigned int>(r);
+    case Operator::ShiftRight: return static_cast<unsigned int>(l) >> static_cast<unsigned int>(r);
+    case Operator::Greater: return l > r ? 1 : 0;
+    case Operator::GreaterEq: return l >= r ? 1 : 0;
+    case Operator::Less: return l < r ? 1 : 0;
+    case Operator::LessEq: return l <= r ? 1 : 0;
+    case Operator::Equal: return l == r ? 1 : 0;
+    case Operator::NotEqual: return l != r ? 1 : 0;
+  }
+
+  return l; // Unreachable
+}
+
+inline double apply(UnaryOperator operation, double term)
+{
+  switch(operation)
+  {
+    case UnaryOperator::BinaryNegation: return ~static_cast<unsigned int>(term);
+    case UnaryOperator::Minus: return -term;
+    case UnaryOperator::LogicalNot: return term == 0 ? 1 : 0;
+  }
+
+  return term; // Unreachable
+}
+
+inline double apply(AssignmentOperator operation, double oldValue, double rhs)
+{
+  switch(operation)
+  {
+    case AssignmentOperator::PlusEq: return oldValue + rhs;
+    case AssignmentOperator::MinusEq: return oldValue - rhs;
+    case AssignmentOperator::MulEq: return oldValue * rhs;
+    case AssignmentOperator::DivEq: return oldValue / rhs;
+    case AssignmentOperator::AndEq: return static_cast<unsigned int>(oldValue) & static_cast<unsigned int>(rhs);
+    case AssignmentOperator::OrEq: return static_cast<unsigned int>(oldValue) | static_cast<unsigned int>(rhs);
+    case AssignmentOperator::XorEq: return static_cast<unsigned int>(oldValue) ^ static_cast<unsigned int>(rhs);
+    case AssignmentOperator::ShiftLeftEq: return static_cast<unsigned int>(oldValue) << static_cast<unsigned int>(rhs);
+    case AssignmentOperator::ShiftRightEq: return static_cast<unsigned int>(oldValue) >> static_cast<unsigned int>(rhs);
+  }
+
+  return oldValue; // Unreachable
+}
+
+inline Value binary(Operator operation, const Value& left, const Value& right, const char* mark)
+{
+  if(left.type == Type::F32 && right.type == Type::F32)
+    return number(apply(operation, left.number, right.number));
+
+  if(operation == Operator::Addition)
+  {
+    if(left.type == Type::String)
+    {
+      if(right.type == Type::String)
+        return string(left.string + right.string);
+      if(right.type == Type::F32)
+        return string(left.string + std::to_string(right.number));
+      fail(mark, std::string{"String cannot be concatenated with value of type "} + typeName(right.type) + "!");
+    }
+    if(left.type == Type::F32)
+      expect(right, Type::F32, "addition", mark);
+    fail(mark, std::string{"Operation cannot be performed with value of type "} + typeName(left.type) + "!");
+  }
+
+  const auto activity = std::string{"binary operation "} + operatorName(operation);
+  expect(left, Type::F32, activity, mark);
+  expect(right, Type::F32, activity, mark);
+  return number(apply(operation, left.number, right.number));
+}
+
+inline Value unary(UnaryOperator operation, const Value& term, const char* mark)
+{
+  expect(term, Type::F32, std::string{"unary operation "} + operatorName(operation), mark);
+  return number(apply(operation, term.number));
+}
+
+inline bool condition(const Value& value, const char* mark)
+{
+  if(value.type != Type::F32)
+    fail(mark, std::string{"Function if expected logical expression, but got "} + typeName(value.type) + "!");
+  return isTrue(value.number);
+}
+
+inline void print(Activation& activation, const Value& value, const char* mark)
+{
+  if(value.type != Type::String)
+    fail(mark, std::string{"Function print expected string, but got "} + typeName(value.type) + "!");
+
+  activation.output += value.string;
+  activation.output += "\n";
+}
+
+// Expression of variable is evaluated in a copy of its captured context, its output is dropped.
+inline Value force(const Symbol& symbol)
+{
+  if(!symbol.code)
+    return number(symbol.literal);
+
+  Context context{*symbol.context};
+  Activation activation{context, discarded()};
+  auto value = symbol.code(activation);
+  discarded().clear();
+  return value;
+}
+
+inline Value function(Activation& activation, Type returnType, const Parameters* parameters, Body body)
+{
+  Value result{};
+  result.type = Type::Function;
+  result.function = std::make_shared<const Closure>(Closure{returnType, parameters, body,
+    std::make_shared<const Context>(activation.context.clone())});
+  return result;
+}
+
+inline Value read(Activation& activation, int name, const char* identifier, const char* mark)
+{
+  const auto symbol = activation.context.lookup(name);
+  if(!symbol)
+    fail(mark, std::string{"Dereferencing invalid symbol "} + identifier + "!");
+
+  if(symbol->function)
+    return function(activation, symbol->type, symbol->parameters, symbol->body);
+
+  const auto& cell = symbol->cell;
+  if(cell && cell->forced)
+    return cell->value;
+
+  auto value = force(*symbol);
+  if(cell)
+  {
+    cell->value = value;
+    cell->forced = true;
+  }
+  return value;
+}
+
+inline void declare(Activation& activation, int name, Type type, Code code, bool shared)
+{
+  auto symbol = std::make_shared<Symbol>();
+  symbol->type = type;
+  symbol->code = code;
+  symbol->context = std::make_shared<const Context>(activation.context.clone());
+  if(shared)
+    symbol->cell = std::make_shared<Cell>();
+  activation.context.addSymbol(name, std::move(symbol));
+}
+
+inline void define(Activation& activation, int name, Type returnType, const Parameters* parameters, Body body)
+{
+  auto symbol = std::make_shared<Symbol>();
+  symbol->function = true;
+  symbol->type = returnType;
+  symbol->parameters = parameters;
+  symbol->body = body;
+  activation.context.addSymbol(name, std::move(symbol));
+}
+
+// New value keeps context of the variable, assignments to functions are ignored.
+inline void assign(Activation& activation, int name, Code code)
+{
+  const auto symbol = activation.context.lookup(name);
+  if(symbol->function)
+    return;
+
+  symbol->code = code;
+  symbol->cell.reset();
+}
+
+inline void assign(Activation& activation, int name, AssignmentOperator operation, Code code, const char* mark)
+{
+  const auto symbol = activation.context.lookup(name);
+  const auto activity = std::string{"assignment operation "} + operatorName(operation);
+
+  const auto oldValue = force(*symbol);
+  expect(oldValue, Type::F32, activity, mark);
+
+  const auto rhs = code(activation);
+  expect(rhs, Type::F32, activity, mark);
+
+  symbol->code = nullptr;
+  symbol->literal = apply(operation, oldValue.number, rhs.number);
+  symbol->cell.reset();
+}
+
+// Body runs in context of the activation, but returns on its own.
+inline Value callBody(Body body, Activation& activation)
+{
+  Activation callee{activation.context, activation.output};
+  body(callee);
+  return std::move(callee.result);
+}
+
+// Arguments are evaluated in the caller's context, without any of the parameters.
+inline void bindArguments(Context& context, const Parameters& parameters, Arguments arguments)
+{
+  const auto argContext = std::make_shared<const Context>(context.clone());
+  context.enterScope();
+
+  for(std::size_t i = 0; i < parameters.size(); ++i)
+  {
+    auto symbol = std::make_shared<Symbol>();
+    symbol->type = parameters[i].type;
+    symbol->code = arguments.codes[i];
+    symbol->context = argContext;
+    context.addSymbol(parameters[i].name, std::move(symbol));
+  }
+}
+
+inline Value callValue(Activation& activation, const std::string& name, const Value& value, Arguments arguments,
+  const char* mark)
+{
+  const auto& closure = *value.function;
+  const auto& parameters = *closure.parameters;
+  if(parameters.size() != arguments.size)
+    fail(mark, "Function " + name + " expected " + std::to_string(parameters.size()) + ", but got " +
+      std::to_string(arguments.size) + " arguments!");
+
+  Context context = closure.context->clone();
+  context.enterScope();
+
+  for(std::size_t i = 0; i < parameters.size(); ++i)
+  {
+    auto symbol = std::make_shared<Symbol>();
+    symbol->type = parameters[i].type;
+    symbol->code = arguments.codes[i];
+    symbol->context = std::make_shared<const Context>(context.clone());
+    context.addSymbol(parameters[i].name, std::move(symbol));
+  }
+
+  Activation callee{context, activation.output};
+  auto result = callBody(closure.body, callee);
+
+  return closure.returnType != Type::Void ? std::move(result) : Value{};
+}
+
+inline Value call(Activation& activation, int name, const char* identifier, Arguments arguments, const char* mark)
+{
+  const auto symbol = activation.context.lookup(name);
+  if(!symbol)
+    fail(mark, std::string{"Calling invalid symbol "} + identifier + "!");
+
+  if(!symbol->function)
+  {
+    const auto callee = force(*symbol);
+    expect(callee, Type::Function, "function call", mark);
+    return callValue(activation, identifier, callee, arguments, mark);
+  }
+
+  auto& context = activation.context;
+  bindArguments(context, *symbol->parameters, arguments);
+  auto result = callBody(symbol->body, activation);
+  context.leaveScope();
+
+  return symbol->type != Type::Void ? std::move(result) : Value{};
+}
+
+inline Value callResult(Activation& activation, const Value& callee, Arguments arguments, const char* mark)
+{
+  expect(callee, Type::Function, "function call", mark);
+  return callValue(activation, "result", callee, arguments, mark);
+}
+
+inline Value callLambda(Activation& activation, const Parameters* parameters, Body body, Arguments arguments)
+{
+  auto& context = activation.context;
+  bindArguments(context, *parameters, arguments);
+  auto result = callBody(body, activation);
+  context.leaveScope();
+  return result;
+}
+
+/*
+ * Declares globals and functions of the program, then calls main in a scope of its own.
+ * Output is printed only if the program finishes without error, the value returned
+ * by main is the exit code.
+ */
+inline int run(Body program, int main)
+{
+  Context context{};
+  std::string output{};
+  Activation global{context, output};
+
+  try
+  {
+    program(global);
+
+    const auto symbol = context.lookup(main);
+    context.enterScope();
+    const auto result = callBody(symbol->body, global);
+    context.leaveScope();
+
+    std::cout << output;
+    return static_cast<int>(result.number);
+  }
+  catch(std::runtime_error& error)
+  {
+    std::cout << error.what() << "\n";
+  }
+
+  return 0;
+}
+
+}
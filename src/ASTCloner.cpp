@@ -0,0 +1,130 @@
+#include "ASTCloner.hpp"
+
+#include "NumericNodes.hpp"
+
+std::list<std::shared_ptr<ExpressionNode>> 
+ASTCloner::cloneArguments(const std::list<std::shared_ptr<ExpressionNode>>& args)
+{
+  std::list<std::shared_ptr<ExpressionNode>> result{};
+  for(const auto& arg : args)
+    result.push_back(clone<ExpressionNode>(*arg));
+  return result;
+}
+
+void ASTCloner::visit(const AssignmentNode& node)
+{
+  auto value = clone<ExpressionNode>(*node.getValue());
+  setResult(std::make_unique<AssignmentNode>(node.getName(), node.getOperation(), std::move(value)), node);
+}
+
+void ASTCloner::visit(const BinaryOpNode& node)
+{
+  auto left = clone<ExpressionNode>(node.getLeftOperand());
+  auto right = clone<ExpressionNode>(node.getRightOperand());
+  setResult(std::make_unique<BinaryOpNode>(std::move(left), node.getOperation(), std::move(right)), node);
+}
+
+void ASTCloner::visit(const NumericBinaryOpNode& node)
+{
+  auto left = clone<ExpressionNode>(node.getLeftOperand());
+  auto right = clone<ExpressionNode>(node.getRightOperand());
+  setResult(makeNumericBinaryNode(std::move(left), node.getOperation(), std::move(right), node.isInteger()), node);
+}
+
+void ASTCloner::visit(const LoopNode& node)
+{
+  ASTCloner cloner{};
+  auto branch = cloner.clone<FunctionCallNode>(static_cast<const FunctionCallNode&>(node.getValue()));
+  setResult(std::make_unique<LoopNode>(std::move(branch), node.getParameters(), node.recursesWhenTrue()), node);
+}
+
+void ASTCloner::visit(const BlockNode& node)
+{
+  auto block = std::make_unique<BlockNode>();
+  for(const auto& statement : node.getStatements())
+    block->addStatement(clone<StatementNode>(*statement));
+  setResult(std::move(block), node);
+}
+
+void ASTCloner::visit(const FunctionCallNode& node)
+{
+  auto args = cloneArguments(node.getArguments());
+  setResult(std::make_unique<FunctionCallNode>(node.getName(), std::move(args)), node);
+}
+
+void ASTCloner::visit(const FunctionCallStatementNode& node)
+{
+  auto call = clone<ExpressionNode>(node.getFunctionCall());
+  setResult(std::make_unique<FunctionCallStatementNode>(std::move(call)), node);
+}
+
+void ASTCloner::visit(const FunctionDeclarationNode& node)
+{
+  auto body = clone<BlockNode>(*node.getBody());
+  setResult(std::make_unique<FunctionDeclarationNode>(node.getName(), 
+    node.getReturnType(), node.getArguments(), std::move(body)), node);
+}
+
+void ASTCloner::visit(const FunctionResultCallNode& node)
+{
+  auto call = clone<ExpressionNode>(node.getCall());
+  auto args = cloneArguments(node.getArguments());
+  setResult(std::make_unique<FunctionResultCallNode>(std::move(call), std::move(args)), node);
+}
+
+void ASTCloner::visit(const LambdaCallNode& node)
+{
+  auto lambda = clone<LambdaNode>(node.getLambda());
+  auto args = cloneArguments(node.getArguments());
+  setResult(std::make_unique<LambdaCallNode>(std::move(lambda), std::move(args)), node);
+}
+
+void ASTCloner::visit(const LambdaNode& node)
+{
+  std::shared_ptr<BlockNode> body = clone<BlockNode>(node.getBody());
+  setResult(std::make_unique<LambdaNode>(node.getReturnType(), node.getArguments(), std::move(body)), node);
+}
+
+void ASTCloner::visit(const NumericLiteralNode& node)
+{
+  setResult(std::make_unique<NumericLiteralNode>(node.getValue()), node);
+}
+
+void ASTCloner::visit(const ProgramNode& node)
+{
+  auto program = std::make_unique<ProgramNode>();
+  for(const auto& variable : node.getVariables())
+    program->addVariable(clone<VariableDeclarationNode>(*variable));
+  for(const auto& function : node.getFunctions())
+    program->addFunction(clone<FunctionDeclarationNode>(*function));
+  setResult(std::move(program), node);
+}
+
+void ASTCloner::visit(const ReturnNode& node)
+{
+  auto value = clone<ExpressionNode>(node.getValue());
+  setResult(std::make_unique<ReturnNode>(std::move(value)), node);
+}
+
+void ASTCloner::visit(const StringLiteralNode& node)
+{
+  setResult(std::make_unique<StringLiteralNode>(node.getValue()), node);
+}
+
+void ASTCloner::visit(const UnaryNode& node)
+{
+  auto term = clone<ExpressionNode>(node.getTerm());
+  setResult(std::make_unique<UnaryNode>(node.getOperation(), std::move(term)), node);
+}
+
+void ASTCloner::visit(const VariableDeclarationNode& node)
+{
+  auto value = clone<ExpressionNode>(*node.getValue());
+  setResult(std::make_unique<VariableDeclarationNode>(node.getName(), 
+    node.getType(), std::move(value), node.isShared()), node);
+}
+
+void ASTCloner::visit(const VariableNode& node)
+{
+  setResult(std::make_unique<VariableNode>(node.getName()), node);
+}
@@ -0,0 +1,193 @@
+#include "ASTHasher.hpp"
+
+#include <cstring>
+
+#include "AST.hpp"
+
+namespace
+{
+
+const std::uint64_t FnvOffsetBasis = 14695981039346656037ull;
+const std::uint64_t FnvPrime = 1099511628211ull;
+
+enum class NodeTag : std::uint64_t
+{
+  Assignment = 1,
+  BinaryOp,
+  Block,
+  FunctionCall,
+  FunctionCallStatement,
+  FunctionDeclaration,
+  FunctionResultCall,
+  LambdaCall,
+  Lambda,
+  NumericLiteral,
+  Program,
+  Return,
+  StringLiteral,
+  Unary,
+  VariableDeclaration,
+  Variable
+};
+
+}
+
+ASTHasher::ASTHasher(): hash_(FnvOffsetBasis) {}
+
+void ASTHasher::add(std::uint64_t value)
+{
+  for(int i = 0; i < 8; ++i)
+  {
+    hash_ ^= (value >> (8 * i)) & 0xff;
+    hash_ *= FnvPrime;
+  }
+}
+
+void ASTHasher::add(double value)
+{
+  std::uint64_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  add(bits);
+}
+
+void ASTHasher::add(const std::string& value)
+{
+  add(static_cast<std::uint64_t>(value.size()));
+  for(const auto c : value)
+  {
+    hash_ ^= static_cast<unsigned char>(c);
+    hash_ *= FnvPrime;
+  }
+}
+
+void ASTHasher::visit(const AssignmentNode& node)
+{
+  add(static_cast<std::uint64_t>(NodeTag::Assignment));
+  add(node.getName());
+  add(static_cast<std::uint64_t>(node.getOperation()));
+  node.getValue()->accept(*this);
+}
+
+void ASTHasher::visit(const BinaryOpNode& node)
+{
+  add(static_cast<std::uint64_t>(NodeTag::BinaryOp));
+  add(static_cast<std::uint64_t>(node.getOperation()));
+  node.getLeftOperand().accept(*this);
+  node.getRightOperand().accept(*this);
+}
+
+void ASTHasher::visit(const BlockNode& node)
+{
+  add(static_cast<std::uint64_t>(NodeTag::Block));
+  add(static_cast<std::uint64_t>(node.getStatements().size()));
+  for(const auto& statement : node.getStatements())
+    statement->accept(*this);
+}
+
+void ASTHasher::visit(const FunctionCallNode& node)
+{
+  add(static_cast<std::uint64_t>(NodeTag::FunctionCall));
+  add(node.getName());
+  add(static_cast<std::uint64_t>(node.getArguments().size()));
+  for(const auto& arg : node.getArguments())
+    arg->accept(*this);
+}
+
+void ASTHasher::visit(const FunctionCallStatementNode& node)
+{
+  add(static_cast<std::uint64_t>(NodeTag::FunctionCallStatement));
+  node.getFunctionCall().accept(*this);
+}
+
+void ASTHasher::visit(const FunctionDeclarationNode& node)
+{
+  add(static_cast<std::uint64_t>(NodeTag::FunctionDeclaration));
+  add(node.getName());
+  add(static_cast<std::uint64_t>(node.getReturnType()));
+  add(static_cast<std::uint64_t>(node.getArguments().size()));
+  for(const auto& arg : node.getArguments())
+  {
+    add(arg.first);
+    add(static_cast<std::uint64_t>(arg.second));
+  }
+  node.getBody()->accept(*this);
+}
+
+void ASTHasher::visit(const FunctionResultCallNode& node)
+{
+  add(static_cast<std::uint64_t>(NodeTag::FunctionResultCall));
+  node.getCall().accept(*this);
+  add(static_cast<std::uint64_t>(node.getArguments().size()));
+  for(const auto& arg : node.getArguments())
+    arg->accept(*this);
+}
+
+void ASTHasher::visit(const LambdaCallNode& node)
+{
+  add(static_cast<std::uint64_t>(NodeTag::LambdaCall));
+  node.getLambda().accept(*this);
+  add(static_cast<std::uint64_t>(node.getArguments().size()));
+  for(const auto& arg : node.getArguments())
+    arg->accept(*this);
+}
+
+void ASTHasher::visit(const LambdaNode& node)
+{
+  add(static_cast<std::uint64_t>(NodeTag::Lambda));
+  add(static_cast<std::uint64_t>(node.getReturnType()));
+  add(static_cast<std::uint64_t>(node.getArguments().size()));
+  for(const auto& arg : node.getArguments())
+  {
+    add(arg.first);
+    add(static_cast<std::uint64_t>(arg.second));
+  }
+  node.getBody().accept(*this);
+}
+
+void ASTHasher::visit(const NumericLiteralNode& node)
+{
+  add(static_cast<std::uint64_t>(NodeTag::NumericLiteral));
+  add(node.getValue());
+}
+
+void ASTHasher::visit(const ProgramNode& node)
+{
+  add(static_cast<std::uint64_t>(NodeTag::Program));
+  for(const auto& variable : node.getVariables())
+    variable->accept(*this);
+  for(const auto& function : node.getFunctions())
+    function->accept(*this);
+}
+
+void ASTHasher::visit(const ReturnNode& node)
+{
+  add(static_cast<std::uint64_t>(NodeTag::Return));
+  node.getValue().accept(*this);
+}
+
+void ASTHasher::visit(const StringLiteralNode& node)
+{
+  add(static_cast<std::uint64_t>(NodeTag::StringLiteral));
+  add(node.getValue());
+}
+
+void ASTHasher::visit(const UnaryNode& node)
+{
+  add(static_cast<std::uint64_t>(NodeTag::Unary));
+  add(static_cast<std::uint64_t>(node.getOperation()));
+  node.getTerm().accept(*this);
+}
+
+void ASTHasher::visit(const VariableDeclarationNode& node)
+{
+  add(static_cast<std::uint64_t>(NodeTag::VariableDeclaration));
+  add(node.getName());
+  add(static_cast<std::uint64_t>(node.getType()));
+  node.getValue()->accept(*this);
+}
+
+void ASTHasher::visit(const VariableNode& node)
+{
+  add(static_cast<std::uint64_t>(NodeTag::Variable));
+  add(node.getName());
+}
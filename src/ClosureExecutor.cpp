@@ -0,0 +1,647 @@
+#include "ClosureExecutor.hpp"
+
+#include <vector>
+
+#include "Common.hpp"
+#include "Operators.hpp"
+#include "AST.hpp"
+#include "LoopEvaluator.hpp"
+#include "ReassignmentAnalyser.hpp"
+#include "ValueOperations.hpp"
+
+namespace
+{
+
+using Code = ClosureExecutor::Code;
+
+// Value of numeric type is always a Number.
+double getNumber(const Value& value)
+{
+  return static_cast<const Number&>(value).getValue();
+}
+
+template<BinaryOperator Op>
+Code compileBinary(const BinaryOpNode& node, const Code* left, const Code* right)
+{
+  return [&node, left, right](ClosureExecutor::Activation& activation) -> std::unique_ptr<Value> {
+    const auto l = (*left)(activation);
+    const auto r = (*right)(activation);
+    if(l->getType() == TypeName::F32 && r->getType() == TypeName::F32)
+      return std::make_unique<Number>(evaluateBinary(Op, getNumber(*l), getNumber(*r)));
+    return applyBinaryOperation(node, *l, *r);
+  };
+}
+
+template<UnaryOperator Op>
+Code compileUnary(const UnaryNode& node, const Code* term)
+{
+  return [&node, term](ClosureExecutor::Activation& activation) -> std::unique_ptr<Value> {
+    const auto value = (*term)(activation);
+    if(value->getType() == TypeName::F32)
+      return std::make_unique<Number>(evaluateUnary(Op, getNumber(*value)));
+    return applyUnaryOperation(node, *value);
+  };
+}
+
+}
+
+/*
+ * Builds closure of a single node. Closures of children are compiled through
+ * the executor, which keeps them for the whole run, so they are referred to
+ * by pointers.
+ */
+class ClosureCompiler : public Visitor
+{
+public:
+  ClosureCompiler(ClosureExecutor& executor): code(), executor_(executor) {}
+
+  Code code;
+
+  void visit(const AssignmentNode& node) override
+  {
+    const auto executor = &executor_;
+    executor_.compile(*node.getValue());
+
+    code = [executor, &node](ClosureExecutor::Activation& activation) -> std::unique_ptr<Value> {
+      executor->assign(node, activation);
+      return nullptr;
+    };
+  }
+
+  void visit(const BinaryOpNode& node) override
+  {
+    const auto left = &executor_.compile(node.getLeftOperand());
+    const auto right = &executor_.compile(node.getRightOperand());
+
+    switch(node.getOperation())
+    {
+      case BinaryOperator::Addition: code = compileBinary<BinaryOperator::Addition>(node, left, right); break;
+      case BinaryOperator::Subtraction: code = compileBinary<BinaryOperator::Subtraction>(node, left, right); break;
+      case BinaryOperator::Multiplication: code = compileBinary<BinaryOperator::Multiplication>(node, left, right); break;
+      case BinaryOperator::Division: code = compileBinary<BinaryOperator::Division>(node, left, right); break;
+      case BinaryOperator::Modulo: code = compileBinary<BinaryOperator::Modulo>(node, left, right); break;
+      case BinaryOperator::LogicalAnd: code = compileBinary<BinaryOperator::LogicalAnd>(node, left, right); break;
+      case BinaryOperator::LogicalOr: code = compileBinary<BinaryOperator::LogicalOr>(node, left, right); break;
+      case BinaryOperator::BinaryAnd: code = compileBinary<BinaryOperator::BinaryAnd>(node, left, right); break;
+      case BinaryOperator::BinaryOr: code = compileBinary<BinaryOperator::BinaryOr>(node, left, right); break;
+      case BinaryOperator::BinaryXor: code = compileBinary<BinaryOperator::BinaryXor>(node, left, right); break;
+      case BinaryOperator::ShiftLeft: code = compileBinary<BinaryOperator::ShiftLeft>(node, left, right); break;
+      case BinaryOperator::ShiftRight: code = compileBinary<BinaryOperator::ShiftRight>(node, left, right); break;
+      case BinaryOperator::Greater: code = compileBinary<BinaryOperator::Greater>(node, left, right); break;
+      case BinaryOperator::GreaterEq: code = compileBinary<BinaryOperator::GreaterEq>(node, left, right); break;
+      case BinaryOperator::Less: code = compileBinary<BinaryOperator::Less>(node, left, right); break;
+      case BinaryOperator::LessEq: code = compileBinary<BinaryOperator::LessEq>(node, left, right); break;
+      case BinaryOperator::Equal: code = compileBinary<BinaryOperator::Equal>(node, left, right); break;
+      case BinaryOperator::NotEqual: code = compileBinary<BinaryOperator::NotEqual>(node, left, right); break;
+    }
+  }
+
+  // Body stops at the first return, the value it returned is the value of the body.
+  void visit(const BlockNode& node) override
+  {
+    std::vector<const Code*> statements{};
+    for(const auto& statement : node.getStatements())
+      statements.push_back(&executor_.compile(*statement));
+
+    code = [statements](ClosureExecutor::Activation& activation) -> std::unique_ptr<Value> {
+      for(const auto statement : statements)
+      {
+        (*statement)(activation);
+        if(activation.returned)
+          break;
+      }
+      return nullptr;
+    };
+  }
+
+  void visit(const FunctionCallNode& node) override
+  {
+    std::vector<const Code*> args{};
+    for(const auto& arg : node.getArguments())
+      args.push_back(&executor_.compile(*arg));
+
+    const auto& name = node.getName();
+    if(name == "print")
+    {
+      const auto value = args.front();
+      code = [&node, value](ClosureExecutor::Activation& activation) -> std::unique_ptr<Value> {
+        const auto str = (*value)(activation);
+        if(str->getType() != TypeName::String)
+          reportError("Function print expected string, but got " +
+            TypeNameStrings.at(str->getType()) + "!", node);
+
+        activation.output += static_cast<const String&>(*str).getValue();
+        activation.output += "\n";
+        return nullptr;
+      };
+    }
+    else if(name == "if")
+    {
+      const auto condition = args[0];
+      const auto onTrue = args[1];
+      const auto onFalse = args.back();
+      code = [&node, condition, onTrue, onFalse](ClosureExecutor::Activation& activation) {
+        const auto value = (*condition)(activation);
+        if(value->getType() != TypeName::F32)
+          reportError("Function if expected logical expression, but got " +
+                      TypeNameStrings.at(value->getType()) + "!", node);
+
+        return isTrue(getNumber(*value)) ? (*onTrue)(activation) : (*onFalse)(activation);
+      };
+    }
+    else
+    {
+      const auto executor = &executor_;
+      code = [executor, &node](ClosureExecutor::Activation& activation) {
+        return executor->call(node, activation);
+      };
+    }
+  }
+
+  void visit(const FunctionCallStatementNode& node) override
+  {
+    const auto call = &executor_.compile(node.getFunctionCall());
+    code = [call](ClosureExecutor::Activation& activation) -> std::unique_ptr<Value> {
+      (*call)(activation);
+      return nullptr;
+    };
+  }
+
+  void visit(const FunctionDeclarationNode& node) override
+  {
+    executor_.compile(*node.getBody());
+
+    code = [&node](ClosureExecutor::Activation& activation) -> std::unique_ptr<Value> {
+      auto symbol = std::make_unique<RuntimeFunctionSymbol>(node.getName(), node.getReturnType(), node.getBody());
+      for(const auto& arg : node.getArguments())
+        symbol->addArgument(RuntimeFunctionSymbol::Argument{arg.first, arg.second});
+
+      activation.context.addSymbol(node.getName(), std::move(symbol));
+      return nullptr;
+    };
+  }
+
+  void visit(const FunctionResultCallNode& node) override
+  {
+    for(const auto& arg : node.getArguments())
+      executor_.compile(*arg);
+
+    const auto executor = &executor_;
+    const auto call = &executor_.compile(node.getCall());
+    code = [executor, &node, call](ClosureExecutor::Activation& activation) {
+      const auto callee = (*call)(activation);
+      assertValueType(*callee, TypeName::Function, "function call", node);
+      return executor->callValue(node, "result", *callee, activation);
+    };
+  }
+
+  void visit(const LambdaCallNode& node) override
+  {
+    for(const auto& arg : node.getArguments())
+      executor_.compile(*arg);
+
+    const auto executor = &executor_;
+    const auto& lambda = node.getLambda();
+    const auto body = &executor_.compile(lambda.getBody());
+    code = [executor, &node, &lambda, body](ClosureExecutor::Activation& activation) {
+      auto& context = activation.context;
+      executor->bindArguments(node, lambda.getArguments(), context);
+
+      ClosureExecutor::Activation callee{context, activation.output};
+      (*body)(callee);
+
+      context.leaveScope();
+      return std::move(callee.result);
+    };
+  }
+
+  void visit(const LambdaNode& node) override
+  {
+    executor_.compile(node.getBody());
+
+    code = [&node](ClosureExecutor::Activation& activation) -> std::unique_ptr<Value> {
+      return std::make_unique<Function>(node.getReturnType(),
+        node.getArguments(), node.getBodyPtr(), activation.context.clone());
+    };
+  }
+
+  void visit(const NumericLiteralNode& node) override
+  {
+    const auto value = node.getValue();
+    code = [value](ClosureExecutor::Activation&) -> std::unique_ptr<Value> {
+      return std::make_unique<Number>(value);
+    };
+  }
+
+  void visit(const ProgramNode& node) override
+  {
+    for(const auto& variable : node.getVariables())
+      executor_.compile(*variable);
+    for(const auto& function : node.getFunctions())
+      executor_.compile(*function);
+  }
+
+  void visit(const ReturnNode& node) override
+  {
+    const auto value = &executor_.compile(node.getValue());
+    code = [value](ClosureExecutor::Activation& activation) -> std::unique_ptr<Value> {
+      activation.result = (*value)(activation);
+      activation.returned = true;
+      return nullptr;
+    };
+  }
+
+  // Loop runs as in Executor, parameters it needs are read like variables.
+  void visit(const LoopNode& node) override
+  {
+    visit(static_cast<const ReturnNode&>(node));
+    auto recursive = std::move(code);
+    const auto result = &executor_.compile(node.getResult());
+    const auto executor = &executor_;
+    code = [executor, &node, recursive, result](ClosureExecutor::Activation& activation) -> std::unique_ptr<Value> {
+      LoopEvaluator loop{node};
+      while(const auto variable = loop.run())
+      {
+        const auto value = executor->readVariable(*variable, activation);
+        if(value->getType() != TypeName::F32)
+          return recursive(activation);
+        loop.setValue(getNumber(*value));
+      }
+
+      if(loop.hasIterated())
+      {
+        activation.context.enterScope();
+        loop.bindParameters(activation.context);
+        activation.result = (*result)(activation);
+        activation.context.leaveScope();
+      }
+      else
+        activation.result = (*result)(activation);
+      activation.returned = true;
+      return nullptr;
+    };
+  }
+
+  void visit(const StringLiteralNode& node) override
+  {
+    const auto value = node.getValue();
+    code = [value](ClosureExecutor::Activation&) -> std::unique_ptr<Value> {
+      return std::make_unique<String>(value);
+    };
+  }
+
+  void visit(const UnaryNode& node) override
+  {
+    const auto term = &executor_.compile(node.getTerm());
+    switch(node.getOperation())
+    {
+      case UnaryOperator::BinaryNegation: code = compileUnary<UnaryOperator::BinaryNegation>(node, term); break;
+      case UnaryOperator::Minus: code = compileUnary<UnaryOperator::Minus>(node, term); break;
+      case UnaryOperator::LogicalNot: code = compileUnary<UnaryOperator::LogicalNot>(node, term); break;
+    }
+  }
+
+  void visit(const VariableDeclarationNode& node) override
+  {
+    executor_.compile(*node.getValue());
+
+    const auto executor = &executor_;
+    code = [executor, &node](ClosureExecutor::Activation& activation) -> std::unique_ptr<Value> {
+      auto& context = activation.context;
+      auto cell = node.isShared() ? std::make_shared<ValueCell>() : nullptr;
+      const auto& speculator = executor->speculator_;
+      auto literal = speculator ? speculator->speculate(node.getValue(), context) : nullptr;
+      auto symbol = literal && !speculator->isReassigned(node.getName()) ?
+        std::make_unique<RuntimeVariableSymbol>(node.getName(), node.getType(), std::move(literal),
+          speculator->getContext(), std::move(cell)) :
+        std::make_unique<RuntimeVariableSymbol>(node.getName(), node.getType(), literal ? literal : node.getValue(),
+          context.clone(), std::move(cell));
+      symbol->setMark(node.getMark());
+      context.addSymbol(node.getName(), std::move(symbol));
+      return nullptr;
+    };
+  }
+
+  void visit(const VariableNode& node) override
+  {
+    const auto executor = &executor_;
+    code = [executor, &node](ClosureExecutor::Activation& activation) {
+      return executor->readVariable(node, activation);
+    };
+  }
+
+  void visit(const NumericBinaryOpNode& node) override
+  {
+    visit(static_cast<const BinaryOpNode&>(node));
+  }
+
+private:
+  ClosureExecutor& executor_;
+};
+
+ClosureExecutor::ClosureExecutor(const ExecutorOptions& options):
+  code_(), context_(), value_(), stdout_(), discarded_(), exitCode_(0), memoTable_(), jit_(), speculator_(),
+  reassigned_(), forced_()
+{
+  if(options.memoize)
+    memoTable_ = std::make_shared<MemoTable>(options.memoCapacity);
+  if(options.jit)
+    jit_ = std::make_shared<JitCompiler>(options.feedback);
+  if(options.speculate)
+    speculator_ = std::make_shared<Speculator>(options.speculationBudget, options.feedback);
+}
+
+const ClosureExecutor::Code& ClosureExecutor::compile(const Node& node)
+{
+  const auto it = code_.find(&node);
+  if(it != code_.end())
+    return it->second;
+
+  ClosureCompiler compiler{*this};
+  node.accept(compiler);
+  return code_[&node] = std::move(compiler.code);
+}
+
+void ClosureExecutor::evaluate(const Node& node)
+{
+  Activation activation{context_, stdout_};
+  value_ = compile(node)(activation);
+}
+
+/*
+ * Nodes created during evaluation (values of compound assignments and memoized
+ * arguments) are compiled each time, as their addresses can be reused.
+ */
+std::unique_ptr<Value> ClosureExecutor::run(const Node& node, Activation& activation)
+{
+  const auto it = code_.find(&node);
+  if(it != code_.end())
+    return it->second(activation);
+
+  ClosureCompiler compiler{*this};
+  node.accept(compiler);
+  return compiler.code(activation);
+}
+
+void ClosureExecutor::visit(const ProgramNode& node)
+{
+  ClosureCompiler compiler{*this};
+  node.accept(compiler);
+
+  if(memoTable_)
+    registerMemoizableFunctions(*memoTable_, node);
+  if(jit_)
+    jit_->compile(node);
+  if(speculator_)
+    speculator_->addProgram(node);
+  reassigned_ = findReassignedNames(node);
+
+  Activation global{context_, stdout_};
+  for(const auto& variable : node.getVariables())
+    run(*variable, global);
+
+  for(const auto& function : node.getFunctions())
+    run(*function, global);
+
+  const auto mainSymbol = context_.lookup("main");
+  auto functionAnalyser = RuntimeFunctionAnalyser{};
+  mainSymbol.value().get().accept(functionAnalyser);
+
+  context_.enterScope();
+  value_ = callBody(*functionAnalyser.getBody(), global);
+  context_.leaveScope();
+
+  NumberValueAnalyser valueAnalyser{};
+  value_->accept(valueAnalyser);
+  exitCode_ = valueAnalyser.getValue().value();
+}
+
+std::unique_ptr<Value> ClosureExecutor::readVariable(const VariableNode& node, Activation& activation)
+{
+  const auto& name = node.getName();
+  const auto symbol = activation.context.lookup(name);
+
+  if(!symbol)
+    reportError("Dereferencing invalid symbol " + name + "!", node);
+
+  RuntimeVariableAnalyser analyser{};
+  symbol.value().get().accept(analyser);
+
+  if(analyser.isSymbolValid())
+  {
+    const auto& cell = analyser.getCell();
+    if(cell && cell->value)
+      return cell->value->clone();
+
+    auto value = force(analyser);
+    if(cell)
+      cell->value = value->clone();
+    return value;
+  }
+
+  RuntimeFunctionAnalyser functionAnalyser{};
+  symbol.value().get().accept(functionAnalyser);
+
+  return std::make_unique<Function>(functionAnalyser.getReturnType().value(), functionAnalyser.getArguments(),
+    functionAnalyser.getBody(), activation.context.clone());
+}
+
+/*
+ * Expression of variable is evaluated in a copy of its captured context, its output is dropped.
+ * Variable which depends on itself is reported, as Executor does.
+ */
+std::unique_ptr<Value> ClosureExecutor::force(const RuntimeVariableAnalyser& variable)
+{
+  ForcedVariableGuard guard{forced_, variable};
+  Context context{variable.getContext()};
+  Activation activation{context, discarded_};
+  auto value = run(*variable.getValue(), activation);
+  discarded_.clear();
+  return value;
+}
+
+std::unique_ptr<Value> ClosureExecutor::call(const FunctionCallNode& node, Activation& activation)
+{
+  const auto symbol = activation.context.lookup(node.getName());
+  RuntimeFunctionAnalyser functionAnalyser{};
+  symbol.value().get().accept(functionAnalyser);
+
+  if(functionAnalyser.isSymbolValid())
+    return callFunction(node, functionAnalyser, activation);
+
+  RuntimeVariableAnalyser variableAnalyser{};
+  symbol.value().get().accept(variableAnalyser);
+  const auto callee = force(variableAnalyser);
+
+  return callValue(node, node.getName(), *callee, activation);
+}
+
+std::unique_ptr<Value> ClosureExecutor::callFunction(const FunctionCallNode& node,
+  const RuntimeFunctionAnalyser& function, Activation& activation)
+{
+  const auto& body = *function.getBody();
+  if(memoTable_ && memoTable_->isMemoizable(&body))
+    return callMemoized(node, function, activation);
+
+  const auto native = jit_ ? jit_->lookup(&body) : nullptr;
+  if(native)
+    return std::make_unique<Number>(native(forceArguments(node, activation.context).data()));
+
+  auto& context = activation.context;
+  bindArguments(node, function.getArguments(), context);
+  auto result = callBody(body, activation);
+  context.leaveScope();
+
+  return function.getReturnType() != TypeName::Void ? std::move(result) : nullptr;
+}
+
+std::unique_ptr<Value> ClosureExecutor::callMemoized(const FunctionCallNode& node,
+  const RuntimeFunctionAnalyser& function, Activation& activation)
+{
+  auto& context = activation.context;
+  const auto arguments = forceArguments(node, context);
+
+  const auto body = function.getBody().get();
+  const auto cached = memoTable_->lookup(body, arguments);
+  if(cached.has_value())
+    return std::make_unique<Number>(cached.value());
+
+  context.enterScope();
+
+  auto it = arguments.begin();
+  for(const auto& arg : function.getArguments())
+  {
+    auto value = std::make_shared<NumericLiteralNode>(*it);
+    context.addSymbol(arg.first, std::make_unique<RuntimeVariableSymbol>(arg.first, arg.second, value, Context{}));
+
+    ++it;
+  }
+
+  auto result = callBody(*body, activation);
+  context.leaveScope();
+
+  if(result->getType() == TypeName::F32)
+    memoTable_->insert(body, arguments, getNumber(*result));
+  return result;
+}
+
+/*
+ * Memoizable (and compiled) functions are strict in all of their numeric arguments,
+ * which are forced in the caller's context before the call, as Executor does.
+ */
+std::vector<double> ClosureExecutor::forceArguments(const FunctionCallNode& node, Context& context)
+{
+  std::vector<double> arguments{};
+  for(const auto& arg : node.getArguments())
+  {
+    Activation argument{context, discarded_};
+    const auto value = run(*arg, argument);
+    assertValueType(*value, TypeName::F32, "function call", node);
+    arguments.push_back(getNumber(*value));
+  }
+  return arguments;
+}
+
+std::unique_ptr<Value> ClosureExecutor::callValue(const CallNode& node, const std::string& name, const Value& value,
+  Activation& activation)
+{
+  const auto& function = resolveCallee(node, name, value);
+
+  Context context = function.getContext().clone();
+  context.enterScope();
+
+  auto it = node.getArguments().begin();
+  for(const auto& arg : function.getArguments())
+  {
+    std::shared_ptr<const Context> argContext{};
+    context.addSymbol(arg.first, bindArgument(arg, *it, context, argContext));
+    ++it;
+  }
+
+  Activation callee{context, activation.output};
+  auto result = callBody(function.getBody(), callee);
+
+  return function.getReturnType() != TypeName::Void ? std::move(result) : nullptr;
+}
+
+// Body runs in context of the activation, but returns on its own.
+std::unique_ptr<Value> ClosureExecutor::callBody(const BlockNode& body, Activation& activation)
+{
+  Activation callee{activation.context, activation.output};
+  run(body, callee);
+  return std::move(callee.result);
+}
+
+void ClosureExecutor::bindArguments(const CallNode& node, const std::list<std::pair<std::string, TypeName>>& parameters,
+  Context& context)
+{
+  // Arguments are evaluated in the caller's context, without any of the parameters.
+  std::vector<std::unique_ptr<RuntimeVariableSymbol>> arguments{};
+  std::shared_ptr<const Context> argContext{};
+  auto it = node.getArguments().begin();
+  for(const auto& parameter : parameters)
+  {
+    arguments.push_back(bindArgument(parameter, *it, context, argContext));
+    ++it;
+  }
+
+  context.enterScope();
+  for(auto& argument : arguments)
+  {
+    const auto name = argument->getName();
+    context.addSymbol(name, std::move(argument));
+  }
+}
+
+// Binds speculated value of the argument if there is one, otherwise its expression in a copy of given context.
+std::unique_ptr<RuntimeVariableSymbol> ClosureExecutor::bindArgument(const std::pair<std::string, TypeName>& parameter,
+  const std::shared_ptr<ExpressionNode>& value, const Context& context, std::shared_ptr<const Context>& argContext)
+{
+  // Reassigned parameter evaluates its new expression in the context of the argument.
+  if(reassigned_.count(parameter.first) == 0)
+  {
+    auto symbol = bindDirectly(parameter, value, context);
+    if(symbol)
+      return symbol;
+  }
+
+  auto literal = speculator_ ? speculator_->speculate(value, context) : nullptr;
+  if(literal && !speculator_->isReassigned(parameter.first))
+    return std::make_unique<RuntimeVariableSymbol>(parameter.first, parameter.second, std::move(literal),
+      speculator_->getContext(), nullptr);
+
+  if(!argContext)
+    argContext = std::make_shared<const Context>(context.clone());
+  return std::make_unique<RuntimeVariableSymbol>(parameter.first, parameter.second, literal ? std::move(literal) : value,
+    argContext, nullptr);
+}
+
+void ClosureExecutor::assign(const AssignmentNode& node, Activation& activation)
+{
+  if(node.getOperation() == AssignmentOperator::Assign)
+  {
+    ValueChanger valueChanger{node.getValue(), node.getMark()};
+    activation.context.lookupForUpdate(node.getName()).value().get().accept(valueChanger);
+    return;
+  }
+
+  const auto activity = "assignment operation " + AssignmentOperationNames.at(node.getOperation());
+
+  double oldValue = 0;
+  {
+    // Variable which was forced or updated before is read straight from its cell.
+    RuntimeVariableAnalyser analyser{};
+    activation.context.lookup(node.getName()).value().get().accept(analyser);
+    const auto& cell = analyser.getCell();
+    const auto forced = cell && cell->value ? nullptr : force(analyser);
+    const auto& value = forced ? *forced : *cell->value;
+    assertValueType(value, TypeName::F32, activity, node);
+    oldValue = getNumber(value);
+  }
+
+  const auto rhs = run(*node.getValue(), activation);
+  assertValueType(*rhs, TypeName::F32, activity, node);
+
+  NumberChanger numberChanger{evaluateAssignment(node.getOperation(), oldValue, getNumber(*rhs))};
+  activation.context.lookupForUpdate(node.getName()).value().get().accept(numberChanger);
+}
@@ -7,7 +7,12 @@
 [[noreturn]]
 void reportError(const std::string& message, const Node& node)
 {
-  const auto mark = node.getMark();
+  reportError(message, node.getMark());
+}
+
+[[noreturn]]
+void reportError(const std::string& message, const Mark& mark)
+{
   std::stringstream ss;
   ss << "ERROR (" << mark.to_string() << "): " << message;
   throw std::runtime_error(ss.str());
@@ -0,0 +1,454 @@
+#include "CommonSubexpressionEliminator.hpp"
+
+#include <algorithm>
+#include <optional>
+#include <sstream>
+
+namespace
+{
+
+using Locals = std::map<std::string, TypeName>;
+
+const std::string TemporaryPrefix = "$cse";
+
+struct Environment
+{
+  const Locals& locals;
+  const std::set<std::string>& functions;
+  const std::set<std::string>& numericFunctions;
+  const PurityAnalyser& purity;
+};
+
+/*
+ * Builds structural key of an expression which can be replaced by a temporary. Such
+ * expression consists only of literals, local f32 variables, arithmetic, if and calls
+ * of pure numeric functions.
+ */
+class CandidateAnalyser : public Visitor
+{
+public:
+  CandidateAnalyser(const Environment& environment):
+    environment_(environment), key_(), eligible_(true), computes_(false), dependent_(false), size_(0), references_() {}
+
+  bool isEligible() const { return eligible_; }
+  // Only expressions that compute something out of variables or calls are worth sharing.
+  bool isWorthwhile() const { return eligible_ && computes_ && dependent_; }
+  std::string getKey() const { return key_.str(); }
+  std::size_t getSize() const { return size_; }
+  const std::set<std::string>& getReferences() const { return references_; }
+
+  void visit(const AssignmentNode&) override { eligible_ = false; }
+
+  void visit(const BinaryOpNode& node) override
+  {
+    key_ << "b" << static_cast<int>(node.getOperation()) << "(";
+    node.getLeftOperand().accept(*this);
+    key_ << ",";
+    node.getRightOperand().accept(*this);
+    key_ << ")";
+    computes_ = true;
+    ++size_;
+  }
+
+  void visit(const BlockNode&) override { eligible_ = false; }
+
+  void visit(const FunctionCallNode& node) override
+  {
+    const auto& name = node.getName();
+    const auto isFunction = environment_.numericFunctions.find(name) != environment_.numericFunctions.end() &&
+      environment_.locals.find(name) == environment_.locals.end();
+    if(name != "if" && !isFunction)
+    {
+      eligible_ = false;
+      return;
+    }
+
+    key_ << "c" << name << "(";
+    for(const auto& arg : node.getArguments())
+    {
+      arg->accept(*this);
+      key_ << ",";
+    }
+    key_ << ")";
+    computes_ = true;
+    dependent_ = dependent_ || name != "if";
+    ++size_;
+  }
+
+  void visit(const FunctionCallStatementNode&) override { eligible_ = false; }
+  void visit(const FunctionDeclarationNode&) override { eligible_ = false; }
+  void visit(const FunctionResultCallNode&) override { eligible_ = false; }
+  void visit(const LambdaCallNode&) override { eligible_ = false; }
+  void visit(const LambdaNode&) override { eligible_ = false; }
+
+  void visit(const NumericLiteralNode& node) override
+  {
+    key_ << "n" << std::hexfloat << node.getValue() << ";";
+    ++size_;
+  }
+
+  void visit(const ProgramNode&) override { eligible_ = false; }
+  void visit(const ReturnNode&) override { eligible_ = false; }
+  void visit(const StringLiteralNode&) override { eligible_ = false; }
+
+  void visit(const UnaryNode& node) override
+  {
+    key_ << "u" << static_cast<int>(node.getOperation()) << "(";
+    node.getTerm().accept(*this);
+    key_ << ")";
+    computes_ = true;
+    ++size_;
+  }
+
+  void visit(const VariableDeclarationNode&) override { eligible_ = false; }
+
+  void visit(const VariableNode& node) override
+  {
+    const auto name = node.getName();
+    const auto it = environment_.locals.find(name);
+    if(it == environment_.locals.end() || it->second != TypeName::F32)
+    {
+      eligible_ = false;
+      return;
+    }
+
+    key_ << "v" << name << ";";
+    references_.insert(name);
+    // Reading a temporary is already cheap, reading other variables forces their thunks.
+    computes_ = computes_ || name.rfind(TemporaryPrefix, 0) != 0;
+    dependent_ = true;
+    ++size_;
+  }
+
+private:
+  const Environment& environment_;
+  std::ostringstream key_;
+  bool eligible_;
+  bool computes_;
+  bool dependent_;
+  std::size_t size_;
+  std::set<std::string> references_;
+};
+
+/*
+ * Copies a statement, collecting candidate occurrences and replacing the target
+ * candidate with a read of temporary. Only expressions evaluated eagerly in the
+ * context of the statement are considered: right-hand side of plain assignment
+ * is evaluated in the context captured by variable, arguments of calls through
+ * variables are bound in the context of the closure and bodies of lambdas are
+ * handled separately.
+ */
+class SubexpressionRewriter : public ASTCloner
+{
+public:
+  struct Occurrence
+  {
+    std::string key;
+    std::size_t size;
+    std::set<std::string> references;
+    const ExpressionNode* node;
+  };
+
+  SubexpressionRewriter(const Environment& environment, const std::string& target = "", const std::string& temporary = ""):
+    environment_(environment), target_(target), temporary_(temporary), rewritable_(true),
+    occurrences_(), assigned_(), declared_(), killsAll_(false), replaced_(0) {}
+
+  const std::list<Occurrence>& getOccurrences() const { return occurrences_; }
+  const std::set<std::string>& getAssigned() const { return assigned_; }
+  const std::optional<std::pair<std::string, TypeName>>& getDeclared() const { return declared_; }
+  // Statement may change arbitrary local variable through dynamically scoped call.
+  bool killsAll() const { return killsAll_; }
+  std::size_t getReplaced() const { return replaced_; }
+
+  void visit(const AssignmentNode& node) override
+  {
+    assigned_.insert(node.getName());
+
+    const auto rewritable = node.getOperation() != AssignmentOperator::Assign;
+    auto value = cloneExpression(*node.getValue(), rewritable_ && rewritable);
+    setResult(std::make_unique<AssignmentNode>(node.getName(), node.getOperation(), std::move(value)), node);
+  }
+
+  void visit(const BinaryOpNode& node) override
+  {
+    if(!consider(node))
+      ASTCloner::visit(node);
+  }
+
+  void visit(const NumericBinaryOpNode& node) override
+  {
+    if(!consider(node))
+      ASTCloner::visit(node);
+  }
+
+  void visit(const FunctionCallNode& node) override
+  {
+    if(consider(node))
+      return;
+
+    // Closures run in their own context, but top-level functions run in the caller's one.
+    const auto& name = node.getName();
+    const auto builtIn = name == "if" || name == "print";
+    const auto local = environment_.locals.find(name) != environment_.locals.end();
+    const auto function = !local && environment_.functions.find(name) != environment_.functions.end();
+    const auto shadowed = environment_.purity.isShadowed(name);
+    const auto direct = builtIn || (function && !shadowed);
+
+    if(function && (shadowed || !environment_.purity.isPure(name)))
+      killsAll_ = true;
+
+    std::list<std::shared_ptr<ExpressionNode>> args{};
+    for(const auto& arg : node.getArguments())
+      args.push_back(cloneExpression(*arg, rewritable_ && direct));
+    setResult(std::make_unique<FunctionCallNode>(name, std::move(args)), node);
+  }
+
+  void visit(const FunctionResultCallNode& node) override
+  {
+    auto call = clone<ExpressionNode>(node.getCall());
+    std::list<std::shared_ptr<ExpressionNode>> args{};
+    for(const auto& arg : node.getArguments())
+      args.push_back(cloneExpression(*arg, false));
+    setResult(std::make_unique<FunctionResultCallNode>(std::move(call), std::move(args)), node);
+  }
+
+  void visit(const LambdaCallNode& node) override
+  {
+    killsAll_ = true;
+    ASTCloner::visit(node);
+  }
+
+  void visit(const LambdaNode& node) override
+  {
+    ASTCloner cloner{};
+    result_ = cloner.clone(node);
+  }
+
+  void visit(const UnaryNode& node) override
+  {
+    if(!consider(node))
+      ASTCloner::visit(node);
+  }
+
+  void visit(const VariableDeclarationNode& node) override
+  {
+    assigned_.insert(node.getName());
+    declared_ = std::make_pair(node.getName(), node.getType());
+    ASTCloner::visit(node);
+  }
+
+  void visit(const VariableNode& node) override
+  {
+    if(!consider(node))
+      ASTCloner::visit(node);
+  }
+
+private:
+  std::unique_ptr<ExpressionNode> cloneExpression(const ExpressionNode& node, bool rewritable)
+  {
+    const auto previous = rewritable_;
+    rewritable_ = rewritable;
+    auto result = clone(node);
+    rewritable_ = previous;
+    return result;
+  }
+
+  bool consider(const ExpressionNode& node)
+  {
+    if(!rewritable_)
+      return false;
+
+    CandidateAnalyser analyser{environment_};
+    node.accept(analyser);
+    if(!analyser.isWorthwhile())
+      return false;
+
+    const auto key = analyser.getKey();
+    if(!target_.empty() && key == target_)
+    {
+      setResult(std::make_unique<VariableNode>(temporary_), node);
+      ++replaced_;
+      return true;
+    }
+
+    occurrences_.push_back(Occurrence{key, analyser.getSize(), analyser.getReferences(), &node});
+    return false;
+  }
+
+  const Environment& environment_;
+  std::string target_;
+  std::string temporary_;
+  bool rewritable_;
+  std::list<Occurrence> occurrences_;
+  std::set<std::string> assigned_;
+  std::optional<std::pair<std::string, TypeName>> declared_;
+  bool killsAll_;
+  std::size_t replaced_;
+};
+
+}
+
+CommonSubexpressionEliminator::CommonSubexpressionEliminator():
+  analysis_(), purity_(), functions_(), numericFunctions_(), temporaries_(0), eliminated_(0) {}
+
+void CommonSubexpressionEliminator::visit(const FunctionDeclarationNode& node)
+{
+  auto body = eliminate(*node.getBody(), node.getArguments());
+  setResult(std::make_unique<FunctionDeclarationNode>(node.getName(),
+    node.getReturnType(), node.getArguments(), std::move(body)), node);
+}
+
+void CommonSubexpressionEliminator::visit(const LambdaNode& node)
+{
+  std::shared_ptr<BlockNode> body = eliminate(node.getBody(), node.getArguments());
+  setResult(std::make_unique<LambdaNode>(node.getReturnType(), node.getArguments(), std::move(body)), node);
+}
+
+void CommonSubexpressionEliminator::visit(const ProgramNode& node)
+{
+  purity_ = analysePurity(node, analysis_);
+
+  functions_.clear();
+  numericFunctions_.clear();
+  for(const auto& function : node.getFunctions())
+  {
+    const auto& name = function->getName();
+    functions_.insert(name);
+
+    const auto& args = function->getArguments();
+    const auto numeric = function->getReturnType() == TypeName::F32 &&
+      std::all_of(args.begin(), args.end(), [](const auto& arg) { return arg.second == TypeName::F32; });
+    if(numeric && purity_->isPure(name) && !purity_->isShadowed(name))
+      numericFunctions_.insert(name);
+  }
+
+  ASTCloner::visit(node);
+}
+
+std::unique_ptr<BlockNode> CommonSubexpressionEliminator::eliminate(const BlockNode& body, const Arguments& arguments)
+{
+  Statements statements{};
+  for(const auto& statement : body.getStatements())
+    statements.push_back(clone(*statement));
+
+  while(eliminateOne(statements, arguments))
+    continue;
+
+  auto block = std::make_unique<BlockNode>();
+  for(auto& statement : statements)
+    block->addStatement(std::move(statement));
+  block->setMark(body.getMark());
+  return block;
+}
+
+/*
+ * Candidate can be replaced between its first occurrence and the first statement
+ * which may change one of the variables it reads. The largest candidate occurring
+ * at least twice in such window is bound to a temporary just before the window.
+ */
+bool CommonSubexpressionEliminator::eliminateOne(Statements& statements, const Arguments& arguments)
+{
+  struct Window
+  {
+    std::size_t first;
+    std::size_t last;
+    std::size_t count;
+    SubexpressionRewriter::Occurrence occurrence;
+  };
+
+  std::map<std::string, Window> open{};
+  std::list<Window> windows{};
+  Locals locals(arguments.begin(), arguments.end());
+  const Environment environment{locals, functions_, numericFunctions_, *purity_};
+
+  std::size_t index = 0;
+  for(const auto& statement : statements)
+  {
+    SubexpressionRewriter rewriter{environment};
+    rewriter.clone(*statement);
+
+    if(rewriter.killsAll())
+    {
+      for(auto& window : open)
+        windows.push_back(window.second);
+      open.clear();
+    }
+    else
+    {
+      for(const auto& occurrence : rewriter.getOccurrences())
+      {
+        auto& window = open.try_emplace(occurrence.key, Window{index, index, 0, occurrence}).first->second;
+        window.last = index;
+        ++window.count;
+      }
+
+      const auto& assigned = rewriter.getAssigned();
+      for(auto it = open.begin(); it != open.end();)
+      {
+        const auto& references = it->second.occurrence.references;
+        const auto killed = std::any_of(assigned.begin(), assigned.end(),
+          [&](const auto& name) { return references.find(name) != references.end(); });
+        if(killed)
+        {
+          windows.push_back(it->second);
+          it = open.erase(it);
+        }
+        else
+          ++it;
+      }
+    }
+
+    if(rewriter.getDeclared())
+      locals.insert(rewriter.getDeclared().value());
+    ++index;
+  }
+
+  for(auto& window : open)
+    windows.push_back(window.second);
+
+  const Window* best = nullptr;
+  for(const auto& window : windows)
+  {
+    if(window.count < 2)
+      continue;
+
+    if(!best || window.occurrence.size > best->occurrence.size ||
+      (window.occurrence.size == best->occurrence.size && window.first < best->first))
+      best = &window;
+  }
+
+  if(!best)
+    return false;
+
+  const auto temporary = TemporaryPrefix + std::to_string(temporaries_++);
+  ASTCloner cloner{};
+  auto value = cloner.clone(*best->occurrence.node);
+  const auto mark = value->getMark();
+  auto declaration = std::make_unique<VariableDeclarationNode>(temporary, TypeName::F32, std::move(value), true);
+  declaration->setMark(mark);
+
+  locals = Locals(arguments.begin(), arguments.end());
+  index = 0;
+  auto insertionPoint = statements.end();
+  for(auto it = statements.begin(); it != statements.end() && index <= best->last; ++it, ++index)
+  {
+    SubexpressionRewriter rewriter{environment, best->occurrence.key, temporary};
+    auto rewritten = rewriter.clone(**it);
+
+    if(index >= best->first)
+    {
+      if(index == best->first)
+        insertionPoint = it;
+      eliminated_ += rewriter.getReplaced();
+      *it = std::move(rewritten);
+    }
+
+    if(rewriter.getDeclared())
+      locals.insert(rewriter.getDeclared().value());
+  }
+
+  // Computation done by the temporary itself is not eliminated.
+  --eliminated_;
+  statements.insert(insertionPoint, std::move(declaration));
+  return true;
+}
@@ -1,8 +1,20 @@
 #include "Context.hpp"
 
-std::shared_ptr<RuntimeSymbol> RuntimeVariableSymbol::clone(const Context& context) const
+#include "Common.hpp"
+#include "Value.h"
+
+std::shared_ptr<RuntimeSymbol> RuntimeVariableSymbol::clone(const Context&) const
+{
+  auto symbol = std::make_shared<RuntimeVariableSymbol>(name_, type_, value_, context_, cell_);
+  symbol->mark_ = mark_;
+  return symbol;
+}
+
+std::unique_ptr<RuntimeVariableSymbol> RuntimeVariableSymbol::alias(const std::string& name, const TypeName& type) const
 {
-  return std::make_shared<RuntimeVariableSymbol>(name_, type_, value_, context);
+  auto symbol = std::make_unique<RuntimeVariableSymbol>(name, type, value_, context_, cell_);
+  symbol->mark_ = mark_;
+  return symbol;
 }
 
 std::shared_ptr<RuntimeSymbol> RuntimeFunctionSymbol::clone(const Context&) const
@@ -10,14 +22,33 @@ std::shared_ptr<RuntimeSymbol> RuntimeFunctionSymbol::clone(const Context&) cons
   return std::make_shared<RuntimeFunctionSymbol>(name_, returnType_, arguments_, body_);
 }
 
+/*
+ * Number is kept in the cell of the variable, which reads take before its expression.
+ * Cell which no other binding shares is updated in place, otherwise the variable gets
+ * a new one, so that clones taken by captured contexts keep the value they saw.
+ */
+void RuntimeVariableSymbol::setNumber(double value)
+{
+  if(cell_ && cell_.use_count() == 1 && cell_->value && cell_->value->getType() == TypeName::F32)
+  {
+    static_cast<Number&>(*cell_->value).setValue(value);
+    return;
+  }
+
+  cell_ = std::make_shared<ValueCell>();
+  cell_->value = std::make_unique<Number>(value);
+}
+
 RuntimeVariableAnalyser::RuntimeVariableAnalyser():
-  symbolValid_(false), type_(), value_(nullptr), context_() {}
+  symbolValid_(false), type_(), value_(nullptr), mark_(), context_(), cell_() {}
 
 void RuntimeVariableAnalyser::visit(RuntimeVariableSymbol& symbol)
 {
   type_ = symbol.getType();
   value_ = symbol.getValue();
+  mark_ = symbol.getMark();
   context_ = symbol.getContext();
+  cell_ = symbol.getCell();
   symbolValid_ = true;
 }
 
@@ -26,6 +57,35 @@ void RuntimeVariableAnalyser::visit(RuntimeFunctionSymbol&)
   symbolValid_ = false;
 }
 
+ForcedVariableGuard::ForcedVariableGuard(ForcedVariables& forced, const RuntimeVariableAnalyser& variable):
+  forced_(&forced), key_(variable.getValue().get(), &variable.getContext())
+{
+  if(!forced.insert(key_).second)
+  {
+    forced_ = nullptr;
+    reportError("Value of variable depends on itself (<<loop>>)!", variable.getMark());
+  }
+}
+
+ForcedVariableGuard& ForcedVariableGuard::operator=(ForcedVariableGuard&& other) noexcept
+{
+  if(this != &other)
+  {
+    release();
+    forced_ = other.forced_;
+    key_ = other.key_;
+    other.forced_ = nullptr;
+  }
+  return *this;
+}
+
+void ForcedVariableGuard::release()
+{
+  if(forced_)
+    forced_->erase(key_);
+  forced_ = nullptr;
+}
+
 RuntimeFunctionAnalyser::RuntimeFunctionAnalyser():
   symbolValid_(false), returnType_(), arguments_(), body_(nullptr) {}
 
@@ -42,9 +102,14 @@ void RuntimeFunctionAnalyser::visit(RuntimeFunctionSymbol& symbol)
   body_ = symbol.getBody();
 }
 
+void VariableAliaser::visit(RuntimeVariableSymbol& symbol)
+{
+  alias_ = symbol.alias(name_, type_);
+}
+
 void ValueChanger::visit(RuntimeVariableSymbol& symbol)
 {
-  symbol.setValue(value_);
+  symbol.setValue(value_, mark_, std::make_shared<ValueCell>());
 }
 
 void ValueChanger::visit(RuntimeFunctionSymbol&)
@@ -52,57 +117,122 @@ void ValueChanger::visit(RuntimeFunctionSymbol&)
 
 }
 
-Context::Context(): scopes_()
+void NumberChanger::visit(RuntimeVariableSymbol& symbol)
+{
+  symbol.setNumber(value_);
+}
+
+struct Context::Scope
+{
+  using Symbols = std::unordered_map<std::string, std::shared_ptr<RuntimeSymbol>>;
+
+  Scope(std::shared_ptr<Scope> parent, std::uint64_t names): parent(std::move(parent)), symbols(), names(names) {}
+  Scope(const Scope&) = default;
+  ~Scope();
+
+  std::shared_ptr<Scope> parent;
+  Symbols symbols;
+  std::uint64_t names;
+};
+
+namespace
+{
+  std::uint64_t nameBit(const std::string& name)
+  {
+    return std::uint64_t{1} << (std::hash<std::string>{}(name) % 64);
+  }
+}
+
+// Scopes no other context shares are released one by one, chains of deep recursion would overflow the stack.
+Context::Scope::~Scope()
 {
-  auto globalScope = std::unordered_map<std::string, std::shared_ptr<RuntimeSymbol>>();
-  scopes_.push_back(std::move(globalScope));
+  auto scope = std::move(parent);
+  symbols.clear();
+  while(scope && scope.use_count() == 1)
+  {
+    auto next = std::move(scope->parent);
+    scope = std::move(next);
+  }
 }
 
+Context::Context(): scope_(std::make_shared<Scope>(nullptr, 0)), global_(scope_.get()) {}
+
 void Context::enterScope()
 {
-  auto localScope = std::unordered_map<std::string, std::shared_ptr<RuntimeSymbol>>();
-  scopes_.push_back(std::move(localScope));
+  const auto names = scope_.get() == global_ ? 0 : scope_->names;
+  scope_ = std::make_shared<Scope>(std::move(scope_), names);
 }
 
 void Context::leaveScope()
 {
-  scopes_.pop_back();
+  scope_ = scope_->parent;
 }
 
 void Context::addSymbol(const std::string& name, std::shared_ptr<RuntimeSymbol> symbol)
 {
-  scopes_.back().insert(std::pair<std::string, std::shared_ptr<RuntimeSymbol>>{name, std::move(symbol)});
+  if(scope_.use_count() > 1)
+  {
+    const bool global = scope_.get() == global_;
+    scope_ = std::make_shared<Scope>(*scope_);
+    if(global)
+      global_ = scope_.get();
+  }
+
+  if(scope_->symbols.insert(Scope::Symbols::value_type{name, std::move(symbol)}).second && scope_.get() != global_)
+    scope_->names |= nameBit(name);
 }
 
 Context Context::clone() const
 {
-  Context newContext{};
-  for(auto scopesIt = scopes_.cbegin(); scopesIt != scopes_.cend(); ++scopesIt)
-  {
-    for(const auto& symbol : *scopesIt)
-    {
-      const auto name = symbol.first;
-      newContext.addSymbol(name, symbol.second->clone(newContext));
-    }
-
-    if(scopesIt + 1 != scopes_.cend())
-      newContext.enterScope();
-  }
-  return newContext;
+  return *this;
 }
 
 std::optional<std::reference_wrapper<RuntimeSymbol>> Context::lookup(const std::string& name, int maxDepth) const
 {
+  const auto bit = nameBit(name);
   int depth = 1;
-  for(auto scopesIt = scopes_.crbegin(); scopesIt != scopes_.crend(); ++scopesIt, ++depth)
+  for(const Scope* scope = scope_.get(); scope; scope = scope->parent.get(), ++depth)
   {
-    auto it = scopesIt->find(name);
-    if(it != scopesIt->end())
+    if(maxDepth == 0 && !(scope->names & bit))
+      scope = global_;
+
+    auto it = scope->symbols.find(name);
+    if(it != scope->symbols.end())
       return *it->second;
 
-    if(maxDepth != 0 && depth == maxDepth)
+    if(scope == global_ || (maxDepth != 0 && depth == maxDepth))
       break;
   }
 
-  return {};  
+  return {};
+}
+
+/*
+ * Scopes from the top down to the one binding the name are copied if any of them is
+ * shared, and so is the symbol, whose clone keeps the cell, see setNumber.
+ */
+std::optional<std::reference_wrapper<RuntimeSymbol>> Context::lookupForUpdate(const std::string& name)
+{
+  bool shared = false;
+  for(auto* scope = &scope_; *scope; scope = &(*scope)->parent)
+  {
+    const bool global = scope->get() == global_;
+    shared = shared || scope->use_count() > 1;
+    if(shared)
+    {
+      *scope = std::make_shared<Scope>(**scope);
+      if(global)
+        global_ = scope->get();
+    }
+
+    auto it = (*scope)->symbols.find(name);
+    if(it != (*scope)->symbols.end())
+    {
+      if(it->second.use_count() > 1)
+        it->second = it->second->clone(*this);
+      return *it->second;
+    }
+  }
+
+  return {};
 }
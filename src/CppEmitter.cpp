@@ -0,0 +1,358 @@
+#include "CppEmitter.hpp"
+
+#include <cctype>
+#include <iomanip>
+
+namespace
+{
+
+std::string quote(const std::string& text)
+{
+  std::stringstream ss;
+  ss << '"';
+  for(const auto c : text)
+  {
+    if(c == '"' || c == '\\')
+      ss << '\\' << c;
+    else if(c == '\n')
+      ss << "\\n";
+    else if(c == '\t')
+      ss << "\\t";
+    else if(static_cast<unsigned char>(c) < 0x20 || static_cast<unsigned char>(c) >= 0x7f)
+      ss << '\\' << std::oct << std::setw(3) << std::setfill('0') << static_cast<int>(static_cast<unsigned char>(c))
+        << std::dec;
+    else
+      ss << c;
+  }
+  ss << '"';
+  return ss.str();
+}
+
+// Digits enough for the literal to read back as the same double.
+std::string formatNumber(double value)
+{
+  std::stringstream ss;
+  ss << std::setprecision(17) << value;
+  return ss.str();
+}
+
+std::string mark(const Node& node)
+{
+  return quote(node.getMark().to_string());
+}
+
+std::string typeName(const TypeName& type)
+{
+  switch(type)
+  {
+    case TypeName::F32: return "lil::Type::F32";
+    case TypeName::Function: return "lil::Type::Function";
+    case TypeName::Void: return "lil::Type::Void";
+    case TypeName::String: return "lil::Type::String";
+  }
+
+  return ""; // Unreachable
+}
+
+}
+
+CppEmitter::CppEmitter():
+  declarations_(), definitions_(), functions_(), emitted_(), names_(), nameList_(), main_(), result_(), counter_(0) {}
+
+std::string CppEmitter::getSource() const
+{
+  std::stringstream ss;
+  ss << "// Translated from a lazy language program by the interpreter (--emit-cpp).\n"
+    << "#include \"lil_runtime.hpp\"\n\n"
+    << "namespace\n{\n\n";
+
+  ss << "enum Name : int\n{\n";
+  for(const auto& name : nameList_)
+    ss << "  " << name << ",\n";
+  ss << "};\n\n";
+
+  ss << declarations_.str() << "\n" << definitions_.str() << "}\n\n";
+
+  ss << "int main()\n{\n"
+    << "  return lil::run(program, " << main_ << ");\n"
+    << "}\n";
+  return ss.str();
+}
+
+void CppEmitter::visit(const AssignmentNode& node)
+{
+  const auto code = emitCode(*node.getValue());
+  if(node.getOperation() == AssignmentOperator::Assign)
+  {
+    line() << "lil::assign(a, " << name(node.getName()) << ", " << code << ");\n";
+    return;
+  }
+
+  line() << "lil::assign(a, " << name(node.getName()) << ", lil::AssignmentOperator::"
+    << AssignmentOperationNames.at(node.getOperation()) << ", " << code << ", " << mark(node) << ");\n";
+}
+
+void CppEmitter::visit(const BinaryOpNode& node)
+{
+  const auto left = emitExpression(node.getLeftOperand());
+  const auto right = emitExpression(node.getRightOperand());
+
+  const auto result = temporary();
+  line() << "lil::Value " << result << " = lil::binary(lil::Operator::" << BinaryOperationNames.at(node.getOperation())
+    << ", " << left << ", " << right << ", " << mark(node) << ");\n";
+  result_ = result;
+}
+
+void CppEmitter::visit(const BlockNode& node)
+{
+  for(const auto& statement : node.getStatements())
+    statement->accept(*this);
+}
+
+void CppEmitter::visit(const FunctionCallNode& node)
+{
+  const auto& args = node.getArguments();
+  const auto& name = node.getName();
+  if(name == "print")
+  {
+    const auto value = emitExpression(*args.front());
+    line() << "lil::print(a, " << value << ", " << mark(node) << ");\n";
+    result_ = "lil::Value{}";
+    return;
+  }
+
+  if(name == "if")
+  {
+    const auto condition = emitExpression(*args.front());
+    const auto result = temporary();
+    line() << "lil::Value " << result << "{};\n";
+    line() << "if(lil::condition(" << condition << ", " << mark(node) << "))\n";
+
+    const auto emitBranch = [this, &result](const ExpressionNode& branch) {
+      line() << "{\n";
+      functions_.back().indent += "  ";
+      const auto value = emitExpression(branch);
+      line() << result << " = " << value << ";\n";
+      functions_.back().indent.resize(functions_.back().indent.size() - 2);
+      line() << "}\n";
+    };
+
+    emitBranch(**std::next(args.begin()));
+    line() << "else\n";
+    emitBranch(*args.back());
+    result_ = result;
+    return;
+  }
+
+  const auto arguments = emitArguments(args);
+  const auto result = temporary();
+  line() << "lil::Value " << result << " = lil::call(a, " << this->name(name) << ", " << quote(name) << ", "
+    << arguments << ", " << mark(node) << ");\n";
+  result_ = result;
+}
+
+void CppEmitter::visit(const FunctionCallStatementNode& node)
+{
+  emitExpression(node.getFunctionCall());
+}
+
+void CppEmitter::visit(const FunctionDeclarationNode& node)
+{
+  const auto parameters = emitParameters(node.getArguments());
+  const auto body = emitBody(*node.getBody());
+  line() << "lil::define(a, " << name(node.getName()) << ", " << typeName(node.getReturnType()) << ", &"
+    << parameters << ", " << body << ");\n";
+}
+
+void CppEmitter::visit(const FunctionResultCallNode& node)
+{
+  const auto callee = emitExpression(node.getCall());
+  const auto arguments = emitArguments(node.getArguments());
+
+  const auto result = temporary();
+  line() << "lil::Value " << result << " = lil::callResult(a, " << callee << ", " << arguments << ", "
+    << mark(node) << ");\n";
+  result_ = result;
+}
+
+void CppEmitter::visit(const LambdaCallNode& node)
+{
+  const auto& lambda = node.getLambda();
+  const auto parameters = emitParameters(lambda.getArguments());
+  const auto body = emitBody(lambda.getBody());
+  const auto arguments = emitArguments(node.getArguments());
+
+  const auto result = temporary();
+  line() << "lil::Value " << result << " = lil::callLambda(a, &" << parameters << ", " << body << ", "
+    << arguments << ");\n";
+  result_ = result;
+}
+
+void CppEmitter::visit(const LambdaNode& node)
+{
+  const auto parameters = emitParameters(node.getArguments());
+  const auto body = emitBody(node.getBody());
+
+  const auto result = temporary();
+  line() << "lil::Value " << result << " = lil::function(a, " << typeName(node.getReturnType()) << ", &"
+    << parameters << ", " << body << ");\n";
+  result_ = result;
+}
+
+void CppEmitter::visit(const NumericLiteralNode& node)
+{
+  result_ = "lil::number(" + formatNumber(node.getValue()) + ")";
+}
+
+void CppEmitter::visit(const ProgramNode& node)
+{
+  functions_.emplace_back();
+  for(const auto& variable : node.getVariables())
+    variable->accept(*this);
+  for(const auto& function : node.getFunctions())
+    function->accept(*this);
+
+  definitions_ << "void program(lil::Activation& a)\n{\n" << functions_.back().body.str() << "}\n\n";
+  functions_.pop_back();
+
+  main_ = name("main");
+}
+
+void CppEmitter::visit(const ReturnNode& node)
+{
+  const auto value = emitExpression(node.getValue());
+  line() << "a.result = " << value << ";\n";
+  line() << "return;\n";
+}
+
+void CppEmitter::visit(const StringLiteralNode& node)
+{
+  result_ = "lil::string(" + quote(node.getValue()) + ")";
+}
+
+void CppEmitter::visit(const UnaryNode& node)
+{
+  const auto term = emitExpression(node.getTerm());
+
+  const auto result = temporary();
+  line() << "lil::Value " << result << " = lil::unary(lil::UnaryOperator::" << UnaryOperationNames.at(node.getOperation())
+    << ", " << term << ", " << mark(node) << ");\n";
+  result_ = result;
+}
+
+void CppEmitter::visit(const VariableDeclarationNode& node)
+{
+  const auto code = emitCode(*node.getValue());
+  line() << "lil::declare(a, " << name(node.getName()) << ", " << typeName(node.getType()) << ", " << code << ", "
+    << (node.isShared() ? "true" : "false") << ");\n";
+}
+
+void CppEmitter::visit(const VariableNode& node)
+{
+  const auto result = temporary();
+  line() << "lil::Value " << result << " = lil::read(a, " << name(node.getName()) << ", " << quote(node.getName())
+    << ", " << mark(node) << ");\n";
+  result_ = result;
+}
+
+// Expressions shared by several nodes (arguments of specialized calls, common subexpressions) are emitted once.
+std::string CppEmitter::emitCode(const ExpressionNode& node)
+{
+  const auto it = emitted_.find(&node);
+  if(it != emitted_.end())
+    return it->second;
+
+  const auto code = "e" + std::to_string(counter_++);
+  emitted_[&node] = code;
+  declarations_ << "lil::Value " << code << "(lil::Activation& a);\n";
+
+  functions_.emplace_back();
+  const auto value = emitExpression(node);
+  line() << "return " << value << ";\n";
+
+  definitions_ << "lil::Value " << code << "(lil::Activation& a)\n{\n" << functions_.back().body.str() << "}\n\n";
+  functions_.pop_back();
+  return code;
+}
+
+std::string CppEmitter::emitBody(const BlockNode& node)
+{
+  const auto it = emitted_.find(&node);
+  if(it != emitted_.end())
+    return it->second;
+
+  const auto body = "b" + std::to_string(counter_++);
+  emitted_[&node] = body;
+  declarations_ << "void " << body << "(lil::Activation& a);\n";
+
+  functions_.emplace_back();
+  node.accept(*this);
+
+  definitions_ << "void " << body << "(lil::Activation& a)\n{\n" << functions_.back().body.str() << "}\n\n";
+  functions_.pop_back();
+  return body;
+}
+
+std::string CppEmitter::emitParameters(const std::list<std::pair<std::string, TypeName>>& parameters)
+{
+  const auto list = "p" + std::to_string(counter_++);
+  declarations_ << "const lil::Parameters " << list << "{";
+  for(const auto& parameter : parameters)
+  {
+    declarations_ << (&parameter == &parameters.front() ? "" : ", ")
+      << "{" << name(parameter.first) << ", " << typeName(parameter.second) << "}";
+  }
+  declarations_ << "};\n";
+  return list;
+}
+
+std::string CppEmitter::emitArguments(const std::list<std::shared_ptr<ExpressionNode>>& arguments)
+{
+  if(arguments.empty())
+    return "lil::Arguments{nullptr, 0}";
+
+  std::vector<std::string> codes{};
+  for(const auto& argument : arguments)
+    codes.push_back(emitCode(*argument));
+
+  const auto array = temporary();
+  line() << "static const lil::Code " << array << "[] = {";
+  for(std::size_t i = 0; i < codes.size(); ++i)
+    functions_.back().body << (i == 0 ? "" : ", ") << codes[i];
+  functions_.back().body << "};\n";
+
+  return "lil::Arguments{" + array + ", " + std::to_string(codes.size()) + "}";
+}
+
+std::string CppEmitter::emitExpression(const ExpressionNode& node)
+{
+  node.accept(*this);
+  return result_;
+}
+
+std::string CppEmitter::temporary()
+{
+  return "t" + std::to_string(functions_.back().temporaries++);
+}
+
+std::ostream& CppEmitter::line()
+{
+  auto& function = functions_.back();
+  function.body << function.indent;
+  return function.body;
+}
+
+// Identifiers are numbered in order of appearance, characters not allowed in C++ are replaced.
+const std::string& CppEmitter::name(const std::string& identifier)
+{
+  const auto it = names_.find(identifier);
+  if(it != names_.end())
+    return it->second;
+
+  auto name = "n" + std::to_string(nameList_.size()) + "_";
+  for(const auto c : identifier)
+    name += std::isalnum(static_cast<unsigned char>(c)) ? c : '_';
+
+  nameList_.push_back(name);
+  return names_[identifier] = name;
+}
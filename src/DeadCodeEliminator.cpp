@@ -0,0 +1,177 @@
+#include "DeadCodeEliminator.hpp"
+
+#include <deque>
+#include <map>
+#include <vector>
+
+#include "RecursiveVisitor.hpp"
+
+namespace
+{
+
+/*
+ * Counts references (reads, calls and assignments) of names in a subtree,
+ * including the ones nested in lambdas.
+ */
+class ReferenceCollector : public RecursiveVisitor
+{
+public:
+  ReferenceCollector(): references(), declared(), returns(0), depth_(0) {}
+
+  std::map<std::string, std::size_t> references;
+  // Variable declared by the visited statement itself.
+  std::string declared;
+  // Returns outside of nested lambdas.
+  std::size_t returns;
+
+  void visit(const AssignmentNode& node) override
+  {
+    ++references[node.getName()];
+    RecursiveVisitor::visit(node);
+  }
+
+  void visit(const FunctionCallNode& node) override
+  {
+    ++references[node.getName()];
+    RecursiveVisitor::visit(node);
+  }
+
+  void visit(const LambdaNode& node) override
+  {
+    ++depth_;
+    RecursiveVisitor::visit(node);
+    --depth_;
+  }
+
+  void visit(const ReturnNode& node) override
+  {
+    if(depth_ == 0)
+      ++returns;
+    RecursiveVisitor::visit(node);
+  }
+
+  void visit(const VariableDeclarationNode& node) override
+  {
+    if(depth_ == 0 && declared.empty())
+      declared = node.getName();
+    RecursiveVisitor::visit(node);
+  }
+
+  void visit(const VariableNode& node) override
+  {
+    ++references[node.getName()];
+  }
+
+private:
+  std::size_t depth_;
+};
+
+}
+
+DeadCodeEliminator::DeadCodeEliminator(): globalNames_(), removedFunctions_(0), removedVariables_(0),
+  removedStatements_(0) {}
+
+/*
+ * Variable can be dropped when it is not referenced in the block. Top-level functions
+ * called from the block run in its scope, but they can only refer to names declared
+ * globally (either variables or functions), so such variables are kept.
+ */
+void DeadCodeEliminator::visit(const BlockNode& node)
+{
+  std::vector<const StatementNode*> statements{};
+  std::vector<ReferenceCollector> collectors{};
+  for(const auto& statement : node.getStatements())
+  {
+    collectors.emplace_back();
+    statement->accept(collectors.back());
+    statements.push_back(statement.get());
+
+    if(collectors.back().returns > 0)
+      break;
+  }
+  removedStatements_ += node.getStatements().size() - statements.size();
+
+  std::map<std::string, std::size_t> references{};
+  for(const auto& collector : collectors)
+  {
+    for(const auto& reference : collector.references)
+      references[reference.first] += reference.second;
+  }
+
+  std::vector<bool> removed(statements.size(), false);
+  bool changed = true;
+  while(changed)
+  {
+    changed = false;
+    for(std::size_t i = 0; i < statements.size(); ++i)
+    {
+      const auto& name = collectors[i].declared;
+      if(removed[i] || name.empty() || references[name] > 0 || globalNames_.find(name) != globalNames_.end())
+        continue;
+
+      removed[i] = true;
+      ++removedVariables_;
+      for(const auto& reference : collectors[i].references)
+        references[reference.first] -= reference.second;
+      changed = true;
+    }
+  }
+
+  auto block = std::make_unique<BlockNode>();
+  for(std::size_t i = 0; i < statements.size(); ++i)
+  {
+    if(!removed[i])
+      block->addStatement(clone<StatementNode>(*statements[i]));
+  }
+  setResult(std::move(block), node);
+}
+
+void DeadCodeEliminator::visit(const ProgramNode& node)
+{
+  globalNames_.clear();
+  std::map<std::string, const FunctionDeclarationNode*> functions{};
+  for(const auto& function : node.getFunctions())
+  {
+    functions[function->getName()] = function.get();
+    globalNames_.insert(function->getName());
+  }
+
+  std::deque<std::string> pending{"main"};
+  for(const auto& variable : node.getVariables())
+  {
+    globalNames_.insert(variable->getName());
+
+    ReferenceCollector collector{};
+    variable->getValue()->accept(collector);
+    for(const auto& reference : collector.references)
+      pending.push_back(reference.first);
+  }
+
+  std::set<std::string> reachable{};
+  while(!pending.empty())
+  {
+    const auto name = pending.front();
+    pending.pop_front();
+
+    const auto function = functions.find(name);
+    if(function == functions.end() || !reachable.insert(name).second)
+      continue;
+
+    ReferenceCollector collector{};
+    function->second->accept(collector);
+    for(const auto& reference : collector.references)
+      pending.push_back(reference.first);
+  }
+
+  auto program = std::make_unique<ProgramNode>();
+  for(const auto& variable : node.getVariables())
+    program->addVariable(clone<VariableDeclarationNode>(*variable));
+  for(const auto& function : node.getFunctions())
+  {
+    if(reachable.find(function->getName()) != reachable.end())
+      program->addFunction(clone<FunctionDeclarationNode>(*function));
+    else
+      ++removedFunctions_;
+  }
+  setResult(std::move(program), node);
+}
@@ -2,85 +2,154 @@
 
 #include <cmath>
 #include <iostream>
+#include <iterator>
 
 #include "Common.hpp"
+#include "Operators.hpp"
 #include "AST.hpp"
+#include "LoopEvaluator.hpp"
+#include "ReassignmentAnalyser.hpp"
+#include "ValueOperations.hpp"
 
-void Executor::assertValueType(const Value& value, const TypeName& type, const std::string& activity, const Node& node) const
+namespace
 {
-  if(value.getType() != type)
-    reportError("Cannot perform " + activity +
-      " with value of type " + TypeNameStrings.at(value.getType()) + "!", node);
+
+// Context of bindings to literals, which do not depend on it.
+const std::shared_ptr<const Context>& emptyContext()
+{
+  static const auto context = std::make_shared<const Context>();
+  return context;
+}
+
+// Recognizes arguments which can be bound without a thunk: literals and variables.
+class ArgumentAnalyser : public Visitor
+{
+public:
+  ArgumentAnalyser(): literal(false), variable(nullptr) {}
+
+  bool literal;
+  const VariableNode* variable;
+
+  void visit(const AssignmentNode&) override {}
+  void visit(const BinaryOpNode&) override {}
+  void visit(const BlockNode&) override {}
+  void visit(const FunctionCallNode&) override {}
+  void visit(const FunctionCallStatementNode&) override {}
+  void visit(const FunctionDeclarationNode&) override {}
+  void visit(const FunctionResultCallNode&) override {}
+  void visit(const LambdaCallNode&) override {}
+  void visit(const LambdaNode&) override {}
+  void visit(const NumericLiteralNode&) override { literal = true; }
+  void visit(const ProgramNode&) override {}
+  void visit(const ReturnNode&) override {}
+  void visit(const StringLiteralNode&) override { literal = true; }
+  void visit(const UnaryNode&) override {}
+  void visit(const VariableDeclarationNode&) override {}
+  void visit(const VariableNode& node) override { variable = &node; }
+};
+
+// Recognizes operands of integer operations which are evaluated without boxing: literals and integer operations.
+class IntegerOperandAnalyser : public Visitor
+{
+public:
+  IntegerOperandAnalyser(): literal(nullptr), operation(nullptr) {}
+
+  const NumericLiteralNode* literal;
+  const NumericBinaryOpNode* operation;
+
+  void visit(const AssignmentNode&) override {}
+  void visit(const BinaryOpNode&) override {}
+  void visit(const BlockNode&) override {}
+  void visit(const FunctionCallNode&) override {}
+  void visit(const FunctionCallStatementNode&) override {}
+  void visit(const FunctionDeclarationNode&) override {}
+  void visit(const FunctionResultCallNode&) override {}
+  void visit(const LambdaCallNode&) override {}
+  void visit(const LambdaNode&) override {}
+  void visit(const NumericLiteralNode& node) override { literal = &node; }
+  void visit(const ProgramNode&) override {}
+  void visit(const ReturnNode&) override {}
+  void visit(const StringLiteralNode&) override {}
+  void visit(const UnaryNode&) override {}
+  void visit(const VariableDeclarationNode&) override {}
+  void visit(const VariableNode&) override {}
+
+  void visit(const NumericBinaryOpNode& node) override
+  {
+    if(node.isInteger())
+      operation = &node;
+  }
+};
+
+}
+
+std::unique_ptr<RuntimeVariableSymbol> bindDirectly(const std::pair<std::string, TypeName>& parameter,
+  const std::shared_ptr<ExpressionNode>& value, const Context& context)
+{
+  ArgumentAnalyser analyser{};
+  value->accept(analyser);
+  if(analyser.literal)
+    return std::make_unique<RuntimeVariableSymbol>(parameter.first, parameter.second, value, emptyContext(), nullptr);
+
+  const auto symbol = analyser.variable ? context.lookup(analyser.variable->getName()) : std::nullopt;
+  if(!symbol)
+    return nullptr;
+
+  VariableAliaser aliaser{parameter.first, parameter.second};
+  symbol.value().get().accept(aliaser);
+  return std::move(aliaser.getAlias());
+}
+
+Executor::Executor(const ExecutorOptions& options):
+  value_(), context_(), returnStack_(), returned_(false), stdout_(), exitCode_(0), memoTable_(), jit_(), speculator_(),
+  strict_(options.strict), reassigned_(), discarding_(false), profile_(options.profile),
+  forced_(std::make_shared<ForcedVariables>())
+{
+  if(options.memoize)
+    memoTable_ = std::make_shared<MemoTable>(options.memoCapacity);
+  if(options.jit)
+    jit_ = std::make_shared<JitCompiler>(options.feedback);
+  if(options.speculate)
+    speculator_ = std::make_shared<Speculator>(options.speculationBudget, options.feedback);
 }
 
+Executor::Executor(const Context& context, const Executor& parent):
+  value_(), context_(context), returnStack_(), returned_(false), stdout_(), exitCode_(0), memoTable_(parent.memoTable_),
+  jit_(parent.jit_), speculator_(parent.speculator_), strict_(parent.strict_), reassigned_(parent.reassigned_),
+  discarding_(parent.discarding_), profile_(parent.profile_), forced_(parent.forced_) {}
+
 void Executor::visit(const AssignmentNode& node)
 {
   const auto name = node.getName();
-  auto symbol = context_.lookup(name);
   if(node.getOperation() == AssignmentOperator::Assign)
   {
-    ValueChanger valueChanger{node.getValue()};
-    symbol.value().get().accept(valueChanger);
+    ValueChanger valueChanger{node.getValue(), node.getMark()};
+    context_.lookupForUpdate(name).value().get().accept(valueChanger);
   }
   else
   {
-    RuntimeVariableAnalyser analyser{};
-    symbol.value().get().accept(analyser);
-    Executor executor{analyser.getContext()};
-    analyser.getValue()->accept(executor);
-
+    const auto activity = "assignment operation " + AssignmentOperationNames.at(node.getOperation());
     NumberValueAnalyser valueAnalyser{};
-
-    assertValueType(*executor.getValue(), TypeName::F32,
-                    "assignment operation " + AssignmentOperationNames.at(node.getOperation()), node);
-
-    executor.getValue()->accept(valueAnalyser);
-    const auto oldValue = valueAnalyser.getValue().value();
+    {
+      // Variable which was forced or updated before is read straight from its cell.
+      RuntimeVariableAnalyser analyser{};
+      context_.lookup(name).value().get().accept(analyser);
+      const auto& cell = analyser.getCell();
+      const auto forced = cell && cell->value ? nullptr : force(analyser);
+      const auto& oldValue = forced ? *forced : *cell->value;
+      assertValueType(oldValue, TypeName::F32, activity, node);
+      oldValue.accept(valueAnalyser);
+    }
+    const auto oldNumber = valueAnalyser.getValue().value();
 
     node.getValue()->accept(*this);
-
-    assertValueType(*value_, TypeName::F32,
-      "assignment operation " + AssignmentOperationNames.at(node.getOperation()), node);
+    assertValueType(*value_, TypeName::F32, activity, node);
 
     value_->accept(valueAnalyser);
     const auto rhs = valueAnalyser.getValue().value();
 
-    double newValue = oldValue;
-    switch(node.getOperation())
-    {
-      case AssignmentOperator::PlusEq:
-        newValue = oldValue + rhs;
-        break;
-      case AssignmentOperator::MinusEq:
-        newValue = oldValue - rhs;
-        break;
-      case AssignmentOperator::MulEq:
-        newValue = oldValue * rhs;
-        break;
-      case AssignmentOperator::DivEq:
-        newValue = oldValue / rhs;
-        break;
-      case AssignmentOperator::OrEq:
-        newValue = static_cast<unsigned int>(oldValue) | static_cast<unsigned int>(rhs);
-        break;
-      case AssignmentOperator::AndEq:
-        newValue = static_cast<unsigned int>(oldValue) & static_cast<unsigned int>(rhs);
-        break;
-      case AssignmentOperator::XorEq:
-        newValue = static_cast<unsigned int>(oldValue) ^ static_cast<unsigned int>(rhs);
-        break;
-      case AssignmentOperator::ShiftLeftEq:
-        newValue = static_cast<unsigned int>(oldValue) << static_cast<unsigned int>(rhs);
-        break;
-      case AssignmentOperator::ShiftRightEq:
-        newValue = static_cast<unsigned int>(oldValue) >> static_cast<unsigned int>(rhs);
-        break;
-      case AssignmentOperator::Assign:
-        break; // Unreachable
-    }
-
-    ValueChanger valueChanger{std::make_shared<NumericLiteralNode>(newValue)};
-    symbol.value().get().accept(valueChanger);
+    NumberChanger numberChanger{evaluateAssignment(node.getOperation(), oldNumber, rhs)};
+    context_.lookupForUpdate(name).value().get().accept(numberChanger);
   }
 }
 
@@ -92,129 +161,20 @@ void Executor::visit(const BinaryOpNode& node)
   node.getRightOperand().accept(*this);
   auto right = std::move(value_);
 
-  if(node.getOperation() == BinaryOperator::Addition)
-  {
-    if(left->getType() == TypeName::String)
-    {
-      StringValueAnalyser valueAnalyser{};
-      left->accept(valueAnalyser);
-
-      const auto l = valueAnalyser.getValue().value();
-      if(right->getType() == TypeName::String)
-      {
-        right->accept(valueAnalyser);
-        const auto r = valueAnalyser.getValue().value();
-        value_ = std::make_unique<String>(l + r);
-      }
-      else if(right->getType() == TypeName::F32)
-      {
-        NumberValueAnalyser numberValueAnalyser{};
-        right->accept(numberValueAnalyser);
-
-        const auto r = numberValueAnalyser.getValue().value();
-        value_ = std::make_unique<String>(l + std::to_string(r));
-      }
-      else
-        reportError("String cannot be concatenated with value of type "  +
-          TypeNameStrings.at(right->getType()) + "!", node);
-    }
-    else if(left->getType() == TypeName::F32)
-    {
-      NumberValueAnalyser numberValueAnalyser{};
-      left->accept(numberValueAnalyser);
-      const auto l = numberValueAnalyser.getValue().value();
-
-      assertValueType(*right, TypeName::F32, "addition", node);
-
-      right->accept(numberValueAnalyser);
-      const auto r = numberValueAnalyser.getValue().value();
-
-      value_ = std::make_unique<Number>(l + r);
-    }
-    else
-      reportError("Operation cannot be performed with value of type "  +
-                  TypeNameStrings.at(left->getType()) + "!", node);
-  }
-  else {
-    assertValueType(*left, TypeName::F32,
-            "binary operation " + BinaryOperationNames.at(node.getOperation()), node);
-    assertValueType(*right, TypeName::F32,
-            "binary operation " + BinaryOperationNames.at(node.getOperation()), node);
-
-    NumberValueAnalyser valueAnalyser{};
-    left->accept(valueAnalyser);
-    const auto l = valueAnalyser.getValue().value();
-
-    right->accept(valueAnalyser);
-    const auto r = valueAnalyser.getValue().value();
-
-    auto newValue = l;
-
-    switch (node.getOperation())
-    {
-      case BinaryOperator::BinaryAnd:
-        newValue = static_cast<unsigned int>(l) & static_cast<unsigned int>(r);
-        break;
-      case BinaryOperator::BinaryOr:
-        newValue = static_cast<unsigned int>(l) | static_cast<unsigned int>(r);
-        break;
-      case BinaryOperator::BinaryXor:
-        newValue = static_cast<unsigned int>(l) ^ static_cast<unsigned int>(r);
-        break;
-      case BinaryOperator::Division:
-        newValue = l / r;
-        break;
-      case BinaryOperator::Equal:
-        newValue = l == r ? 1 : 0;
-        break;
-        case BinaryOperator::Greater:
-        newValue = l > r ? 1 : 0;
-        break;
-      case BinaryOperator::GreaterEq:
-        newValue = l >= r ? 1 : 0;
-        break;
-      case BinaryOperator::Less:
-        newValue = l < r ? 1 : 0;
-        break;
-      case BinaryOperator::LessEq:
-        newValue = l <= r ? 1 : 0;
-        break;
-      case BinaryOperator::LogicalAnd:
-        newValue = l && r;
-        break;
-      case BinaryOperator::LogicalOr:
-        newValue = l || r;
-        break;
-      case BinaryOperator::Modulo:
-        newValue = std::fmod(l, r);
-        break;
-      case BinaryOperator::Multiplication:
-        newValue = l * r;
-        break;
-      case BinaryOperator::NotEqual:
-        newValue = l != r ? 1 : 0;
-        break;
-      case BinaryOperator::ShiftLeft:
-        newValue = static_cast<unsigned int>(l) << static_cast<unsigned int>(r);
-        break;
-      case BinaryOperator::ShiftRight:
-        newValue = static_cast<unsigned int>(l) >> static_cast<unsigned int>(r);
-        break;
-      case BinaryOperator::Subtraction:
-        newValue = l - r;
-        break;
-      case BinaryOperator::Addition:
-        break; // Unreachable
-    }
-
-    value_ = std::make_unique<Number>(newValue);
-  }
+  value_ = applyBinaryOperation(node, *left, *right);
 }
 
 void Executor::visit(const BlockNode& node)
 {
   for(const auto& statement: node.getStatements())
-   statement->accept(*this);
+  {
+    statement->accept(*this);
+    if(returned_)
+    {
+      returned_ = false;
+      break;
+    }
+  }
 }
 
 void Executor::visit(const FunctionCallNode& node)
@@ -226,6 +186,9 @@ void Executor::visit(const FunctionCallNode& node)
     handleIf(node);
   else
   {
+    if(profile_)
+      profile_->recordCall(node);
+
     const auto symbol = context_.lookup(name);
     auto functionAnalyser = RuntimeFunctionAnalyser{};
     symbol.value().get().accept(functionAnalyser);
@@ -263,6 +226,9 @@ void Executor::visit(const FunctionDeclarationNode& node)
 
 void Executor::visit(const FunctionResultCallNode& node)
 {
+  if(profile_)
+    profile_->recordCall(node);
+
   node.getCall().accept(*this);
   assertValueType(*value_, TypeName::Function, "function call", node);
 
@@ -271,19 +237,17 @@ void Executor::visit(const FunctionResultCallNode& node)
 
 void Executor::visit(const LambdaCallNode& node)
 {
+  if(profile_)
+    profile_->recordCall(node);
+
   const auto& lambda = node.getLambda();
+  auto arguments = bindArguments(node, lambda.getArguments());
   context_.enterScope();
 
-  auto it = node.getArguments().begin();
-  for(const auto& arg : lambda.getArguments())
+  for(auto& argSymbol : arguments)
   {
-    const auto argName = arg.first;
-    const auto type = arg.second;
-    std::shared_ptr<ExpressionNode> value = *it;
-    auto argSymbol = std::make_unique<RuntimeVariableSymbol>(argName, type, value, context_.clone());
+    const auto argName = argSymbol->getName();
     context_.addSymbol(argName, std::move(argSymbol));
-
-    ++it;
   }
 
   lambda.getBody().accept(*this);
@@ -304,6 +268,16 @@ void Executor::visit(const NumericLiteralNode& node)
 
 void Executor::visit(const ProgramNode& node)
 {
+  if(profile_)
+    profile_->addProgram(node);
+  if(memoTable_)
+    registerMemoizableFunctions(*memoTable_, node);
+  if(jit_)
+    jit_->compile(node);
+  if(speculator_)
+    speculator_->addProgram(node);
+  reassigned_ = std::make_shared<const std::unordered_set<std::string>>(findReassignedNames(node));
+
   for(const auto& variable : node.getVariables())
     variable->accept(*this);
 
@@ -328,6 +302,7 @@ void Executor::visit(const ReturnNode& node)
   node.getValue().accept(*this);
   auto returnedValue = value_->clone();
   returnStack_.emplace(std::move(returnedValue));
+  returned_ = true;
 }
 
 void Executor::visit(const StringLiteralNode& node)
@@ -338,28 +313,7 @@ void Executor::visit(const StringLiteralNode& node)
 void Executor::visit(const UnaryNode& node)
 {
   node.getTerm().accept(*this);
-
-  assertValueType(*value_, TypeName::F32,
-    "unary operation " + UnaryOperationNames.at(node.getOperation()), node);
-
-  NumberValueAnalyser analyser{};
-  value_->accept(analyser);
-  auto term = analyser.getValue().value();
-  auto newValue = term;
-  switch(node.getOperation())
-  {
-    case UnaryOperator::BinaryNegation:
-      newValue = ~static_cast<unsigned int>(term);
-      break;
-    case UnaryOperator::LogicalNot:
-      newValue = term == 0 ? 1 : 0;
-      break;
-    case UnaryOperator::Minus:
-      newValue = -term;
-      break;
-  }
-
-  value_ = std::make_unique<Number>(newValue);
+  value_ = applyUnaryOperation(node, *value_);
 }
 
 void Executor::visit(const VariableDeclarationNode& node)
@@ -367,8 +321,32 @@ void Executor::visit(const VariableDeclarationNode& node)
   const auto name = node.getName();
   const auto type = node.getType();
   auto value = node.getValue();
+  auto cell = node.isShared() ? std::make_shared<ValueCell>() : nullptr;
 
-  auto symbol = std::make_unique<RuntimeVariableSymbol>(name, type, value, context_.clone());
+  if(strict_)
+  {
+    auto symbol = bindValue(name, type, value, context_, std::move(cell));
+    symbol->setMark(node.getMark());
+    context_.addSymbol(name, std::move(symbol));
+    return;
+  }
+
+  if(profile_)
+    profile_->recordBinding(*value);
+
+  auto literal = speculator_ ? speculator_->speculate(value, context_) : nullptr;
+  if(literal && !speculator_->isReassigned(name))
+  {
+    auto symbol = std::make_unique<RuntimeVariableSymbol>(name, type, std::move(literal), speculator_->getContext(),
+      std::move(cell));
+    symbol->setMark(node.getMark());
+    context_.addSymbol(name, std::move(symbol));
+    return;
+  }
+
+  auto symbol = std::make_unique<RuntimeVariableSymbol>(name, type, literal ? std::move(literal) : value,
+    context_.clone(), std::move(cell));
+  symbol->setMark(node.getMark());
   context_.addSymbol(name, std::move(symbol));
 }
 
@@ -385,11 +363,16 @@ void Executor::visit(const VariableNode& node)
 
   if(analyser.isSymbolValid())
   {
-    const auto& value = analyser.getValue();
-    auto executor = Executor{analyser.getContext()};
+    const auto& cell = analyser.getCell();
+    if(cell && cell->value)
+    {
+      value_ = cell->value->clone();
+      return;
+    }
 
-    value->accept(executor);
-    value_ = executor.getValue()->clone();
+    value_ = force(analyser);
+    if(cell)
+      cell->value = value_->clone();
   }
   else
   {
@@ -404,6 +387,85 @@ void Executor::visit(const VariableNode& node)
   }
 }
 
+void Executor::visit(const NumericBinaryOpNode& node)
+{
+  if(node.isInteger())
+  {
+    value_ = std::make_unique<Number>(static_cast<double>(evaluateInteger(node)));
+    return;
+  }
+
+  node.getLeftOperand().accept(*this);
+  auto left = std::move(value_);
+
+  node.getRightOperand().accept(*this);
+  auto right = std::move(value_);
+
+  value_ = applyNumericBinaryOperation(node, *left, *right);
+}
+
+/*
+ * Parameters are forced when the loop first reads them. Result is evaluated in a
+ * scope binding their final values, like the innermost call would evaluate it.
+ * Parameters which are not numbers (the analysis trusts declared types) are left
+ * to the recursive calls.
+ */
+void Executor::visit(const LoopNode& node)
+{
+  LoopEvaluator loop{node};
+  while(const auto variable = loop.run())
+  {
+    variable->accept(*this);
+    if(value_->getType() != TypeName::F32)
+    {
+      Executor::visit(static_cast<const ReturnNode&>(node));
+      return;
+    }
+
+    NumberValueAnalyser analyser{};
+    value_->accept(analyser);
+    loop.setValue(analyser.getValue().value());
+  }
+
+  if(loop.hasIterated())
+  {
+    context_.enterScope();
+    loop.bindParameters(context_);
+    node.getResult().accept(*this);
+    context_.leaveScope();
+  }
+  else
+    node.getResult().accept(*this);
+
+  returnStack_.emplace(value_->clone());
+  returned_ = true;
+}
+
+// Nested integer operations pass their results on as int64, instead of as boxed numbers.
+std::int64_t Executor::evaluateInteger(const NumericBinaryOpNode& node)
+{
+  const auto left = evaluateIntegerOperand(node.getLeftOperand(), node);
+  const auto right = evaluateIntegerOperand(node.getRightOperand(), node);
+  return node.evaluateInteger(left, right);
+}
+
+std::int64_t Executor::evaluateIntegerOperand(const ExpressionNode& operand, const NumericBinaryOpNode& node)
+{
+  IntegerOperandAnalyser analyser{};
+  operand.accept(analyser);
+  if(analyser.operation)
+    return evaluateInteger(*analyser.operation);
+  if(analyser.literal)
+    return static_cast<std::int64_t>(analyser.literal->getValue());
+
+  // Other operands were proven to evaluate to integers, which numbers represent exactly.
+  operand.accept(*this);
+  assertValueType(*value_, TypeName::F32, "binary operation " + BinaryOperationNames.at(node.getOperation()), node);
+  NumberValueAnalyser valueAnalyser{};
+  value_->accept(valueAnalyser);
+  return static_cast<std::int64_t>(valueAnalyser.getValue().value());
+}
+
 void Executor::handlePrint(const FunctionCallNode& node)
 {
   const auto& args = node.getArguments();
@@ -417,7 +479,8 @@ void Executor::handlePrint(const FunctionCallNode& node)
   value_->accept(analyser);
 
   const auto str = analyser.getValue().value();
-  stdout_ << str << "\n";
+  if(!discarding_)
+    stdout_ << str << "\n";
 }
 
 void Executor::handleIf(const FunctionCallNode& node)
@@ -433,8 +496,10 @@ void Executor::handleIf(const FunctionCallNode& node)
   NumberValueAnalyser analyser{};
   value_->accept(analyser);
   const auto condition = analyser.getValue().value();
+  if(profile_)
+    profile_->recordBranch(node, isTrue(condition));
 
-  if(std::fabs(condition) > 0.0001)
+  if(isTrue(condition))
   {
     it++;
     (*it)->accept(*this);
@@ -445,29 +510,63 @@ void Executor::handleIf(const FunctionCallNode& node)
   }
 }
 
-void Executor::handleVariableCall(const FunctionCallNode& node, const RuntimeVariableAnalyser& variableAnalyser)
+/*
+ * Expression of variable is evaluated in a separate executor with its captured context.
+ * Variable stays marked while it is evaluated, so one which depends on itself is
+ * reported at its binding instead of recursing until the stack overflows.
+ */
+std::unique_ptr<Value> Executor::force(const RuntimeVariableAnalyser& variable)
 {
-  const auto value = variableAnalyser.getValue();
-  auto executor = Executor{variableAnalyser.getContext()};
+  const auto& value = variable.getValue();
+  if(profile_)
+    profile_->recordForce(*value);
+
+  ForcedVariableGuard guard{*forced_, variable};
+  Executor executor{variable.getContext(), *this};
   value->accept(executor);
+  return std::move(executor.value_);
+}
 
-  callValue(node, node.getName(), *executor.getValue());
+void Executor::handleVariableCall(const FunctionCallNode& node, const RuntimeVariableAnalyser& variableAnalyser)
+{
+  // Forced variable is called straight from its cell, like it would be read.
+  const auto& cell = variableAnalyser.getCell();
+  if(cell && cell->value)
+  {
+    callValue(node, node.getName(), *cell->value);
+    return;
+  }
+
+  const auto callee = force(variableAnalyser);
+  if(cell)
+    cell->value = callee->clone();
+
+  callValue(node, node.getName(), *callee);
 }
 
 void Executor::handleFunctionCall(const FunctionCallNode& node, const RuntimeFunctionAnalyser& functionAnalyser)
 {
+  if(memoTable_ && memoTable_->isMemoizable(functionAnalyser.getBody().get()))
+  {
+    handleMemoizedCall(node, functionAnalyser);
+    return;
+  }
+
+  const auto native = jit_ ? jit_->lookup(functionAnalyser.getBody().get()) : nullptr;
+  if(native)
+  {
+    const auto arguments = forceArguments(node);
+    value_ = std::make_unique<Number>(native(arguments.data()));
+    return;
+  }
+
+  auto arguments = bindArguments(node, functionAnalyser.getArguments());
   context_.enterScope();
 
-  auto it = node.getArguments().begin();
-  for (const auto &arg : functionAnalyser.getArguments())
+  for(auto& argSymbol : arguments)
   {
-    const auto argName = arg.first;
-    const auto type = arg.second;
-    std::shared_ptr<ExpressionNode> value = *it;
-    auto argSymbol = std::make_unique<RuntimeVariableSymbol>(argName, type, value, context_.clone());
+    const auto argName = argSymbol->getName();
     context_.addSymbol(argName, std::move(argSymbol));
-
-    ++it;
   }
 
   functionAnalyser.getBody()->accept(*this);
@@ -481,41 +580,181 @@ void Executor::handleFunctionCall(const FunctionCallNode& node, const RuntimeFun
   }
 }
 
-void Executor::callValue(const CallNode& node, const std::string& name, const Value& value)
+void Executor::handleMemoizedCall(const FunctionCallNode& node, const RuntimeFunctionAnalyser& functionAnalyser)
 {
-  auto valueAnalyser = FunctionValueAnalyser{};
-  value.accept(valueAnalyser);
+  const auto arguments = forceArguments(node);
+
+  const auto body = functionAnalyser.getBody().get();
+  const auto cached = memoTable_->lookup(body, arguments);
+  if(cached.has_value())
+  {
+    value_ = std::make_unique<Number>(cached.value());
+    return;
+  }
 
-  const auto nExpectedArgs = valueAnalyser.getArguments()->size();
-  const auto nProvidedArgs = node.getArguments().size();
-  if(nExpectedArgs != nProvidedArgs)
-    reportError("Function " + name + " expected " +
-                std::to_string(nExpectedArgs) + ", but got " + std::to_string(nProvidedArgs) + " arguments!", node);
+  context_.enterScope();
 
-  Context newContext = valueAnalyser.getContext()->clone();
+  auto it = arguments.begin();
+  for(const auto& arg : functionAnalyser.getArguments())
+  {
+    auto value = std::make_shared<NumericLiteralNode>(*it);
+    auto argSymbol = std::make_unique<RuntimeVariableSymbol>(arg.first, arg.second, value, Context{});
+    context_.addSymbol(arg.first, std::move(argSymbol));
+
+    ++it;
+  }
+
+  body->accept(*this);
+
+  context_.leaveScope();
+
+  value_ = std::move(returnStack_.top());
+  returnStack_.pop();
+
+  NumberValueAnalyser valueAnalyser{};
+  value_->accept(valueAnalyser);
+  if(valueAnalyser.isValid())
+    memoTable_->insert(body, arguments, valueAnalyser.getValue().value());
+}
+
+/*
+ * Memoizable (and compiled) functions are strict in all of their numeric arguments,
+ * so arguments can be forced before the call without changing program's behaviour.
+ */
+std::vector<double> Executor::forceArguments(const FunctionCallNode& node)
+{
+  std::vector<double> arguments{};
+  for(const auto& arg : node.getArguments())
+  {
+    Executor executor{context_, *this};
+    arg->accept(executor);
+    assertValueType(*executor.getValue(), TypeName::F32, "function call", node);
+
+    NumberValueAnalyser valueAnalyser{};
+    executor.getValue()->accept(valueAnalyser);
+    arguments.push_back(valueAnalyser.getValue().value());
+  }
+  return arguments;
+}
+
+void Executor::callValue(const CallNode& node, const std::string& name, const Value& value)
+{
+  const auto& function = resolveCallee(node, name, value);
+  if(profile_)
+    profile_->recordTarget(node, function.getBody());
+
+  Context newContext = function.getContext().clone();
 
   newContext.enterScope();
 
   auto it = node.getArguments().begin();
-  for (const auto &arg : valueAnalyser.getArguments().value())
+  for (const auto &arg : function.getArguments())
   {
-    const auto argName = arg.first;
-    const auto type = arg.second;
-    std::shared_ptr<ExpressionNode> argValue = *it;
-    auto argSymbol = std::make_unique<RuntimeVariableSymbol>(argName, type, argValue, newContext.clone());
-    newContext.addSymbol(argName, std::move(argSymbol));
+    std::shared_ptr<const Context> argContext{};
+    auto argSymbol = bindArgument(arg, *it, newContext, argContext);
+    newContext.addSymbol(arg.first, std::move(argSymbol));
 
     ++it;
   }
 
-  Executor functionExecutor{newContext};
-  valueAnalyser.getBody()->accept(functionExecutor);
+  Executor functionExecutor{newContext, *this};
+  function.getBody().accept(functionExecutor);
 
   newContext.leaveScope();
 
   stdout_ << functionExecutor.getStandardOut();
-  if (valueAnalyser.getReturnType() != TypeName::Void)
+  if (function.getReturnType() != TypeName::Void)
   {
     value_ = functionExecutor.getValue()->clone();
   }
-}
\ No newline at end of file
+}
+/*
+ * Arguments are evaluated in the caller's context, without any of the parameters.
+ * The context is copied only when some argument has to stay lazy.
+ */
+std::vector<std::unique_ptr<RuntimeVariableSymbol>> Executor::bindArguments(const CallNode& node,
+  const RuntimeFunctionAnalyser::ArgumentsList& parameters)
+{
+  std::vector<std::unique_ptr<RuntimeVariableSymbol>> arguments{};
+  std::shared_ptr<const Context> argContext{};
+
+  auto it = node.getArguments().begin();
+  for(const auto& parameter : parameters)
+  {
+    arguments.push_back(bindArgument(parameter, *it, context_, argContext));
+    ++it;
+  }
+  return arguments;
+}
+
+// Binds speculated value of the argument if there is one, otherwise its expression in a copy of given context.
+std::unique_ptr<RuntimeVariableSymbol> Executor::bindArgument(const std::pair<std::string, TypeName>& parameter,
+  const std::shared_ptr<ExpressionNode>& value, const Context& context, std::shared_ptr<const Context>& argContext)
+{
+  if(strict_)
+    return bindValue(parameter.first, parameter.second, value, context, nullptr);
+
+  // Reassigned parameter evaluates its new expression in the context of the argument.
+  if(!reassigned_ || reassigned_->count(parameter.first) == 0)
+  {
+    auto symbol = bindDirectly(parameter, value, context);
+    if(symbol)
+      return symbol;
+  }
+
+  if(profile_)
+    profile_->recordBinding(*value);
+
+  auto literal = speculator_ ? speculator_->speculate(value, context) : nullptr;
+  if(literal && !speculator_->isReassigned(parameter.first))
+    return std::make_unique<RuntimeVariableSymbol>(parameter.first, parameter.second, std::move(literal),
+      speculator_->getContext(), nullptr);
+
+  if(!argContext)
+    argContext = std::make_shared<const Context>(context.clone());
+  return std::make_unique<RuntimeVariableSymbol>(parameter.first, parameter.second, literal ? std::move(literal) : value,
+    argContext, nullptr);
+}
+
+/*
+ * Binds variable to the value of expression evaluated right away in a copy of given
+ * context, the one a thunk would capture, so assignments made by called functions
+ * do not reach the live context, as they would not when the thunk is forced.
+ * Numbers and strings are bound as literals, which need the context only if the
+ * variable can be reassigned. Other values are kept in a cell next to the expression.
+ */
+std::unique_ptr<RuntimeVariableSymbol> Executor::bindValue(const std::string& name, const TypeName& type,
+  const std::shared_ptr<ExpressionNode>& value, const Context& context, std::shared_ptr<ValueCell> cell)
+{
+  std::unique_ptr<Value> result{};
+  const auto discarding = discarding_;
+  discarding_ = true;
+  Executor executor{context.clone(), *this};
+  value->accept(executor);
+  result = std::move(executor.value_);
+  discarding_ = discarding;
+
+  std::shared_ptr<ExpressionNode> literal{};
+  if(result->getType() == TypeName::F32)
+  {
+    NumberValueAnalyser analyser{};
+    result->accept(analyser);
+    literal = std::make_shared<NumericLiteralNode>(analyser.getValue().value());
+  }
+  else if(result->getType() == TypeName::String)
+  {
+    StringValueAnalyser analyser{};
+    result->accept(analyser);
+    literal = std::make_shared<StringLiteralNode>(analyser.getValue().value());
+  }
+
+  if(literal && (!reassigned_ || reassigned_->count(name) == 0))
+    return std::make_unique<RuntimeVariableSymbol>(name, type, std::move(literal), emptyContext(), std::move(cell));
+  if(literal)
+    return std::make_unique<RuntimeVariableSymbol>(name, type, std::move(literal), context.clone(), std::move(cell));
+
+  if(!cell)
+    cell = std::make_shared<ValueCell>();
+  cell->value = std::move(result);
+  return std::make_unique<RuntimeVariableSymbol>(name, type, value, context.clone(), std::move(cell));
+}
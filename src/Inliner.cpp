@@ -0,0 +1,166 @@
+#include "Inliner.hpp"
+
+#include <algorithm>
+
+namespace
+{
+
+// Largest returned expression, in nodes, which is inlined.
+constexpr std::size_t MaxSize = 32;
+
+// Counts nodes of an expression and finds out whether it calls anything but if.
+class ExpressionMeasurer : public Visitor
+{
+public:
+  ExpressionMeasurer(): size(0), calls(false) {}
+
+  std::size_t size;
+  bool calls;
+
+  void visit(const AssignmentNode&) override { calls = true; }
+
+  void visit(const BinaryOpNode& node) override
+  {
+    ++size;
+    node.getLeftOperand().accept(*this);
+    node.getRightOperand().accept(*this);
+  }
+
+  void visit(const BlockNode&) override { calls = true; }
+
+  void visit(const FunctionCallNode& node) override
+  {
+    ++size;
+    if(node.getName() != "if")
+      calls = true;
+    for(const auto& arg : node.getArguments())
+      arg->accept(*this);
+  }
+
+  void visit(const FunctionCallStatementNode&) override { calls = true; }
+  void visit(const FunctionDeclarationNode&) override { calls = true; }
+  void visit(const FunctionResultCallNode&) override { calls = true; }
+  void visit(const LambdaCallNode&) override { calls = true; }
+  void visit(const LambdaNode&) override { calls = true; }
+  void visit(const NumericLiteralNode&) override { ++size; }
+  void visit(const ProgramNode&) override { calls = true; }
+  void visit(const ReturnNode&) override { calls = true; }
+  void visit(const StringLiteralNode&) override { ++size; }
+
+  void visit(const UnaryNode& node) override
+  {
+    ++size;
+    node.getTerm().accept(*this);
+  }
+
+  void visit(const VariableDeclarationNode&) override { calls = true; }
+  void visit(const VariableNode&) override { ++size; }
+};
+
+class ReturnAnalyser : public Visitor
+{
+public:
+  ReturnAnalyser(): value(nullptr) {}
+
+  const ExpressionNode* value;
+
+  void visit(const AssignmentNode&) override {}
+  void visit(const BinaryOpNode&) override {}
+  void visit(const BlockNode&) override {}
+  void visit(const FunctionCallNode&) override {}
+  void visit(const FunctionCallStatementNode&) override {}
+  void visit(const FunctionDeclarationNode&) override {}
+  void visit(const FunctionResultCallNode&) override {}
+  void visit(const LambdaCallNode&) override {}
+  void visit(const LambdaNode&) override {}
+  void visit(const NumericLiteralNode&) override {}
+  void visit(const ProgramNode&) override {}
+  void visit(const ReturnNode& node) override { value = &node.getValue(); }
+  void visit(const StringLiteralNode&) override {}
+  void visit(const UnaryNode&) override {}
+  void visit(const VariableDeclarationNode&) override {}
+  void visit(const VariableNode&) override {}
+};
+
+bool calls(const ExpressionNode& expression)
+{
+  ExpressionMeasurer measurer{};
+  expression.accept(measurer);
+  return measurer.calls;
+}
+
+}
+
+Inliner::Inliner(std::shared_ptr<Profile> profile, std::uint64_t threshold):
+  profile_(std::move(profile)), threshold_(threshold), analysis_(), purity_(), inlinable_(), arguments_(),
+  inlined_(0) {}
+
+// Arguments are inlined first, so calls whose arguments only called inlined functions are inlined as well.
+void Inliner::visit(const FunctionCallNode& node)
+{
+  auto args = cloneArguments(node.getArguments());
+  const auto inlinable = inlinable_.find(node.getName());
+  const auto calls = profile_->getCalls(node);
+  if(inlinable == inlinable_.end() || !calls || *calls < threshold_ ||
+    inlinable->second.function->getArguments().size() != args.size() ||
+    std::any_of(args.begin(), args.end(), [](const std::shared_ptr<ExpressionNode>& arg) { return ::calls(*arg); }))
+  {
+    setResult(std::make_unique<FunctionCallNode>(node.getName(), std::move(args)), node);
+    return;
+  }
+
+  auto it = args.begin();
+  for(const auto& parameter : inlinable->second.function->getArguments())
+    arguments_[parameter.first] = (it++)->get();
+
+  auto result = clone<ExpressionNode>(*inlinable->second.result);
+  arguments_.clear();
+  result_ = std::move(result);
+  ++inlined_;
+}
+
+void Inliner::visit(const ProgramNode& node)
+{
+  purity_ = analysePurity(node, analysis_);
+  profile_->addProgram(node);
+
+  inlinable_.clear();
+  for(const auto& function : node.getFunctions())
+  {
+    const auto& name = function->getName();
+    const auto& statements = function->getBody()->getStatements();
+    if(name == "main" || purity_->isShadowed(name) || function->getReturnType() == TypeName::Void ||
+      statements.size() != 1)
+      continue;
+
+    ReturnAnalyser analyser{};
+    statements.front()->accept(analyser);
+    if(!analyser.value)
+      continue;
+
+    ExpressionMeasurer measurer{};
+    analyser.value->accept(measurer);
+    if(!measurer.calls && measurer.size <= MaxSize)
+      inlinable_[name] = Inlinable{function.get(), analyser.value};
+  }
+
+  ASTCloner::visit(node);
+}
+
+// Arguments are cloned without substitution, their names belong to the caller.
+void Inliner::visit(const VariableNode& node)
+{
+  const auto argument = arguments_.find(node.getName());
+  if(argument == arguments_.end())
+  {
+    ASTCloner::visit(node);
+    return;
+  }
+
+  const auto& expression = *argument->second;
+  auto arguments = std::move(arguments_);
+  arguments_.clear();
+  auto result = clone<ExpressionNode>(expression);
+  arguments_ = std::move(arguments);
+  result_ = std::move(result);
+}
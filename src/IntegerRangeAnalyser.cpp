@@ -0,0 +1,247 @@
+#include "IntegerRangeAnalyser.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+namespace
+{
+
+// Integers up to this magnitude are represented exactly by numbers.
+constexpr std::int64_t MaxExact = std::int64_t{1} << 53;
+constexpr std::int64_t MaxUnsigned = 0xFFFFFFFF;
+
+bool fitsUnsigned(const IntegerRange& range) { return range.min >= 0 && range.max <= MaxUnsigned; }
+bool isShiftAmount(const IntegerRange& range) { return range.min >= 0 && range.max < 32; }
+bool contains(const IntegerRange& range, std::int64_t value) { return range.min <= value && value <= range.max; }
+std::int64_t magnitude(std::int64_t value) { return value < 0 ? -value : value; }
+
+std::optional<IntegerRange> bounded(std::int64_t min, std::int64_t max)
+{
+  if(min < -MaxExact || max > MaxExact)
+    return {};
+  return IntegerRange{min, max};
+}
+
+// Smallest number of the form 2^k - 1 which is not less than value.
+std::int64_t mask(std::int64_t value)
+{
+  std::int64_t result = 0;
+  while(result < value)
+    result = result * 2 + 1;
+  return result;
+}
+
+std::optional<IntegerRange> multiply(const IntegerRange& l, const IntegerRange& r)
+{
+  // Zero times a negative number is negative zero.
+  if((contains(l, 0) && r.min < 0) || (contains(r, 0) && l.min < 0))
+    return {};
+
+  std::int64_t min = MaxExact;
+  std::int64_t max = -MaxExact;
+  for(const auto a : {l.min, l.max})
+  {
+    for(const auto b : {r.min, r.max})
+    {
+      if(a != 0 && magnitude(b) > MaxExact / magnitude(a))
+        return {};
+      min = std::min(min, a * b);
+      max = std::max(max, a * b);
+    }
+  }
+  return bounded(min, max);
+}
+
+// Range of the result if evaluating the operation with int64 gives the same number.
+std::optional<IntegerRange> exactRange(const BinaryOperator& operation, const IntegerRange& l, const IntegerRange& r)
+{
+  switch(operation)
+  {
+    case BinaryOperator::Addition:
+      return bounded(l.min + r.min, l.max + r.max);
+    case BinaryOperator::Subtraction:
+      return bounded(l.min - r.max, l.max - r.min);
+    case BinaryOperator::Multiplication:
+      return multiply(l, r);
+    case BinaryOperator::Division:
+      return {};
+    case BinaryOperator::Modulo:
+    {
+      // Remainder of a negative number may be negative zero.
+      if(l.min < 0 || contains(r, 0))
+        return {};
+      const auto divisor = std::max(magnitude(r.min), magnitude(r.max));
+      return IntegerRange{0, std::min(l.max, divisor - 1)};
+    }
+    case BinaryOperator::BinaryAnd:
+      if(!fitsUnsigned(l) || !fitsUnsigned(r))
+        return {};
+      return IntegerRange{0, std::min(l.max, r.max)};
+    case BinaryOperator::BinaryOr:
+    case BinaryOperator::BinaryXor:
+      if(!fitsUnsigned(l) || !fitsUnsigned(r))
+        return {};
+      return IntegerRange{0, mask(std::max(l.max, r.max))};
+    case BinaryOperator::ShiftLeft:
+      if(!fitsUnsigned(l) || !isShiftAmount(r))
+        return {};
+      if((l.max << r.max) > MaxUnsigned)
+        return IntegerRange{0, MaxUnsigned};
+      return IntegerRange{l.min << r.min, l.max << r.max};
+    case BinaryOperator::ShiftRight:
+      if(!fitsUnsigned(l) || !isShiftAmount(r))
+        return {};
+      return IntegerRange{l.min >> r.max, l.max >> r.min};
+    case BinaryOperator::Equal:
+    case BinaryOperator::NotEqual:
+    case BinaryOperator::Greater:
+    case BinaryOperator::GreaterEq:
+    case BinaryOperator::Less:
+    case BinaryOperator::LessEq:
+    case BinaryOperator::LogicalAnd:
+    case BinaryOperator::LogicalOr:
+      return IntegerRange{0, 1};
+  }
+
+  return {}; // Unreachable
+}
+
+// Range of operations whose result does not depend on knowing both operands.
+std::optional<IntegerRange> resultRange(const BinaryOperator& operation,
+  const std::optional<IntegerRange>& l, const std::optional<IntegerRange>& r)
+{
+  switch(operation)
+  {
+    case BinaryOperator::BinaryAnd:
+    {
+      auto max = MaxUnsigned;
+      if(l && fitsUnsigned(*l))
+        max = std::min(max, l->max);
+      if(r && fitsUnsigned(*r))
+        max = std::min(max, r->max);
+      return IntegerRange{0, max};
+    }
+    case BinaryOperator::ShiftRight:
+      if(l && fitsUnsigned(*l))
+        return IntegerRange{0, l->max};
+      return IntegerRange{0, MaxUnsigned};
+    case BinaryOperator::BinaryOr:
+    case BinaryOperator::BinaryXor:
+    case BinaryOperator::ShiftLeft:
+      return IntegerRange{0, MaxUnsigned};
+    case BinaryOperator::Equal:
+    case BinaryOperator::NotEqual:
+    case BinaryOperator::Greater:
+    case BinaryOperator::GreaterEq:
+    case BinaryOperator::Less:
+    case BinaryOperator::LessEq:
+    case BinaryOperator::LogicalAnd:
+    case BinaryOperator::LogicalOr:
+      return IntegerRange{0, 1};
+    default:
+      return {};
+  }
+}
+
+class RangeFinder : public Visitor
+{
+public:
+  RangeFinder(IntegerRangeAnalyser& analyser): range(), analyser_(analyser) {}
+
+  std::optional<IntegerRange> range;
+
+  void visit(const AssignmentNode&) override {}
+
+  void visit(const BinaryOpNode& node) override
+  {
+    const auto l = analyser_.getRange(node.getLeftOperand());
+    const auto r = analyser_.getRange(node.getRightOperand());
+    if(l && r)
+      range = exactRange(node.getOperation(), *l, *r);
+    if(!range)
+      range = resultRange(node.getOperation(), l, r);
+  }
+
+  void visit(const BlockNode&) override {}
+
+  void visit(const FunctionCallNode& node) override
+  {
+    const auto& args = node.getArguments();
+    if(node.getName() != "if" || args.size() != 3)
+      return;
+
+    const auto whenTrue = analyser_.getRange(**std::next(args.begin()));
+    const auto whenFalse = analyser_.getRange(*args.back());
+    if(whenTrue && whenFalse)
+      range = IntegerRange{std::min(whenTrue->min, whenFalse->min), std::max(whenTrue->max, whenFalse->max)};
+  }
+
+  void visit(const FunctionCallStatementNode&) override {}
+  void visit(const FunctionDeclarationNode&) override {}
+  void visit(const FunctionResultCallNode&) override {}
+  void visit(const LambdaCallNode&) override {}
+  void visit(const LambdaNode&) override {}
+
+  void visit(const NumericLiteralNode& node) override
+  {
+    const auto value = node.getValue();
+    if(value == std::trunc(value) && !std::signbit(value) && value <= static_cast<double>(MaxExact))
+    {
+      const auto integer = static_cast<std::int64_t>(value);
+      range = IntegerRange{integer, integer};
+    }
+  }
+
+  void visit(const ProgramNode&) override {}
+  void visit(const ReturnNode&) override {}
+  void visit(const StringLiteralNode&) override {}
+
+  void visit(const UnaryNode& node) override
+  {
+    const auto term = analyser_.getRange(node.getTerm());
+    switch(node.getOperation())
+    {
+      case UnaryOperator::BinaryNegation:
+        range = IntegerRange{0, MaxUnsigned};
+        break;
+      case UnaryOperator::LogicalNot:
+        range = IntegerRange{0, 1};
+        break;
+      case UnaryOperator::Minus:
+        // Negated zero is negative zero.
+        if(term && !contains(*term, 0))
+          range = IntegerRange{-term->max, -term->min};
+        break;
+    }
+  }
+
+  void visit(const VariableDeclarationNode&) override {}
+  void visit(const VariableNode&) override {}
+
+private:
+  IntegerRangeAnalyser& analyser_;
+};
+
+}
+
+IntegerRangeAnalyser::IntegerRangeAnalyser(): ranges_() {}
+
+std::optional<IntegerRange> IntegerRangeAnalyser::getRange(const ExpressionNode& node)
+{
+  const auto it = ranges_.find(&node);
+  if(it != ranges_.end())
+    return it->second;
+
+  RangeFinder finder{*this};
+  node.accept(finder);
+  ranges_[&node] = finder.range;
+  return finder.range;
+}
+
+bool IntegerRangeAnalyser::isExact(const BinaryOpNode& node)
+{
+  const auto l = getRange(node.getLeftOperand());
+  const auto r = getRange(node.getRightOperand());
+  return l && r && exactRange(node.getOperation(), *l, *r).has_value();
+}
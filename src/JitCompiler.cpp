@@ -0,0 +1,609 @@
+#include "JitCompiler.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) && defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+#include "PurityAnalyser.hpp"
+
+namespace
+{
+
+using Parameters = std::map<std::string, std::size_t>;
+using Arities = std::map<std::string, std::size_t>;
+
+Parameters parameterIndices(const FunctionDeclarationNode& function)
+{
+  Parameters parameters{};
+  for(const auto& parameter : function.getArguments())
+    parameters.emplace(parameter.first, parameters.size());
+  return parameters;
+}
+
+/*
+ * Finds whether body of a function consists of a return of an expression the
+ * compiler has templates for, and which functions it calls.
+ */
+class TemplateChecker : public Visitor
+{
+public:
+  TemplateChecker(const Parameters& parameters): valid(true), callees(), parameters_(parameters) {}
+
+  bool valid;
+  std::map<std::string, std::size_t> callees;
+
+  void visit(const AssignmentNode&) override { valid = false; }
+
+  void visit(const BinaryOpNode& node) override
+  {
+    switch(node.getOperation())
+    {
+      case BinaryOperator::BinaryAnd:
+      case BinaryOperator::BinaryOr:
+      case BinaryOperator::BinaryXor:
+      case BinaryOperator::ShiftLeft:
+      case BinaryOperator::ShiftRight:
+        valid = false;
+        return;
+      default:
+        break;
+    }
+
+    node.getLeftOperand().accept(*this);
+    node.getRightOperand().accept(*this);
+  }
+
+  // Statements following the return are never executed.
+  void visit(const BlockNode& node) override
+  {
+    if(node.getStatements().empty())
+      valid = false;
+    else
+      node.getStatements().front()->accept(*this);
+  }
+
+  void visit(const FunctionCallNode& node) override
+  {
+    const auto& name = node.getName();
+    if(name == "print" || (name == "if" && node.getArguments().size() != 3))
+    {
+      valid = false;
+      return;
+    }
+
+    if(name != "if")
+      callees[name] = node.getArguments().size();
+    for(const auto& arg : node.getArguments())
+      arg->accept(*this);
+  }
+
+  void visit(const FunctionCallStatementNode&) override { valid = false; }
+  void visit(const FunctionDeclarationNode&) override { valid = false; }
+  void visit(const FunctionResultCallNode&) override { valid = false; }
+  void visit(const LambdaCallNode&) override { valid = false; }
+  void visit(const LambdaNode&) override { valid = false; }
+  void visit(const NumericLiteralNode&) override {}
+  void visit(const ProgramNode&) override { valid = false; }
+  void visit(const ReturnNode& node) override { node.getValue().accept(*this); }
+  void visit(const StringLiteralNode&) override { valid = false; }
+
+  void visit(const UnaryNode& node) override
+  {
+    if(node.getOperation() == UnaryOperator::BinaryNegation)
+      valid = false;
+    else
+      node.getTerm().accept(*this);
+  }
+
+  void visit(const VariableDeclarationNode&) override { valid = false; }
+
+  void visit(const VariableNode& node) override
+  {
+    if(parameters_.find(node.getName()) == parameters_.end())
+      valid = false;
+  }
+
+private:
+  const Parameters& parameters_;
+};
+
+/*
+ * Emits code of a function, which receives pointer to its arguments in rdi and
+ * returns its value in xmm0. Value of every expression is left in xmm0, operands
+ * waiting for the other one are stored in slots below the saved registers:
+ *
+ *   push rbp; mov rbp, rsp; push rbx; sub rsp, frame; mov rbx, rdi
+ *   ...
+ *   lea rsp, [rbp - 8]; pop rbx; pop rbp; ret
+ *
+ * Calls of other compiled functions are emitted with relative addresses, which
+ * are patched once all functions are laid out.
+ */
+class X86Emitter : public Visitor
+{
+public:
+  struct Call
+  {
+    std::size_t position;
+    std::string callee;
+  };
+
+  X86Emitter(std::vector<std::uint8_t>& code, std::vector<Call>& calls, const Profile* profile):
+    code_(code), calls_(calls), profile_(profile), parameters_(), depth_(0), slots_(0) {}
+
+  void emitFunction(const FunctionDeclarationNode& function)
+  {
+    parameters_ = parameterIndices(function);
+    depth_ = 0;
+    slots_ = 0;
+
+    emit({0x55, 0x48, 0x89, 0xE5, 0x53});
+    emit({0x48, 0x81, 0xEC});
+    const auto frame = code_.size();
+    emit32(0);
+    emit({0x48, 0x89, 0xFB});
+
+    function.getBody()->accept(*this);
+
+    emit({0x48, 0x8D, 0x65, 0xF8, 0x5B, 0x5D, 0xC3});
+
+    // Stack stays aligned to 16 bytes for calls made from the function.
+    auto size = static_cast<std::int32_t>(slots_ * 8);
+    if(size % 16 == 0)
+      size += 8;
+    patch32(frame, size);
+  }
+
+  void visit(const AssignmentNode&) override {}
+
+  void visit(const BinaryOpNode& node) override
+  {
+    const auto slot = depth_;
+    node.getLeftOperand().accept(*this);
+    storeSlot(slot);
+
+    ++depth_;
+    node.getRightOperand().accept(*this);
+    --depth_;
+
+    // xmm1 = right, xmm0 = left
+    emit({0x66, 0x0F, 0x28, 0xC8});
+    loadSlot(slot);
+
+    switch(node.getOperation())
+    {
+      case BinaryOperator::Addition: emit({0xF2, 0x0F, 0x58, 0xC1}); break;
+      case BinaryOperator::Subtraction: emit({0xF2, 0x0F, 0x5C, 0xC1}); break;
+      case BinaryOperator::Multiplication: emit({0xF2, 0x0F, 0x59, 0xC1}); break;
+      case BinaryOperator::Division: emit({0xF2, 0x0F, 0x5E, 0xC1}); break;
+      case BinaryOperator::Modulo: callAbsolute(reinterpret_cast<std::uint64_t>(&remainder)); break;
+      case BinaryOperator::Equal: compare(0x00, false); break;
+      case BinaryOperator::Less: compare(0x01, false); break;
+      case BinaryOperator::LessEq: compare(0x02, false); break;
+      case BinaryOperator::NotEqual: compare(0x04, false); break;
+      case BinaryOperator::Greater: compare(0x01, true); break;
+      case BinaryOperator::GreaterEq: compare(0x02, true); break;
+      case BinaryOperator::LogicalAnd: logical(0x54); break;
+      case BinaryOperator::LogicalOr: logical(0x56); break;
+      default: break;
+    }
+  }
+
+  void visit(const BlockNode& node) override
+  {
+    node.getStatements().front()->accept(*this);
+  }
+
+  void visit(const FunctionCallNode& node) override
+  {
+    if(node.getName() == "if")
+    {
+      emitIf(node);
+      return;
+    }
+
+    // Arguments are stored so that they lie in memory in order of parameters.
+    const auto& args = node.getArguments();
+    const auto base = depth_;
+    const auto last = base + args.size() - 1;
+    depth_ += args.size();
+
+    std::size_t i = 0;
+    for(const auto& arg : args)
+    {
+      arg->accept(*this);
+      storeSlot(last - i);
+      ++i;
+    }
+    depth_ = base;
+
+    // lea rdi, [rbp + disp32]
+    emit({0x48, 0x8D, 0xBD});
+    emit32(args.empty() ? -16 : slotDisplacement(last));
+
+    emit({0xE8});
+    calls_.push_back(Call{code_.size(), node.getName()});
+    emit32(0);
+  }
+
+  void visit(const FunctionCallStatementNode&) override {}
+  void visit(const FunctionDeclarationNode&) override {}
+  void visit(const FunctionResultCallNode&) override {}
+  void visit(const LambdaCallNode&) override {}
+  void visit(const LambdaNode&) override {}
+
+  void visit(const NumericLiteralNode& node) override
+  {
+    loadConstant(0, node.getValue());
+  }
+
+  void visit(const ProgramNode&) override {}
+
+  void visit(const ReturnNode& node) override
+  {
+    node.getValue().accept(*this);
+  }
+
+  /*
+   * Parameters are copied to slots of the frame, which rbx then points to, so the
+   * loop can overwrite them. New values are stored in slots above them first, as
+   * every argument reads the old ones:
+   *
+   *   top: condition; jbe/ja end; arguments; parameters = arguments; jmp top
+   *   end: result
+   */
+  void visit(const LoopNode& node) override
+  {
+    const auto count = parameters_.size();
+    const auto base = depth_;
+    const auto last = base + count - 1;
+    for(std::size_t i = 0; i < count; ++i)
+    {
+      loadParameter(i);
+      storeSlot(last - i);
+    }
+    // lea rbx, [rbp + disp32]
+    emit({0x48, 0x8D, 0x9D});
+    emit32(slotDisplacement(last));
+    depth_ += count;
+
+    const auto top = code_.size();
+    node.getCondition().accept(*this);
+    testCondition();
+    emit({0x0F, static_cast<std::uint8_t>(node.recursesWhenTrue() ? 0x86 : 0x87)});
+    const auto end = code_.size();
+    emit32(0);
+
+    const auto arguments = depth_;
+    for(const auto& arg : node.getArguments())
+    {
+      arg->accept(*this);
+      storeSlot(depth_++);
+    }
+    for(std::size_t i = 0; i < count; ++i)
+    {
+      loadSlot(arguments + i);
+      // movsd [rbx + disp32], xmm0
+      emit({0xF2, 0x0F, 0x11, 0x83});
+      emit32(static_cast<std::int32_t>(i * 8));
+    }
+    depth_ = arguments;
+
+    // jmp top
+    emit({0xE9});
+    emit32(static_cast<std::int32_t>(top) - static_cast<std::int32_t>(code_.size() + 4));
+    patch32(end, static_cast<std::int32_t>(code_.size() - (end + 4)));
+
+    node.getResult().accept(*this);
+    depth_ = base;
+  }
+
+  void visit(const StringLiteralNode&) override {}
+
+  void visit(const UnaryNode& node) override
+  {
+    node.getTerm().accept(*this);
+    if(node.getOperation() == UnaryOperator::Minus)
+    {
+      // xorpd xmm0, xmm1 with sign bit
+      loadBits(1, 0x8000000000000000ull);
+      emit({0x66, 0x0F, 0x57, 0xC1});
+    }
+    else
+    {
+      // xorpd xmm1, xmm1; cmpeqsd xmm0, xmm1
+      emit({0x66, 0x0F, 0x57, 0xC9, 0xF2, 0x0F, 0xC2, 0xC1, 0x00});
+      maskToNumber();
+    }
+  }
+
+  void visit(const VariableDeclarationNode&) override {}
+
+  void visit(const VariableNode& node) override
+  {
+    loadParameter(parameters_.at(node.getName()));
+  }
+
+private:
+  static double remainder(double l, double r) { return std::fmod(l, r); }
+
+  void emit(std::initializer_list<std::uint8_t> bytes) { code_.insert(code_.end(), bytes); }
+
+  void emit32(std::int32_t value)
+  {
+    std::uint8_t bytes[4];
+    std::memcpy(bytes, &value, sizeof(bytes));
+    code_.insert(code_.end(), bytes, bytes + sizeof(bytes));
+  }
+
+  void patch32(std::size_t position, std::int32_t value)
+  {
+    std::memcpy(code_.data() + position, &value, sizeof(value));
+  }
+
+  std::int32_t slotDisplacement(std::size_t slot)
+  {
+    return -16 - static_cast<std::int32_t>(slot * 8);
+  }
+
+  void loadParameter(std::size_t index)
+  {
+    // movsd xmm0, [rbx + disp32]
+    emit({0xF2, 0x0F, 0x10, 0x83});
+    emit32(static_cast<std::int32_t>(index * 8));
+  }
+
+  void storeSlot(std::size_t slot)
+  {
+    slots_ = std::max(slots_, slot + 1);
+    // movsd [rbp + disp32], xmm0
+    emit({0xF2, 0x0F, 0x11, 0x85});
+    emit32(slotDisplacement(slot));
+  }
+
+  void loadSlot(std::size_t slot)
+  {
+    // movsd xmm0, [rbp + disp32]
+    emit({0xF2, 0x0F, 0x10, 0x85});
+    emit32(slotDisplacement(slot));
+  }
+
+  // mov rax, imm64; movq xmmN, rax
+  void loadBits(std::uint8_t xmm, std::uint64_t bits)
+  {
+    emit({0x48, 0xB8});
+    for(int i = 0; i < 8; ++i)
+      code_.push_back(static_cast<std::uint8_t>(bits >> (8 * i)));
+    emit({0x66, 0x48, 0x0F, 0x6E, static_cast<std::uint8_t>(0xC0 | (xmm << 3))});
+  }
+
+  void loadConstant(std::uint8_t xmm, double value)
+  {
+    std::uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    loadBits(xmm, bits);
+  }
+
+  // Turns all-ones or zero mask in xmm0 into 1 or 0.
+  void maskToNumber()
+  {
+    loadConstant(1, 1.0);
+    emit({0x66, 0x0F, 0x54, 0xC1});
+  }
+
+  // cmpsd with given predicate, greater comparisons swap operands.
+  void compare(std::uint8_t predicate, bool swapped)
+  {
+    if(swapped)
+    {
+      // movapd xmm2, xmm1; cmpsd xmm2, xmm0; movapd xmm0, xmm2
+      emit({0x66, 0x0F, 0x28, 0xD1, 0xF2, 0x0F, 0xC2, 0xD0, predicate, 0x66, 0x0F, 0x28, 0xC2});
+    }
+    else
+      emit({0xF2, 0x0F, 0xC2, 0xC1, predicate});
+    maskToNumber();
+  }
+
+  // Both operands are compared with zero, masks are combined with andpd or orpd.
+  void logical(std::uint8_t combine)
+  {
+    // xorpd xmm2, xmm2; cmpneqsd xmm0, xmm2; cmpneqsd xmm1, xmm2
+    emit({0x66, 0x0F, 0x57, 0xD2, 0xF2, 0x0F, 0xC2, 0xC2, 0x04, 0xF2, 0x0F, 0xC2, 0xCA, 0x04});
+    emit({0x66, 0x0F, combine, 0xC1});
+    maskToNumber();
+  }
+
+  void callAbsolute(std::uint64_t address)
+  {
+    // mov rax, imm64; call rax
+    emit({0x48, 0xB8});
+    for(int i = 0; i < 8; ++i)
+      code_.push_back(static_cast<std::uint8_t>(address >> (8 * i)));
+    emit({0xFF, 0xD0});
+  }
+
+  // Condition holds when |condition| > 0.0001, as in isTrue.
+  void testCondition()
+  {
+    // andpd xmm0, xmm1 with all bits but sign; ucomisd xmm0, xmm1 with threshold
+    loadBits(1, 0x7FFFFFFFFFFFFFFFull);
+    emit({0x66, 0x0F, 0x54, 0xC1});
+    loadConstant(1, 0.0001);
+    emit({0x66, 0x0F, 0x2E, 0xC1});
+  }
+
+  /*
+   * The branch taken more often according to the profile falls through after the
+   * condition, the other one is jumped to. Without a profile it is the true branch.
+   */
+  void emitIf(const FunctionCallNode& node)
+  {
+    const auto& args = node.getArguments();
+    const auto& whenTrue = **std::next(args.begin());
+    const auto& whenFalse = *args.back();
+    args.front()->accept(*this);
+    testCondition();
+
+    const auto branches = profile_ ? profile_->getBranches(node) : std::nullopt;
+    const auto falseFirst = branches && branches->whenFalse > branches->whenTrue;
+
+    // jbe onFalse, or ja onTrue (not taken for NaN, like jbe is)
+    emit({0x0F, static_cast<std::uint8_t>(falseFirst ? 0x87 : 0x86)});
+    const auto jump = code_.size();
+    emit32(0);
+
+    (falseFirst ? whenFalse : whenTrue).accept(*this);
+
+    // jmp end
+    emit({0xE9});
+    const auto end = code_.size();
+    emit32(0);
+
+    patch32(jump, static_cast<std::int32_t>(code_.size() - (jump + 4)));
+    (falseFirst ? whenTrue : whenFalse).accept(*this);
+    patch32(end, static_cast<std::int32_t>(code_.size() - (end + 4)));
+  }
+
+  std::vector<std::uint8_t>& code_;
+  std::vector<Call>& calls_;
+  const Profile* profile_;
+  Parameters parameters_;
+  std::size_t depth_;
+  std::size_t slots_;
+};
+
+}
+
+JitCompiler::JitCompiler(std::shared_ptr<Profile> feedback): functions_(), feedback_(std::move(feedback)),
+  code_(nullptr), size_(0) {}
+
+JitCompiler::~JitCompiler()
+{
+#if defined(__x86_64__) && defined(__linux__)
+  if(code_)
+    munmap(code_, size_);
+#endif
+}
+
+bool JitCompiler::isSupported()
+{
+#if defined(__x86_64__) && defined(__linux__)
+  return true;
+#else
+  return false;
+#endif
+}
+
+/*
+ * Functions calling something that is not compiled are dropped until only
+ * functions calling each other remain.
+ */
+void JitCompiler::compile(const ProgramNode& program)
+{
+  if(!isSupported() || code_)
+    return;
+
+  PurityAnalyser purity{};
+  program.accept(purity);
+
+  std::map<std::string, const FunctionDeclarationNode*> candidates{};
+  std::map<std::string, Arities> callees{};
+  for(const auto& function : program.getFunctions())
+  {
+    const auto& name = function->getName();
+    if(!purity.isMemoizable(name))
+      continue;
+
+    const auto parameters = parameterIndices(*function);
+    TemplateChecker checker{parameters};
+    function->getBody()->accept(checker);
+    if(!checker.valid)
+      continue;
+
+    candidates[name] = function.get();
+    callees[name] = checker.callees;
+  }
+
+  bool changed = true;
+  while(changed)
+  {
+    changed = false;
+    for(auto it = candidates.begin(); it != candidates.end();)
+    {
+      bool compilable = true;
+      for(const auto& callee : callees.at(it->first))
+      {
+        const auto target = candidates.find(callee.first);
+        compilable = compilable && target != candidates.end() &&
+          target->second->getArguments().size() == callee.second;
+      }
+
+      if(compilable)
+        ++it;
+      else
+      {
+        it = candidates.erase(it);
+        changed = true;
+      }
+    }
+  }
+
+  if(candidates.empty())
+    return;
+
+  if(feedback_)
+    feedback_->addProgram(program);
+
+  std::vector<std::uint8_t> code{};
+  std::vector<X86Emitter::Call> calls{};
+  std::map<std::string, std::size_t> offsets{};
+  X86Emitter emitter{code, calls, feedback_.get()};
+  for(const auto& candidate : candidates)
+  {
+    offsets[candidate.first] = code.size();
+    emitter.emitFunction(*candidate.second);
+  }
+
+  for(const auto& call : calls)
+  {
+    const auto displacement = static_cast<std::int32_t>(offsets.at(call.callee) - (call.position + 4));
+    std::memcpy(code.data() + call.position, &displacement, sizeof(displacement));
+  }
+
+#if defined(__x86_64__) && defined(__linux__)
+  const auto memory = mmap(nullptr, code.size(), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if(memory == MAP_FAILED)
+    return;
+
+  std::memcpy(memory, code.data(), code.size());
+  if(mprotect(memory, code.size(), PROT_READ | PROT_EXEC) != 0)
+  {
+    munmap(memory, code.size());
+    return;
+  }
+
+  code_ = memory;
+  size_ = code.size();
+  for(const auto& candidate : candidates)
+  {
+    const auto address = static_cast<std::uint8_t*>(code_) + offsets.at(candidate.first);
+    functions_[candidate.second->getBody().get()] = reinterpret_cast<NativeFunction>(address);
+  }
+#endif
+}
+
+JitCompiler::NativeFunction JitCompiler::lookup(const BlockNode* body) const
+{
+  const auto it = functions_.find(body);
+  return it != functions_.end() ? it->second : nullptr;
+}
@@ -0,0 +1,302 @@
+#include "LambdaLifter.hpp"
+
+#include <algorithm>
+#include <vector>
+
+#include "RecursiveVisitor.hpp"
+
+namespace
+{
+
+/*
+ * Collects names used by a subtree. Calls and reads nested in lambdas are
+ * gathered separately, as they are evaluated in the context of the closure.
+ */
+class NameUsage : public RecursiveVisitor
+{
+public:
+  NameUsage(): reads(), calls(), nestedNames(), assigned(), declared(), binding(nullptr), lambdas(0), returns(0),
+    depth_(0), lastLambda_(nullptr) {}
+
+  std::map<std::string, std::size_t> reads;
+  std::map<std::string, std::list<const FunctionCallNode*>> calls;
+  std::set<std::string> nestedNames;
+  std::set<std::string> assigned;
+  // Variables declared outside of lambdas.
+  std::map<std::string, TypeName> declared;
+  // Lambda bound directly by a let statement.
+  const LambdaNode* binding;
+  std::size_t lambdas;
+  std::size_t returns;
+
+  std::set<std::string> getNames() const
+  {
+    std::set<std::string> names{nestedNames};
+    for(const auto& read : reads)
+      names.insert(read.first);
+    for(const auto& call : calls)
+      names.insert(call.first);
+    return names;
+  }
+
+  void visit(const AssignmentNode& node) override
+  {
+    assigned.insert(node.getName());
+    RecursiveVisitor::visit(node);
+  }
+
+  void visit(const FunctionCallNode& node) override
+  {
+    const auto& name = node.getName();
+    if(name != "if" && name != "print")
+    {
+      if(depth_ == 0)
+        calls[name].push_back(&node);
+      else
+        nestedNames.insert(name);
+    }
+
+    RecursiveVisitor::visit(node);
+  }
+
+  void visit(const LambdaNode& node) override
+  {
+    ++lambdas;
+    ++depth_;
+    RecursiveVisitor::visit(node);
+    --depth_;
+    lastLambda_ = &node;
+  }
+
+  void visit(const ReturnNode& node) override
+  {
+    ++returns;
+    RecursiveVisitor::visit(node);
+  }
+
+  void visit(const VariableDeclarationNode& node) override
+  {
+    if(depth_ == 0)
+      declared[node.getName()] = node.getType();
+    lastLambda_ = nullptr;
+    RecursiveVisitor::visit(node);
+    if(depth_ == 0 && lastLambda_ == node.getValue().get())
+      binding = lastLambda_;
+  }
+
+  void visit(const VariableNode& node) override
+  {
+    if(depth_ == 0)
+      ++reads[node.getName()];
+    else
+      nestedNames.insert(node.getName());
+  }
+
+private:
+  std::size_t depth_;
+  const LambdaNode* lastLambda_;
+};
+
+// Redirects calls of lifted lambdas to the top-level functions replacing them.
+class CallRedirector : public ASTCloner
+{
+public:
+  using Target = std::pair<std::string, std::list<std::pair<std::string, TypeName>>>;
+
+  CallRedirector(const std::map<std::string, Target>& targets): targets_(targets) {}
+
+  void visit(const FunctionCallNode& node) override
+  {
+    const auto it = targets_.find(node.getName());
+    if(it == targets_.end())
+    {
+      ASTCloner::visit(node);
+      return;
+    }
+
+    auto args = cloneArguments(node.getArguments());
+    for(const auto& variable : it->second.second)
+    {
+      auto arg = std::make_shared<VariableNode>(variable.first);
+      arg->setMark(node.getMark());
+      args.push_back(std::move(arg));
+    }
+    setResult(std::make_unique<FunctionCallNode>(it->second.first, std::move(args)), node);
+  }
+
+private:
+  const std::map<std::string, Target>& targets_;
+};
+
+}
+
+LambdaLifter::LambdaLifter(): analysis_(), purity_(), functions_(), liftedFunctions_(), lifted_(0) {}
+
+void LambdaLifter::visit(const FunctionDeclarationNode& node)
+{
+  auto body = lift(*node.getBody(), node.getArguments());
+  setResult(std::make_unique<FunctionDeclarationNode>(node.getName(),
+    node.getReturnType(), node.getArguments(), std::move(body)), node);
+}
+
+void LambdaLifter::visit(const ProgramNode& node)
+{
+  purity_ = analysePurity(node, analysis_);
+
+  functions_.clear();
+  for(const auto& function : node.getFunctions())
+    functions_.insert(function->getName());
+
+  ASTCloner::visit(node);
+
+  auto& program = static_cast<ProgramNode&>(*result_);
+  for(auto& function : liftedFunctions_)
+    program.addFunction(std::move(function));
+  liftedFunctions_.clear();
+}
+
+/*
+ * Lambda bound by let can be lifted if the variable is only called with matching
+ * number of arguments after the binding and never read, assigned or captured. All
+ * free variables of the lambda have to be locals declared before the binding which
+ * are never assigned, so that passing them at the call gives the captured values.
+ * Remaining free names have to be pure functions, as functions run in the scope
+ * of the caller, which is the closure's context for lambda but not for the lifted one.
+ */
+std::unique_ptr<BlockNode> LambdaLifter::lift(const BlockNode& body, const Arguments& arguments)
+{
+  const auto& statements = body.getStatements();
+
+  std::vector<NameUsage> usages(statements.size());
+  NameUsage bodyUsage{};
+  std::map<std::string, std::size_t> declarations{};
+  std::map<std::string, TypeName> types{};
+  for(const auto& arg : arguments)
+  {
+    ++declarations[arg.first];
+    types[arg.first] = arg.second;
+  }
+
+  std::size_t index = 0;
+  for(const auto& statement : statements)
+  {
+    statement->accept(usages[index]);
+    statement->accept(bodyUsage);
+    for(const auto& declared : usages[index].declared)
+    {
+      ++declarations[declared.first];
+      types[declared.first] = declared.second;
+    }
+    ++index;
+  }
+
+  std::map<std::string, CallRedirector::Target> targets{};
+  std::set<const LambdaNode*> liftedLambdas{};
+  std::set<std::string> visible{};
+  for(const auto& arg : arguments)
+    visible.insert(arg.first);
+
+  for(index = 0; index < usages.size();)
+  {
+    const auto& usage = usages[index++];
+    const auto lambda = usage.binding;
+    if(!lambda || usage.declared.size() != 1)
+    {
+      for(const auto& declared : usage.declared)
+        visible.insert(declared.first);
+      continue;
+    }
+
+    const auto& name = usage.declared.begin()->first;
+    auto liftable = declarations[name] == 1 && bodyUsage.assigned.find(name) == bodyUsage.assigned.end() &&
+      bodyUsage.reads.find(name) == bodyUsage.reads.end() && bodyUsage.nestedNames.find(name) == bodyUsage.nestedNames.end();
+
+    // Calls have to follow the binding.
+    const auto& lambdaArgs = lambda->getArguments();
+    for(std::size_t i = 0; liftable && i < usages.size(); ++i)
+    {
+      const auto calls = usages[i].calls.find(name);
+      if(calls == usages[i].calls.end())
+        continue;
+
+      liftable = i >= index;
+      for(const auto call : calls->second)
+        liftable = liftable && call->getArguments().size() == lambdaArgs.size();
+    }
+
+    NameUsage lambdaUsage{};
+    lambda->getBody().accept(lambdaUsage);
+    liftable = liftable && lambdaUsage.lambdas == 0;
+
+    // Value of lambda is value of its last statement, which has to be the only return.
+    const auto& lambdaStatements = lambda->getBody().getStatements();
+    if(lambda->getReturnType() != TypeName::Void)
+    {
+      NameUsage lastUsage{};
+      if(!lambdaStatements.empty())
+        lambdaStatements.back()->accept(lastUsage);
+      liftable = liftable && lambdaUsage.returns == 1 && lastUsage.returns == 1;
+    }
+
+    std::set<std::string> locals{};
+    for(const auto& arg : lambdaArgs)
+      locals.insert(arg.first);
+
+    for(const auto& local : lambdaUsage.declared)
+    {
+      locals.insert(local.first);
+      if(declarations.find(local.first) != declarations.end() || functions_.find(local.first) != functions_.end())
+        liftable = false;
+    }
+
+    std::list<std::pair<std::string, TypeName>> freeVariables{};
+    for(const auto& freeName : lambdaUsage.getNames())
+    {
+      if(!liftable)
+        break;
+      if(locals.find(freeName) != locals.end())
+        continue;
+
+      if(visible.find(freeName) != visible.end())
+      {
+        liftable = declarations[freeName] == 1 && bodyUsage.assigned.find(freeName) == bodyUsage.assigned.end() &&
+          lambdaUsage.assigned.find(freeName) == lambdaUsage.assigned.end() && !purity_->isAssignedNonLocally(freeName);
+        if(liftable)
+          freeVariables.emplace_back(freeName, types[freeName]);
+      }
+      else
+        liftable = functions_.find(freeName) != functions_.end() &&
+          purity_->isPure(freeName) && !purity_->isShadowed(freeName);
+    }
+
+    visible.insert(name);
+    if(!liftable)
+      continue;
+
+    const auto liftedName = "$lambda" + std::to_string(lifted_++);
+    auto liftedArgs = lambdaArgs;
+    liftedArgs.insert(liftedArgs.end(), freeVariables.begin(), freeVariables.end());
+
+    ASTCloner cloner{};
+    auto function = std::make_unique<FunctionDeclarationNode>(liftedName, lambda->getReturnType(),
+      liftedArgs, cloner.clone(lambda->getBody()));
+    function->setMark(lambda->getMark());
+    liftedFunctions_.push_back(std::move(function));
+
+    targets[name] = CallRedirector::Target{liftedName, freeVariables};
+    liftedLambdas.insert(lambda);
+  }
+
+  CallRedirector redirector{targets};
+  auto block = std::make_unique<BlockNode>();
+  index = 0;
+  for(const auto& statement : statements)
+  {
+    const auto lambda = usages[index++].binding;
+    if(lambda && liftedLambdas.find(lambda) != liftedLambdas.end())
+      continue;
+    block->addStatement(redirector.clone(*statement));
+  }
+  block->setMark(body.getMark());
+  return block;
+}
@@ -0,0 +1,99 @@
+#include "LoopEvaluator.hpp"
+
+#include <iterator>
+#include <memory>
+#include <utility>
+
+#include "Operators.hpp"
+
+LoopEvaluator::LoopEvaluator(const LoopNode& loop): loop_(loop), values_(loop.getParameters().size()),
+  next_(values_.size()), known_(values_.size(), false), missing_(0), iterated_(false), value_(0) {}
+
+const VariableNode* LoopEvaluator::run()
+{
+  try
+  {
+    while(isTrue(evaluate(loop_.getCondition())) == loop_.recursesWhenTrue())
+    {
+      auto it = next_.begin();
+      for(const auto& arg : loop_.getArguments())
+        *it++ = evaluate(*arg);
+      values_.swap(next_);
+      if(!iterated_)
+        known_.assign(known_.size(), true);
+      iterated_ = true;
+    }
+  }
+  catch(const Missing& missing)
+  {
+    missing_ = missing.index;
+    return missing.variable;
+  }
+  return nullptr;
+}
+
+void LoopEvaluator::setValue(double value)
+{
+  values_[missing_] = value;
+  known_[missing_] = true;
+}
+
+// Context is captured for the case that the result calls a function which reassigns a parameter.
+void LoopEvaluator::bindParameters(Context& context) const
+{
+  const auto& parameters = loop_.getParameters();
+  for(std::size_t i = 0; i < parameters.size(); ++i)
+  {
+    auto value = std::make_shared<NumericLiteralNode>(values_[i]);
+    context.addSymbol(parameters[i],
+      std::make_shared<RuntimeVariableSymbol>(parameters[i], TypeName::F32, std::move(value), context));
+  }
+}
+
+double LoopEvaluator::evaluate(const ExpressionNode& expression)
+{
+  expression.accept(*this);
+  return value_;
+}
+
+void LoopEvaluator::visit(const BinaryOpNode& node)
+{
+  const auto left = evaluate(node.getLeftOperand());
+  value_ = evaluateBinary(node.getOperation(), left, evaluate(node.getRightOperand()));
+}
+
+// Only if is called in the condition and arguments.
+void LoopEvaluator::visit(const FunctionCallNode& node)
+{
+  const auto& args = node.getArguments();
+  if(isTrue(evaluate(*args.front())))
+    evaluate(**std::next(args.begin()));
+  else
+    evaluate(*args.back());
+}
+
+void LoopEvaluator::visit(const UnaryNode& node)
+{
+  value_ = evaluateUnary(node.getOperation(), evaluate(node.getTerm()));
+}
+
+void LoopEvaluator::visit(const VariableNode& node)
+{
+  const auto& parameters = loop_.getParameters();
+  for(std::size_t i = 0; i < parameters.size(); ++i)
+  {
+    if(parameters[i] != node.getName())
+      continue;
+
+    if(!known_[i])
+      throw Missing{&node, i};
+    value_ = values_[i];
+    return;
+  }
+}
+
+void LoopEvaluator::visit(const NumericBinaryOpNode& node)
+{
+  const auto left = evaluate(node.getLeftOperand());
+  value_ = node.evaluate(left, evaluate(node.getRightOperand()));
+}
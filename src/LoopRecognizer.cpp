@@ -0,0 +1,361 @@
+#include "LoopRecognizer.hpp"
+
+#include <iterator>
+#include <vector>
+
+namespace
+{
+
+class ReturnAnalyser : public Visitor
+{
+public:
+  ReturnAnalyser(): value(nullptr) {}
+
+  const ExpressionNode* value;
+
+  void visit(const AssignmentNode&) override {}
+  void visit(const BinaryOpNode&) override {}
+  void visit(const BlockNode&) override {}
+  void visit(const FunctionCallNode&) override {}
+  void visit(const FunctionCallStatementNode&) override {}
+  void visit(const FunctionDeclarationNode&) override {}
+  void visit(const FunctionResultCallNode&) override {}
+  void visit(const LambdaCallNode&) override {}
+  void visit(const LambdaNode&) override {}
+  void visit(const NumericLiteralNode&) override {}
+  void visit(const ProgramNode&) override {}
+  void visit(const ReturnNode& node) override { value = &node.getValue(); }
+  void visit(const StringLiteralNode&) override {}
+  void visit(const UnaryNode&) override {}
+  void visit(const VariableDeclarationNode&) override {}
+  void visit(const VariableNode&) override {}
+};
+
+class CallAnalyser : public Visitor
+{
+public:
+  CallAnalyser(): call(nullptr) {}
+
+  const FunctionCallNode* call;
+
+  void visit(const AssignmentNode&) override {}
+  void visit(const BinaryOpNode&) override {}
+  void visit(const BlockNode&) override {}
+  void visit(const FunctionCallNode& node) override { call = &node; }
+  void visit(const FunctionCallStatementNode&) override {}
+  void visit(const FunctionDeclarationNode&) override {}
+  void visit(const FunctionResultCallNode&) override {}
+  void visit(const LambdaCallNode&) override {}
+  void visit(const LambdaNode&) override {}
+  void visit(const NumericLiteralNode&) override {}
+  void visit(const ProgramNode&) override {}
+  void visit(const ReturnNode&) override {}
+  void visit(const StringLiteralNode&) override {}
+  void visit(const UnaryNode&) override {}
+  void visit(const VariableDeclarationNode&) override {}
+  void visit(const VariableNode&) override {}
+};
+
+const FunctionCallNode* getCall(const ExpressionNode& expression)
+{
+  CallAnalyser analyser{};
+  expression.accept(analyser);
+  return analyser.call;
+}
+
+/*
+ * Finds out which parameters are certainly forced when an expression is evaluated
+ * and whether the expression only combines parameters and literals with operators
+ * and if. Names it calls or reads anywhere are collected as well.
+ */
+class ExpressionAnalyser : public Visitor
+{
+public:
+  ExpressionAnalyser(const std::set<std::string>& parameters, const PurityAnalyser& purity):
+    simple(true), names(), parameters_(parameters), purity_(purity), forced_() {}
+
+  bool simple;
+  std::set<std::string> names;
+
+  std::set<std::string> getForced(const Node& node)
+  {
+    node.accept(*this);
+    return std::move(forced_);
+  }
+
+  void visit(const AssignmentNode& node) override
+  {
+    simple = false;
+    names.insert(node.getName());
+    getForced(*node.getValue());
+    forced_.clear();
+  }
+
+  void visit(const BinaryOpNode& node) override
+  {
+    auto forced = getForced(node.getLeftOperand());
+    const auto right = getForced(node.getRightOperand());
+    forced.insert(right.begin(), right.end());
+    forced_ = std::move(forced);
+  }
+
+  void visit(const BlockNode& node) override
+  {
+    simple = false;
+    for(const auto& statement : node.getStatements())
+      getForced(*statement);
+    forced_.clear();
+  }
+
+  // Both branches of if have to force a parameter, other functions force their strict arguments.
+  void visit(const FunctionCallNode& node) override
+  {
+    const auto& name = node.getName();
+    const auto& args = node.getArguments();
+    names.insert(name);
+    if(name == "if" && args.size() == 3)
+    {
+      auto forced = getForced(*args.front());
+      const auto whenTrue = getForced(**std::next(args.begin()));
+      for(const auto& parameter : getForced(*args.back()))
+      {
+        if(whenTrue.count(parameter) != 0)
+          forced.insert(parameter);
+      }
+      forced_ = std::move(forced);
+      return;
+    }
+
+    simple = false;
+    const auto strict = name == "print" ? std::vector<bool>{true} :
+      purity_.isShadowed(name) ? std::vector<bool>{} : purity_.getStrictArguments(name);
+    std::set<std::string> forced{};
+    std::size_t i = 0;
+    for(const auto& arg : args)
+    {
+      const auto argument = getForced(*arg);
+      if(i < strict.size() && strict[i])
+        forced.insert(argument.begin(), argument.end());
+      ++i;
+    }
+    forced_ = std::move(forced);
+  }
+
+  void visit(const FunctionCallStatementNode& node) override
+  {
+    simple = false;
+    getForced(node.getFunctionCall());
+    forced_.clear();
+  }
+
+  void visit(const FunctionDeclarationNode& node) override
+  {
+    simple = false;
+    getForced(*node.getBody());
+    forced_.clear();
+  }
+
+  void visit(const FunctionResultCallNode& node) override
+  {
+    simple = false;
+    for(const auto& arg : node.getArguments())
+      getForced(*arg);
+    forced_ = getForced(node.getCall());
+  }
+
+  void visit(const LambdaCallNode& node) override
+  {
+    simple = false;
+    for(const auto& arg : node.getArguments())
+      getForced(*arg);
+    getForced(node.getLambda());
+    forced_.clear();
+  }
+
+  void visit(const LambdaNode& node) override
+  {
+    simple = false;
+    getForced(node.getBody());
+    forced_.clear();
+  }
+
+  void visit(const NumericLiteralNode&) override { forced_.clear(); }
+
+  void visit(const ProgramNode&) override
+  {
+    simple = false;
+    forced_.clear();
+  }
+
+  void visit(const ReturnNode& node) override
+  {
+    simple = false;
+    getForced(node.getValue());
+    forced_.clear();
+  }
+
+  void visit(const StringLiteralNode&) override
+  {
+    simple = false;
+    forced_.clear();
+  }
+
+  void visit(const UnaryNode& node) override
+  {
+    forced_ = getForced(node.getTerm());
+  }
+
+  void visit(const VariableDeclarationNode& node) override
+  {
+    simple = false;
+    getForced(*node.getValue());
+    forced_.clear();
+  }
+
+  void visit(const VariableNode& node) override
+  {
+    const auto name = node.getName();
+    names.insert(name);
+    forced_.clear();
+    if(parameters_.count(name) != 0)
+      forced_.insert(name);
+    else
+      simple = false;
+  }
+
+private:
+  const std::set<std::string>& parameters_;
+  const PurityAnalyser& purity_;
+  std::set<std::string> forced_;
+};
+
+/*
+ * Returns if of the function's only return statement, if the function is a loop.
+ * Call which returns forces parameters which the condition forces, or both the
+ * result and the arguments it forces in the recursive call do; the greatest such
+ * set is found by iteration. Loop evaluates all arguments of the recursive call
+ * eagerly, so parameters they read have to be forced by every call which recurses.
+ */
+const FunctionCallNode* recognizeLoop(const FunctionDeclarationNode& function, const PurityAnalyser& purity,
+  bool& recursesWhenTrue)
+{
+  const auto& name = function.getName();
+  const auto& statements = function.getBody()->getStatements();
+  if(function.getArguments().empty() || function.getReturnType() == TypeName::Void || statements.size() != 1 ||
+    purity.isShadowed(name))
+    return nullptr;
+
+  std::set<std::string> parameters{};
+  for(const auto& argument : function.getArguments())
+  {
+    if(argument.second != TypeName::F32 || !parameters.insert(argument.first).second)
+      return nullptr;
+  }
+
+  ReturnAnalyser returnAnalyser{};
+  statements.front()->accept(returnAnalyser);
+  const auto branch = returnAnalyser.value ? getCall(*returnAnalyser.value) : nullptr;
+  if(!branch || branch->getName() != "if" || branch->getArguments().size() != 3)
+    return nullptr;
+
+  const auto& args = branch->getArguments();
+  const auto whenTrue = getCall(**std::next(args.begin()));
+  const auto whenFalse = getCall(*args.back());
+  recursesWhenTrue = whenTrue && whenTrue->getName() == name;
+  if(recursesWhenTrue == (whenFalse && whenFalse->getName() == name))
+    return nullptr;
+
+  const auto& call = recursesWhenTrue ? *whenTrue : *whenFalse;
+  const auto& result = recursesWhenTrue ? *args.back() : **std::next(args.begin());
+  if(call.getArguments().size() != parameters.size())
+    return nullptr;
+
+  ExpressionAnalyser condition{parameters, purity};
+  const auto forcedByCondition = condition.getForced(*args.front());
+  ExpressionAnalyser arguments{parameters, purity};
+  std::vector<std::set<std::string>> forcedByArguments{};
+  for(const auto& arg : call.getArguments())
+    forcedByArguments.push_back(arguments.getForced(*arg));
+  if(!condition.simple || !arguments.simple)
+    return nullptr;
+
+  ExpressionAnalyser resultAnalyser{parameters, purity};
+  const auto forcedByResult = resultAnalyser.getForced(result);
+  if(resultAnalyser.names.count(name) != 0)
+    return nullptr;
+
+  // Parameters forced by the recursive call of a function which forces given ones.
+  const auto forcedByCall = [&function, &forcedByArguments](const std::set<std::string>& forced)
+  {
+    std::set<std::string> result{};
+    auto it = forcedByArguments.begin();
+    for(const auto& argument : function.getArguments())
+    {
+      if(forced.count(argument.first) != 0)
+        result.insert(it->begin(), it->end());
+      ++it;
+    }
+    return result;
+  };
+
+  auto forced = parameters;
+  while(true)
+  {
+    const auto byCall = forcedByCall(forced);
+    auto next = forcedByCondition;
+    for(const auto& parameter : forcedByResult)
+    {
+      if(byCall.count(parameter) != 0)
+        next.insert(parameter);
+    }
+
+    if(next == forced)
+      break;
+    forced = std::move(next);
+  }
+
+  auto forcedWhenRecursing = forcedByCall(forced);
+  forcedWhenRecursing.insert(forcedByCondition.begin(), forcedByCondition.end());
+  for(const auto& read : arguments.names)
+  {
+    if(parameters.count(read) != 0 && forcedWhenRecursing.count(read) == 0)
+      return nullptr;
+  }
+  return branch;
+}
+
+}
+
+LoopRecognizer::LoopRecognizer(): analysis_(), purity_(), recognized_(0) {}
+
+void LoopRecognizer::visit(const FunctionDeclarationNode& node)
+{
+  bool recursesWhenTrue = false;
+  const auto branch = recognizeLoop(node, *purity_, recursesWhenTrue);
+  if(!branch)
+  {
+    ASTCloner::visit(node);
+    return;
+  }
+
+  std::vector<std::string> parameters{};
+  for(const auto& argument : node.getArguments())
+    parameters.push_back(argument.first);
+
+  auto loop = std::make_unique<LoopNode>(clone<FunctionCallNode>(*branch), std::move(parameters), recursesWhenTrue);
+  loop->setMark(node.getBody()->getStatements().front()->getMark());
+
+  auto body = std::make_unique<BlockNode>();
+  body->setMark(node.getBody()->getMark());
+  body->addStatement(std::move(loop));
+
+  setResult(std::make_unique<FunctionDeclarationNode>(node.getName(), node.getReturnType(), node.getArguments(),
+    std::move(body)), node);
+  ++recognized_;
+}
+
+void LoopRecognizer::visit(const ProgramNode& node)
+{
+  purity_ = analysePurity(node, analysis_);
+  ASTCloner::visit(node);
+}
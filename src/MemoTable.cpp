@@ -0,0 +1,271 @@
+#include "MemoTable.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <list>
+#include <map>
+#include <set>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "AST.hpp"
+#include "ASTHasher.hpp"
+#include "PurityAnalyser.hpp"
+
+namespace
+{
+
+/*
+ * Cache file layout (native byte order):
+ *   magic[8], uint64 number of entries,
+ *   entries: uint64 fingerprint, uint64 number of arguments, double arguments[], double result.
+ * Entries are stored from the most recently used.
+ */
+const char CacheMagic[8] = {'L', 'I', 'L', 'M', 'E', 'M', 'O', '1'};
+
+std::uint64_t bitsOf(double value)
+{
+  std::uint64_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+template<typename T>
+bool read(const char*& cursor, const char* end, T& value)
+{
+  if(static_cast<std::size_t>(end - cursor) < sizeof(T))
+    return false;
+
+  std::memcpy(&value, cursor, sizeof(T));
+  cursor += sizeof(T);
+  return true;
+}
+
+template<typename T>
+void write(std::ofstream& file, const T& value)
+{
+  file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+}
+
+// Arguments are compared bitwise, so -0 and 0 are distinct and NaN can be cached.
+bool MemoTable::Key::operator==(const Key& other) const
+{
+  if(function != other.function || arguments.size() != other.arguments.size())
+    return false;
+
+  for(std::size_t i = 0; i < arguments.size(); ++i)
+  {
+    if(bitsOf(arguments[i]) != bitsOf(other.arguments[i]))
+      return false;
+  }
+  return true;
+}
+
+std::size_t MemoTable::KeyHash::operator()(const Key& key) const
+{
+  std::size_t hash = std::hash<std::uint64_t>{}(key.function);
+  for(const auto argument : key.arguments)
+    hash ^= std::hash<std::uint64_t>{}(bitsOf(argument)) + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2);
+  return hash;
+}
+
+MemoTable::MemoTable(std::size_t capacity):
+  capacity_(capacity), functions_(), fingerprints_(), entries_(), index_(), 
+  hits_(0), misses_(0), evictions_(0) {}
+
+void MemoTable::addFunction(const BlockNode* function, std::uint64_t fingerprint)
+{
+  functions_[function] = fingerprint;
+  fingerprints_.insert(fingerprint);
+}
+
+bool MemoTable::isMemoizable(const BlockNode* function) const
+{
+  return capacity_ > 0 && functions_.find(function) != functions_.end();
+}
+
+std::optional<double> MemoTable::lookup(const BlockNode* function, const std::vector<double>& arguments)
+{
+  const auto it = index_.find(Key{functions_.at(function), arguments});
+  if(it == index_.end())
+  {
+    misses_++;
+    return {};
+  }
+
+  hits_++;
+  entries_.splice(entries_.begin(), entries_, it->second);
+  return it->second->second;
+}
+
+void MemoTable::insert(const BlockNode* function, const std::vector<double>& arguments, double result)
+{
+  insert(Key{functions_.at(function), arguments}, result);
+}
+
+void MemoTable::insert(Key key, double result)
+{
+  const auto it = index_.find(key);
+  if(it != index_.end())
+  {
+    it->second->second = result;
+    entries_.splice(entries_.begin(), entries_, it->second);
+    return;
+  }
+
+  if(capacity_ == 0)
+    return;
+
+  if(entries_.size() >= capacity_)
+  {
+    index_.erase(entries_.back().first);
+    entries_.pop_back();
+    evictions_++;
+  }
+
+  entries_.emplace_front(key, result);
+  index_.emplace(std::move(key), entries_.begin());
+}
+
+bool MemoTable::load(const std::string& path)
+{
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if(fd < 0)
+    return false;
+
+  struct stat status{};
+  if(::fstat(fd, &status) != 0 || status.st_size < static_cast<off_t>(sizeof(CacheMagic)))
+  {
+    ::close(fd);
+    return false;
+  }
+
+  const auto size = static_cast<std::size_t>(status.st_size);
+  void* mapping = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if(mapping == MAP_FAILED)
+    return false;
+
+  const char* cursor = static_cast<const char*>(mapping);
+  const char* end = cursor + size;
+
+  std::vector<Entry> loaded{};
+  bool valid = std::memcmp(cursor, CacheMagic, sizeof(CacheMagic)) == 0;
+  cursor += sizeof(CacheMagic);
+
+  std::uint64_t count = 0;
+  valid = valid && read(cursor, end, count);
+  for(std::uint64_t i = 0; valid && i < count; ++i)
+  {
+    Key key{};
+    std::uint64_t argumentsCount = 0;
+    valid = read(cursor, end, key.function) && read(cursor, end, argumentsCount) &&
+      argumentsCount <= static_cast<std::uint64_t>(end - cursor) / sizeof(double);
+
+    for(std::uint64_t j = 0; valid && j < argumentsCount; ++j)
+    {
+      double argument = 0;
+      valid = read(cursor, end, argument);
+      key.arguments.push_back(argument);
+    }
+
+    double result = 0;
+    valid = valid && read(cursor, end, result);
+    if(valid && fingerprints_.find(key.function) != fingerprints_.end())
+      loaded.emplace_back(std::move(key), result);
+  }
+
+  ::munmap(mapping, size);
+  if(!valid)
+    return false;
+
+  // Insert from the least recently used, so that the order of entries is preserved.
+  for(auto it = loaded.rbegin(); it != loaded.rend(); ++it)
+    insert(std::move(it->first), it->second);
+
+  return true;
+}
+
+bool MemoTable::save(const std::string& path) const
+{
+  const auto temporaryPath = path + ".tmp";
+  {
+    std::ofstream file{temporaryPath, std::ios::binary | std::ios::trunc};
+    if(!file.is_open())
+      return false;
+
+    std::uint64_t count = 0;
+    for(const auto& entry : entries_)
+    {
+      if(fingerprints_.find(entry.first.function) != fingerprints_.end())
+        count++;
+    }
+
+    file.write(CacheMagic, sizeof(CacheMagic));
+    write(file, count);
+    for(const auto& entry : entries_)
+    {
+      const auto& key = entry.first;
+      if(fingerprints_.find(key.function) == fingerprints_.end())
+        continue;
+
+      write(file, key.function);
+      write(file, static_cast<std::uint64_t>(key.arguments.size()));
+      for(const auto argument : key.arguments)
+        write(file, argument);
+      write(file, entry.second);
+    }
+
+    if(!file.good())
+      return false;
+  }
+
+  return std::rename(temporaryPath.c_str(), path.c_str()) == 0;
+}
+
+/*
+ * Fingerprint of memoizable function covers its declaration and declarations of all
+ * functions it transitively calls, so that cached results are invalidated whenever
+ * any code that could influence them changes.
+ */
+void registerMemoizableFunctions(MemoTable& table, const ProgramNode& node)
+{
+  PurityAnalyser purity{};
+  node.accept(purity);
+
+  std::map<std::string, const FunctionDeclarationNode*> declarations{};
+  for(const auto& function : node.getFunctions())
+    declarations[function->getName()] = function.get();
+
+  for(const auto& function : node.getFunctions())
+  {
+    if(!purity.isMemoizable(function->getName()))
+      continue;
+
+    std::set<std::string> reachable{function->getName()};
+    std::list<std::string> pending{function->getName()};
+    while(!pending.empty())
+    {
+      for(const auto& callee : purity.getCallees(pending.front()))
+      {
+        if(reachable.insert(callee).second)
+          pending.push_back(callee);
+      }
+      pending.pop_front();
+    }
+
+    ASTHasher hasher{};
+    hasher.add(function->getName());
+    for(const auto& name : reachable)
+      declarations.at(name)->accept(hasher);
+
+    table.addFunction(function->getBody().get(), hasher.getHash());
+  }
+}
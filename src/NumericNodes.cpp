@@ -0,0 +1,47 @@
+#include "NumericNodes.hpp"
+
+std::unique_ptr<NumericBinaryOpNode> makeNumericBinaryNode(std::unique_ptr<ExpressionNode> l,
+  const BinaryOperator& op, std::unique_ptr<ExpressionNode> r, bool integer)
+{
+  switch(op)
+  {
+    case BinaryOperator::Addition:
+      return std::make_unique<NumericBinaryNode<BinaryOperator::Addition>>(std::move(l), std::move(r), integer);
+    case BinaryOperator::Subtraction:
+      return std::make_unique<NumericBinaryNode<BinaryOperator::Subtraction>>(std::move(l), std::move(r), integer);
+    case BinaryOperator::Multiplication:
+      return std::make_unique<NumericBinaryNode<BinaryOperator::Multiplication>>(std::move(l), std::move(r), integer);
+    case BinaryOperator::Division:
+      return std::make_unique<NumericBinaryNode<BinaryOperator::Division>>(std::move(l), std::move(r), integer);
+    case BinaryOperator::Modulo:
+      return std::make_unique<NumericBinaryNode<BinaryOperator::Modulo>>(std::move(l), std::move(r), integer);
+    case BinaryOperator::LogicalAnd:
+      return std::make_unique<NumericBinaryNode<BinaryOperator::LogicalAnd>>(std::move(l), std::move(r), integer);
+    case BinaryOperator::LogicalOr:
+      return std::make_unique<NumericBinaryNode<BinaryOperator::LogicalOr>>(std::move(l), std::move(r), integer);
+    case BinaryOperator::BinaryAnd:
+      return std::make_unique<NumericBinaryNode<BinaryOperator::BinaryAnd>>(std::move(l), std::move(r), integer);
+    case BinaryOperator::BinaryOr:
+      return std::make_unique<NumericBinaryNode<BinaryOperator::BinaryOr>>(std::move(l), std::move(r), integer);
+    case BinaryOperator::BinaryXor:
+      return std::make_unique<NumericBinaryNode<BinaryOperator::BinaryXor>>(std::move(l), std::move(r), integer);
+    case BinaryOperator::ShiftLeft:
+      return std::make_unique<NumericBinaryNode<BinaryOperator::ShiftLeft>>(std::move(l), std::move(r), integer);
+    case BinaryOperator::ShiftRight:
+      return std::make_unique<NumericBinaryNode<BinaryOperator::ShiftRight>>(std::move(l), std::move(r), integer);
+    case BinaryOperator::Greater:
+      return std::make_unique<NumericBinaryNode<BinaryOperator::Greater>>(std::move(l), std::move(r), integer);
+    case BinaryOperator::GreaterEq:
+      return std::make_unique<NumericBinaryNode<BinaryOperator::GreaterEq>>(std::move(l), std::move(r), integer);
+    case BinaryOperator::Less:
+      return std::make_unique<NumericBinaryNode<BinaryOperator::Less>>(std::move(l), std::move(r), integer);
+    case BinaryOperator::LessEq:
+      return std::make_unique<NumericBinaryNode<BinaryOperator::LessEq>>(std::move(l), std::move(r), integer);
+    case BinaryOperator::Equal:
+      return std::make_unique<NumericBinaryNode<BinaryOperator::Equal>>(std::move(l), std::move(r), integer);
+    case BinaryOperator::NotEqual:
+      return std::make_unique<NumericBinaryNode<BinaryOperator::NotEqual>>(std::move(l), std::move(r), integer);
+  }
+
+  return nullptr; // Unreachable
+}
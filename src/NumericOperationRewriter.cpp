@@ -0,0 +1,24 @@
+#include "NumericOperationRewriter.hpp"
+
+#include "NumericNodes.hpp"
+
+NumericOperationRewriter::NumericOperationRewriter(const TypeTable& types): typeChecker_(types), ranges_(), rewritten_(0), integers_(0) {}
+
+void NumericOperationRewriter::visit(const BinaryOpNode& node)
+{
+  const auto leftType = typeChecker_.getType(node.getLeftOperand());
+  const auto rightType = typeChecker_.getType(node.getRightOperand());
+
+  auto left = clone<ExpressionNode>(node.getLeftOperand());
+  auto right = clone<ExpressionNode>(node.getRightOperand());
+  if(leftType == TypeName::F32 && rightType == TypeName::F32)
+  {
+    const auto integer = ranges_.isExact(node);
+    setResult(makeNumericBinaryNode(std::move(left), node.getOperation(), std::move(right), integer), node);
+    ++rewritten_;
+    if(integer)
+      ++integers_;
+  }
+  else
+    setResult(std::make_unique<BinaryOpNode>(std::move(left), node.getOperation(), std::move(right)), node);
+}
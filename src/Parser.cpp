@@ -7,6 +7,8 @@
 
 Parser::Parser(std::istream& stream): tokenizer_(stream) {}
 
+Parser::Parser(std::string_view text): tokenizer_(text) {}
+
 [[noreturn]]
 void Parser::reportError(const std::string& msg) const
 {
@@ -58,7 +60,7 @@ Parser::parseExpression(std::function<std::unique_ptr<ExpressionNode>()> parseOp
 }
 
 
-std::unique_ptr<Node> Parser::parseProgram()
+std::unique_ptr<ProgramNode> Parser::parseProgram()
 {
   auto programNode = std::make_unique<ProgramNode>();
   auto token = tokenizer_.peek();
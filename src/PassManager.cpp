@@ -0,0 +1,298 @@
+#include "PassManager.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+#include "CommonSubexpressionEliminator.hpp"
+#include "DeadCodeEliminator.hpp"
+#include "Inliner.hpp"
+#include "LambdaLifter.hpp"
+#include "LoopRecognizer.hpp"
+#include "NumericOperationRewriter.hpp"
+#include "PurityAnalyser.hpp"
+#include "RecursiveVisitor.hpp"
+#include "SemanticAnalyser.hpp"
+#include "Specializer.hpp"
+
+namespace
+{
+
+const std::vector<std::string> PassOrder{"numeric", "inline", "specialize", "lift-lambdas", "loops", "cse", "dce"};
+
+class NodeCounter : public RecursiveVisitor
+{
+public:
+  NodeCounter(): count(0) {}
+
+  std::size_t count;
+
+protected:
+  void enter(const Node&) override { ++count; }
+};
+
+class NumericPass : public Pass
+{
+public:
+  NumericPass(): rewritten_(0), integers_(0) {}
+
+  std::unique_ptr<ProgramNode> run(const ProgramNode& program, AnalysisManager& analyses) override
+  {
+    NumericOperationRewriter rewriter{analyses.get<SemanticAnalyser>(program)->getTypes()};
+    auto result = rewriter.clone(program);
+    rewritten_ = rewriter.getRewritten();
+    integers_ = rewriter.getIntegers();
+    return rewritten_ == 0 ? nullptr : std::move(result);
+  }
+
+  std::string getSummary() const override
+  {
+    return std::to_string(rewritten_) + " operations rewritten, " + std::to_string(integers_) +
+      " evaluated on integers";
+  }
+
+private:
+  std::size_t rewritten_;
+  std::size_t integers_;
+};
+
+class InlinePass : public Pass
+{
+public:
+  InlinePass(std::shared_ptr<Profile> feedback): feedback_(std::move(feedback)), inlined_(0) {}
+
+  std::unique_ptr<ProgramNode> run(const ProgramNode& program, AnalysisManager& analyses) override
+  {
+    if(!feedback_)
+      return nullptr;
+
+    Inliner inliner{feedback_};
+    inliner.setPurity(analyses.get<PurityAnalyser>(program));
+    auto result = inliner.clone(program);
+    inlined_ = inliner.getInlined();
+    return inlined_ == 0 ? nullptr : std::move(result);
+  }
+
+  std::string getSummary() const override
+  {
+    if(!feedback_)
+      return "skipped without profile";
+    return std::to_string(inlined_) + " calls inlined";
+  }
+
+private:
+  std::shared_ptr<Profile> feedback_;
+  std::size_t inlined_;
+};
+
+// Folding constants changes the program even when nothing is specialized.
+class SpecializePass : public Pass
+{
+public:
+  SpecializePass(std::size_t capacity, std::shared_ptr<Profile> feedback):
+    capacity_(capacity), feedback_(std::move(feedback)), specialized_(0) {}
+
+  std::unique_ptr<ProgramNode> run(const ProgramNode& program, AnalysisManager& analyses) override
+  {
+    Specializer specializer{capacity_, feedback_};
+    specializer.setPurity(analyses.get<PurityAnalyser>(program));
+    auto result = specializer.clone(program);
+    specialized_ = specializer.getSpecialized();
+    return result;
+  }
+
+  std::string getSummary() const override
+  {
+    return std::to_string(specialized_) + " specializations created";
+  }
+
+private:
+  std::size_t capacity_;
+  std::shared_ptr<Profile> feedback_;
+  std::size_t specialized_;
+};
+
+class LiftLambdasPass : public Pass
+{
+public:
+  LiftLambdasPass(): lifted_(0) {}
+
+  std::unique_ptr<ProgramNode> run(const ProgramNode& program, AnalysisManager& analyses) override
+  {
+    LambdaLifter lifter{};
+    lifter.setPurity(analyses.get<PurityAnalyser>(program));
+    auto result = lifter.clone(program);
+    lifted_ = lifter.getLifted();
+    return lifted_ == 0 ? nullptr : std::move(result);
+  }
+
+  std::string getSummary() const override
+  {
+    return std::to_string(lifted_) + " lambdas lifted";
+  }
+
+private:
+  std::size_t lifted_;
+};
+
+class CsePass : public Pass
+{
+public:
+  CsePass(): eliminated_(0) {}
+
+  std::unique_ptr<ProgramNode> run(const ProgramNode& program, AnalysisManager& analyses) override
+  {
+    CommonSubexpressionEliminator eliminator{};
+    eliminator.setPurity(analyses.get<PurityAnalyser>(program));
+    auto result = eliminator.clone(program);
+    eliminated_ = eliminator.getEliminated();
+    return eliminated_ == 0 ? nullptr : std::move(result);
+  }
+
+  std::string getSummary() const override
+  {
+    return std::to_string(eliminated_) + " common subexpressions eliminated";
+  }
+
+private:
+  std::size_t eliminated_;
+};
+
+class DcePass : public Pass
+{
+public:
+  DcePass(): functions_(0), variables_(0), statements_(0) {}
+
+  std::unique_ptr<ProgramNode> run(const ProgramNode& program, AnalysisManager&) override
+  {
+    DeadCodeEliminator dce{};
+    auto result = dce.clone(program);
+    functions_ = dce.getRemovedFunctions();
+    variables_ = dce.getRemovedVariables();
+    statements_ = dce.getRemovedStatements();
+    return functions_ + variables_ + statements_ == 0 ? nullptr : std::move(result);
+  }
+
+  std::string getSummary() const override
+  {
+    return std::to_string(functions_) + " functions, " + std::to_string(variables_) + " variables, " +
+      std::to_string(statements_) + " statements removed";
+  }
+
+private:
+  std::size_t functions_;
+  std::size_t variables_;
+  std::size_t statements_;
+};
+
+class LoopPass : public Pass
+{
+public:
+  LoopPass(): recognized_(0) {}
+
+  std::unique_ptr<ProgramNode> run(const ProgramNode& program, AnalysisManager& analyses) override
+  {
+    LoopRecognizer recognizer{};
+    recognizer.setPurity(analyses.get<PurityAnalyser>(program));
+    auto result = recognizer.clone(program);
+    recognized_ = recognizer.getRecognized();
+    return recognized_ == 0 ? nullptr : std::move(result);
+  }
+
+  std::string getSummary() const override
+  {
+    return std::to_string(recognized_) + " functions turned into loops";
+  }
+
+private:
+  std::size_t recognized_;
+};
+
+std::unique_ptr<Pass> createPass(const std::string& name, const PassOptions& options)
+{
+  if(name == "numeric")
+    return std::make_unique<NumericPass>();
+  if(name == "inline")
+    return std::make_unique<InlinePass>(options.feedback);
+  if(name == "specialize")
+    return std::make_unique<SpecializePass>(options.specializationCapacity, options.feedback);
+  if(name == "lift-lambdas")
+    return std::make_unique<LiftLambdasPass>();
+  if(name == "cse")
+    return std::make_unique<CsePass>();
+  if(name == "dce")
+    return std::make_unique<DcePass>();
+  if(name == "loops")
+    return std::make_unique<LoopPass>();
+  return nullptr;
+}
+
+}
+
+std::size_t countNodes(const Node& node)
+{
+  NodeCounter counter{};
+  node.accept(counter);
+  return counter.count;
+}
+
+PassManager::PassManager(const PassOptions& options): options_(options), passes_(), analyses_(), reports_() {}
+
+/*
+ * Level 1 only rewrites numeric operations, level 2 adds passes which make the
+ * program smaller, level 3 also those that may grow it to make it faster.
+ */
+std::optional<std::vector<std::string>> PassManager::getLevel(int level)
+{
+  switch(level)
+  {
+    case 0:
+      return std::vector<std::string>{};
+    case 1:
+      return std::vector<std::string>{"numeric"};
+    case 2:
+      return std::vector<std::string>{"numeric", "lift-lambdas", "loops", "cse", "dce"};
+    case 3:
+      return PassOrder;
+    default:
+      return std::nullopt;
+  }
+}
+
+bool PassManager::isRegistered(const std::string& name)
+{
+  return std::find(PassOrder.begin(), PassOrder.end(), name) != PassOrder.end();
+}
+
+// Types are only known for the program as written, passes add functions after their callers.
+bool PassManager::add(const std::string& name)
+{
+  if(name == "numeric" && !passes_.empty())
+    return false;
+
+  auto pass = createPass(name, options_);
+  if(!pass)
+    return false;
+  passes_.emplace_back(name, std::move(pass));
+  return true;
+}
+
+std::unique_ptr<ProgramNode> PassManager::run(std::unique_ptr<ProgramNode> program)
+{
+  for(auto& pass : passes_)
+  {
+    const auto nodesBefore = countNodes(*program);
+    const auto start = std::chrono::steady_clock::now();
+
+    auto result = pass.second->run(*program, analyses_);
+    if(result)
+    {
+      program = std::move(result);
+      analyses_.invalidate();
+    }
+
+    const std::chrono::duration<double, std::milli> time = std::chrono::steady_clock::now() - start;
+    reports_.push_back(Report{pass.first, time.count(), nodesBefore, countNodes(*program),
+      pass.second->getSummary()});
+  }
+  return program;
+}
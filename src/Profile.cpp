@@ -0,0 +1,347 @@
+#include "Profile.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+
+#include "ASTHasher.hpp"
+#include "RecursiveVisitor.hpp"
+
+namespace
+{
+
+const char* ProfileHeader = "lil-profile 1";
+// Function of sites in initializers of global variables.
+const char* GlobalScope = "-";
+
+enum class SiteKind
+{
+  Call,
+  If,
+  Binding
+};
+
+const char* kindName(SiteKind kind)
+{
+  switch(kind)
+  {
+    case SiteKind::Call:
+      return "call";
+    case SiteKind::If:
+      return "if";
+    case SiteKind::Binding:
+      return "bind";
+  }
+  return ""; // Unreachable
+}
+
+struct Site
+{
+  SiteKind kind;
+  std::string function;
+  const Node* node;
+};
+
+// Lists sites of a program in the order they appear in, and names bodies of functions and lambdas.
+class SiteCollector : public RecursiveVisitor
+{
+public:
+  SiteCollector(): sites(), bodies(), function_(GlobalScope), lambdas_(0) {}
+
+  std::vector<Site> sites;
+  std::unordered_map<const BlockNode*, std::string> bodies;
+
+  void visit(const AssignmentNode& node) override
+  {
+    if(node.getOperation() == AssignmentOperator::Assign)
+      add(SiteKind::Binding, *node.getValue());
+    RecursiveVisitor::visit(node);
+  }
+
+  void visit(const FunctionCallNode& node) override
+  {
+    const auto& name = node.getName();
+    if(name == "if")
+      add(SiteKind::If, node);
+    else if(name != "print")
+      addCall(node);
+
+    RecursiveVisitor::visit(node);
+  }
+
+  void visit(const FunctionDeclarationNode& node) override
+  {
+    function_ = node.getName();
+    lambdas_ = 0;
+    bodies[node.getBody().get()] = function_;
+    RecursiveVisitor::visit(node);
+  }
+
+  void visit(const FunctionResultCallNode& node) override
+  {
+    addCall(node);
+    RecursiveVisitor::visit(node);
+  }
+
+  void visit(const LambdaCallNode& node) override
+  {
+    addCall(node);
+    RecursiveVisitor::visit(node);
+  }
+
+  void visit(const LambdaNode& node) override
+  {
+    bodies[&node.getBody()] = function_ + ".lambda" + std::to_string(lambdas_++);
+    RecursiveVisitor::visit(node);
+  }
+
+  void visit(const VariableDeclarationNode& node) override
+  {
+    add(SiteKind::Binding, *node.getValue());
+    RecursiveVisitor::visit(node);
+  }
+
+private:
+  // Arguments of calls are bound lazily.
+  void addCall(const CallNode& node)
+  {
+    add(SiteKind::Call, node);
+    for(const auto& arg : node.getArguments())
+      add(SiteKind::Binding, *arg);
+  }
+
+  void add(SiteKind kind, const Node& node)
+  {
+    sites.push_back(Site{kind, function_, &node});
+  }
+
+  std::string function_;
+  std::size_t lambdas_;
+};
+
+std::string hashString(const Node& node)
+{
+  ASTHasher hasher{};
+  node.accept(hasher);
+
+  std::ostringstream result{};
+  result << std::hex << std::setw(16) << std::setfill('0') << hasher.getHash();
+  return result.str();
+}
+
+std::string markString(const Mark& mark)
+{
+  return std::to_string(mark.line) + ":" + std::to_string(mark.column);
+}
+
+}
+
+Profile::Profile(): counters_(), sites_(), bindings_(), bodies_() {}
+
+void Profile::addProgram(const ProgramNode& program)
+{
+  SiteCollector collector{};
+  program.accept(collector);
+
+  sites_.clear();
+  bindings_.clear();
+  bodies_ = std::move(collector.bodies);
+
+  std::map<std::string, std::size_t> occurrences{};
+  for(const auto& site : collector.sites)
+  {
+    auto key = std::string{kindName(site.kind)} + " " + site.function + " " + hashString(*site.node);
+    key += " " + std::to_string(occurrences[key]++);
+
+    auto& counters = counters_[key];
+    counters.mark = site.node->getMark();
+    if(site.kind == SiteKind::Binding)
+      bindings_[site.node] = &counters;
+    else
+      sites_[site.node] = &counters;
+  }
+}
+
+const Profile::Counters* Profile::find(const std::unordered_map<const Node*, Counters*>& index, const Node& node) const
+{
+  const auto it = index.find(&node);
+  if(it == index.end() || !it->second->known)
+    return nullptr;
+  return it->second;
+}
+
+Profile::Counters* Profile::find(std::unordered_map<const Node*, Counters*>& index, const Node& node)
+{
+  const auto it = index.find(&node);
+  if(it == index.end())
+    return nullptr;
+  it->second->known = true;
+  return it->second;
+}
+
+void Profile::recordCall(const Node& site)
+{
+  auto counters = find(sites_, site);
+  if(counters)
+    ++counters->first;
+}
+
+void Profile::recordBranch(const FunctionCallNode& site, bool condition)
+{
+  auto counters = find(sites_, site);
+  if(counters)
+    ++(condition ? counters->first : counters->second);
+}
+
+void Profile::recordTarget(const CallNode& site, const BlockNode& body)
+{
+  auto counters = find(sites_, site);
+  const auto name = bodies_.find(&body);
+  if(counters && name != bodies_.end())
+    ++counters->targets[name->second];
+}
+
+void Profile::recordBinding(const ExpressionNode& expression)
+{
+  auto counters = find(bindings_, expression);
+  if(counters)
+    ++counters->first;
+}
+
+void Profile::recordForce(const ExpressionNode& expression)
+{
+  auto counters = find(bindings_, expression);
+  if(counters)
+    ++counters->second;
+}
+
+std::optional<std::uint64_t> Profile::getCalls(const Node& site) const
+{
+  const auto counters = find(sites_, site);
+  if(!counters)
+    return std::nullopt;
+  return counters->first;
+}
+
+std::optional<Profile::Branches> Profile::getBranches(const FunctionCallNode& site) const
+{
+  const auto counters = find(sites_, site);
+  if(!counters)
+    return std::nullopt;
+  return Branches{counters->first, counters->second};
+}
+
+std::optional<std::string> Profile::getTarget(const CallNode& site) const
+{
+  const auto counters = find(sites_, site);
+  if(!counters || counters->targets.size() != 1)
+    return std::nullopt;
+  return counters->targets.begin()->first;
+}
+
+std::optional<double> Profile::getForceRate(const ExpressionNode& expression) const
+{
+  const auto counters = find(bindings_, expression);
+  if(!counters || counters->first == 0)
+    return std::nullopt;
+  return static_cast<double>(counters->second) / static_cast<double>(counters->first);
+}
+
+std::size_t Profile::getMatched() const
+{
+  std::size_t matched = 0;
+  for(const auto& index : {&sites_, &bindings_})
+  {
+    for(const auto& site : *index)
+    {
+      if(site.second->known)
+        ++matched;
+    }
+  }
+  return matched;
+}
+
+/*
+ * Profile is a text file, whose first line is the header. Every other line holds
+ * the key of a site (kind, function, hash and occurrence), followed by its Mark and
+ * counters: calls of call sites, true and false branches of ifs, made and forced
+ * bindings. Calls of each target are on separate lines of kind target.
+ */
+bool Profile::load(const std::string& path)
+{
+  std::ifstream file{path};
+  std::string line{};
+  if(!std::getline(file, line) || line != ProfileHeader)
+    return false;
+
+  std::map<std::string, Counters> loaded{};
+  while(std::getline(file, line))
+  {
+    std::istringstream fields{line};
+    std::string kind{}, function{}, hash{}, mark{};
+    std::size_t occurrence = 0;
+    if(!(fields >> kind >> function >> hash >> occurrence))
+      return false;
+
+    const auto key = (kind == "target" ? std::string{"call"} : kind) + " " + function + " " + hash + " " +
+      std::to_string(occurrence);
+    auto& counters = loaded[key];
+    counters.known = true;
+
+    if(kind == "target")
+    {
+      std::string callee{};
+      std::uint64_t calls = 0;
+      if(!(fields >> callee >> calls))
+        return false;
+      counters.targets[callee] = calls;
+      continue;
+    }
+
+    if(kind != "call" && kind != "if" && kind != "bind")
+      return false;
+
+    char separator = 0;
+    if(!(fields >> counters.mark.line >> separator >> counters.mark.column >> counters.first) || separator != ':')
+      return false;
+    if(kind != "call" && !(fields >> counters.second))
+      return false;
+  }
+
+  counters_ = std::move(loaded);
+  sites_.clear();
+  bindings_.clear();
+  bodies_.clear();
+  return true;
+}
+
+bool Profile::save(const std::string& path) const
+{
+  const auto temporaryPath = path + ".tmp";
+  {
+    std::ofstream file{temporaryPath, std::ios::trunc};
+    if(!file.is_open())
+      return false;
+
+    file << ProfileHeader << "\n";
+    for(const auto& entry : counters_)
+    {
+      const auto& counters = entry.second;
+      const auto& key = entry.first;
+      file << key << " " << markString(counters.mark) << " " << counters.first;
+      if(key.rfind("call ", 0) != 0)
+        file << " " << counters.second;
+      file << "\n";
+
+      for(const auto& target : counters.targets)
+        file << "target" << key.substr(key.find(' ')) << " " << target.first << " " << target.second << "\n";
+    }
+
+    if(!file.good())
+      return false;
+  }
+
+  return std::rename(temporaryPath.c_str(), path.c_str()) == 0;
+}
@@ -0,0 +1,486 @@
+#include "PurityAnalyser.hpp"
+
+#include <algorithm>
+#include <iterator>
+
+namespace
+{
+
+using NameSet = std::set<std::string>;
+using StrictnessTable = std::map<std::string, std::vector<bool>>;
+
+/*
+ * Computes set of variables that are certainly forced when given node is evaluated.
+ * Environment maps local names to the sets forced by reading them, which allows to
+ * see through let bindings and lambda arguments.
+ */
+class StrictnessAnalyser : public Visitor
+{
+public:
+  StrictnessAnalyser(const StrictnessTable& table, const std::map<std::string, NameSet>& environment):
+    table_(table), environment_(environment), forced_(), returned_(false) {}
+
+  const NameSet& getForced() const { return forced_; }
+
+  // Statements are analysed until the first return, which ends the block.
+  template<typename Iterator>
+  void analyseStatements(Iterator begin, Iterator end)
+  {
+    for(auto it = begin; it != end && !returned_; ++it)
+      (*it)->accept(*this);
+  }
+
+  void visit(const AssignmentNode& node) override
+  {
+    if(node.getOperation() == AssignmentOperator::Assign)
+      environment_[node.getName()] = analyse(*node.getValue());
+    else
+    {
+      merge(lookup(node.getName()));
+      merge(analyse(*node.getValue()));
+      environment_[node.getName()] = {};
+    }
+  }
+
+  void visit(const BinaryOpNode& node) override
+  {
+    merge(analyse(node.getLeftOperand()));
+    merge(analyse(node.getRightOperand()));
+  }
+
+  void visit(const BlockNode& node) override
+  {
+    analyseStatements(node.getStatements().begin(), node.getStatements().end());
+  }
+
+  void visit(const FunctionCallNode& node) override
+  {
+    const auto& name = node.getName();
+    const auto& args = node.getArguments();
+    if(name == "if")
+    {
+      auto it = args.begin();
+      merge(analyse(**it++));
+      const auto onTrue = analyse(**it++);
+      const auto onFalse = analyse(**it);
+
+      std::set_intersection(onTrue.begin(), onTrue.end(), onFalse.begin(), onFalse.end(),
+        std::inserter(forced_, forced_.end()));
+    }
+    else if(name == "print")
+      merge(analyse(*args.front()));
+    else if(environment_.find(name) != environment_.end())
+      merge(lookup(name));
+    else
+    {
+      const auto function = table_.find(name);
+      if(function == table_.end() || function->second.size() != args.size())
+        return;
+
+      auto strictIt = function->second.begin();
+      for(const auto& arg : args)
+      {
+        if(*strictIt++)
+          merge(analyse(*arg));
+      }
+    }
+  }
+
+  void visit(const FunctionCallStatementNode& node) override
+  {
+    merge(analyse(node.getFunctionCall()));
+  }
+
+  void visit(const FunctionDeclarationNode&) override {}
+
+  void visit(const FunctionResultCallNode& node) override
+  {
+    merge(analyse(node.getCall()));
+  }
+
+  void visit(const LambdaCallNode& node) override
+  {
+    const auto& lambda = node.getLambda();
+    auto environment = environment_;
+    auto argIt = node.getArguments().begin();
+    for(const auto& arg : lambda.getArguments())
+      environment[arg.first] = analyse(**argIt++);
+
+    StrictnessAnalyser analyser{table_, environment};
+    lambda.getBody().accept(analyser);
+    merge(analyser.getForced());
+  }
+
+  void visit(const LambdaNode&) override {}
+  void visit(const NumericLiteralNode&) override {}
+  void visit(const ProgramNode&) override {}
+
+  void visit(const ReturnNode& node) override
+  {
+    merge(analyse(node.getValue()));
+    returned_ = true;
+  }
+
+  void visit(const StringLiteralNode&) override {}
+
+  void visit(const UnaryNode& node) override
+  {
+    merge(analyse(node.getTerm()));
+  }
+
+  void visit(const VariableDeclarationNode& node) override
+  {
+    environment_[node.getName()] = analyse(*node.getValue());
+  }
+
+  void visit(const VariableNode& node) override
+  {
+    merge(lookup(node.getName()));
+  }
+
+private:
+  NameSet analyse(const Node& node) const
+  {
+    StrictnessAnalyser analyser{table_, environment_};
+    node.accept(analyser);
+    return analyser.getForced();
+  }
+
+  NameSet lookup(const std::string& name) const
+  {
+    const auto it = environment_.find(name);
+    return it != environment_.end() ? it->second : NameSet{};
+  }
+
+  void merge(const NameSet& names) { forced_.insert(names.begin(), names.end()); }
+
+  const StrictnessTable& table_;
+  std::map<std::string, NameSet> environment_;
+  NameSet forced_;
+  bool returned_;
+};
+
+}
+
+std::shared_ptr<const PurityAnalyser> analysePurity(const ProgramNode& program,
+  const std::shared_ptr<const PurityAnalyser>& given)
+{
+  if(given)
+    return given;
+
+  auto purity = std::make_shared<PurityAnalyser>();
+  program.accept(*purity);
+  return purity;
+}
+
+PurityAnalyser::PurityAnalyser(): functions_(), localNames_(), nonLocalAssignments_(), scopes_(), current_(nullptr) {}
+
+bool PurityAnalyser::isPure(const std::string& function) const
+{
+  const auto it = functions_.find(function);
+  return it != functions_.end() && it->second.pure;
+}
+
+bool PurityAnalyser::isMemoizable(const std::string& function) const
+{
+  const auto it = functions_.find(function);
+  if(it == functions_.end() || !it->second.pure || !it->second.numeric)
+    return false;
+
+  const auto& strict = it->second.strictArguments;
+  return std::all_of(strict.begin(), strict.end(), [](bool s) { return s; });
+}
+
+bool PurityAnalyser::isClosed(const std::string& function) const
+{
+  const auto it = functions_.find(function);
+  return it != functions_.end() && it->second.closed;
+}
+
+bool PurityAnalyser::isShadowed(const std::string& name) const
+{
+  return localNames_.find(name) != localNames_.end();
+}
+
+bool PurityAnalyser::isAssignedNonLocally(const std::string& name) const
+{
+  return nonLocalAssignments_.find(name) != nonLocalAssignments_.end();
+}
+
+std::vector<bool> PurityAnalyser::getStrictArguments(const std::string& function) const
+{
+  const auto it = functions_.find(function);
+  if(it == functions_.end())
+    return {};
+  return it->second.strictArguments;
+}
+
+std::set<std::string> PurityAnalyser::getForced(const BlockNode& block, const StatementNode& first,
+  const std::set<std::string>& names) const
+{
+  StrictnessTable table{};
+  for(const auto& function : functions_)
+    table[function.first] = function.second.strictArguments;
+
+  std::map<std::string, NameSet> environment{};
+  for(const auto& name : names)
+    environment[name] = {name};
+
+  const auto& statements = block.getStatements();
+  const auto begin = std::find_if(statements.begin(), statements.end(),
+    [&first](const auto& statement) { return statement.get() == &first; });
+
+  StrictnessAnalyser analyser{table, environment};
+  analyser.analyseStatements(begin, statements.end());
+
+  NameSet forced{};
+  const auto& all = analyser.getForced();
+  std::set_intersection(all.begin(), all.end(), names.begin(), names.end(), std::inserter(forced, forced.end()));
+  return forced;
+}
+
+std::set<std::string> PurityAnalyser::getCallees(const std::string& function) const
+{
+  const auto it = functions_.find(function);
+  if(it == functions_.end())
+    return {};
+  return it->second.callees;
+}
+
+bool PurityAnalyser::isLocal(const std::string& name) const
+{
+  for(const auto& scope : scopes_)
+  {
+    if(scope.find(name) != scope.end())
+      return true;
+  }
+  return false;
+}
+
+void PurityAnalyser::computePurity()
+{
+  for(auto& function : functions_)
+  {
+    function.second.pure = function.second.locallyPure;
+    function.second.closed = function.second.locallyClosed;
+  }
+
+  bool changed = true;
+  while(changed)
+  {
+    changed = false;
+    for(auto& function : functions_)
+    {
+      for(const auto& callee : function.second.callees)
+      {
+        if(function.second.pure && (!isPure(callee) || isShadowed(callee)))
+        {
+          function.second.pure = false;
+          changed = true;
+        }
+        if(function.second.closed && (!isClosed(callee) || isShadowed(callee)))
+        {
+          function.second.closed = false;
+          changed = true;
+        }
+      }
+    }
+  }
+}
+
+void PurityAnalyser::computeStrictness()
+{
+  StrictnessTable table{};
+  for(const auto& function : functions_)
+    table[function.first] = std::vector<bool>(function.second.declaration->getArguments().size(), true);
+
+  bool changed = true;
+  while(changed)
+  {
+    changed = false;
+    for(const auto& function : functions_)
+    {
+      const auto& declaration = *function.second.declaration;
+      std::map<std::string, NameSet> environment{};
+      for(const auto& arg : declaration.getArguments())
+        environment[arg.first] = {arg.first};
+
+      StrictnessAnalyser analyser{table, environment};
+      declaration.getBody()->accept(analyser);
+      const auto& forced = analyser.getForced();
+
+      std::vector<bool> strict{};
+      for(const auto& arg : declaration.getArguments())
+        strict.push_back(forced.find(arg.first) != forced.end());
+
+      if(strict != table[function.first])
+      {
+        table[function.first] = strict;
+        changed = true;
+      }
+    }
+  }
+
+  for(auto& function : functions_)
+    function.second.strictArguments = table[function.first];
+}
+
+void PurityAnalyser::visit(const AssignmentNode& node)
+{
+  if(!isLocal(node.getName()))
+  {
+    current_->locallyPure = false;
+    current_->locallyClosed = false;
+    nonLocalAssignments_.insert(node.getName());
+  }
+
+  node.getValue()->accept(*this);
+}
+
+void PurityAnalyser::visit(const BinaryOpNode& node)
+{
+  node.getLeftOperand().accept(*this);
+  node.getRightOperand().accept(*this);
+}
+
+void PurityAnalyser::visit(const BlockNode& node)
+{
+  for(const auto& statement : node.getStatements())
+    statement->accept(*this);
+}
+
+void PurityAnalyser::visit(const FunctionCallNode& node)
+{
+  const auto& name = node.getName();
+  if(name == "print" || isLocal(name))
+    current_->locallyPure = false;
+  else if(name != "if")
+  {
+    if(functions_.find(name) != functions_.end())
+      current_->callees.insert(name);
+    else
+    {
+      current_->locallyPure = false;
+      current_->locallyClosed = false;
+    }
+  }
+
+  for(const auto& arg : node.getArguments())
+    arg->accept(*this);
+}
+
+void PurityAnalyser::visit(const FunctionCallStatementNode& node)
+{
+  node.getFunctionCall().accept(*this);
+}
+
+void PurityAnalyser::visit(const FunctionDeclarationNode& node)
+{
+  current_ = &functions_[node.getName()];
+
+  scopes_.emplace_back();
+  for(const auto& arg : node.getArguments())
+  {
+    scopes_.back().insert(arg.first);
+    localNames_.insert(arg.first);
+  }
+
+  node.getBody()->accept(*this);
+
+  scopes_.clear();
+  current_ = nullptr;
+}
+
+void PurityAnalyser::visit(const FunctionResultCallNode& node)
+{
+  current_->locallyPure = false;
+
+  node.getCall().accept(*this);
+  for(const auto& arg : node.getArguments())
+    arg->accept(*this);
+}
+
+void PurityAnalyser::visit(const LambdaCallNode& node)
+{
+  node.getLambda().accept(*this);
+  for(const auto& arg : node.getArguments())
+    arg->accept(*this);
+}
+
+void PurityAnalyser::visit(const LambdaNode& node)
+{
+  scopes_.emplace_back();
+  for(const auto& arg : node.getArguments())
+  {
+    scopes_.back().insert(arg.first);
+    localNames_.insert(arg.first);
+  }
+
+  node.getBody().accept(*this);
+
+  scopes_.pop_back();
+}
+
+void PurityAnalyser::visit(const NumericLiteralNode&)
+{}
+
+void PurityAnalyser::visit(const ProgramNode& node)
+{
+  functions_.clear();
+  localNames_.clear();
+  nonLocalAssignments_.clear();
+
+  for(const auto& function : node.getFunctions())
+  {
+    auto& info = functions_[function->getName()];
+    info.declaration = function.get();
+    info.numeric = function->getReturnType() == TypeName::F32;
+    for(const auto& arg : function->getArguments())
+      info.numeric = info.numeric && arg.second == TypeName::F32;
+  }
+
+  for(const auto& function : node.getFunctions())
+    function->accept(*this);
+
+  computePurity();
+  computeStrictness();
+
+  for(auto& function : functions_)
+    function.second.declaration = nullptr;
+}
+
+void PurityAnalyser::visit(const ReturnNode& node)
+{
+  node.getValue().accept(*this);
+}
+
+void PurityAnalyser::visit(const StringLiteralNode&)
+{}
+
+void PurityAnalyser::visit(const UnaryNode& node)
+{
+  node.getTerm().accept(*this);
+}
+
+void PurityAnalyser::visit(const VariableDeclarationNode& node)
+{
+  node.getValue()->accept(*this);
+
+  scopes_.back().insert(node.getName());
+  localNames_.insert(node.getName());
+}
+
+void PurityAnalyser::visit(const VariableNode& node)
+{
+  const auto& name = node.getName();
+  if(isLocal(name))
+    return;
+
+  if(functions_.find(name) != functions_.end())
+    current_->callees.insert(name);
+  else
+  {
+    current_->locallyPure = false;
+    current_->locallyClosed = false;
+  }
+}
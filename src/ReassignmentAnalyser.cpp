@@ -0,0 +1,33 @@
+#include "ReassignmentAnalyser.hpp"
+
+#include "RecursiveVisitor.hpp"
+
+namespace
+{
+
+// Collects names of variables which are assigned a new expression with =.
+class AssignmentCollector : public RecursiveVisitor
+{
+public:
+  AssignmentCollector(std::unordered_set<std::string>& names): names_(names) {}
+
+  void visit(const AssignmentNode& node) override
+  {
+    if(node.getOperation() == AssignmentOperator::Assign)
+      names_.insert(node.getName());
+    RecursiveVisitor::visit(node);
+  }
+
+private:
+  std::unordered_set<std::string>& names_;
+};
+
+}
+
+std::unordered_set<std::string> findReassignedNames(const ProgramNode& program)
+{
+  std::unordered_set<std::string> names{};
+  AssignmentCollector collector{names};
+  program.accept(collector);
+  return names;
+}
@@ -0,0 +1,107 @@
+#include "RecursiveVisitor.hpp"
+
+void RecursiveVisitor::visitArguments(const CallNode& node)
+{
+  for(const auto& arg : node.getArguments())
+    arg->accept(*this);
+}
+
+void RecursiveVisitor::visit(const AssignmentNode& node)
+{
+  enter(node);
+  node.getValue()->accept(*this);
+}
+
+void RecursiveVisitor::visit(const BinaryOpNode& node)
+{
+  enter(node);
+  node.getLeftOperand().accept(*this);
+  node.getRightOperand().accept(*this);
+}
+
+void RecursiveVisitor::visit(const BlockNode& node)
+{
+  enter(node);
+  for(const auto& statement : node.getStatements())
+    statement->accept(*this);
+}
+
+void RecursiveVisitor::visit(const FunctionCallNode& node)
+{
+  enter(node);
+  visitArguments(node);
+}
+
+void RecursiveVisitor::visit(const FunctionCallStatementNode& node)
+{
+  enter(node);
+  node.getFunctionCall().accept(*this);
+}
+
+void RecursiveVisitor::visit(const FunctionDeclarationNode& node)
+{
+  enter(node);
+  node.getBody()->accept(*this);
+}
+
+void RecursiveVisitor::visit(const FunctionResultCallNode& node)
+{
+  enter(node);
+  node.getCall().accept(*this);
+  visitArguments(node);
+}
+
+void RecursiveVisitor::visit(const LambdaCallNode& node)
+{
+  enter(node);
+  node.getLambda().accept(*this);
+  visitArguments(node);
+}
+
+void RecursiveVisitor::visit(const LambdaNode& node)
+{
+  enter(node);
+  node.getBody().accept(*this);
+}
+
+void RecursiveVisitor::visit(const NumericLiteralNode& node)
+{
+  enter(node);
+}
+
+void RecursiveVisitor::visit(const ProgramNode& node)
+{
+  enter(node);
+  for(const auto& variable : node.getVariables())
+    variable->accept(*this);
+  for(const auto& function : node.getFunctions())
+    function->accept(*this);
+}
+
+void RecursiveVisitor::visit(const ReturnNode& node)
+{
+  enter(node);
+  node.getValue().accept(*this);
+}
+
+void RecursiveVisitor::visit(const StringLiteralNode& node)
+{
+  enter(node);
+}
+
+void RecursiveVisitor::visit(const UnaryNode& node)
+{
+  enter(node);
+  node.getTerm().accept(*this);
+}
+
+void RecursiveVisitor::visit(const VariableDeclarationNode& node)
+{
+  enter(node);
+  node.getValue()->accept(*this);
+}
+
+void RecursiveVisitor::visit(const VariableNode& node)
+{
+  enter(node);
+}
@@ -3,7 +3,7 @@
 #include "Common.hpp"
 #include "TypeChecker.hpp"
 
-SemanticAnalyser::SemanticAnalyser(): symbols_(), hasReturn_()
+SemanticAnalyser::SemanticAnalyser(): symbols_(), types_(), hasReturn_()
 {
   addBuildInSymbols();
 }
@@ -22,6 +22,12 @@ void SemanticAnalyser::addBuildInSymbols()
   symbols_.addSymbol("print", std::move(printSymbol));
 }
 
+void SemanticAnalyser::setType(const ExpressionNode& node, const std::optional<TypeName>& type)
+{
+  if(type.has_value())
+    types_[&node] = type.value();
+}
+
 void SemanticAnalyser::visit(const AssignmentNode& node) 
 {
   const auto name = node.getName();
@@ -39,20 +45,44 @@ void SemanticAnalyser::visit(const AssignmentNode& node)
 
   node.getValue()->accept(*this);
 
-  TypeChecker typeChecker{symbols_};
-  node.getValue()->accept(typeChecker);
+  TypeChecker typeChecker{types_};
+  const auto type = typeChecker.getType(*node.getValue());
 
   // Type checker is not able to deduce expression's type when variable was called
   // and in that case getType has no value.
-  if(typeChecker.getType().has_value() && typeChecker.getType() != analyser.getType())
+  if(type.has_value() && type != analyser.getType())
     reportError("Cannot assign value of type " + 
-      TypeNameStrings.at(typeChecker.getType().value()) + " to variable " + name + "!", node);
+      TypeNameStrings.at(type.value()) + " to variable " + name + "!", node);
 }
 
 void SemanticAnalyser::visit(const BinaryOpNode& node) 
 {
   node.getLeftOperand().accept(*this);
   node.getRightOperand().accept(*this);
+
+  TypeChecker typeChecker{types_};
+  const auto leftType = typeChecker.getType(node.getLeftOperand());
+  const auto rightType = typeChecker.getType(node.getRightOperand());
+
+  if(!leftType.has_value() || !rightType.has_value())
+    return;
+
+  if(leftType == TypeName::String)
+  {
+    if(node.getOperation() != BinaryOperator::Addition)
+      reportError("Invalid operation on value of type " + 
+        TypeNameStrings.at(leftType.value()) + "!", node);
+    else if(rightType != TypeName::F32 && rightType != TypeName::String)
+      reportError("Cannot concatenate string with " +
+        TypeNameStrings.at(rightType.value()) + "!", node);
+
+    setType(node, TypeName::String);
+  }
+  else if(leftType == TypeName::F32 && rightType == TypeName::F32)
+    setType(node, TypeName::F32);
+  else
+    reportError("Invalid operation on value of type " + 
+        TypeNameStrings.at(leftType.value()) + "!", node);
 }
 
 void SemanticAnalyser::visit(const BlockNode& node) 
@@ -73,6 +103,8 @@ void SemanticAnalyser::visit(const FunctionCallNode& node)
   if(!analyser.isSymbolValid())
     reportError("Symbol " + name + " does not name a function!", node);
 
+  setType(node, analyser.getReturnType());
+
   /*
    * If user calls variable of type function, then analyser knows nothing about it's return type and arguments.
    * This is because variables' values are not being tracked.
@@ -93,12 +125,12 @@ void SemanticAnalyser::visit(const FunctionCallNode& node)
     {
       arg->accept(*this);
 
-      TypeChecker typeChecker{symbols_};
-      arg->accept(typeChecker);
-      if(typeChecker.getType().has_value() && typeChecker.getType() != *expectedArgsIt)
+      TypeChecker typeChecker{types_};
+      const auto type = typeChecker.getType(*arg);
+      if(type.has_value() && type != *expectedArgsIt)
         reportError("Function " + name + " expected argument of type " + 
           TypeNameStrings.at(*expectedArgsIt) + ", but got " + 
-            TypeNameStrings.at(typeChecker.getType().value()) + "!", node);
+            TypeNameStrings.at(type.value()) + "!", node);
       
       expectedArgsIt++;
     }
@@ -155,11 +187,11 @@ void SemanticAnalyser::visit(const FunctionResultCallNode& node)
 {
   node.getCall().accept(*this);
 
-  TypeChecker typeChecker{symbols_};
-  node.getCall().accept(typeChecker);
-  if(typeChecker.getType().has_value() && typeChecker.getType() != TypeName::Function)
+  TypeChecker typeChecker{types_};
+  const auto type = typeChecker.getType(node.getCall());
+  if(type.has_value() && type != TypeName::Function)
     reportError("Cannot call result of function returning " + 
-      TypeNameStrings.at(typeChecker.getType().value()) + "!", node);
+      TypeNameStrings.at(type.value()) + "!", node);
   
   for(const auto& arg : node.getArguments())
     arg->accept(*this);
@@ -174,6 +206,7 @@ void SemanticAnalyser::visit(const LambdaCallNode& node)
   const auto nProvidedArgs = providedArguments.size();
 
   lambda.accept(*this);
+  setType(node, lambda.getReturnType());
 
   if(nExpectedArgs != nProvidedArgs)
     reportError("Lambda expected " + std::to_string(nExpectedArgs) + 
@@ -185,12 +218,12 @@ void SemanticAnalyser::visit(const LambdaCallNode& node)
   {
     arg->accept(*this);
 
-    TypeChecker typeChecker{symbols_};
-    arg->accept(typeChecker);
-    if(typeChecker.getType().has_value() && typeChecker.getType() != expectedArgumentIt->second)
+    TypeChecker typeChecker{types_};
+    const auto type = typeChecker.getType(*arg);
+    if(type.has_value() && type != expectedArgumentIt->second)
       reportError("Lambda expected argument of type " + 
         TypeNameStrings.at(expectedArgumentIt->second) + ", but got " + 
-          TypeNameStrings.at(typeChecker.getType().value()) + "!", node);
+          TypeNameStrings.at(type.value()) + "!", node);
 
     expectedArgumentIt++;
   }
@@ -198,6 +231,8 @@ void SemanticAnalyser::visit(const LambdaCallNode& node)
 
 void SemanticAnalyser::visit(const LambdaNode& node) 
 {
+  setType(node, TypeName::Function);
+
   hasReturn_.push({});
   symbols_.enterScope();
 
@@ -223,8 +258,10 @@ void SemanticAnalyser::visit(const LambdaNode& node)
         TypeNameStrings.at(returnInfo.type.value()) + "!", node);
 }
 
-void SemanticAnalyser::visit(const NumericLiteralNode&) 
-{}
+void SemanticAnalyser::visit(const NumericLiteralNode& node) 
+{
+  setType(node, TypeName::F32);
+}
 
 void SemanticAnalyser::visit(const ProgramNode& node) 
 {
@@ -249,21 +286,31 @@ void SemanticAnalyser::visit(const ProgramNode& node)
 void SemanticAnalyser::visit(const ReturnNode& node) 
 {
   node.getValue().accept(*this);
-  TypeChecker typeChecker{symbols_};
-  node.getValue().accept(typeChecker);
+  TypeChecker typeChecker{types_};
+  const auto type = typeChecker.getType(node.getValue());
 
-  if(typeChecker.getType().has_value())
-    hasReturn_.top() = ReturnInfo{typeChecker.getType().value()};
+  if(type.has_value())
+    hasReturn_.top() = ReturnInfo{type.value()};
   else
     hasReturn_.top() = ReturnInfo{true};
 }
 
-void SemanticAnalyser::visit(const StringLiteralNode&) 
-{}
+void SemanticAnalyser::visit(const StringLiteralNode& node) 
+{
+  setType(node, TypeName::String);
+}
 
 void SemanticAnalyser::visit(const UnaryNode& node) 
 {
   node.getTerm().accept(*this);
+
+  TypeChecker typeChecker{types_};
+  const auto termType = typeChecker.getType(node.getTerm());
+  if(termType.has_value() && termType != TypeName::F32)
+    reportError("Invalid operation on value of type " + 
+      TypeNameStrings.at(termType.value()) + "!", node);
+
+  setType(node, termType);
 }
 
 
@@ -276,14 +323,14 @@ void SemanticAnalyser::visit(const VariableDeclarationNode& node)
   
   node.getValue()->accept(*this);
 
-  TypeChecker typeChecker{symbols_};
-  node.getValue()->accept(typeChecker);
+  TypeChecker typeChecker{types_};
+  const auto type = typeChecker.getType(*node.getValue());
 
   // Type checker is not able to deduce expression's type when variable was called
   // and in that case getType has no value.
-  if(typeChecker.getType().has_value() && typeChecker.getType() != node.getType())
+  if(type.has_value() && type != node.getType())
     reportError("Cannot assign value of type " + 
-      TypeNameStrings.at(typeChecker.getType().value()) + " to variable " + name + "!", node);
+      TypeNameStrings.at(type.value()) + " to variable " + name + "!", node);
 
   auto variableSymbol = std::make_unique<VariableSymbol>(name, node.getType());
   symbols_.addSymbol(name, std::move(variableSymbol));
@@ -295,4 +342,18 @@ void SemanticAnalyser::visit(const VariableNode& node)
   const auto symbol = symbols_.lookup(name);
   if(!symbol)
     reportError("Usage of undeclared symbol " + name + "!", node);
+
+  VariableAnalyser variableAnalyser{};
+  symbol.value().get().accept(variableAnalyser);
+  if(variableAnalyser.isSymbolValid())
+    setType(node, variableAnalyser.getType());
+  else
+  {
+    FunctionAnalyser functionAnalyser{};
+    symbol.value().get().accept(functionAnalyser);
+    if(functionAnalyser.isSymbolValid())
+      setType(node, TypeName::Function);
+    else
+      reportError("Invalid symbol reference!", node);
+  }
 }
\ No newline at end of file
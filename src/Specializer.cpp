@@ -0,0 +1,396 @@
+#include "Specializer.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "NumericNodes.hpp"
+#include "Operators.hpp"
+#include "RecursiveVisitor.hpp"
+
+namespace
+{
+
+class NumericLiteralAnalyser : public Visitor
+{
+public:
+  NumericLiteralAnalyser(): value_() {}
+
+  const std::optional<double>& getValue() const { return value_; }
+
+  void visit(const AssignmentNode&) override {}
+  void visit(const BinaryOpNode&) override {}
+  void visit(const BlockNode&) override {}
+  void visit(const FunctionCallNode&) override {}
+  void visit(const FunctionCallStatementNode&) override {}
+  void visit(const FunctionDeclarationNode&) override {}
+  void visit(const FunctionResultCallNode&) override {}
+  void visit(const LambdaCallNode&) override {}
+  void visit(const LambdaNode&) override {}
+  void visit(const NumericLiteralNode& node) override { value_ = node.getValue(); }
+  void visit(const ProgramNode&) override {}
+  void visit(const ReturnNode&) override {}
+  void visit(const StringLiteralNode&) override {}
+  void visit(const UnaryNode&) override {}
+  void visit(const VariableDeclarationNode&) override {}
+  void visit(const VariableNode&) override {}
+
+private:
+  std::optional<double> value_;
+};
+
+std::optional<double> getLiteral(const ExpressionNode& node)
+{
+  NumericLiteralAnalyser analyser{};
+  node.accept(analyser);
+  return analyser.getValue();
+}
+
+/*
+ * Collects names that are bound (declared, assigned or taken as lambda parameters)
+ * anywhere in a subtree and names which are read or called in it.
+ */
+class BindingCollector : public RecursiveVisitor
+{
+public:
+  BindingCollector(): bound(), used() {}
+
+  std::set<std::string> bound;
+  std::set<std::string> used;
+
+  void visit(const AssignmentNode& node) override
+  {
+    bound.insert(node.getName());
+    RecursiveVisitor::visit(node);
+  }
+
+  void visit(const FunctionCallNode& node) override
+  {
+    used.insert(node.getName());
+    RecursiveVisitor::visit(node);
+  }
+
+  void visit(const LambdaNode& node) override
+  {
+    for(const auto& arg : node.getArguments())
+      bound.insert(arg.first);
+    RecursiveVisitor::visit(node);
+  }
+
+  void visit(const VariableDeclarationNode& node) override
+  {
+    bound.insert(node.getName());
+    RecursiveVisitor::visit(node);
+  }
+
+  void visit(const VariableNode& node) override
+  {
+    used.insert(node.getName());
+  }
+};
+
+// Numeric parameters which are never rebound in the body.
+std::set<std::string> getFixableParameters(const std::list<std::pair<std::string, TypeName>>& parameters,
+  const BindingCollector& body)
+{
+  std::set<std::string> fixable{};
+  for(const auto& parameter : parameters)
+  {
+    if(parameter.second == TypeName::F32 && body.bound.find(parameter.first) == body.bound.end())
+      fixable.insert(parameter.first);
+  }
+  return fixable;
+}
+
+}
+
+Specializer::Specializer(std::size_t capacity, std::shared_ptr<Profile> feedback): analysis_(), purity_(), functions_(),
+  fixable_(), cache_(), residualFunctions_(), constants_(), enclosing_(), capacity_(capacity),
+  feedback_(std::move(feedback)), specialized_(0) {}
+
+void Specializer::visit(const BinaryOpNode& node)
+{
+  fold(node, false);
+}
+
+void Specializer::visit(const NumericBinaryOpNode& node)
+{
+  fold(node, true);
+}
+
+// Loop is copied as the return it replaces, constants substituted into it would not be loop variables anymore.
+void Specializer::visit(const LoopNode& node)
+{
+  ASTCloner::visit(static_cast<const ReturnNode&>(node));
+}
+
+void Specializer::fold(const BinaryOpNode& node, bool numeric)
+{
+  auto left = clone<ExpressionNode>(node.getLeftOperand());
+  auto right = clone<ExpressionNode>(node.getRightOperand());
+
+  const auto l = getLiteral(*left);
+  const auto r = getLiteral(*right);
+  if(l.has_value() && r.has_value())
+    setResult(std::make_unique<NumericLiteralNode>(evaluateBinary(node.getOperation(), l.value(), r.value())), node);
+  else if(numeric)
+  {
+    const auto integer = static_cast<const NumericBinaryOpNode&>(node).isInteger();
+    setResult(makeNumericBinaryNode(std::move(left), node.getOperation(), std::move(right), integer), node);
+  }
+  else
+    setResult(std::make_unique<BinaryOpNode>(std::move(left), node.getOperation(), std::move(right)), node);
+}
+
+void Specializer::visit(const FunctionCallNode& node)
+{
+  const auto& name = node.getName();
+  const auto& args = node.getArguments();
+  if(name == "if")
+  {
+    auto it = args.begin();
+    auto condition = clone<ExpressionNode>(**it++);
+    const auto value = getLiteral(*condition);
+    if(value.has_value())
+    {
+      if(!isTrue(value.value()))
+        ++it;
+      result_ = clone<ExpressionNode>(**it);
+      return;
+    }
+
+    std::list<std::shared_ptr<ExpressionNode>> branches{std::move(condition)};
+    for(; it != args.end(); ++it)
+      branches.push_back(clone<ExpressionNode>(**it));
+    setResult(std::make_unique<FunctionCallNode>(name, std::move(branches)), node);
+    return;
+  }
+
+  auto clonedArgs = cloneArguments(args);
+  const auto function = functions_.find(name);
+  if(function != functions_.end() && !purity_->isShadowed(name) &&
+    function->second->getArguments().size() == clonedArgs.size() && !isCold(node))
+  {
+    const auto pattern = getPattern(function->second->getArguments(), fixable_[name], clonedArgs);
+    const auto residual = specialize(*function->second, pattern);
+    if(residual.has_value())
+    {
+      std::list<std::shared_ptr<ExpressionNode>> remainingArgs{};
+      auto patternIt = pattern.begin();
+      for(auto& arg : clonedArgs)
+      {
+        if(!(patternIt++)->has_value())
+          remainingArgs.push_back(std::move(arg));
+      }
+
+      setResult(std::make_unique<FunctionCallNode>(residual.value(), std::move(remainingArgs)), node);
+      return;
+    }
+  }
+
+  setResult(std::make_unique<FunctionCallNode>(name, std::move(clonedArgs)), node);
+}
+
+/*
+ * Body of called lambda runs in the caller's scope, so constant arguments can be
+ * substituted if top-level functions it refers to cannot observe its parameters.
+ */
+void Specializer::visit(const LambdaCallNode& node)
+{
+  const auto& lambda = node.getLambda();
+  auto args = cloneArguments(node.getArguments());
+
+  BindingCollector body{};
+  lambda.getBody().accept(body);
+
+  const auto closed = std::all_of(body.used.begin(), body.used.end(), [this](const std::string& name) {
+    return functions_.find(name) == functions_.end() || isClosedCallee(name);
+  });
+
+  const auto& parameters = lambda.getArguments();
+  const auto pattern = closed && parameters.size() == args.size() && !isCold(node) ?
+    getPattern(parameters, getFixableParameters(parameters, body), args) : Pattern{};
+  if(std::none_of(pattern.begin(), pattern.end(), [](const std::optional<double>& value) { return value.has_value(); }))
+  {
+    setResult(std::make_unique<LambdaCallNode>(clone<LambdaNode>(lambda), std::move(args)), node);
+    return;
+  }
+
+  const auto saved = constants_;
+  Arguments remainingParameters{};
+  std::list<std::shared_ptr<ExpressionNode>> remainingArgs{};
+  auto argIt = args.begin();
+  auto patternIt = pattern.begin();
+  for(const auto& parameter : parameters)
+  {
+    const auto& value = *patternIt++;
+    if(value.has_value())
+      constants_[parameter.first] = value.value();
+    else
+    {
+      remainingParameters.push_back(parameter);
+      remainingArgs.push_back(std::move(*argIt));
+    }
+    ++argIt;
+  }
+
+  std::shared_ptr<BlockNode> lambdaBody = clone<BlockNode>(lambda.getBody());
+  constants_ = saved;
+  ++specialized_;
+
+  auto residual = std::make_unique<LambdaNode>(lambda.getReturnType(), remainingParameters, std::move(lambdaBody));
+  residual->setMark(lambda.getMark());
+  setResult(std::make_unique<LambdaCallNode>(std::move(residual), std::move(remainingArgs)), node);
+}
+
+void Specializer::visit(const ProgramNode& node)
+{
+  purity_ = analysePurity(node, analysis_);
+  if(feedback_)
+    feedback_->addProgram(node);
+
+  functions_.clear();
+  fixable_.clear();
+  cache_.clear();
+  enclosing_.clear();
+  for(const auto& function : node.getFunctions())
+  {
+    const auto& name = function->getName();
+    functions_[name] = function.get();
+
+    const auto callees = purity_->getCallees(name);
+    if(std::all_of(callees.begin(), callees.end(), [this](const std::string& callee) { return isClosedCallee(callee); }))
+    {
+      BindingCollector body{};
+      function->getBody()->accept(body);
+      fixable_[name] = getFixableParameters(function->getArguments(), body);
+    }
+  }
+
+  ASTCloner::visit(node);
+
+  auto& program = static_cast<ProgramNode&>(*result_);
+  for(auto& function : residualFunctions_)
+    program.addFunction(std::move(function));
+  residualFunctions_.clear();
+}
+
+void Specializer::visit(const UnaryNode& node)
+{
+  auto term = clone<ExpressionNode>(node.getTerm());
+
+  const auto value = getLiteral(*term);
+  if(value.has_value())
+    setResult(std::make_unique<NumericLiteralNode>(evaluateUnary(node.getOperation(), value.value())), node);
+  else
+    setResult(std::make_unique<UnaryNode>(node.getOperation(), std::move(term)), node);
+}
+
+void Specializer::visit(const VariableNode& node)
+{
+  const auto constant = constants_.find(node.getName());
+  if(constant != constants_.end())
+    setResult(std::make_unique<NumericLiteralNode>(constant->second), node);
+  else
+    ASTCloner::visit(node);
+}
+
+/*
+ * Returns name of residual function for given constant arguments. Residual function
+ * is registered before its body is specialized, so recursive calls with the same
+ * constants reuse it. Recursive calls with other constants are left to the original
+ * function, otherwise every step of the recursion would get its own residual.
+ */
+std::optional<std::string> Specializer::specialize(const FunctionDeclarationNode& function, const Pattern& pattern)
+{
+  if(std::none_of(pattern.begin(), pattern.end(), [](const std::optional<double>& value) { return value.has_value(); }))
+    return std::nullopt;
+
+  const auto key = std::make_pair(function.getName(), pattern);
+  const auto cached = cache_.find(key);
+  if(cached != cache_.end())
+    return cached->second;
+
+  if(cache_.size() >= capacity_)
+    return std::nullopt;
+
+  for(const auto& enclosing : enclosing_)
+  {
+    const auto& called = function.getName();
+    if(enclosing.second != pattern && (enclosing.first == called || reaches(called, enclosing.first)))
+      return std::nullopt;
+  }
+
+  const auto name = function.getName() + "$" + std::to_string(cache_.size());
+  cache_[key] = name;
+  ++specialized_;
+
+  auto saved = std::move(constants_);
+  constants_.clear();
+
+  Arguments parameters{};
+  auto patternIt = pattern.begin();
+  for(const auto& parameter : function.getArguments())
+  {
+    const auto& value = *patternIt++;
+    if(value.has_value())
+      constants_[parameter.first] = value.value();
+    else
+      parameters.push_back(parameter);
+  }
+
+  enclosing_.emplace_back(function.getName(), pattern);
+  auto body = clone<BlockNode>(*function.getBody());
+  enclosing_.pop_back();
+  constants_ = std::move(saved);
+
+  auto residual = std::make_unique<FunctionDeclarationNode>(name, function.getReturnType(), parameters, std::move(body));
+  residual->setMark(function.getMark());
+  residualFunctions_.push_back(std::move(residual));
+  return name;
+}
+
+Specializer::Pattern Specializer::getPattern(const Arguments& parameters, const std::set<std::string>& fixable,
+  const std::list<std::shared_ptr<ExpressionNode>>& args) const
+{
+  Pattern pattern{};
+  auto argIt = args.begin();
+  for(const auto& parameter : parameters)
+  {
+    const auto value = getLiteral(**argIt++);
+    if(fixable.find(parameter.first) != fixable.end() && value.has_value() && !std::isnan(value.value()))
+      pattern.push_back(value);
+    else
+      pattern.push_back(std::nullopt);
+  }
+  return pattern;
+}
+
+// Closed functions cannot read parameters of their caller, which are dynamically in scope.
+bool Specializer::isClosedCallee(const std::string& name) const
+{
+  return purity_->isClosed(name) && !purity_->isShadowed(name);
+}
+
+bool Specializer::reaches(const std::string& caller, const std::string& callee) const
+{
+  std::set<std::string> visited{caller};
+  std::vector<std::string> pending{caller};
+  while(!pending.empty())
+  {
+    const auto name = pending.back();
+    pending.pop_back();
+    for(const auto& next : purity_->getCallees(name))
+    {
+      if(next == callee)
+        return true;
+      if(visited.insert(next).second)
+        pending.push_back(next);
+    }
+  }
+  return false;
+}
+
+bool Specializer::isCold(const CallNode& node) const
+{
+  return feedback_ && feedback_->getCalls(node) == std::uint64_t{0};
+}
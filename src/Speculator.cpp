@@ -0,0 +1,231 @@
+#include "Speculator.hpp"
+
+#include <string>
+
+#include "Operators.hpp"
+#include "ReassignmentAnalyser.hpp"
+#include "Value.h"
+
+namespace
+{
+
+// Sites which aborted this many more times than they succeeded are no longer tried.
+constexpr std::size_t Patience = 4;
+// Sites whose bindings were forced less often than this in the profiled runs are not tried.
+constexpr double MinForceRate = 0.5;
+
+struct Abort {};
+
+/*
+ * Evaluates expression like Executor would, with every step counted against
+ * the budget. Anything that could call, print, fail or take too long throws
+ * Abort instead.
+ */
+class SpeculativeEvaluator : public Visitor
+{
+public:
+  SpeculativeEvaluator(const Context& context, std::size_t budget):
+    context_(&context), budget_(budget), type_(TypeName::Void), number_(0), string_() {}
+
+  std::shared_ptr<ExpressionNode> getLiteral() const
+  {
+    if(type_ == TypeName::String)
+      return std::make_shared<StringLiteralNode>(string_);
+    return std::make_shared<NumericLiteralNode>(number_);
+  }
+
+  void visit(const AssignmentNode&) override { throw Abort{}; }
+
+  void visit(const BinaryOpNode& node) override
+  {
+    step();
+    node.getLeftOperand().accept(*this);
+    const auto leftType = type_;
+    const auto left = number_;
+    auto leftString = std::move(string_);
+
+    node.getRightOperand().accept(*this);
+
+    if(node.getOperation() == BinaryOperator::Addition && leftType == TypeName::String)
+    {
+      if(type_ == TypeName::String)
+        string_ = leftString + string_;
+      else if(type_ == TypeName::F32)
+        string_ = leftString + std::to_string(number_);
+      else
+        throw Abort{};
+      type_ = TypeName::String;
+      return;
+    }
+
+    if(leftType != TypeName::F32 || type_ != TypeName::F32)
+      throw Abort{};
+    number_ = evaluateBinary(node.getOperation(), left, number_);
+  }
+
+  void visit(const BlockNode&) override { throw Abort{}; }
+
+  void visit(const FunctionCallNode& node) override
+  {
+    const auto& args = node.getArguments();
+    if(node.getName() != "if" || args.size() != 3)
+      throw Abort{};
+
+    step();
+    auto it = args.begin();
+    (*it)->accept(*this);
+    if(type_ != TypeName::F32)
+      throw Abort{};
+
+    if(isTrue(number_))
+      (*++it)->accept(*this);
+    else
+      args.back()->accept(*this);
+  }
+
+  void visit(const FunctionCallStatementNode&) override { throw Abort{}; }
+  void visit(const FunctionDeclarationNode&) override { throw Abort{}; }
+  void visit(const FunctionResultCallNode&) override { throw Abort{}; }
+  void visit(const LambdaCallNode&) override { throw Abort{}; }
+  void visit(const LambdaNode&) override { throw Abort{}; }
+
+  void visit(const NumericLiteralNode& node) override
+  {
+    step();
+    type_ = TypeName::F32;
+    number_ = node.getValue();
+  }
+
+  void visit(const ProgramNode&) override { throw Abort{}; }
+  void visit(const ReturnNode&) override { throw Abort{}; }
+
+  void visit(const StringLiteralNode& node) override
+  {
+    step();
+    type_ = TypeName::String;
+    string_ = node.getValue();
+  }
+
+  void visit(const UnaryNode& node) override
+  {
+    step();
+    node.getTerm().accept(*this);
+    if(type_ != TypeName::F32)
+      throw Abort{};
+    number_ = evaluateUnary(node.getOperation(), number_);
+  }
+
+  void visit(const VariableDeclarationNode&) override { throw Abort{}; }
+
+  void visit(const VariableNode& node) override
+  {
+    step();
+    const auto symbol = context_->lookup(node.getName());
+    if(!symbol)
+      throw Abort{};
+
+    RuntimeVariableAnalyser analyser{};
+    symbol.value().get().accept(analyser);
+    if(!analyser.isSymbolValid())
+      throw Abort{};
+
+    // Forced shared variables are read from their cells, others are evaluated in their own context.
+    const auto& cell = analyser.getCell();
+    if(cell && cell->value)
+    {
+      read(*cell->value);
+      return;
+    }
+
+    const auto context = context_;
+    context_ = &analyser.getContext();
+    analyser.getValue()->accept(*this);
+    context_ = context;
+  }
+
+private:
+  void step()
+  {
+    if(budget_ == 0)
+      throw Abort{};
+    --budget_;
+  }
+
+  void read(const Value& value)
+  {
+    if(value.getType() == TypeName::F32)
+    {
+      NumberValueAnalyser analyser{};
+      value.accept(analyser);
+      type_ = TypeName::F32;
+      number_ = analyser.getValue().value();
+    }
+    else if(value.getType() == TypeName::String)
+    {
+      StringValueAnalyser analyser{};
+      value.accept(analyser);
+      type_ = TypeName::String;
+      string_ = analyser.getValue().value();
+    }
+    else
+      throw Abort{};
+  }
+
+  const Context* context_;
+  std::size_t budget_;
+  TypeName type_;
+  double number_;
+  std::string string_;
+};
+
+}
+
+Speculator::Speculator(std::size_t budget, std::shared_ptr<Profile> feedback):
+  budget_(budget), context_(std::make_shared<const Context>()), sites_(), reassigned_(), feedback_(std::move(feedback)),
+  attempts_(0), aborted_(0), disabled_(0) {}
+
+void Speculator::addProgram(const ProgramNode& program)
+{
+  reassigned_ = findReassignedNames(program);
+  if(feedback_)
+    feedback_->addProgram(program);
+}
+
+std::shared_ptr<ExpressionNode> Speculator::speculate(const std::shared_ptr<ExpressionNode>& expression,
+  const Context& context)
+{
+  const auto inserted = sites_.try_emplace(expression.get(), Site{0, 0, false});
+  auto& site = inserted.first->second;
+  if(inserted.second && feedback_)
+  {
+    const auto rate = feedback_->getForceRate(*expression);
+    if(rate && *rate < MinForceRate)
+    {
+      site.disabled = true;
+      ++disabled_;
+    }
+  }
+
+  if(site.disabled)
+    return nullptr;
+
+  ++attempts_;
+  SpeculativeEvaluator evaluator{context, budget_};
+  try
+  {
+    expression->accept(evaluator);
+  }
+  catch(const Abort&)
+  {
+    ++aborted_;
+    if(++site.aborted >= site.succeeded + Patience)
+    {
+      site.disabled = true;
+      ++disabled_;
+    }
+    return nullptr;
+  }
+
+  ++site.succeeded;
+  return evaluator.getLiteral();
+}
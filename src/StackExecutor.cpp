@@ -0,0 +1,689 @@
+#include "StackExecutor.hpp"
+
+#include <algorithm>
+
+#include "Common.hpp"
+#include "Operators.hpp"
+#include "AST.hpp"
+#include "ValueOperations.hpp"
+
+namespace
+{
+
+const std::string MainName = "main";
+const std::string LambdaName = "lambda";
+const std::string ResultName = "result";
+
+}
+
+StackExecutor::StackExecutor(const ExecutorOptions& options):
+  forced_(), frames_(), segments_(), control_(nullptr), exitCode_(0), memoTable_(),
+  stackLimit_(options.stackLimit << 20), maxDepth_(0)
+{
+  segments_.emplace_back(Context{});
+  if(options.memoize)
+    memoTable_ = std::make_shared<MemoTable>(options.memoCapacity);
+}
+
+std::vector<std::string> StackExecutor::getStackTrace() const
+{
+  std::vector<std::string> trace{};
+  for(auto it = frames_.crbegin(); it != frames_.crend(); ++it)
+  {
+    if(it->name)
+      trace.push_back(*it->name + " (" + it->node->getMark().to_string() + ")");
+  }
+  return trace;
+}
+
+/*
+ * Evaluates control node and resumes frames until the stack shrinks back to
+ * given size, that is until the value of the whole evaluation is known.
+ */
+void StackExecutor::run(std::size_t base)
+{
+  while(control_ || frames_.size() > base)
+  {
+    if(control_)
+    {
+      const auto node = control_;
+      control_ = nullptr;
+      node->accept(*this);
+    }
+    else
+      resume(frames_.back());
+  }
+}
+
+StackExecutor::Frame& StackExecutor::pushFrame(FrameKind kind, const Node& node)
+{
+  checkStackLimit(node);
+  frames_.emplace_back(kind, node);
+  maxDepth_ = std::max(maxDepth_, frames_.size());
+  return frames_.back();
+}
+
+void StackExecutor::enterSegment(Segment segment, const Node& node)
+{
+  checkStackLimit(node);
+  segments_.push_back(std::move(segment));
+}
+
+// Output of nested evaluations is dropped, as it is by nested executors.
+std::unique_ptr<Value> StackExecutor::leaveSegment()
+{
+  auto value = std::move(segments_.back().value);
+  segments_.pop_back();
+  return value;
+}
+
+void StackExecutor::checkStackLimit(const Node& node) const
+{
+  const auto size = (frames_.size() + 1) * sizeof(Frame) + (segments_.size() + 1) * sizeof(Segment);
+  if(size > stackLimit_)
+    reportError("Evaluation stack exceeded " + std::to_string(stackLimit_ >> 20) + " MiB!", node);
+}
+
+/*
+ * Evaluates expression of variable in a segment with a copy of its captured context,
+ * for given frame. Variable which depends on itself is reported, as Executor does.
+ */
+void StackExecutor::force(Frame& frame, const RuntimeVariableAnalyser& variable, const Node& node)
+{
+  frame.forced = ForcedVariableGuard{forced_, variable};
+  control_ = variable.getValue().get();
+  enterSegment(Segment{variable.getContext()}, node);
+}
+
+std::unique_ptr<Value> StackExecutor::leaveForced(Frame& frame)
+{
+  frame.forced.release();
+  return leaveSegment();
+}
+
+void StackExecutor::resume(Frame& frame)
+{
+  switch(frame.kind)
+  {
+    case FrameKind::Assignment:
+    {
+      const auto& node = static_cast<const AssignmentNode&>(*frame.node);
+      const auto activity = "assignment operation " + AssignmentOperationNames.at(node.getOperation());
+      NumberValueAnalyser valueAnalyser{};
+      if(frame.stage == 0)
+      {
+        const auto oldValue = leaveForced(frame);
+        assertValueType(*oldValue, TypeName::F32, activity, node);
+
+        oldValue->accept(valueAnalyser);
+        frame.number = valueAnalyser.getValue().value();
+        frame.stage = 1;
+        control_ = node.getValue().get();
+        return;
+      }
+
+      assertValueType(*segment().value, TypeName::F32, activity, node);
+
+      segment().value->accept(valueAnalyser);
+      const auto newValue = evaluateAssignment(node.getOperation(), frame.number, valueAnalyser.getValue().value());
+
+      NumberChanger numberChanger{newValue};
+      context().lookupForUpdate(node.getName()).value().get().accept(numberChanger);
+      popFrame();
+      return;
+    }
+    case FrameKind::Binary:
+    case FrameKind::NumericBinary:
+    {
+      const auto& node = static_cast<const BinaryOpNode&>(*frame.node);
+      if(frame.stage == 0)
+      {
+        frame.operand = std::move(segment().value);
+        frame.stage = 1;
+        control_ = &node.getRightOperand();
+        return;
+      }
+
+      const auto right = std::move(segment().value);
+      if(frame.kind == FrameKind::NumericBinary)
+        segment().value = applyNumericBinaryOperation(static_cast<const NumericBinaryOpNode&>(node), *frame.operand, *right);
+      else
+        segment().value = applyBinaryOperation(node, *frame.operand, *right);
+      popFrame();
+      return;
+    }
+    case FrameKind::Block:
+    {
+      const auto& node = static_cast<const BlockNode&>(*frame.node);
+      if(segment().returned)
+      {
+        segment().returned = false;
+        popFrame();
+      }
+      else if(++frame.statement == node.getStatements().end())
+        popFrame();
+      else
+        control_ = frame.statement->get();
+      return;
+    }
+    case FrameKind::Print:
+    {
+      const auto& node = *frame.node;
+      const auto& value = *segment().value;
+      if(value.getType() != TypeName::String)
+        reportError("Function print expected string, but got " +
+          TypeNameStrings.at(value.getType()) + "!", node);
+
+      StringValueAnalyser analyser{};
+      value.accept(analyser);
+      segment().output += analyser.getValue().value() + "\n";
+      popFrame();
+      return;
+    }
+    case FrameKind::If:
+    {
+      const auto& node = static_cast<const FunctionCallNode&>(*frame.node);
+      const auto& value = *segment().value;
+      if(value.getType() != TypeName::F32)
+        reportError("Function if expected logical expression, but got " +
+                    TypeNameStrings.at(value.getType()) + "!", node);
+
+      NumberValueAnalyser analyser{};
+      value.accept(analyser);
+
+      const auto& args = node.getArguments();
+      control_ = isTrue(analyser.getValue().value()) ? std::next(args.begin())->get() : args.back().get();
+      popFrame();
+      return;
+    }
+    case FrameKind::Call:
+    {
+      context().leaveScope();
+      if(frame.returnType != TypeName::Void)
+      {
+        segment().value = std::move(segment().returnStack.top());
+        segment().returnStack.pop();
+      }
+      popFrame();
+      return;
+    }
+    case FrameKind::MemoizedArgument:
+    {
+      const auto& node = *frame.node;
+      const auto value = leaveSegment();
+      assertValueType(*value, TypeName::F32, "function call", node);
+
+      NumberValueAnalyser valueAnalyser{};
+      value->accept(valueAnalyser);
+      frame.arguments.push_back(valueAnalyser.getValue().value());
+
+      if(++frame.argument == static_cast<const FunctionCallNode&>(node).getArguments().end())
+        handleMemoizedCall(frame);
+      else
+      {
+        control_ = frame.argument->get();
+        enterSegment(Segment{&context()}, node);
+      }
+      return;
+    }
+    case FrameKind::MemoizedCall:
+    {
+      finishMemoizedCall(frame);
+      return;
+    }
+    case FrameKind::VariableCall:
+    {
+      const auto& node = static_cast<const FunctionCallNode&>(*frame.node);
+      const auto callee = leaveForced(frame);
+      popFrame();
+      callValue(node, node.getName(), *callee);
+      return;
+    }
+    case FrameKind::ResultCall:
+    {
+      const auto& node = static_cast<const FunctionResultCallNode&>(*frame.node);
+      const auto callee = std::move(segment().value);
+      popFrame();
+
+      assertValueType(*callee, TypeName::Function, "function call", node);
+      callValue(node, ResultName, *callee);
+      return;
+    }
+    case FrameKind::ClosureCall:
+    {
+      const auto returnType = frame.returnType;
+      auto callee = std::move(segments_.back());
+      segments_.pop_back();
+      popFrame();
+
+      segment().output += callee.output;
+      if(returnType != TypeName::Void)
+        segment().value = std::move(callee.value);
+      return;
+    }
+    case FrameKind::LambdaCall:
+    case FrameKind::Main:
+    {
+      context().leaveScope();
+      popFrame();
+      return;
+    }
+    case FrameKind::Return:
+    {
+      segment().returnStack.emplace(segment().value->clone());
+      segment().returned = true;
+      popFrame();
+      return;
+    }
+    case FrameKind::Loop:
+    {
+      const auto& node = static_cast<const LoopNode&>(*frame.node);
+      if(frame.stage == 0)
+      {
+        // Parameters which are not numbers are left to the recursive calls, as in Executor.
+        if(segment().value->getType() != TypeName::F32)
+        {
+          popFrame();
+          visit(static_cast<const ReturnNode&>(node));
+          return;
+        }
+
+        NumberValueAnalyser valueAnalyser{};
+        segment().value->accept(valueAnalyser);
+        frame.loop->setValue(valueAnalyser.getValue().value());
+        runLoop(frame);
+        return;
+      }
+
+      if(frame.loop->hasIterated())
+        context().leaveScope();
+      segment().returnStack.emplace(segment().value->clone());
+      segment().returned = true;
+      popFrame();
+      return;
+    }
+    case FrameKind::Unary:
+    {
+      const auto& node = static_cast<const UnaryNode&>(*frame.node);
+      segment().value = applyUnaryOperation(node, *segment().value);
+      popFrame();
+      return;
+    }
+    case FrameKind::Force:
+    {
+      auto value = leaveForced(frame);
+      if(frame.cell)
+        frame.cell->value = value->clone();
+      segment().value = std::move(value);
+      popFrame();
+      return;
+    }
+  }
+}
+
+void StackExecutor::visit(const AssignmentNode& node)
+{
+  const auto name = node.getName();
+  if(node.getOperation() == AssignmentOperator::Assign)
+  {
+    ValueChanger valueChanger{node.getValue(), node.getMark()};
+    context().lookupForUpdate(name).value().get().accept(valueChanger);
+    return;
+  }
+
+  const auto symbol = context().lookup(name);
+  auto& frame = pushFrame(FrameKind::Assignment, node);
+
+  RuntimeVariableAnalyser analyser{};
+  symbol.value().get().accept(analyser);
+
+  // Variable which was forced or updated before is read straight from its cell.
+  const auto& cell = analyser.getCell();
+  if(cell && cell->value)
+  {
+    const auto activity = "assignment operation " + AssignmentOperationNames.at(node.getOperation());
+    assertValueType(*cell->value, TypeName::F32, activity, node);
+
+    NumberValueAnalyser valueAnalyser{};
+    cell->value->accept(valueAnalyser);
+    frame.number = valueAnalyser.getValue().value();
+    frame.stage = 1;
+    control_ = node.getValue().get();
+    return;
+  }
+  force(frame, analyser, node);
+}
+
+void StackExecutor::visit(const BinaryOpNode& node)
+{
+  pushFrame(FrameKind::Binary, node);
+  control_ = &node.getLeftOperand();
+}
+
+void StackExecutor::visit(const BlockNode& node)
+{
+  const auto& statements = node.getStatements();
+  if(statements.empty())
+    return;
+
+  auto& frame = pushFrame(FrameKind::Block, node);
+  frame.statement = statements.begin();
+  control_ = frame.statement->get();
+}
+
+void StackExecutor::visit(const FunctionCallNode& node)
+{
+  const auto& name = node.getName();
+  if(name == "print" || name == "if")
+  {
+    pushFrame(name == "print" ? FrameKind::Print : FrameKind::If, node);
+    control_ = node.getArguments().front().get();
+    return;
+  }
+
+  const auto symbol = context().lookup(name);
+  auto functionAnalyser = RuntimeFunctionAnalyser{};
+  symbol.value().get().accept(functionAnalyser);
+
+  if(functionAnalyser.isSymbolValid())
+  {
+    handleFunctionCall(node, functionAnalyser);
+    return;
+  }
+
+  auto variableAnalyser = RuntimeVariableAnalyser{};
+  symbol.value().get().accept(variableAnalyser);
+
+  auto& frame = pushFrame(FrameKind::VariableCall, node);
+  frame.name = &name;
+  force(frame, variableAnalyser, node);
+}
+
+void StackExecutor::visit(const FunctionCallStatementNode& node)
+{
+  control_ = &node.getFunctionCall();
+}
+
+void StackExecutor::visit(const FunctionDeclarationNode& node)
+{
+  const auto name = node.getName();
+  const auto type = node.getReturnType();
+  auto symbol = std::make_unique<RuntimeFunctionSymbol>(name, type, node.getBody());
+  for(const auto& arg : node.getArguments())
+  {
+    symbol->addArgument(RuntimeFunctionSymbol::Argument{arg.first, arg.second});
+  }
+
+  context().addSymbol(name, std::move(symbol));
+}
+
+void StackExecutor::visit(const FunctionResultCallNode& node)
+{
+  pushFrame(FrameKind::ResultCall, node);
+  control_ = &node.getCall();
+}
+
+void StackExecutor::visit(const LambdaCallNode& node)
+{
+  const auto& lambda = node.getLambda();
+  bindArguments(node, lambda.getArguments());
+
+  auto& frame = pushFrame(FrameKind::LambdaCall, node);
+  frame.name = &LambdaName;
+  control_ = &lambda.getBody();
+}
+
+void StackExecutor::visit(const LambdaNode& node)
+{
+  segment().value = std::make_unique<Function>(node.getReturnType(),
+    node.getArguments(), node.getBodyPtr(), context().clone());
+}
+
+/*
+ * Loop runs in a frame, which is resumed with the value of every parameter the
+ * loop reads before its first iteration and then with the value of its result.
+ */
+void StackExecutor::visit(const LoopNode& node)
+{
+  auto& frame = pushFrame(FrameKind::Loop, node);
+  frame.loop = std::make_unique<LoopEvaluator>(node);
+  runLoop(frame);
+}
+
+void StackExecutor::visit(const NumericLiteralNode& node)
+{
+  segment().value = std::make_unique<Number>(node.getValue());
+}
+
+void StackExecutor::visit(const ProgramNode& node)
+{
+  if(memoTable_)
+    registerMemoizableFunctions(*memoTable_, node);
+
+  for(const auto& variable : node.getVariables())
+    variable->accept(*this);
+
+  for(const auto& function : node.getFunctions())
+    function->accept(*this);
+
+  const auto mainSymbol = context().lookup("main");
+  auto functionAnalyser = RuntimeFunctionAnalyser{};
+  mainSymbol.value().get().accept(functionAnalyser);
+
+  const auto base = frames_.size();
+  context().enterScope();
+  auto& frame = pushFrame(FrameKind::Main, *functionAnalyser.getBody());
+  frame.name = &MainName;
+  control_ = functionAnalyser.getBody().get();
+  run(base);
+
+  auto valueAnalyser = NumberValueAnalyser{};
+  segment().value->accept(valueAnalyser);
+  exitCode_ = valueAnalyser.getValue().value();
+}
+
+void StackExecutor::visit(const ReturnNode& node)
+{
+  pushFrame(FrameKind::Return, node);
+  control_ = &node.getValue();
+}
+
+void StackExecutor::visit(const StringLiteralNode& node)
+{
+  segment().value = std::make_unique<String>(node.getValue());
+}
+
+void StackExecutor::visit(const UnaryNode& node)
+{
+  pushFrame(FrameKind::Unary, node);
+  control_ = &node.getTerm();
+}
+
+void StackExecutor::visit(const VariableDeclarationNode& node)
+{
+  const auto name = node.getName();
+  const auto type = node.getType();
+  auto value = node.getValue();
+  auto cell = node.isShared() ? std::make_shared<ValueCell>() : nullptr;
+
+  auto symbol = std::make_unique<RuntimeVariableSymbol>(name, type, value, context().clone(), std::move(cell));
+  symbol->setMark(node.getMark());
+  context().addSymbol(name, std::move(symbol));
+}
+
+void StackExecutor::visit(const VariableNode& node)
+{
+  const auto name = node.getName();
+  const auto symbol = context().lookup(name);
+
+  if(!symbol)
+    reportError("Dereferencing invalid symbol " + name + "!", node);
+
+  RuntimeVariableAnalyser analyser{};
+  symbol.value().get().accept(analyser);
+
+  if(analyser.isSymbolValid())
+  {
+    const auto& cell = analyser.getCell();
+    if(cell && cell->value)
+    {
+      segment().value = cell->value->clone();
+      return;
+    }
+
+    auto& frame = pushFrame(FrameKind::Force, node);
+    frame.cell = cell;
+    force(frame, analyser, node);
+  }
+  else
+  {
+    RuntimeFunctionAnalyser functionAnalyser{};
+    symbol.value().get().accept(functionAnalyser);
+
+    const auto returnType = functionAnalyser.getReturnType().value();
+    const auto args = functionAnalyser.getArguments();
+    const auto body = functionAnalyser.getBody();
+
+    segment().value = std::make_unique<Function>(returnType, args, body, context().clone());
+  }
+}
+
+void StackExecutor::visit(const NumericBinaryOpNode& node)
+{
+  pushFrame(FrameKind::NumericBinary, node);
+  control_ = &node.getLeftOperand();
+}
+
+void StackExecutor::bindArguments(const CallNode& node, const std::list<std::pair<std::string, TypeName>>& parameters)
+{
+  // Arguments are evaluated in the caller's context, without any of the parameters.
+  const auto argContext = std::make_shared<const Context>(context().clone());
+  context().enterScope();
+
+  auto it = node.getArguments().begin();
+  for(const auto& parameter : parameters)
+  {
+    auto argSymbol = std::make_unique<RuntimeVariableSymbol>(parameter.first, parameter.second, *it, argContext, nullptr);
+    context().addSymbol(parameter.first, std::move(argSymbol));
+
+    ++it;
+  }
+}
+
+void StackExecutor::handleFunctionCall(const FunctionCallNode& node, const RuntimeFunctionAnalyser& functionAnalyser)
+{
+  const auto body = functionAnalyser.getBody().get();
+  if(memoTable_ && memoTable_->isMemoizable(body))
+  {
+    auto& frame = pushFrame(FrameKind::MemoizedArgument, node);
+    frame.name = &node.getName();
+    frame.body = body;
+    frame.argument = node.getArguments().begin();
+    if(node.getArguments().empty())
+      handleMemoizedCall(frame);
+    else
+    {
+      control_ = frame.argument->get();
+      enterSegment(Segment{&context()}, node);
+    }
+    return;
+  }
+
+  bindArguments(node, functionAnalyser.getArguments());
+
+  auto& frame = pushFrame(FrameKind::Call, node);
+  frame.name = &node.getName();
+  frame.returnType = functionAnalyser.getReturnType().value();
+  control_ = body;
+}
+
+/*
+ * Memoizable functions are strict in all of their numeric arguments, so arguments
+ * are forced before the call, as Executor does.
+ */
+void StackExecutor::handleMemoizedCall(Frame& frame)
+{
+  const auto cached = memoTable_->lookup(frame.body, frame.arguments);
+  if(cached.has_value())
+  {
+    segment().value = std::make_unique<Number>(cached.value());
+    popFrame();
+    return;
+  }
+
+  const auto symbol = context().lookup(*frame.name);
+  RuntimeFunctionAnalyser functionAnalyser{};
+  symbol.value().get().accept(functionAnalyser);
+
+  context().enterScope();
+
+  auto it = frame.arguments.begin();
+  for(const auto& arg : functionAnalyser.getArguments())
+  {
+    auto value = std::make_shared<NumericLiteralNode>(*it);
+    auto argSymbol = std::make_unique<RuntimeVariableSymbol>(arg.first, arg.second, value, Context{});
+    context().addSymbol(arg.first, std::move(argSymbol));
+
+    ++it;
+  }
+
+  frame.kind = FrameKind::MemoizedCall;
+  control_ = frame.body;
+}
+
+void StackExecutor::finishMemoizedCall(Frame& frame)
+{
+  context().leaveScope();
+
+  auto& value = segment().value;
+  value = std::move(segment().returnStack.top());
+  segment().returnStack.pop();
+
+  NumberValueAnalyser valueAnalyser{};
+  value->accept(valueAnalyser);
+  if(valueAnalyser.isValid())
+    memoTable_->insert(frame.body, frame.arguments, valueAnalyser.getValue().value());
+  popFrame();
+}
+
+void StackExecutor::callValue(const CallNode& node, const std::string& name, const Value& value)
+{
+  const auto& function = resolveCallee(node, name, value);
+
+  Context newContext = function.getContext().clone();
+
+  newContext.enterScope();
+
+  auto it = node.getArguments().begin();
+  for(const auto& arg : function.getArguments())
+  {
+    auto argSymbol = std::make_unique<RuntimeVariableSymbol>(arg.first, arg.second, *it, newContext.clone());
+    newContext.addSymbol(arg.first, std::move(argSymbol));
+
+    ++it;
+  }
+
+  auto& frame = pushFrame(FrameKind::ClosureCall, node);
+  frame.name = &name;
+  frame.returnType = function.getReturnType();
+  control_ = &function.getBody();
+  enterSegment(Segment{std::move(newContext)}, node);
+}
+
+void StackExecutor::runLoop(Frame& frame)
+{
+  const auto variable = frame.loop->run();
+  if(variable)
+  {
+    control_ = variable;
+    return;
+  }
+
+  frame.stage = 1;
+  if(frame.loop->hasIterated())
+  {
+    context().enterScope();
+    frame.loop->bindParameters(context());
+  }
+  control_ = &static_cast<const LoopNode&>(*frame.node).getResult();
+}
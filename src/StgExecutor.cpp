@@ -0,0 +1,898 @@
+#include "StgExecutor.hpp"
+
+#include <algorithm>
+
+#include "Common.hpp"
+#include "Operators.hpp"
+#include "AST.hpp"
+#include "ValueOperations.hpp"
+
+namespace
+{
+
+const std::string LambdaName = "lambda";
+const std::string ResultName = "result";
+
+void assertType(const TypeName& type, const TypeName& expected, const std::string& activity, const Node& node)
+{
+  if(type != expected)
+    reportError("Cannot perform " + activity + " with value of type " + TypeNameStrings.at(type) + "!", node);
+}
+
+}
+
+/*
+ * Builds code of a single node. Code of children is compiled through the
+ * executor, which keeps it for the whole run, so it is referred to by pointers.
+ */
+class StgCompiler : public Visitor
+{
+public:
+  using Code = StgExecutor::Code;
+  using Op = StgExecutor::Op;
+
+  StgCompiler(StgExecutor& executor): code(nullptr), executor_(executor) {}
+
+  Code* code;
+
+  void visit(const AssignmentNode& node) override
+  {
+    create(Op::Assign, node);
+    code->name = executor_.intern(node.getName());
+    add(*node.getValue());
+  }
+
+  void visit(const BinaryOpNode& node) override
+  {
+    create(Op::Binary, node);
+    add(node.getLeftOperand());
+    add(node.getRightOperand());
+  }
+
+  void visit(const BlockNode& node) override
+  {
+    create(Op::Block, node);
+    for(const auto& statement : node.getStatements())
+      add(*statement);
+  }
+
+  void visit(const FunctionCallNode& node) override
+  {
+    const auto& name = node.getName();
+    if(name == "print")
+      create(Op::Print, node);
+    else if(name == "if")
+      create(Op::If, node);
+    else
+    {
+      create(Op::Call, node);
+      code->name = executor_.intern(name);
+    }
+
+    for(const auto& arg : node.getArguments())
+      add(*arg);
+  }
+
+  void visit(const FunctionCallStatementNode& node) override
+  {
+    create(Op::Evaluate, node);
+    add(node.getFunctionCall());
+  }
+
+  void visit(const FunctionDeclarationNode& node) override
+  {
+    create(Op::Define, node);
+    code->name = executor_.intern(node.getName());
+    code->lambda = &lambda(node.getName(), node.getReturnType(), node.getArguments(), node.getBody());
+  }
+
+  void visit(const FunctionResultCallNode& node) override
+  {
+    create(Op::ResultCall, node);
+    add(node.getCall());
+    for(const auto& arg : node.getArguments())
+      add(*arg);
+  }
+
+  void visit(const LambdaCallNode& node) override
+  {
+    const auto& lambda = node.getLambda();
+    create(Op::LambdaCall, node);
+    code->lambda = &this->lambda(LambdaName, lambda.getReturnType(), lambda.getArguments(), lambda.getBodyPtr());
+    for(const auto& arg : node.getArguments())
+      add(*arg);
+  }
+
+  void visit(const LambdaNode& node) override
+  {
+    create(Op::Lambda, node);
+    code->lambda = &lambda(LambdaName, node.getReturnType(), node.getArguments(), node.getBodyPtr());
+  }
+
+  void visit(const NumericLiteralNode& node) override
+  {
+    create(Op::Number, node);
+    code->object = StgExecutor::Object{node.getValue()};
+  }
+
+  void visit(const ProgramNode& node) override
+  {
+    for(const auto& variable : node.getVariables())
+      executor_.compile(*variable);
+    for(const auto& function : node.getFunctions())
+      executor_.compile(*function);
+  }
+
+  void visit(const ReturnNode& node) override
+  {
+    create(Op::Return, node);
+    add(node.getValue());
+  }
+
+  // Recursive return is kept for parameters which turn out not to be numbers.
+  void visit(const LoopNode& node) override
+  {
+    create(Op::Loop, node);
+    add(node.getValue());
+    add(node.getResult());
+  }
+
+  void visit(const StringLiteralNode& node) override
+  {
+    create(Op::String, node);
+    code->object.type = TypeName::String;
+    code->object.string = std::make_shared<const std::string>(node.getValue());
+  }
+
+  void visit(const UnaryNode& node) override
+  {
+    create(Op::Unary, node);
+    add(node.getTerm());
+  }
+
+  void visit(const VariableDeclarationNode& node) override
+  {
+    create(Op::Declare, node);
+    code->name = executor_.intern(node.getName());
+    add(*node.getValue());
+  }
+
+  void visit(const VariableNode& node) override
+  {
+    create(Op::Variable, node);
+    code->name = executor_.intern(node.getName());
+  }
+
+  void visit(const NumericBinaryOpNode& node) override
+  {
+    visit(static_cast<const BinaryOpNode&>(node));
+    code->op = Op::NumericBinary;
+  }
+
+private:
+  void create(Op op, const Node& node)
+  {
+    code = &executor_.code_.emplace_back(op, node);
+  }
+
+  void add(const Node& child)
+  {
+    code->children.push_back(&executor_.compile(child));
+  }
+
+  const StgExecutor::Lambda& lambda(const std::string& name, const TypeName& returnType,
+    const std::list<std::pair<std::string, TypeName>>& arguments, const std::shared_ptr<BlockNode>& body)
+  {
+    auto& lambda = executor_.lambdas_.emplace_back();
+    lambda.name = name;
+    lambda.returnType = returnType;
+    for(const auto& arg : arguments)
+      lambda.parameters.emplace_back(executor_.intern(arg.first), arg.second);
+    lambda.block = body;
+    lambda.arguments = &arguments;
+    lambda.body = &executor_.compile(*body);
+    return lambda;
+  }
+
+  StgExecutor& executor_;
+};
+
+namespace
+{
+
+std::uint64_t nameBit(int name)
+{
+  return std::uint64_t{1} << (name & 63);
+}
+
+}
+
+StgExecutor::Scope::Scope(Env parent):
+  parent(std::move(parent)), bindings(), names(this->parent && this->parent->parent ? this->parent->names : 0),
+  global(this->parent ? this->parent->global : this) {}
+
+StgExecutor::Scope::Scope(const Scope& scope):
+  parent(scope.parent), bindings(scope.bindings), names(scope.names), global(parent ? scope.global : this) {}
+
+// Long chains of scopes are released iteratively, not by nested destructors.
+StgExecutor::Scope::~Scope()
+{
+  auto scope = std::move(parent);
+  bindings.clear();
+  while(scope && scope.use_count() == 1)
+  {
+    auto next = std::move(scope->parent);
+    scope = std::move(next);
+  }
+}
+
+StgExecutor::StgExecutor(const ExecutorOptions& options):
+  code_(), lambdas_(), compiled_(), names_(), frames_(), control_(nullptr), env_(std::make_shared<Scope>(nullptr)),
+  value_(), output_(&stdout_), stdout_(), discarded_(), exitCode_(0), memoTable_(),
+  stackLimit_(options.stackLimit << 20), allocated_(0), updated_(0), shared_(0), maxDepth_(0)
+{
+  if(options.memoize)
+    memoTable_ = std::make_shared<MemoTable>(options.memoCapacity);
+}
+
+std::unique_ptr<Value> StgExecutor::getValue() const
+{
+  switch(value_.type)
+  {
+    case TypeName::String:
+      return std::make_unique<String>(*value_.string);
+    case TypeName::Function:
+    {
+      const auto& lambda = *value_.closure->lambda;
+      return std::make_unique<Function>(lambda.returnType, *lambda.arguments, lambda.block, Context{});
+    }
+    default:
+      return std::make_unique<Number>(value_.number);
+  }
+}
+
+const StgExecutor::Code& StgExecutor::compile(const Node& node)
+{
+  const auto it = compiled_.find(&node);
+  if(it != compiled_.end())
+    return *it->second;
+
+  StgCompiler compiler{*this};
+  node.accept(compiler);
+  compiled_[&node] = compiler.code;
+  return *compiler.code;
+}
+
+int StgExecutor::intern(const std::string& name)
+{
+  return names_.emplace(name, static_cast<int>(names_.size())).first->second;
+}
+
+void StgExecutor::visit(const ProgramNode& node)
+{
+  StgCompiler compiler{*this};
+  node.accept(compiler);
+
+  if(memoTable_)
+    registerMemoizableFunctions(*memoTable_, node);
+
+  for(const auto& variable : node.getVariables())
+    run(compile(*variable));
+
+  for(const auto& function : node.getFunctions())
+    run(compile(*function));
+
+  const auto main = lookup(intern("main"));
+
+  enterScope();
+  run(*main->function->body);
+  leaveScope();
+
+  if(value_.type == TypeName::F32)
+    exitCode_ = value_.number;
+}
+
+void StgExecutor::evaluate(const Node& node)
+{
+  run(compile(node));
+}
+
+/*
+ * Evaluates code and resumes frames until the stack shrinks back to its size
+ * at the start, that is until the value of the whole evaluation is known.
+ */
+void StgExecutor::run(const Code& code)
+{
+  const auto base = frames_.size();
+  control_ = &code;
+  while(control_ || frames_.size() > base)
+  {
+    if(control_)
+    {
+      const auto next = control_;
+      control_ = nullptr;
+      eval(*next);
+    }
+    else
+      resume(frames_.back());
+  }
+}
+
+StgExecutor::Frame& StgExecutor::pushFrame(FrameKind kind, const Code& code)
+{
+  if((frames_.size() + 1) * sizeof(Frame) > stackLimit_)
+    reportError("Evaluation stack exceeded " + std::to_string(stackLimit_ >> 20) + " MiB!", *code.node);
+
+  frames_.emplace_back(kind, code);
+  maxDepth_ = std::max(maxDepth_, frames_.size());
+  return frames_.back();
+}
+
+const StgExecutor::Binding* StgExecutor::lookup(int name) const
+{
+  const auto bit = nameBit(name);
+  for(auto scope = env_.get(); scope; scope = scope->parent.get())
+  {
+    if(!(scope->names & bit))
+      scope = scope->global;
+
+    for(const auto& binding : scope->bindings)
+    {
+      if(binding.name == name)
+        return &binding;
+    }
+  }
+  return nullptr;
+}
+
+/*
+ * Scopes on the path to the binding, starting with the first one shared with
+ * another environment, are copied, so that only the live environment sees the change.
+ */
+StgExecutor::Binding& StgExecutor::lookupForUpdate(int name, const Code& code)
+{
+  auto shared = false;
+  for(auto scope = &env_; *scope; scope = &(*scope)->parent)
+  {
+    shared = shared || scope->use_count() > 1;
+    if(shared)
+      *scope = std::make_shared<Scope>(**scope);
+
+    for(auto& binding : (*scope)->bindings)
+    {
+      if(binding.name == name)
+      {
+        // Global scope was copied, scopes of the live environment refer to the copy.
+        if(!(*scope)->parent && shared)
+        {
+          for(auto it = env_.get(); it; it = it->parent.get())
+            it->global = scope->get();
+        }
+        return binding;
+      }
+    }
+  }
+
+  reportError("Dereferencing invalid symbol " + static_cast<const AssignmentNode&>(*code.node).getName() + "!",
+    *code.node);
+}
+
+// First binding of a name in a scope is kept, as it is by Context.
+void StgExecutor::addBinding(Binding binding)
+{
+  if(env_.use_count() > 1)
+    env_ = std::make_shared<Scope>(*env_);
+
+  for(const auto& existing : env_->bindings)
+  {
+    if(existing.name == binding.name)
+      return;
+  }
+  env_->names |= nameBit(binding.name);
+  env_->bindings.push_back(std::move(binding));
+}
+
+void StgExecutor::enterScope()
+{
+  env_ = std::make_shared<Scope>(std::move(env_));
+}
+
+void StgExecutor::leaveScope()
+{
+  env_ = Env{env_->parent};
+}
+
+void StgExecutor::eval(const Code& code)
+{
+  switch(code.op)
+  {
+    case Op::Number:
+    case Op::String:
+      value_ = code.object;
+      return;
+    case Op::Variable:
+    {
+      const auto binding = lookup(code.name);
+      if(!binding)
+        reportError("Dereferencing invalid symbol " + static_cast<const VariableNode&>(*code.node).getName() + "!",
+          *code.node);
+
+      if(binding->function)
+      {
+        value_ = Object{};
+        value_.type = TypeName::Function;
+        value_.closure = std::make_shared<const Closure>(*binding->function, env_);
+        return;
+      }
+
+      enter(binding->thunk, code);
+      return;
+    }
+    case Op::Binary:
+    case Op::NumericBinary:
+      pushFrame(FrameKind::Binary, code);
+      control_ = code.children.front();
+      return;
+    case Op::Unary:
+      pushFrame(FrameKind::Unary, code);
+      control_ = code.children.front();
+      return;
+    case Op::Print:
+      pushFrame(FrameKind::Print, code);
+      control_ = code.children.front();
+      return;
+    case Op::If:
+      pushFrame(FrameKind::If, code);
+      control_ = code.children.front();
+      return;
+    case Op::Call:
+    {
+      const auto binding = lookup(code.name);
+      if(!binding)
+        reportError("Dereferencing invalid symbol " + static_cast<const FunctionCallNode&>(*code.node).getName() + "!",
+          *code.node);
+
+      if(binding->function)
+      {
+        call(code, *binding->function);
+        return;
+      }
+
+      const auto thunk = binding->thunk;
+      pushFrame(FrameKind::VariableCall, code);
+      enter(thunk, code);
+      return;
+    }
+    case Op::ResultCall:
+      pushFrame(FrameKind::ResultCall, code);
+      control_ = code.children.front();
+      return;
+    case Op::LambdaCall:
+      bindArguments(code, *code.lambda, false);
+      pushFrame(FrameKind::Call, code).lambda = code.lambda;
+      control_ = code.lambda->body;
+      return;
+    case Op::Lambda:
+      value_ = Object{};
+      value_.type = TypeName::Function;
+      value_.closure = std::make_shared<const Closure>(*code.lambda, env_);
+      return;
+    case Op::Block:
+      value_ = Object{};
+      if(code.children.empty())
+        return;
+      pushFrame(FrameKind::Block, code);
+      control_ = code.children.front();
+      return;
+    case Op::Return:
+      pushFrame(FrameKind::Return, code);
+      control_ = code.children.front();
+      return;
+    case Op::Loop:
+    {
+      auto& frame = pushFrame(FrameKind::Loop, code);
+      frame.loop = std::make_unique<LoopEvaluator>(static_cast<const LoopNode&>(*code.node));
+      runLoop(frame);
+      return;
+    }
+    case Op::Declare:
+      ++allocated_;
+      addBinding(Binding{code.name, std::make_shared<Thunk>(code.children.front(), env_, *code.node), nullptr});
+      value_ = Object{};
+      return;
+    case Op::Define:
+      addBinding(Binding{code.name, nullptr, code.lambda});
+      value_ = Object{};
+      return;
+    case Op::Assign:
+    {
+      const auto binding = lookup(code.name);
+      if(!binding)
+        reportError("Dereferencing invalid symbol " + static_cast<const AssignmentNode&>(*code.node).getName() + "!",
+          *code.node);
+
+      // Functions cannot be assigned to, as in Executor.
+      value_ = Object{};
+      if(binding->function)
+        return;
+
+      const auto thunk = binding->thunk;
+      if(static_cast<const AssignmentNode&>(*code.node).getOperation() == AssignmentOperator::Assign)
+      {
+        ++allocated_;
+        lookupForUpdate(code.name, code).thunk = std::make_shared<Thunk>(code.children.front(), thunk->env, *code.node);
+        return;
+      }
+
+      pushFrame(FrameKind::Assignment, code).thunk = thunk;
+      enter(thunk, code);
+      return;
+    }
+    case Op::Evaluate:
+      control_ = code.children.front();
+      return;
+  }
+}
+
+/*
+ * Evaluated thunk holds its value. Otherwise it is blackholed and its expression
+ * is evaluated in its environment below an update frame. As in Executor, output
+ * of the evaluation is dropped and thunk entered again before its update is
+ * reported at its binding.
+ */
+void StgExecutor::enter(const std::shared_ptr<Thunk>& thunk, const Code& code)
+{
+  switch(thunk->state)
+  {
+    case ThunkState::Evaluated:
+      ++shared_;
+      value_ = thunk->value;
+      return;
+    case ThunkState::Blackhole:
+      reportError("Value of variable depends on itself (<<loop>>)!", *thunk->binding);
+    case ThunkState::Unevaluated:
+    {
+      auto& frame = pushFrame(FrameKind::Update, code);
+      frame.thunk = thunk;
+      frame.env = std::move(env_);
+      frame.output = output_;
+
+      thunk->state = ThunkState::Blackhole;
+      env_ = thunk->env;
+      output_ = &discarded_;
+      control_ = thunk->code;
+      return;
+    }
+  }
+}
+
+/*
+ * Declared functions run in the caller's environment, their arguments are thunks
+ * of the caller's environment. Arguments of memoizable functions are forced first,
+ * they are strict in all of them.
+ */
+void StgExecutor::call(const Code& code, const Lambda& function)
+{
+  if(memoTable_ && memoTable_->isMemoizable(function.block.get()))
+  {
+    auto& frame = pushFrame(FrameKind::MemoizedArgument, code);
+    frame.lambda = &function;
+    frame.output = output_;
+    output_ = &discarded_;
+
+    if(code.children.empty())
+      callMemoized(frame);
+    else
+      control_ = code.children.front();
+    return;
+  }
+
+  bindArguments(code, function, false);
+  pushFrame(FrameKind::Call, code).lambda = &function;
+  control_ = function.body;
+}
+
+void StgExecutor::callMemoized(Frame& frame)
+{
+  output_ = frame.output;
+  discarded_.clear();
+
+  const auto& function = *frame.lambda;
+  const auto cached = memoTable_->lookup(function.block.get(), frame.arguments);
+  if(cached.has_value())
+  {
+    value_ = Object{cached.value()};
+    popFrame();
+    return;
+  }
+
+  enterScope();
+  for(std::size_t i = 0; i < function.parameters.size() && i < frame.arguments.size(); ++i)
+  {
+    ++allocated_;
+    addBinding(Binding{function.parameters[i].first, std::make_shared<Thunk>(Object{frame.arguments[i]}, nullptr),
+      nullptr});
+  }
+
+  frame.kind = FrameKind::MemoizedCall;
+  control_ = function.body;
+}
+
+/*
+ * Closures run in a new scope of their captured environment. Arguments are
+ * thunks of that environment with previous arguments bound, as in Executor.
+ */
+void StgExecutor::callValue(const Code& code, const std::string& name, const Object& callee)
+{
+  const auto closure = callee.closure;
+  const auto& lambda = *closure->lambda;
+  const auto first = code.op == Op::ResultCall ? 1 : 0;
+  const auto provided = code.children.size() - first;
+  if(lambda.parameters.size() != provided)
+    reportError("Function " + name + " expected " + std::to_string(lambda.parameters.size()) + ", but got " +
+      std::to_string(provided) + " arguments!", *code.node);
+
+  auto& frame = pushFrame(FrameKind::ClosureCall, code);
+  frame.lambda = &lambda;
+  frame.env = std::move(env_);
+
+  env_ = closure->env;
+  bindArguments(code, lambda, true);
+  control_ = lambda.body;
+}
+
+void StgExecutor::bindArguments(const Code& code, const Lambda& lambda, bool extendEnv)
+{
+  const std::size_t first = code.op == Op::ResultCall ? 1 : 0;
+  const auto argEnv = env_;
+  enterScope();
+
+  for(std::size_t i = 0; i < lambda.parameters.size() && first + i < code.children.size(); ++i)
+  {
+    ++allocated_;
+    const auto& parameter = lambda.parameters[i];
+    const auto argument = code.children[first + i];
+    auto thunk = std::make_shared<Thunk>(argument, extendEnv ? env_ : argEnv, *argument->node);
+    addBinding(Binding{parameter.first, std::move(thunk), nullptr});
+  }
+}
+
+void StgExecutor::applyBinary(const Code& code, const Object& left, const Object& right)
+{
+  if(left.type == TypeName::F32 && right.type == TypeName::F32)
+  {
+    if(code.op == Op::NumericBinary)
+      value_ = Object{static_cast<const NumericBinaryOpNode&>(*code.node).evaluate(left.number, right.number)};
+    else
+      value_ = Object{evaluateBinary(static_cast<const BinaryOpNode&>(*code.node).getOperation(),
+        left.number, right.number)};
+    return;
+  }
+
+  const auto& node = static_cast<const BinaryOpNode&>(*code.node);
+  if(node.getOperation() == BinaryOperator::Addition && left.type == TypeName::String &&
+    (right.type == TypeName::String || right.type == TypeName::F32))
+  {
+    const auto r = right.type == TypeName::String ? *right.string : std::to_string(right.number);
+    value_ = Object{};
+    value_.type = TypeName::String;
+    value_.string = std::make_shared<const std::string>(*left.string + r);
+    return;
+  }
+
+  // Operands of other types are errors, reported as Executor reports them.
+  assertType(left.type, TypeName::F32, "binary operation " + BinaryOperationNames.at(node.getOperation()), node);
+  assertType(right.type, TypeName::F32, "binary operation " + BinaryOperationNames.at(node.getOperation()), node);
+}
+
+/*
+ * Loop waits in its frame for parameters it reads before the first iteration,
+ * which are entered like variables. Result is evaluated in a scope binding the
+ * final values to evaluated thunks.
+ */
+void StgExecutor::runLoop(Frame& frame)
+{
+  const auto variable = frame.loop->run();
+  if(variable)
+  {
+    control_ = &compile(*variable);
+    return;
+  }
+
+  frame.stage = 1;
+  if(frame.loop->hasIterated())
+  {
+    const auto& parameters = static_cast<const LoopNode&>(*frame.code->node).getParameters();
+    const auto& values = frame.loop->getValues();
+    const auto env = env_;
+    enterScope();
+    for(std::size_t i = 0; i < parameters.size(); ++i)
+    {
+      ++allocated_;
+      addBinding(Binding{intern(parameters[i]), std::make_shared<Thunk>(Object{values[i]}, env), nullptr});
+    }
+  }
+  control_ = frame.code->children.back();
+}
+
+void StgExecutor::resume(Frame& frame)
+{
+  const auto& code = *frame.code;
+  switch(frame.kind)
+  {
+    case FrameKind::Update:
+    {
+      ++updated_;
+      frame.thunk->value = value_;
+      frame.thunk->state = ThunkState::Evaluated;
+      env_ = std::move(frame.env);
+      output_ = frame.output;
+      discarded_.clear();
+      popFrame();
+      return;
+    }
+    case FrameKind::Binary:
+    {
+      if(frame.stage == 0)
+      {
+        frame.operand = std::move(value_);
+        frame.stage = 1;
+        control_ = code.children.back();
+        return;
+      }
+
+      const auto left = std::move(frame.operand);
+      popFrame();
+      applyBinary(code, left, Object{value_});
+      return;
+    }
+    case FrameKind::Unary:
+    {
+      popFrame();
+      const auto& node = static_cast<const UnaryNode&>(*code.node);
+      assertType(value_.type, TypeName::F32, "unary operation " + UnaryOperationNames.at(node.getOperation()), node);
+      value_ = Object{evaluateUnary(node.getOperation(), value_.number)};
+      return;
+    }
+    case FrameKind::Print:
+    {
+      popFrame();
+      if(value_.type != TypeName::String)
+        reportError("Function print expected string, but got " + TypeNameStrings.at(value_.type) + "!", *code.node);
+
+      *output_ += *value_.string;
+      *output_ += "\n";
+      return;
+    }
+    case FrameKind::If:
+    {
+      popFrame();
+      if(value_.type != TypeName::F32)
+        reportError("Function if expected logical expression, but got " + TypeNameStrings.at(value_.type) + "!",
+          *code.node);
+
+      control_ = isTrue(value_.number) ? code.children[1] : code.children.back();
+      return;
+    }
+    case FrameKind::Call:
+    {
+      leaveScope();
+      if(frame.lambda->returnType == TypeName::Void)
+        value_ = Object{};
+      popFrame();
+      return;
+    }
+    case FrameKind::MemoizedArgument:
+    {
+      assertType(value_.type, TypeName::F32, "function call", *code.node);
+      frame.arguments.push_back(value_.number);
+
+      if(++frame.stage < code.children.size())
+        control_ = code.children[frame.stage];
+      else
+        callMemoized(frame);
+      return;
+    }
+    case FrameKind::MemoizedCall:
+    {
+      leaveScope();
+      if(value_.type == TypeName::F32)
+        memoTable_->insert(frame.lambda->block.get(), frame.arguments, value_.number);
+      popFrame();
+      return;
+    }
+    case FrameKind::VariableCall:
+    {
+      popFrame();
+      assertType(value_.type, TypeName::Function, "function call", *code.node);
+      const auto callee = value_;
+      callValue(code, static_cast<const FunctionCallNode&>(*code.node).getName(), callee);
+      return;
+    }
+    case FrameKind::ResultCall:
+    {
+      popFrame();
+      assertType(value_.type, TypeName::Function, "function call", *code.node);
+      const auto callee = value_;
+      callValue(code, ResultName, callee);
+      return;
+    }
+    case FrameKind::ClosureCall:
+    {
+      env_ = std::move(frame.env);
+      if(frame.lambda->returnType == TypeName::Void)
+        value_ = Object{};
+      popFrame();
+      return;
+    }
+    case FrameKind::Block:
+    {
+      if(++frame.stage < code.children.size())
+        control_ = code.children[frame.stage];
+      else
+      {
+        value_ = Object{};
+        popFrame();
+      }
+      return;
+    }
+    // Returned value is the value of the call, the rest of the body is skipped.
+    case FrameKind::Return:
+    {
+      popFrame();
+      if(!frames_.empty() && frames_.back().kind == FrameKind::Block)
+        popFrame();
+      return;
+    }
+    case FrameKind::Loop:
+    {
+      if(frame.stage == 0)
+      {
+        // Parameters which are not numbers are left to the recursive calls, as in Executor.
+        if(value_.type != TypeName::F32)
+        {
+          frame.kind = FrameKind::Return;
+          frame.loop.reset();
+          control_ = code.children.front();
+          return;
+        }
+
+        frame.loop->setValue(value_.number);
+        runLoop(frame);
+        return;
+      }
+
+      if(frame.loop->hasIterated())
+        leaveScope();
+      popFrame();
+      if(!frames_.empty() && frames_.back().kind == FrameKind::Block)
+        popFrame();
+      return;
+    }
+    case FrameKind::Assignment:
+    {
+      const auto& node = static_cast<const AssignmentNode&>(*code.node);
+      const auto activity = "assignment operation " + AssignmentOperationNames.at(node.getOperation());
+      assertType(value_.type, TypeName::F32, activity, node);
+
+      if(frame.stage == 0)
+      {
+        frame.operand = value_;
+        frame.stage = 1;
+        control_ = code.children.front();
+        return;
+      }
+
+      ++allocated_;
+      const auto newValue = evaluateAssignment(node.getOperation(), frame.operand.number, value_.number);
+      const auto env = frame.thunk->env;
+      popFrame();
+
+      auto& binding = lookupForUpdate(code.name, code);
+      if(!binding.function)
+        binding.thunk = std::make_shared<Thunk>(Object{newValue}, env);
+      value_ = Object{};
+      return;
+    }
+  }
+}
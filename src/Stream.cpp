@@ -1,35 +1,62 @@
 #include "Stream.hpp"
 
-bool Stream::eof() const
-{
-  return is_.eof();
-}
+#include <fstream>
+#include <iterator>
 
-char Stream::peek() const
-{
-  return static_cast<char>(is_.peek());
-}
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
-const Mark& Stream::getMark() const
-{
-  return mark_;
-}
+Stream::Stream(std::istream& stream):
+  buffer_(std::istreambuf_iterator<char>{stream}, std::istreambuf_iterator<char>{}), begin_(buffer_.data()),
+  current_(begin_), end_(begin_ + buffer_.size()), mark_() {}
+
+Stream::Stream(std::string_view text):
+  buffer_(), begin_(text.data()), current_(begin_), end_(begin_ + text.size()), mark_() {}
 
 void Stream::unget()
 {
-  is_.unget();
+  if(current_ != begin_)
+    --current_;
   mark_.column--;
 }
 
-int Stream::advance()
+SourceFile::SourceFile(const std::string& path): open_(false), mapping_(nullptr), size_(0), buffer_(), text_()
 {
-  is_.get();
-  int c = is_.peek();
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if(fd < 0)
+    return;
+
+  struct stat status{};
+  const bool regular = ::fstat(fd, &status) == 0 && S_ISREG(status.st_mode);
+  if(regular && status.st_size > 0)
+  {
+    size_ = static_cast<std::size_t>(status.st_size);
+    mapping_ = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    if(mapping_ == MAP_FAILED)
+      mapping_ = nullptr;
+  }
+  ::close(fd);
 
-  if(c == '\n')
-    mark_.newLine();
-  else 
-    mark_.advance();
+  if(mapping_)
+  {
+    ::madvise(mapping_, size_, MADV_SEQUENTIAL);
+    text_ = std::string_view{static_cast<const char*>(mapping_), size_};
+    open_ = true;
+    return;
+  }
 
-  return c;
+  std::ifstream file{path, std::ios::binary};
+  if(!file.is_open())
+    return;
+  buffer_.assign(std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{});
+  text_ = buffer_;
+  open_ = true;
+}
+
+SourceFile::~SourceFile()
+{
+  if(mapping_)
+    ::munmap(mapping_, size_);
 }
@@ -0,0 +1,236 @@
+#include "StrictModeChecker.hpp"
+
+#include <iterator>
+#include <set>
+
+#include "RecursiveVisitor.hpp"
+
+namespace
+{
+
+// Whether evaluating the expression calls anything, bodies of lambdas are not evaluated.
+class CallFinder : public RecursiveVisitor
+{
+public:
+  CallFinder(): found(false) {}
+
+  bool found;
+
+  void visit(const FunctionCallNode& node) override
+  {
+    if(node.getName() != "if")
+      found = true;
+    RecursiveVisitor::visit(node);
+  }
+
+  void visit(const FunctionResultCallNode&) override { found = true; }
+  void visit(const LambdaCallNode&) override { found = true; }
+  void visit(const LambdaNode&) override {}
+};
+
+bool calls(const ExpressionNode& expression)
+{
+  CallFinder finder{};
+  expression.accept(finder);
+  return finder.found;
+}
+
+// Whether evaluating the expression reads given variable, bodies of lambdas are not evaluated.
+class ReadFinder : public RecursiveVisitor
+{
+public:
+  ReadFinder(const std::string& name): found(false), name_(name) {}
+
+  bool found;
+
+  void visit(const LambdaNode&) override {}
+  void visit(const VariableNode& node) override { found = found || node.getName() == name_; }
+
+private:
+  const std::string& name_;
+};
+
+bool reads(const ExpressionNode& expression, const std::string& name)
+{
+  ReadFinder finder{name};
+  expression.accept(finder);
+  return finder.found;
+}
+
+}
+
+StrictModeChecker::StrictModeChecker(): purity_(), functions_(), declaration_(nullptr), assigned_(nullptr),
+  warnings_() {}
+
+/*
+ * New value of a variable is evaluated in the context the variable captured, which
+ * does not bind the variable itself, so arguments reading it may fail when evaluated.
+ */
+void StrictModeChecker::visit(const AssignmentNode& node)
+{
+  const auto assigned = assigned_;
+  if(node.getOperation() == AssignmentOperator::Assign)
+    assigned_ = &node.getName();
+  node.getValue()->accept(*this);
+  assigned_ = assigned;
+}
+
+void StrictModeChecker::visit(const BinaryOpNode& node)
+{
+  node.getLeftOperand().accept(*this);
+  node.getRightOperand().accept(*this);
+}
+
+void StrictModeChecker::visit(const BlockNode& node)
+{
+  const auto& statements = node.getStatements();
+  for(auto it = statements.begin(); it != statements.end(); ++it)
+  {
+    declaration_ = nullptr;
+    (*it)->accept(*this);
+    if(!declaration_ || !calls(*declaration_->getValue()))
+      continue;
+
+    const auto& name = declaration_->getName();
+    const auto next = std::next(it);
+    if(next == statements.end() || purity_.getForced(node, **next, {name}).empty())
+      warn("Variable " + name + " may not be used, but strict evaluation evaluates it!", *declaration_);
+  }
+  declaration_ = nullptr;
+}
+
+void StrictModeChecker::visit(const FunctionCallNode& node)
+{
+  const auto& name = node.getName();
+  if(name != "if" && name != "print")
+  {
+    const auto function = functions_.find(name);
+    if(function != functions_.end() && !purity_.isShadowed(name))
+      checkArguments(node, name, purity_.getStrictArguments(name));
+    else
+      checkArguments(node, name, {});
+  }
+
+  for(const auto& arg : node.getArguments())
+    arg->accept(*this);
+}
+
+void StrictModeChecker::visit(const FunctionCallStatementNode& node)
+{
+  node.getFunctionCall().accept(*this);
+}
+
+void StrictModeChecker::visit(const FunctionDeclarationNode& node)
+{
+  node.getBody()->accept(*this);
+}
+
+void StrictModeChecker::visit(const FunctionResultCallNode& node)
+{
+  node.getCall().accept(*this);
+  checkArguments(node, "result", {});
+  for(const auto& arg : node.getArguments())
+    arg->accept(*this);
+}
+
+void StrictModeChecker::visit(const LambdaCallNode& node)
+{
+  const auto& lambda = node.getLambda();
+  const auto& statements = lambda.getBody().getStatements();
+
+  std::set<std::string> parameters{};
+  for(const auto& arg : lambda.getArguments())
+    parameters.insert(arg.first);
+  const auto forced = statements.empty() ? std::set<std::string>{} :
+    purity_.getForced(lambda.getBody(), *statements.front(), parameters);
+
+  std::vector<bool> strict{};
+  for(const auto& arg : lambda.getArguments())
+    strict.push_back(forced.find(arg.first) != forced.end());
+  checkArguments(node, "lambda", strict);
+
+  lambda.accept(*this);
+  for(const auto& arg : node.getArguments())
+    arg->accept(*this);
+}
+
+void StrictModeChecker::visit(const LambdaNode& node)
+{
+  node.getBody().accept(*this);
+}
+
+void StrictModeChecker::visit(const ProgramNode& node)
+{
+  node.accept(purity_);
+
+  functions_.clear();
+  for(const auto& function : node.getFunctions())
+    functions_[function->getName()] = function.get();
+
+  // Global variables are evaluated before main, so they have to be forced by main itself.
+  std::set<std::string> globals{};
+  for(const auto& variable : node.getVariables())
+  {
+    variable->getValue()->accept(*this);
+    globals.insert(variable->getName());
+  }
+
+  std::set<std::string> forced{};
+  const auto main = functions_.find("main");
+  if(main != functions_.end() && !main->second->getBody()->getStatements().empty())
+  {
+    const auto& body = *main->second->getBody();
+    forced = purity_.getForced(body, *body.getStatements().front(), globals);
+  }
+
+  for(const auto& variable : node.getVariables())
+  {
+    const auto& name = variable->getName();
+    if(calls(*variable->getValue()) && forced.find(name) == forced.end())
+      warn("Global variable " + name + " may not be used, but strict evaluation evaluates it!", *variable);
+  }
+
+  for(const auto& function : node.getFunctions())
+    function->accept(*this);
+}
+
+void StrictModeChecker::visit(const ReturnNode& node)
+{
+  node.getValue().accept(*this);
+}
+
+void StrictModeChecker::visit(const UnaryNode& node)
+{
+  node.getTerm().accept(*this);
+}
+
+void StrictModeChecker::visit(const VariableDeclarationNode& node)
+{
+  node.getValue()->accept(*this);
+  declaration_ = &node;
+}
+
+// Arguments without known strictness are treated as lazy.
+void StrictModeChecker::checkArguments(const CallNode& node, const std::string& name, const std::vector<bool>& strict)
+{
+  std::size_t index = 0;
+  for(const auto& arg : node.getArguments())
+  {
+    const auto isStrict = index < strict.size() && strict[index];
+    ++index;
+    if(isStrict)
+      continue;
+
+    if(calls(*arg))
+      warn("Argument " + std::to_string(index) + " of " + name +
+        " may not be used, but strict evaluation evaluates it!", node);
+    else if(assigned_ && reads(*arg, *assigned_))
+      warn("Argument " + std::to_string(index) + " of " + name + " may not be used, but strict evaluation reads " +
+        *assigned_ + ", which the assignment rebinds!", node);
+  }
+}
+
+void StrictModeChecker::warn(const std::string& message, const Node& node)
+{
+  warnings_.push_back("WARNING (" + node.getMark().to_string() + "): " + message);
+}
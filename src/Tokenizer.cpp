@@ -2,13 +2,9 @@
 
 #include <cstring>
 #include <exception>
-#include <set>
 #include <sstream>
 #include <unordered_map>
 
-const std::set<std::string> Tokenizer::keywords_ = 
-  std::set<std::string>{"f32", "if", "print", "fn", "let", "ret", "void", "function"};
-
 const std::unordered_map<std::string, TokenType> Tokenizer::keywordTokenTypes_ = {
   std::make_pair("f32", TokenType::KeywordF32),
   std::make_pair("if", TokenType::KeywordIf),
@@ -34,6 +30,11 @@ Tokenizer::Tokenizer(std::istream& stream): stream_(stream), token_(stream_.getM
   nextToken();
 }
 
+Tokenizer::Tokenizer(std::string_view text): stream_(text), token_(stream_.getMark())
+{
+  nextToken();
+}
+
 bool Tokenizer::end() const
 {
   return token_.type == TokenType::EOT;
@@ -107,33 +108,23 @@ bool Tokenizer::tryToSkipSpaces()
 
 bool Tokenizer::tryToGetNumber()
 {
-  std::stringstream ss;
   const Mark mark = stream_.getMark();
+  const auto start = stream_.getOffset();
   if(isdigit(stream_.peek()))
   {
     if(stream_.peek() != '0')
     {
       while(isdigit(stream_.peek()))
-      {
-        ss << stream_.peek();
         stream_.advance();
-      }
     }
     else
-    {
-      ss << stream_.peek();
       stream_.advance();
-    }
 
     if(stream_.peek() == '.')
     {
-      ss << stream_.peek();
       stream_.advance();
       while(isdigit(stream_.peek()))
-      {
-        ss << stream_.peek();
         stream_.advance();
-      }
     }
     else if(isdigit(stream_.peek()) || isalpha(stream_.peek()))
       throw std::runtime_error(makeErrorMessage("Unexpected character!"));
@@ -143,7 +134,7 @@ bool Tokenizer::tryToGetNumber()
 
   try
   {
-    const double value = std::stod(ss.str());
+    const double value = std::stod(std::string{stream_.getText(start)});
     token_ = Token(TokenType::Number, value, mark);
   }
   catch(...)
@@ -155,7 +146,7 @@ bool Tokenizer::tryToGetNumber()
 
 bool Tokenizer::tryToGetString()
 {
-  std::stringstream ss;
+  std::string value{};
   const Mark mark = stream_.getMark();
   if(stream_.peek() == '\"')
   {
@@ -168,10 +159,10 @@ bool Tokenizer::tryToGetString()
       else if(stream_.peek() == '\\')
       {
         stream_.advance();
-        ss << handleEscapeSequence();
+        value.push_back(handleEscapeSequence());
       }
       else
-        ss << (char)stream_.peek();
+        value.push_back(stream_.peek());
       stream_.advance();
     }
     stream_.advance();
@@ -179,35 +170,29 @@ bool Tokenizer::tryToGetString()
   else
     return false;
 
-  token_ = Token{TokenType::String, ss.str(), mark};
+  token_ = Token{TokenType::String, std::move(value), mark};
   return true;
 }
 
 bool Tokenizer::tryToGetKeywordOrIdentifier()
 {
-  std::stringstream ss;
   const Mark mark = stream_.getMark();
+  const auto start = stream_.getOffset();
   if(isalpha(stream_.peek()) || stream_.peek() == '_')
   {
-    ss << (char)stream_.peek();
     stream_.advance();
     while(isalpha(stream_.peek()) || isdigit(stream_.peek()) || stream_.peek() == '_')
-    {
-      ss << (char)stream_.peek();
       stream_.advance();
-    }
   }
   else
     return false;
 
-  const std::string str = ss.str();
-  if(keywords_.find(str) != keywords_.end())
-  {
-    const auto type = keywordTokenTypes_.at(str);
-    token_ = Token{type, str, mark};
-  }
+  std::string str{stream_.getText(start)};
+  const auto keyword = keywordTokenTypes_.find(str);
+  if(keyword != keywordTokenTypes_.end())
+    token_ = Token{keyword->second, std::move(str), mark};
   else
-    token_ = Token{TokenType::Identifier, str, mark};
+    token_ = Token{TokenType::Identifier, std::move(str), mark};
 
   return true;
 }
@@ -0,0 +1,123 @@
+#include "ValueOperations.hpp"
+
+#include "Common.hpp"
+#include "Operators.hpp"
+
+void assertValueType(const Value& value, const TypeName& type, const std::string& activity, const Node& node)
+{
+  if(value.getType() != type)
+    reportError("Cannot perform " + activity +
+      " with value of type " + TypeNameStrings.at(value.getType()) + "!", node);
+}
+
+const Function& resolveCallee(const CallNode& node, const std::string& name, const Value& value)
+{
+  FunctionValueResolver resolver{};
+  value.accept(resolver);
+  if(!resolver.getFunction())
+    assertValueType(value, TypeName::Function, "function call", node);
+
+  const auto& function = *resolver.getFunction();
+  if(node.getCachedCallee() == &function.getBody())
+    return function;
+
+  const auto nExpectedArgs = function.getArguments().size();
+  const auto nProvidedArgs = node.getArguments().size();
+  if(nExpectedArgs != nProvidedArgs)
+    reportError("Function " + name + " expected " +
+                std::to_string(nExpectedArgs) + ", but got " + std::to_string(nProvidedArgs) + " arguments!", node);
+
+  node.setCachedCallee(&function.getBody());
+  return function;
+}
+
+std::unique_ptr<Value> applyBinaryOperation(const BinaryOpNode& node, const Value& left, const Value& right)
+{
+  if(node.getOperation() == BinaryOperator::Addition)
+  {
+    if(left.getType() == TypeName::String)
+    {
+      StringValueAnalyser valueAnalyser{};
+      left.accept(valueAnalyser);
+
+      const auto l = valueAnalyser.getValue().value();
+      if(right.getType() == TypeName::String)
+      {
+        right.accept(valueAnalyser);
+        const auto r = valueAnalyser.getValue().value();
+        return std::make_unique<String>(l + r);
+      }
+      else if(right.getType() == TypeName::F32)
+      {
+        NumberValueAnalyser numberValueAnalyser{};
+        right.accept(numberValueAnalyser);
+
+        const auto r = numberValueAnalyser.getValue().value();
+        return std::make_unique<String>(l + std::to_string(r));
+      }
+      else
+        reportError("String cannot be concatenated with value of type "  +
+          TypeNameStrings.at(right.getType()) + "!", node);
+    }
+    else if(left.getType() == TypeName::F32)
+    {
+      NumberValueAnalyser numberValueAnalyser{};
+      left.accept(numberValueAnalyser);
+      const auto l = numberValueAnalyser.getValue().value();
+
+      assertValueType(right, TypeName::F32, "addition", node);
+
+      right.accept(numberValueAnalyser);
+      const auto r = numberValueAnalyser.getValue().value();
+
+      return std::make_unique<Number>(l + r);
+    }
+    else
+      reportError("Operation cannot be performed with value of type "  +
+                  TypeNameStrings.at(left.getType()) + "!", node);
+  }
+
+  assertValueType(left, TypeName::F32,
+          "binary operation " + BinaryOperationNames.at(node.getOperation()), node);
+  assertValueType(right, TypeName::F32,
+          "binary operation " + BinaryOperationNames.at(node.getOperation()), node);
+
+  NumberValueAnalyser valueAnalyser{};
+  left.accept(valueAnalyser);
+  const auto l = valueAnalyser.getValue().value();
+
+  right.accept(valueAnalyser);
+  const auto r = valueAnalyser.getValue().value();
+
+  return std::make_unique<Number>(evaluateBinary(node.getOperation(), l, r));
+}
+
+/*
+ * Operands were proven to be numbers, which can only fail when dynamic scoping binds
+ * a name differently than the checker assumed. Generic path handles that case.
+ */
+std::unique_ptr<Value> applyNumericBinaryOperation(const NumericBinaryOpNode& node, const Value& left, const Value& right)
+{
+  if(left.getType() != TypeName::F32 || right.getType() != TypeName::F32)
+    return applyBinaryOperation(node, left, right);
+
+  NumberValueAnalyser valueAnalyser{};
+  left.accept(valueAnalyser);
+  const auto l = valueAnalyser.getValue().value();
+
+  right.accept(valueAnalyser);
+  const auto r = valueAnalyser.getValue().value();
+
+  return std::make_unique<Number>(node.evaluate(l, r));
+}
+
+std::unique_ptr<Value> applyUnaryOperation(const UnaryNode& node, const Value& term)
+{
+  assertValueType(term, TypeName::F32,
+    "unary operation " + UnaryOperationNames.at(node.getOperation()), node);
+
+  NumberValueAnalyser analyser{};
+  term.accept(analyser);
+
+  return std::make_unique<Number>(evaluateUnary(node.getOperation(), analyser.getValue().value()));
+}
@@ -1,41 +1,442 @@
+#include <algorithm>
 #include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
 
 #include "Parser.hpp"
 #include "PrintVisitor.hpp"
 #include "SemanticAnalyser.hpp"
 #include "Executor.hpp"
+#include "StackExecutor.hpp"
+#include "ClosureExecutor.hpp"
+#include "StgExecutor.hpp"
+#include "CppEmitter.hpp"
+#include "PassManager.hpp"
+#include "StrictModeChecker.hpp"
+
+enum class Engine
+{
+  Tree,
+  Stack,
+  Closure,
+  Stg
+};
+
+struct CommandLineOptions
+{
+  CommandLineOptions(): engine(Engine::Tree), executor(), optimizationLevel(1), extraPasses(), passes(), explicitPasses(false),
+    specializationCapacity(64), stats(false), memoCachePath(), profileInPath(), profileOutPath(), emitPath(),
+    sourcePath() {}
+
+  Engine engine;
+  ExecutorOptions executor;
+  int optimizationLevel;
+  // Passes enabled by their own options on top of the optimization level.
+  std::set<std::string> extraPasses;
+  // Passes given explicitly, which replace the optimization level.
+  std::vector<std::string> passes;
+  bool explicitPasses;
+  std::size_t specializationCapacity;
+  bool stats;
+  std::string memoCachePath;
+  std::string profileInPath;
+  std::string profileOutPath;
+  // Program is translated to C++ and written there instead of being executed.
+  std::string emitPath;
+  std::string sourcePath;
+};
+
+void printUsage(const char* name)
+{
+  std::cout << "Usage: " << name << " [options] source_file\n"
+    << "Options:\n"
+    << "  --engine=name       evaluate with tree (default), stack, closure or stg engine\n"
+    << "  --eval=mode         evaluate variables and arguments lazy (default) or strict (tree engine)\n"
+    << "  --stack-limit=MB    memory available to evaluation stack of stack and stg engines\n"
+    << "  --memoize[=N]       cache results of pure numeric functions (at most N entries)\n"
+    << "  --memo-cache=path   memoize and persist cached results in given file between runs\n"
+    << "  --jit               compile numeric functions to native code (tree and closure engines)\n"
+    << "  --speculate[=N]     evaluate cheap bindings eagerly, in at most N steps (tree and closure engines)\n"
+    << "  -O<level>           run optimization passes of level 0 to 3 (1 by default)\n"
+    << "  --passes=a,b,c      run given passes in this order instead: numeric, inline, specialize,\n"
+    << "                      lift-lambdas, loops, cse, dce (numeric only first)\n"
+    << "  --specialize[=N]    specialize functions for constant arguments (at most N copies)\n"
+    << "  --lift-lambdas      turn lambdas which are only called into top-level functions\n"
+    << "  --cse               share repeated subexpressions of function bodies\n"
+    << "  --dce               remove unreachable functions, unused variables and code after return\n"
+    << "  --profile-out=path  record calls, branches and forced bindings to given file (tree engine)\n"
+    << "  --profile-in=path   inline, specialize, speculate and lay out code guided by given profile\n"
+    << "  --emit-cpp=path     write program translated to C++ to given file instead of running it\n"
+    << "  --stats             print execution statistics to standard error\n";
+}
+
+std::string optionValue(const std::string& option)
+{
+  return option.substr(option.find('=') + 1);
+}
+
+bool parseOption(const std::string& option, CommandLineOptions& options)
+{
+  if(option == "--engine=tree")
+    options.engine = Engine::Tree;
+  else if(option == "--engine=stack")
+    options.engine = Engine::Stack;
+  else if(option == "--engine=closure")
+    options.engine = Engine::Closure;
+  else if(option == "--engine=stg")
+    options.engine = Engine::Stg;
+  else if(option == "--eval=lazy")
+    options.executor.strict = false;
+  else if(option == "--eval=strict")
+    options.executor.strict = true;
+  else if(option.rfind("--stack-limit=", 0) == 0)
+  {
+    try
+    {
+      options.executor.stackLimit = std::stoul(optionValue(option));
+    }
+    catch(std::exception&)
+    {
+      return false;
+    }
+  }
+  else if(option == "--memoize")
+    options.executor.memoize = true;
+  else if(option.rfind("--memoize=", 0) == 0)
+  {
+    options.executor.memoize = true;
+    try
+    {
+      options.executor.memoCapacity = std::stoul(optionValue(option));
+    }
+    catch(std::exception&)
+    {
+      return false;
+    }
+  }
+  else if(option.rfind("--memo-cache=", 0) == 0)
+  {
+    options.executor.memoize = true;
+    options.memoCachePath = optionValue(option);
+    return !options.memoCachePath.empty();
+  }
+  else if(option.size() == 3 && option.rfind("-O", 0) == 0 && PassManager::getLevel(option[2] - '0'))
+    options.optimizationLevel = option[2] - '0';
+  else if(option.rfind("--passes=", 0) == 0)
+  {
+    options.passes.clear();
+    options.explicitPasses = true;
+    std::stringstream names{optionValue(option)};
+    std::string name{};
+    while(std::getline(names, name, ','))
+    {
+      if(!PassManager::isRegistered(name) || (name == "numeric" && !options.passes.empty()))
+        return false;
+      options.passes.push_back(name);
+    }
+  }
+  else if(option == "--specialize")
+    options.extraPasses.insert("specialize");
+  else if(option == "--jit")
+    options.executor.jit = true;
+  else if(option == "--speculate")
+    options.executor.speculate = true;
+  else if(option.rfind("--speculate=", 0) == 0)
+  {
+    options.executor.speculate = true;
+    try
+    {
+      options.executor.speculationBudget = std::stoul(optionValue(option));
+    }
+    catch(std::exception&)
+    {
+      return false;
+    }
+  }
+  else if(option.rfind("--specialize=", 0) == 0)
+  {
+    options.extraPasses.insert("specialize");
+    try
+    {
+      options.specializationCapacity = std::stoul(optionValue(option));
+    }
+    catch(std::exception&)
+    {
+      return false;
+    }
+  }
+  else if(option == "--lift-lambdas")
+    options.extraPasses.insert("lift-lambdas");
+  else if(option == "--cse")
+    options.extraPasses.insert("cse");
+  else if(option == "--dce")
+    options.extraPasses.insert("dce");
+  else if(option.rfind("--profile-in=", 0) == 0)
+  {
+    options.profileInPath = optionValue(option);
+    options.extraPasses.insert("inline");
+    return !options.profileInPath.empty();
+  }
+  else if(option.rfind("--profile-out=", 0) == 0)
+  {
+    options.profileOutPath = optionValue(option);
+    return !options.profileOutPath.empty();
+  }
+  else if(option.rfind("--emit-cpp=", 0) == 0)
+  {
+    options.emitPath = optionValue(option);
+    return !options.emitPath.empty();
+  }
+  else if(option == "--stats")
+    options.stats = true;
+  else
+    return false;
+
+  return true;
+}
+
+bool parseCommandLine(int argc, char* argv[], CommandLineOptions& options)
+{
+  for(int i = 1; i < argc; ++i)
+  {
+    const std::string arg{argv[i]};
+    if(arg.rfind("-", 0) == 0)
+    {
+      if(!parseOption(arg, options))
+        return false;
+    }
+    else if(options.sourcePath.empty())
+      options.sourcePath = arg;
+    else
+      return false;
+  }
+
+  return !options.sourcePath.empty();
+}
+
+// Passes given explicitly are run as they are, otherwise those of the level and the enabled ones are.
+std::vector<std::string> selectPasses(const CommandLineOptions& options)
+{
+  if(options.explicitPasses)
+    return options.passes;
+
+  const auto level = *PassManager::getLevel(options.optimizationLevel);
+  const auto all = *PassManager::getLevel(3);
+  std::vector<std::string> passes{};
+  for(const auto& name : all)
+  {
+    if(std::find(level.begin(), level.end(), name) != level.end() || options.extraPasses.count(name) != 0)
+      passes.push_back(name);
+  }
+  return passes;
+}
+
+void printStatistics(const CommandLineOptions& options, PassManager& passes)
+{
+  for(const auto& report : passes.getReports())
+  {
+    std::ostringstream time{};
+    time << std::fixed << std::setprecision(3) << report.milliseconds;
+    std::cerr << "Pass " << report.name << ": " << report.summary << ", " << report.nodesBefore << " -> "
+      << report.nodesAfter << " nodes, " << time.str() << " ms\n";
+  }
+  std::cerr << "Analyses: " << passes.getAnalyses().getComputed() << " computed, "
+    << passes.getAnalyses().getReused() << " reused\n";
+
+  if(options.executor.feedback)
+  {
+    const auto& profile = *options.executor.feedback;
+    std::cerr << "Profile: " << profile.getMatched() << "/" << profile.getSites() << " sites matched\n";
+  }
+}
+
+void printStatistics(const std::shared_ptr<MemoTable>& memoTable)
+{
+  if(memoTable)
+  {
+    std::cerr << "Memoization: " << memoTable->getHits() << " hits, " 
+      << memoTable->getMisses() << " misses, " << memoTable->getEvictions() << " evictions, "
+      << memoTable->getSize() << "/" << memoTable->getCapacity() << " entries\n";
+  }
+}
+
+void printStatistics(const std::shared_ptr<JitCompiler>& jit)
+{
+  if(jit)
+    std::cerr << "JIT: " << jit->getCompiled() << " functions compiled, " << jit->getCodeSize() << " bytes of code\n";
+}
+
+void printStatistics(const std::shared_ptr<Speculator>& speculator)
+{
+  if(speculator)
+  {
+    const auto attempts = speculator->getAttempts();
+    std::cerr << "Speculation: " << attempts - speculator->getAborted() << "/" << attempts
+      << " bindings evaluated eagerly, " << speculator->getDisabled() << " sites disabled\n";
+  }
+}
+
+/*
+ * Runs program with given engine, all of them expose the same interface as Executor.
+ * Output is printed only if the program finishes without error.
+ */
+template<typename Engine>
+void execute(Engine& engine, const ProgramNode& program, const CommandLineOptions& options)
+{
+  if(!options.memoCachePath.empty())
+  {
+    registerMemoizableFunctions(*engine.getMemoTable(), program);
+    engine.getMemoTable()->load(options.memoCachePath);
+  }
+
+  program.accept(engine);
+
+  std::cout << engine.getStandardOut();
+
+  if(!options.memoCachePath.empty() && !engine.getMemoTable()->save(options.memoCachePath))
+    std::cerr << "Could not write memo cache " << options.memoCachePath << "!\n";
+
+  if(options.stats)
+    printStatistics(engine.getMemoTable());
+}
+
+void executeOnStack(const ProgramNode& program, const CommandLineOptions& options)
+{
+  StackExecutor executor{options.executor};
+  try
+  {
+    execute(executor, program, options);
+  }
+  catch(std::runtime_error&)
+  {
+    const auto trace = executor.getStackTrace();
+    const std::size_t shown = 16;
+    for(std::size_t i = 0; i < trace.size() && i < shown; ++i)
+      std::cerr << "  at " << trace[i] << "\n";
+    if(trace.size() > shown)
+      std::cerr << "  ... " << trace.size() - shown << " more\n";
+    throw;
+  }
+
+  if(options.stats)
+  {
+    std::cerr << "Stack: " << executor.getMaxDepth() << " frames at most, limit "
+      << (executor.getStackLimit() >> 20) << " MiB\n";
+  }
+}
+
+void emitCpp(const ProgramNode& program, const CommandLineOptions& options)
+{
+  CppEmitter emitter{};
+  program.accept(emitter);
+
+  std::ofstream file{options.emitPath};
+  file << emitter.getSource();
+  if(!file)
+  {
+    std::cerr << "Could not write " << options.emitPath << "!\n";
+    return;
+  }
+
+  if(options.stats)
+    std::cerr << "Translation: " << emitter.getFunctions() << " functions emitted\n";
+}
 
 int main(int argc, char* argv[])
 {
-  if(argc != 2)
+  CommandLineOptions options{};
+  if(!parseCommandLine(argc, argv, options))
   {
-    std::cout << "Usage: " << argv[0] << " source_file\n";
+    printUsage(argv[0]);
     return 0;
   }
 
   try
   {
-    std::ifstream sourceFile{argv[1]};
-    if(!sourceFile.is_open())
+    SourceFile sourceFile{options.sourcePath};
+    if(!sourceFile.isOpen())
     {
       std::cout << "Could not open provided source file!\n";
       return 0;
     }
 
-    Parser parser{sourceFile};
+    if(!options.profileInPath.empty())
+    {
+      auto profile = std::make_shared<Profile>();
+      if(profile->load(options.profileInPath))
+        options.executor.feedback = std::move(profile);
+      else
+        std::cerr << "Could not read profile " << options.profileInPath << "!\n";
+    }
+    if(!options.profileOutPath.empty() && options.engine == Engine::Tree)
+      options.executor.profile = std::make_shared<Profile>();
+
+    PassOptions passOptions{};
+    passOptions.specializationCapacity = options.specializationCapacity;
+    passOptions.feedback = options.executor.feedback;
+    PassManager passes{passOptions};
+    for(const auto& name : selectPasses(options))
+      passes.add(name);
+
+    Parser parser{sourceFile.getText()};
     //PrintVisitor printer{};
-    SemanticAnalyser semantic{};
-    Executor executor{};
-    
+
     auto program = parser.parseProgram();
     //program->accept(printer);
-    program->accept(semantic);
-    program->accept(executor);
-    
-    sourceFile.close();
+    passes.getAnalyses().get<SemanticAnalyser>(*program);
+
+    if(options.executor.strict && options.engine == Engine::Tree)
+    {
+      StrictModeChecker checker{};
+      program->accept(checker);
+      for(const auto& warning : checker.getWarnings())
+        std::cerr << warning << "\n";
+    }
+
+    program = passes.run(std::move(program));
+    if(options.stats)
+      printStatistics(options, passes);
 
-    std::cout << executor.getStandardOut();
+    if(!options.emitPath.empty())
+      emitCpp(*program, options);
+    else if(options.engine == Engine::Stack)
+      executeOnStack(*program, options);
+    else if(options.engine == Engine::Stg)
+    {
+      StgExecutor executor{options.executor};
+      execute(executor, *program, options);
+      if(options.stats)
+      {
+        std::cerr << "STG: " << executor.getAllocated() << " thunks allocated, " << executor.getUpdated()
+          << " updated, " << executor.getShared() << " shared reads, " << executor.getMaxDepth() << " frames at most\n";
+      }
+    }
+    else if(options.engine == Engine::Closure)
+    {
+      ClosureExecutor executor{options.executor};
+      execute(executor, *program, options);
+      if(options.stats)
+      {
+        printStatistics(executor.getJit());
+        printStatistics(executor.getSpeculator());
+      }
+    }
+    else
+    {
+      Executor executor{options.executor};
+      execute(executor, *program, options);
+      if(executor.getProfile() && !executor.getProfile()->save(options.profileOutPath))
+        std::cerr << "Could not write profile " << options.profileOutPath << "!\n";
+      if(options.stats)
+      {
+        printStatistics(executor.getJit());
+        printStatistics(executor.getSpeculator());
+      }
+    }
   }
   catch(std::runtime_error& er)
   {
@@ -0,0 +1,153 @@
+#include <gtest/gtest.h>
+#include <sstream>
+
+#include "AST.hpp"
+#include "Parser.hpp"
+#include "Executor.hpp"
+#include "ClosureExecutor.hpp"
+
+void testClosureProgram(const std::string& source, const std::string& out, int status,
+  const ExecutorOptions& options = {})
+{
+  std::stringstream stream{source};
+  Parser parser{stream};
+  auto program = parser.parseProgram();
+
+  Executor original{options};
+  program->accept(original);
+
+  ClosureExecutor executor{options};
+  program->accept(executor);
+
+  EXPECT_EQ(original.getStandardOut(), out);
+  EXPECT_EQ(executor.getStandardOut(), out);
+  EXPECT_EQ(original.getExitCode(), status);
+  EXPECT_EQ(executor.getExitCode(), status);
+}
+
+TEST(ClosureExecutorTest, EvaluatesLikeExecutor)
+{
+  std::string source = R"SRC(
+  let base: f32 = 2;
+
+  fn fact(n: f32): f32 { ret if(n < 2, 1, n * fact(n - 1)); }
+  fn show(x: f32): void { print("value " : x); }
+  fn second(a: f32, b: f32): f32 { ret b; }
+  fn hang(): f32 { ret hang(); }
+
+  fn main(): f32
+  {
+    let a: f32 = 10;
+    let lazy: f32 = hang();
+    print("" : fact(5) : " " : second(1, a) : " " : -base);
+    show(3 + (\(x: f32, y: f32): f32 = { ret x * y; ret 0; })(2, 3));
+    a += 5;
+    a <<= 1;
+    print("" : a);
+    ret base + 1;
+  }
+  )SRC";
+
+  testClosureProgram(source, "120.000000 10.000000 -2.000000\nvalue 9.000000\n30.000000\n", 3);
+}
+
+TEST(ClosureExecutorTest, ClosuresKeepTheirContext)
+{
+  std::string source = R"SRC(
+  fn makeAdder(n: f32): function
+  {
+    let add: function = \(x: f32): f32 = { print("adding"); ret x + n; };
+    ret add;
+  }
+
+  fn apply(f: function): f32 { ret f(5); }
+
+  fn main(): f32
+  {
+    let m: f32 = 1;
+    let g: function = \(y: f32): f32 = { ret y + m; };
+    m = 2;
+    let add: function = makeAdder(10);
+    print("" : g(1) : " " : add(1) : " " : makeAdder(3)(4) : " " : apply(g));
+    ret 0;
+  }
+  )SRC";
+
+  testClosureProgram(source, "adding\nadding\n2.000000 11.000000 7.000000 6.000000\n", 0);
+}
+
+TEST(ClosureExecutorTest, CompoundAssignmentKeepsCapturedValues)
+{
+  std::string source = R"SRC(
+  fn main(): f32
+  {
+    let m: f32 = 1;
+    m += 1;
+    m += 1;
+    let seen: f32 = m;
+    let g: function = \(y: f32): f32 = { ret y + m; };
+    m += 10;
+    m *= 2;
+    print("" : seen : " " : g(0) : " " : m);
+    ret m;
+  }
+  )SRC";
+
+  testClosureProgram(source, "3.000000 3.000000 26.000000\n", 26);
+}
+
+TEST(ClosureExecutorTest, MemoizedCallsMatchExecutor)
+{
+  std::string source = R"SRC(
+  fn fib(n: f32): f32 { ret if(n < 2, n, fib(n - 1) + fib(n - 2)); }
+
+  fn main(): f32
+  {
+    print("" : fib(30));
+    ret 0;
+  }
+  )SRC";
+
+  ExecutorOptions options{};
+  options.memoize = true;
+  testClosureProgram(source, "832040.000000\n", 0, options);
+}
+
+TEST(ClosureExecutorTest, NodesAreCompiledOnce)
+{
+  std::string source = R"SRC(
+  fn fib(n: f32): f32 { ret if(n < 2, n, fib(n - 1) + fib(n - 2)); }
+
+  fn main(): f32
+  {
+    print("" : fib(10));
+    ret 0;
+  }
+  )SRC";
+
+  std::stringstream stream{source};
+  Parser parser{stream};
+  auto program = parser.parseProgram();
+
+  ClosureExecutor executor{};
+  program->accept(executor);
+  const auto compiled = executor.getCompiled();
+
+  EXPECT_EQ(executor.getStandardOut(), "55.000000\n");
+  // Only nodes created while evaluating, like literals of forced arguments, may be added later.
+  EXPECT_GT(compiled, 20);
+}
+
+TEST(ClosureExecutorTest, EvaluatesExpressions)
+{
+  std::stringstream stream{"2 * (3 + 4) - 1"};
+  Parser parser{stream};
+  auto expression = parser.parseLogicalExpression();
+
+  ClosureExecutor executor{};
+  expression->accept(executor);
+
+  ASSERT_NE(executor.getValue(), nullptr);
+  ASSERT_EQ(executor.getValue()->getType(), TypeName::F32);
+  EXPECT_EQ(static_cast<const Number&>(*executor.getValue()).getValue(), 13);
+}
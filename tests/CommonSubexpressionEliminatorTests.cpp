@@ -0,0 +1,143 @@
+#include <gtest/gtest.h>
+#include <sstream>
+
+#include "AST.hpp"
+#include "Parser.hpp"
+#include "SemanticAnalyser.hpp"
+#include "CommonSubexpressionEliminator.hpp"
+#include "Executor.hpp"
+
+void testElimination(const std::string& source, const std::string& out, std::size_t eliminated)
+{
+  std::stringstream stream{source};
+  Parser parser{stream};
+  auto program = parser.parseProgram();
+
+  SemanticAnalyser semantic{};
+  program->accept(semantic);
+
+  CommonSubexpressionEliminator eliminator{};
+  auto optimized = eliminator.clone(*program);
+  EXPECT_EQ(eliminator.getEliminated(), eliminated);
+
+  Executor original{};
+  program->accept(original);
+
+  Executor executor{};
+  optimized->accept(executor);
+
+  EXPECT_EQ(original.getStandardOut(), out);
+  EXPECT_EQ(executor.getStandardOut(), out);
+  EXPECT_EQ(executor.getExitCode(), original.getExitCode());
+}
+
+TEST(CommonSubexpressionEliminatorTest, RepeatedExpressionIsShared)
+{
+  std::string source = R"SRC(
+  fn f(x: f32, y: f32): f32
+  {
+    ret (x*y + 1) * (x*y + 2) - x*y;
+  }
+
+  fn main(): f32
+  {
+    print("" : f(2, 3));
+    ret 0;
+  }
+  )SRC";
+
+  testElimination(source, "50.000000\n", 2);
+}
+
+TEST(CommonSubexpressionEliminatorTest, RepeatedParameterReadsAreShared)
+{
+  std::string source = R"SRC(
+  fn fact(n: f32): f32
+  {
+    ret if(n == 0, 1, n * fact(n - 1));
+  }
+
+  fn main(): f32
+  {
+    print("" : fact(6));
+    ret 0;
+  }
+  )SRC";
+
+  testElimination(source, "720.000000\n", 2);
+}
+
+TEST(CommonSubexpressionEliminatorTest, AssignmentEndsSharing)
+{
+  std::string source = R"SRC(
+  fn main(): f32
+  {
+    let x: f32 = 2;
+    let a: f32 = (x + 1) * 3;
+    x += 4;
+    let b: f32 = (x + 1) * 3;
+    print("" : a : " " : b);
+    ret 0;
+  }
+  )SRC";
+
+  testElimination(source, "9.000000 21.000000\n", 0);
+}
+
+TEST(CommonSubexpressionEliminatorTest, ImpureCallEndsSharing)
+{
+  std::string source = R"SRC(
+  fn show(v: f32): void
+  {
+    print("" : v);
+  }
+
+  fn main(): f32
+  {
+    let x: f32 = 2;
+    show(x * 3);
+    show(x * 3);
+    ret 0;
+  }
+  )SRC";
+
+  testElimination(source, "6.000000\n6.000000\n", 0);
+}
+
+TEST(CommonSubexpressionEliminatorTest, SharedExpressionStaysLazy)
+{
+  std::string source = R"SRC(
+  fn hang(x: f32): f32
+  {
+    ret hang(x);
+  }
+
+  fn f(c: f32, x: f32): f32
+  {
+    ret if(c, 1, hang(x) + 1) + if(c, 2, hang(x) + 2);
+  }
+
+  fn main(): f32
+  {
+    print("" : f(1, 5));
+    ret 0;
+  }
+  )SRC";
+
+  testElimination(source, "3.000000\n", 2);
+}
+
+TEST(CommonSubexpressionEliminatorTest, ArgumentsOfClosureCallsAreNotShared)
+{
+  std::string source = R"SRC(
+  fn main(): f32
+  {
+    let k: f32 = 3;
+    let g: function = \(v: f32): f32 = { ret v * 2; };
+    print("" : g(k * k) + k * k);
+    ret 0;
+  }
+  )SRC";
+
+  testElimination(source, "27.000000\n", 1);
+}
@@ -0,0 +1,218 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <sys/wait.h>
+
+#include "AST.hpp"
+#include "Parser.hpp"
+#include "SemanticAnalyser.hpp"
+#include "NumericOperationRewriter.hpp"
+#include "Executor.hpp"
+#include "CppEmitter.hpp"
+
+namespace
+{
+
+struct TranslatedProgram
+{
+  std::string name;
+  std::string out;
+  int status;
+};
+
+std::unique_ptr<ProgramNode> prepareProgram(std::istream& stream)
+{
+  Parser parser{stream};
+  SemanticAnalyser semantic{};
+
+  auto program = parser.parseProgram();
+  program->accept(semantic);
+
+  NumericOperationRewriter rewriter{semantic.getTypes()};
+  return rewriter.clone(*program);
+}
+
+// Output and exit code, as main of the interpreter reports them.
+TranslatedProgram interpret(const ProgramNode& program, const std::string& name)
+{
+  Executor executor{};
+  try
+  {
+    program.accept(executor);
+  }
+  catch(std::runtime_error& error)
+  {
+    return TranslatedProgram{name, std::string{error.what()} + "\n", 0};
+  }
+
+  return TranslatedProgram{name, executor.getStandardOut(), executor.getExitCode()};
+}
+
+std::string runTranslated(const std::string& command, int& status)
+{
+  std::string out{};
+  const auto pipe = popen(command.c_str(), "r");
+  char buffer[256];
+  while(std::fgets(buffer, sizeof(buffer), pipe))
+    out += buffer;
+  status = WEXITSTATUS(pclose(pipe));
+  return out;
+}
+
+}
+
+TEST(CppEmitterTest, EmitsFunctionsForLazyExpressions)
+{
+  std::stringstream stream{R"SRC(
+  let x: f32 = 2;
+
+  fn main(): f32
+  {
+    ret x + 1;
+  }
+  )SRC"};
+  Parser parser{stream};
+  auto program = parser.parseProgram();
+
+  CppEmitter emitter{};
+  program->accept(emitter);
+  const auto source = emitter.getSource();
+
+  // Value of x, parameters and body of main.
+  EXPECT_EQ(emitter.getFunctions(), 3);
+  EXPECT_NE(source.find("lil::declare(a, n0_x, lil::Type::F32, e0, false);"), std::string::npos);
+  EXPECT_NE(source.find("lil::Value t0 = lil::read(a, n0_x, \"x\", "), std::string::npos);
+  EXPECT_NE(source.find("lil::binary(lil::Operator::Addition, t0, lil::number(1), "), std::string::npos);
+  EXPECT_NE(source.find("return lil::run(program, n1_main);"), std::string::npos);
+}
+
+/*
+ * Translates examples and programs like those of executor tests, builds them
+ * with the compiler the tests were built with and compares their output and
+ * exit codes with those of Executor.
+ */
+TEST(CppEmitterTest, TranslatedProgramsMatchExecutor)
+{
+  const std::vector<std::string> sources = {
+    R"SRC(
+    fn main(): f32 { ret 12; }
+    )SRC",
+    R"SRC(
+    let x: f32 = 1;
+    fn test(x: f32, y: f32): f32 { ret x + y + 1; }
+    fn show(x: f32): void { print("test " : x); }
+    fn main(): f32
+    {
+      let x: f32 = 2;
+      print("" : x : " " : test(1, 2) : " " : -x : " " : 7 % 4 : " " : (5 & 3) : " " : !x);
+      show(4);
+      ret 0;
+    }
+    )SRC",
+    R"SRC(
+    fn test(): void { print("test"); }
+    fn main(): f32
+    {
+      let m: f32 = 1;
+      let f: function = \(y: f32, z: f32): f32 = { ret y + z + m; };
+      let g: function = test;
+      m = 2;
+      print("" : f(2, 2) : " " : (\(y: f32, z: f32): f32 = { ret y + z; })(1, 2));
+      g();
+      m += 2;
+      m <<= 1;
+      print("" : m);
+      ret 0;
+    }
+    )SRC",
+    R"SRC(
+    fn second(a: f32, b: f32): f32 { ret b; }
+    fn first(): f32 { ret 1; print("unreachable"); ret 2; }
+    fn hang(): f32 { ret hang(); }
+    fn main(): f32
+    {
+      let a: f32 = 10;
+      let lazy: f32 = hang();
+      print("" : second(1, a) : " " : (\(a: f32, b: f32): f32 = { ret b; })(2, a));
+      print("" : first() + (\(x: f32): f32 = { ret x; ret 0; })(5));
+      ret 3;
+    }
+    )SRC",
+    R"SRC(
+    fn makeAdder(n: f32): function
+    {
+      let add: function = \(x: f32): f32 = { ret x + n; };
+      ret add;
+    }
+    fn apply(f: function): f32 { ret f(5); }
+    fn main(): f32
+    {
+      let g: function = makeAdder(3);
+      print("" : g(1) : " " : makeAdder(10)(4) : " " : apply(g) : " " : if(g(0) > 2, 1, 0));
+      ret 300;
+    }
+    )SRC"
+  };
+
+  const auto directory = std::filesystem::temp_directory_path() / "lil_emit_tests";
+  std::filesystem::remove_all(directory);
+  std::filesystem::create_directories(directory);
+
+  std::vector<TranslatedProgram> programs{};
+  const auto translate = [&](std::istream& stream, const std::string& name) {
+    const auto program = prepareProgram(stream);
+    programs.push_back(interpret(*program, name));
+
+    CppEmitter emitter{};
+    program->accept(emitter);
+    std::ofstream{directory / (name + ".cpp")} << emitter.getSource();
+  };
+
+  for(std::size_t i = 0; i < sources.size(); ++i)
+  {
+    std::stringstream stream{sources[i]};
+    translate(stream, "program" + std::to_string(i));
+  }
+
+  // Example with errors is rejected by the parser, before it could be translated.
+  for(const auto& example : std::filesystem::directory_iterator{std::filesystem::path{LIL_RUNTIME_DIR} / "../examples"})
+  {
+    std::ifstream stream{example.path()};
+    try
+    {
+      translate(stream, example.path().stem().string());
+    }
+    catch(std::runtime_error&)
+    {
+      EXPECT_EQ(example.path().stem(), "7-error");
+    }
+  }
+
+  // Programs are built as a single binary, each in a namespace of its own, and selected by argument.
+  std::ofstream driver{directory / "driver.cpp"};
+  driver << "#include \"lil_runtime.hpp\"\n#include <string>\n";
+  for(std::size_t i = 0; i < programs.size(); ++i)
+  {
+    driver << "namespace program_" << i << "\n{\n#define main main_\n#include \"" << programs[i].name
+      << ".cpp\"\n#undef main\n}\n";
+  }
+  driver << "int main(int, char* argv[])\n{\n  const auto program = std::stoi(argv[1]);\n";
+  for(std::size_t i = 0; i < programs.size(); ++i)
+    driver << "  if(program == " << i << ")\n    return program_" << i << "::main_();\n";
+  driver << "  return -1;\n}\n";
+  driver.close();
+
+  const auto binary = directory / "driver";
+  const auto command = std::string{LIL_CXX} + " -std=c++17 -I " + LIL_RUNTIME_DIR + " " +
+    (directory / "driver.cpp").string() + " -o " + binary.string();
+  ASSERT_EQ(std::system(command.c_str()), 0);
+
+  for(std::size_t i = 0; i < programs.size(); ++i)
+  {
+    int status = 0;
+    EXPECT_EQ(runTranslated(binary.string() + " " + std::to_string(i), status), programs[i].out) << programs[i].name;
+    EXPECT_EQ(status, programs[i].status & 0xff) << programs[i].name;
+  }
+}
@@ -0,0 +1,118 @@
+#include <gtest/gtest.h>
+#include <sstream>
+
+#include "AST.hpp"
+#include "Parser.hpp"
+#include "SemanticAnalyser.hpp"
+#include "DeadCodeEliminator.hpp"
+#include "Executor.hpp"
+
+void testDeadCode(const std::string& source, const std::string& out,
+  std::size_t functions, std::size_t variables, std::size_t statements)
+{
+  std::stringstream stream{source};
+  Parser parser{stream};
+  auto program = parser.parseProgram();
+
+  SemanticAnalyser semantic{};
+  program->accept(semantic);
+
+  DeadCodeEliminator eliminator{};
+  auto transformed = eliminator.clone(*program);
+  EXPECT_EQ(eliminator.getRemovedFunctions(), functions);
+  EXPECT_EQ(eliminator.getRemovedVariables(), variables);
+  EXPECT_EQ(eliminator.getRemovedStatements(), statements);
+  EXPECT_EQ(transformed->getFunctions().size(), program->getFunctions().size() - functions);
+
+  Executor original{};
+  program->accept(original);
+
+  Executor executor{};
+  transformed->accept(executor);
+
+  EXPECT_EQ(original.getStandardOut(), out);
+  EXPECT_EQ(executor.getStandardOut(), out);
+  EXPECT_EQ(executor.getExitCode(), original.getExitCode());
+}
+
+TEST(DeadCodeEliminatorTest, UnreachableFunctionsAreRemoved)
+{
+  std::string source = R"SRC(
+  fn twice(x: f32): f32 { ret x * 2; }
+  fn quad(x: f32): f32 { ret twice(twice(x)); }
+  fn square(x: f32): f32 { ret x * x; }
+
+  let factor: f32 = 3;
+
+  fn main(): f32
+  {
+    let f: function = square;
+    print("" : f(factor));
+    ret 0;
+  }
+  )SRC";
+
+  testDeadCode(source, "9.000000\n", 2, 0, 0);
+}
+
+TEST(DeadCodeEliminatorTest, UnusedFunctionsAndVariablesAreRemoved)
+{
+  std::string source = R"SRC(
+  fn helper(x: f32): f32 { ret x + 1; }
+  fn unused(x: f32): f32 { let y: f32 = helper(x); ret y; }
+
+  fn main(): f32
+  {
+    let a: f32 = 1;
+    let b: f32 = a * 2;
+    let c: f32 = 3;
+    let g: function = \(x: f32): f32 = { let unread: f32 = x; ret x * c; };
+    print("" : g(2));
+    ret 0;
+  }
+  )SRC";
+
+  testDeadCode(source, "6.000000\n", 2, 3, 0);
+}
+
+TEST(DeadCodeEliminatorTest, StatementsAfterReturnAreRemoved)
+{
+  std::string source = R"SRC(
+  fn f(x: f32): f32
+  {
+    ret x * 2;
+    print("unreachable");
+    let y: f32 = 1;
+    ret y;
+  }
+
+  fn main(): f32
+  {
+    print("" : f(4));
+    ret 0;
+  }
+  )SRC";
+
+  testDeadCode(source, "8.000000\n", 0, 0, 3);
+}
+
+TEST(DeadCodeEliminatorTest, VariablesVisibleToCalleesAreKept)
+{
+  std::string source = R"SRC(
+  let k: f32 = 1;
+
+  fn readK(): f32 { ret k; }
+  fn sq(x: f32): f32 { ret x * x; }
+  fn plusOne(): f32 { ret sq(3) + 1; }
+
+  fn main(): f32
+  {
+    let k: f32 = 5;
+    let sq: function = \(y: f32): f32 = { ret y; };
+    print("" : readK() : " " : plusOne());
+    ret 0;
+  }
+  )SRC";
+
+  testDeadCode(source, "5.000000 4.000000\n", 0, 0, 0);
+}
@@ -354,4 +354,421 @@ TEST(ExecutorTest, LazyEvaluation)
   std::string expected = "";
 
   testProgram(source, expected, 0);
-}
\ No newline at end of file
+}
+
+TEST(ExecutorTest, ArgumentsAreEvaluatedInCallerContext)
+{
+  std::string source = R"SRC(
+  fn second(a: f32, b: f32): f32
+  {
+    ret b;
+  }
+
+  fn main(): f32
+  {
+    let a: f32 = 10;
+    print("" : second(1, a));
+    print("" : (\(a: f32, b: f32): f32 = { ret b; })(2, a));
+    ret 0;
+  }
+  )SRC";
+
+  std::string expected = "10.000000\n10.000000\n";
+
+  testProgram(source, expected, 0);
+}
+
+TEST(ExecutorTest, ReturnEndsFunction)
+{
+  std::string source = R"SRC(
+  fn first(): f32
+  {
+    ret 1;
+    print("unreachable");
+    ret 2;
+  }
+
+  fn main(): f32
+  {
+    print("" : first() + (\(x: f32): f32 = { ret x; ret 0; })(5));
+    ret 3;
+    print("unreachable");
+  }
+  )SRC";
+
+  std::string expected = "6.000000\n";
+
+  testProgram(source, expected, 3);
+}
+
+TEST(ExecutorTest, MemoizationOfPureFunctions)
+{
+  std::string source = R"SRC(
+  fn fib(n: f32): f32
+  {
+    ret if(n < 2, n, fib(n - 1) + fib(n - 2));
+  }
+
+  fn main(): f32
+  {
+    print("" : fib(30));
+    ret 0;
+  }
+  )SRC";
+
+  std::stringstream stream{source};
+  Parser parser{stream};
+  auto program = parser.parseProgram();
+
+  ExecutorOptions options{};
+  options.memoize = true;
+  Executor executor{options};
+  program->accept(executor);
+
+  EXPECT_EQ(executor.getStandardOut(), "832040.000000\n");
+  EXPECT_EQ(executor.getMemoTable()->getMisses(), 31);
+  EXPECT_EQ(executor.getMemoTable()->getHits(), 28);
+}
+
+TEST(ExecutorTest, MemoizationIsBounded)
+{
+  std::string source = R"SRC(
+  fn sq(x: f32): f32 { ret x * x; }
+  fn log(x: f32): f32 { print("" : x); ret x; }
+
+  fn main(): f32
+  {
+    print("" : sq(1) + sq(2) + sq(3) + sq(1));
+    print("" : log(1) + log(1));
+    ret 0;
+  }
+  )SRC";
+
+  std::stringstream stream{source};
+  Parser parser{stream};
+  auto program = parser.parseProgram();
+
+  ExecutorOptions options{};
+  options.memoize = true;
+  options.memoCapacity = 2;
+  Executor executor{options};
+  program->accept(executor);
+
+  EXPECT_EQ(executor.getStandardOut(), "15.000000\n1.000000\n1.000000\n2.000000\n");
+  EXPECT_EQ(executor.getMemoTable()->getSize(), 2);
+  EXPECT_EQ(executor.getMemoTable()->getEvictions(), 2);
+  EXPECT_EQ(executor.getMemoTable()->getHits(), 0);
+}
+
+void runMemoized(const std::string& code, const std::string& cachePath, Executor& executor)
+{
+  std::stringstream stream{code};
+  Parser parser{stream};
+  auto program = parser.parseProgram();
+
+  registerMemoizableFunctions(*executor.getMemoTable(), *program);
+  executor.getMemoTable()->load(cachePath);
+  program->accept(executor);
+  ASSERT_TRUE(executor.getMemoTable()->save(cachePath));
+}
+
+TEST(ExecutorTest, PersistentMemoCache)
+{
+  std::string source = R"SRC(
+  fn sq(x: f32): f32 { ret x * x; }
+  fn quad(x: f32): f32 { ret sq(sq(x)); }
+
+  fn main(): f32
+  {
+    print("" : quad(3));
+    ret 0;
+  }
+  )SRC";
+
+  std::string changed = R"SRC(
+  fn sq(x: f32): f32 { ret x * x * 1; }
+  fn quad(x: f32): f32 { ret sq(sq(x)); }
+
+  fn main(): f32
+  {
+    print("" : quad(3));
+    ret 0;
+  }
+  )SRC";
+
+  const auto cachePath = testing::TempDir() + "lil_memo_cache_test";
+  std::remove(cachePath.c_str());
+
+  ExecutorOptions options{};
+  options.memoize = true;
+
+  Executor first{options};
+  runMemoized(source, cachePath, first);
+  EXPECT_EQ(first.getMemoTable()->getHits(), 0);
+  EXPECT_EQ(first.getMemoTable()->getMisses(), 3);
+
+  Executor second{options};
+  runMemoized(source, cachePath, second);
+  EXPECT_EQ(second.getStandardOut(), "81.000000\n");
+  EXPECT_EQ(second.getMemoTable()->getHits(), 1);
+  EXPECT_EQ(second.getMemoTable()->getMisses(), 0);
+
+  // Change of callee invalidates entries of both functions.
+  Executor third{options};
+  runMemoized(changed, cachePath, third);
+  EXPECT_EQ(third.getStandardOut(), "81.000000\n");
+  EXPECT_EQ(third.getMemoTable()->getHits(), 0);
+  EXPECT_EQ(third.getMemoTable()->getMisses(), 3);
+
+  std::remove(cachePath.c_str());
+}
+
+TEST(ExecutorTest, PersistentMemoCacheSkipsStaleEntries)
+{
+  std::string source = R"SRC(
+  fn sq(x: f32): f32 { ret x * x; }
+  fn quad(x: f32): f32 { ret sq(sq(x)); }
+  fn cube(x: f32): f32 { ret x * x * x; }
+
+  fn main(): f32
+  {
+    print("" : quad(3));
+    print("" : cube(1) + cube(2) + cube(3));
+    ret 0;
+  }
+  )SRC";
+
+  std::string removed = R"SRC(
+  fn sq(x: f32): f32 { ret x * x; }
+  fn quad(x: f32): f32 { ret sq(sq(x)); }
+
+  fn main(): f32
+  {
+    print("" : quad(3));
+    ret 0;
+  }
+  )SRC";
+
+  const auto cachePath = testing::TempDir() + "lil_memo_stale_cache_test";
+  std::remove(cachePath.c_str());
+
+  ExecutorOptions options{};
+  options.memoize = true;
+
+  Executor first{options};
+  runMemoized(source, cachePath, first);
+  EXPECT_EQ(first.getMemoTable()->getSize(), 6);
+
+  // Entries of cube are the most recently used, but no longer belong to any function.
+  options.memoCapacity = 3;
+  Executor second{options};
+  runMemoized(removed, cachePath, second);
+  EXPECT_EQ(second.getStandardOut(), "81.000000\n");
+  EXPECT_EQ(second.getMemoTable()->getHits(), 1);
+  EXPECT_EQ(second.getMemoTable()->getMisses(), 0);
+  EXPECT_EQ(second.getMemoTable()->getEvictions(), 0);
+
+  std::remove(cachePath.c_str());
+}
+
+void testStrictProgram(const std::string& code, const std::string& out, int status)
+{
+  std::stringstream stream{code};
+  Parser parser{stream};
+  auto program = parser.parseProgram();
+
+  ExecutorOptions options{};
+  options.strict = true;
+  Executor executor{options};
+  program->accept(executor);
+
+  EXPECT_EQ(executor.getStandardOut(), out);
+  EXPECT_EQ(executor.getExitCode(), status);
+  testProgram(code, out, status);
+}
+
+TEST(ExecutorTest, StrictEvaluationMatchesLazy)
+{
+  std::string source = R"SRC(
+  let base: f32 = 2;
+
+  fn loud(x: f32): f32 { print("forced"); ret x; }
+  fn scale(x: f32, factor: f32): f32 { ret x * factor; }
+  fn show(label: f32, x: f32): void { print("" : label : x); }
+  fn reset(): void { n = base * 3; }
+  fn check(n: f32): f32 { reset(); ret n; }
+
+  fn main(): f32
+  {
+    let x: f32 = 3;
+    let y: f32 = loud(x * 2 + 2 * (3 - 1));
+    let f: function = \(a: f32): f32 = { ret a + x; };
+    x = base + 8;
+    x += 1;
+    show("value " : y : " ", scale(x, -base));
+    print("" : f(1) : " " : check(1) : " " : (\(a: f32): f32 = { ret a * 2; })(y));
+    ret x;
+  }
+  )SRC";
+
+  testStrictProgram(source, "value 10.000000 -22.000000\n4.000000 6.000000 20.000000\n", 11);
+}
+
+TEST(ExecutorTest, StrictBindingsDoNotChangeLiveContext)
+{
+  std::string source = R"SRC(
+  let g: f32 = 1;
+
+  fn bump(): f32 { g = 5; ret 0; }
+  fn add(x: f32): f32 { g += x; ret g; }
+  fn twice(x: f32): f32 { ret x + x; }
+
+  fn main(): f32
+  {
+    let a: f32 = bump();
+    print("" : a : " " : g);
+    let b: f32 = 2;
+    print("" : twice(add(3)) : " " : g : " " : b);
+    ret g;
+  }
+  )SRC";
+
+  testStrictProgram(source, "0.000000 1.000000\n8.000000 1.000000 2.000000\n", 1);
+}
+
+TEST(ExecutorTest, LiteralAndVariableArgumentsAreBoundDirectly)
+{
+  std::string source = R"SRC(
+  fn id(x: f32): f32 { ret x; }
+  fn apply(f: function, y: f32): f32 { ret f(2) + y; }
+  fn square(x: f32): f32 { ret x * x; }
+  fn shift(n: f32): f32 { n = a + 1; ret n; }
+
+  fn main(): f32
+  {
+    let a: f32 = 5;
+    let t: f32 = id(id(a));
+    print("" : id(3) : " " : t : " " : apply(square, a) : " " : shift(a) : " " : id("text"));
+    a = 7;
+    print("" : t : " " : id(a));
+    ret 0;
+  }
+  )SRC";
+
+  testProgram(source, "3.000000 5.000000 9.000000 6.000000 text\n5.000000 7.000000\n", 0);
+}
+
+TEST(ExecutorTest, CallSitesCacheTheirCallee)
+{
+  std::string source = R"SRC(
+  fn apply(f: function): f32 { ret f(3); }
+  fn pair(a: f32, b: f32): f32 { ret a + b; }
+  fn twice(x: f32): f32 { ret 2 * x; }
+
+  fn main(): f32
+  {
+    print("" : apply(twice) : " " : apply(twice) : " " : apply(\(a: f32): f32 = { ret a - 1; }));
+    ret apply(pair);
+  }
+  )SRC";
+
+  std::stringstream stream{source};
+  Parser parser{stream};
+  auto program = parser.parseProgram();
+
+  // Arity is still checked when the call site gets a different callee.
+  Executor executor{};
+  EXPECT_THROW(program->accept(executor), std::runtime_error);
+
+  // Call site keeps the last callee which passed the check, that is the lambda.
+  const auto& functions = program->getFunctions();
+  const auto& apply = *functions.front()->getBody()->getStatements().front();
+  const auto& call = static_cast<const CallNode&>(static_cast<const ReturnNode&>(apply).getValue());
+  ASSERT_NE(call.getCachedCallee(), nullptr);
+  for(const auto& function : functions)
+    EXPECT_NE(call.getCachedCallee(), function->getBody().get());
+
+  source.replace(source.find("ret apply(pair)"), 15, "ret apply(twice)");
+  testProgram(source, "6.000000 6.000000 2.000000\n", 6);
+}
+
+TEST(ExecutorTest, AssignedValueIsEvaluatedOnce)
+{
+  std::string source = R"SRC(
+  fn sq(x: f32): f32 { ret x * x; }
+  fn bump(x: f32): f32 { x = x + sq(2); ret x + x + x; }
+  fn reset(x: f32): f32 { x = sq(3); ret x + x; }
+
+  fn main(): f32
+  {
+    let x: f32 = 1;
+    print("" : bump(x));
+    print("" : reset(x));
+    ret 0;
+  }
+  )SRC";
+
+  std::stringstream stream{source};
+  Parser parser{stream};
+  auto program = parser.parseProgram();
+
+  ExecutorOptions options{};
+  options.profile = std::make_shared<Profile>();
+  Executor executor{options};
+  program->accept(executor);
+  EXPECT_EQ(executor.getStandardOut(), "15.000000\n18.000000\n");
+
+  // Value of a reassigned parameter is kept after the first of its reads.
+  const auto& bump = *std::next(program->getFunctions().begin());
+  const auto& assignment = static_cast<const AssignmentNode&>(*bump->getBody()->getStatements().front());
+  const auto& value = static_cast<const BinaryOpNode&>(*assignment.getValue());
+  EXPECT_EQ(options.profile->getCalls(value.getRightOperand()), 1u);
+
+  const auto& reset = *std::next(program->getFunctions().begin(), 2);
+  const auto& resetAssignment = static_cast<const AssignmentNode&>(*reset->getBody()->getStatements().front());
+  EXPECT_EQ(options.profile->getCalls(*resetAssignment.getValue()), 1u);
+}
+
+TEST(ExecutorTest, VariableWhichDependsOnItselfIsReported)
+{
+  // Programs cannot bind such variables, they capture their context before they are added to it.
+  const auto context = std::make_shared<Context>();
+  context->enterScope();
+  int line = 4;
+  for(const auto& binding : {std::make_pair("x", "y + 1"), std::make_pair("y", "\n\n2 * x")})
+  {
+    std::stringstream stream{binding.second};
+    Parser parser{stream};
+    auto symbol = std::make_shared<RuntimeVariableSymbol>(binding.first, TypeName::F32,
+      parser.parseLogicalExpression(), context, nullptr);
+    symbol->setMark(Mark{line++, 3});
+    context->addSymbol(binding.first, std::move(symbol));
+  }
+
+  std::string error{};
+  std::string output{};
+  {
+    Executor executor{*context};
+    VariableNode x{"x"};
+    try
+    {
+      x.accept(executor);
+    }
+    catch(std::runtime_error& e)
+    {
+      error = e.what();
+    }
+
+    // Variables forced by the failed evaluation are no longer marked.
+    ValueChanger changer{std::make_shared<NumericLiteralNode>(2), Mark{}};
+    context->lookup("y").value().get().accept(changer);
+    std::stringstream stream{"print(\"\" : x)"};
+    Parser parser{stream};
+    parser.parseLogicalExpression()->accept(executor);
+    output = executor.getStandardOut();
+  }
+  context->leaveScope();
+
+  EXPECT_EQ(error, "ERROR (Ln: 4, Col: 3): Value of variable depends on itself (<<loop>>)!");
+  EXPECT_EQ(output, "3.000000\n");
+}
@@ -0,0 +1,60 @@
+#include <gtest/gtest.h>
+#include <sstream>
+
+#include "AST.hpp"
+#include "Parser.hpp"
+#include "IntegerRangeAnalyser.hpp"
+
+namespace
+{
+
+std::unique_ptr<ExpressionNode> parseExpression(const std::string& source)
+{
+  std::stringstream stream{source};
+  Parser parser{stream};
+  return parser.parseLogicalExpression();
+}
+
+void testRange(const std::string& source, std::int64_t min, std::int64_t max)
+{
+  const auto expression = parseExpression(source);
+  IntegerRangeAnalyser analyser{};
+  const auto range = analyser.getRange(*expression);
+  ASSERT_TRUE(range.has_value()) << source;
+  EXPECT_EQ(range->min, min) << source;
+  EXPECT_EQ(range->max, max) << source;
+}
+
+void testUnknown(const std::string& source)
+{
+  const auto expression = parseExpression(source);
+  IntegerRangeAnalyser analyser{};
+  EXPECT_FALSE(analyser.getRange(*expression).has_value()) << source;
+}
+
+}
+
+TEST(IntegerRangeAnalyserTest, RangesOfIntegerExpressions)
+{
+  testRange("7", 7, 7);
+  testRange("x & 255", 0, 255);
+  testRange("(x & 15) * 3 + 1", 1, 46);
+  testRange("(x >> 1) & (y & 3 | 6)", 0, 7);
+  testRange("(x & 3) << 4", 0, 48);
+  testRange("~x", 0, 4294967295);
+  testRange("x < y", 0, 1);
+  testRange("if(x, 2, -((y & 3) + 4))", -7, 2);
+  testRange("(x & 255) % 10", 0, 9);
+}
+
+TEST(IntegerRangeAnalyserTest, InexactExpressionsHaveNoRange)
+{
+  testUnknown("x");
+  testUnknown("1.5");
+  testUnknown("(x & 7) / 2");
+  testUnknown("-(x & 3)");
+  testUnknown("(x & 3) * -1");
+  testUnknown("-(x & 7 | 1) % 3");
+  testUnknown("(~x) * (~y) * (~z)");
+  testUnknown("if(x, 1, y)");
+}
@@ -0,0 +1,215 @@
+#include <gtest/gtest.h>
+#include <sstream>
+
+#include "AST.hpp"
+#include "Parser.hpp"
+#include "Executor.hpp"
+#include "ClosureExecutor.hpp"
+#include "JitCompiler.hpp"
+#include "LoopRecognizer.hpp"
+#include "SemanticAnalyser.hpp"
+
+namespace
+{
+
+ExecutorOptions jitOptions()
+{
+  ExecutorOptions options{};
+  options.jit = true;
+  return options;
+}
+
+// Runs the program interpreted and with compiled functions, returns number of compiled functions.
+std::size_t testJitProgram(const std::string& source, const std::string& out, int status)
+{
+  std::stringstream stream{source};
+  Parser parser{stream};
+  auto program = parser.parseProgram();
+
+  Executor original{};
+  program->accept(original);
+
+  Executor executor{jitOptions()};
+  program->accept(executor);
+
+  ClosureExecutor closureExecutor{jitOptions()};
+  program->accept(closureExecutor);
+
+  EXPECT_EQ(original.getStandardOut(), out);
+  EXPECT_EQ(executor.getStandardOut(), out);
+  EXPECT_EQ(closureExecutor.getStandardOut(), out);
+  EXPECT_EQ(original.getExitCode(), status);
+  EXPECT_EQ(executor.getExitCode(), status);
+  EXPECT_EQ(closureExecutor.getExitCode(), status);
+  EXPECT_EQ(executor.getJit()->getCompiled(), closureExecutor.getJit()->getCompiled());
+
+  return executor.getJit()->getCompiled();
+}
+
+}
+
+TEST(JitCompilerTest, CompilesRecursiveFunctions)
+{
+  if(!JitCompiler::isSupported())
+    GTEST_SKIP() << "JIT is not supported on this platform";
+
+  std::string source = R"SRC(
+  fn fact(n: f32): f32 { ret if(n == 0, 1, n * fact(n - 1)); }
+  fn fib(n: f32): f32 { ret if(n < 2, n, fib(n - 1) + fib(n - 2)); }
+  fn cube(x: f32): f32 { ret x * x * x; }
+
+  fn main(): f32
+  {
+    print("" : fact(6) : " " : fib(15) : " " : cube(-1.5));
+    ret fact(4);
+  }
+  )SRC";
+
+  EXPECT_EQ(testJitProgram(source, "720.000000 610.000000 -3.375000\n", 24), 3);
+}
+
+TEST(JitCompilerTest, CompilesLoops)
+{
+  if(!JitCompiler::isSupported())
+    GTEST_SKIP() << "JIT is not supported on this platform";
+
+  std::string source = R"SRC(
+  fn sum(n: f32, acc: f32): f32 { ret if(n == 0, acc, sum(n - 1, acc + n)); }
+  fn count(i: f32, n: f32, step: f32): f32 { ret if(i < n, count(i + step, n, step * 2), i * 1000 + step); }
+
+  fn main(): f32
+  {
+    print("" : sum(1000000, 0) : " " : count(1, 100, 1));
+    ret sum(3, 0);
+  }
+  )SRC";
+
+  std::stringstream stream{source};
+  Parser parser{stream};
+  auto program = parser.parseProgram();
+  SemanticAnalyser semantic{};
+  program->accept(semantic);
+  LoopRecognizer recognizer{};
+  const auto loops = recognizer.clone(*program);
+  ASSERT_EQ(recognizer.getRecognized(), 2);
+
+  // Recursion a million calls deep would overflow the native stack.
+  Executor executor{jitOptions()};
+  loops->accept(executor);
+  EXPECT_EQ(executor.getJit()->getCompiled(), 2);
+  EXPECT_EQ(executor.getStandardOut(), "500000500000.000000 128128.000000\n");
+  EXPECT_EQ(executor.getExitCode(), 6);
+}
+
+TEST(JitCompilerTest, MatchesExecutorForAllOperators)
+{
+  if(!JitCompiler::isSupported())
+    GTEST_SKIP() << "JIT is not supported on this platform";
+
+  std::string source = R"SRC(
+  fn arithmetic(a: f32, b: f32): f32 { ret (a + b) * (a - b) / b + -a; }
+  fn modulo(a: f32, b: f32): f32 { ret a % b; }
+  fn compare(a: f32, b: f32): f32 { ret (a < b) + 2 * (a <= b) + 4 * (a > b) + 8 * (a >= b) + 16 * (a == b) + 32 * (a != b); }
+  fn logical(a: f32, b: f32): f32 { ret (a && b) + 2 * (a || b) + 4 * (!a); }
+  fn choose(a: f32, b: f32, c: f32): f32 { ret if(a, b + c, c - b); }
+
+  fn main(): f32
+  {
+    print("" : arithmetic(7, 2) : " " : arithmetic(1, 0) : " " : arithmetic(0, 0));
+    print("" : modulo(7.5, 2) : " " : modulo(-7, 3) : " " : modulo(7, 0));
+    print("" : compare(1, 2) : " " : compare(2, 1) : " " : compare(3, 3) : " " : compare(0 / 0, 1));
+    print("" : logical(0, 0) : " " : logical(0.5, 0) : " " : logical(-1, 2) : " " : logical(0 / 0, 0));
+    print("" : choose(0.00001, 1, 2) : " " : choose(-1, 1, 2) : " " : choose(0 / 0, 1, 2));
+    ret 0;
+  }
+  )SRC";
+
+  std::stringstream expected{};
+  {
+    std::stringstream stream{source};
+    Parser parser{stream};
+    auto program = parser.parseProgram();
+    Executor executor{};
+    program->accept(executor);
+    expected << executor.getStandardOut();
+  }
+
+  EXPECT_EQ(testJitProgram(source, expected.str(), 0), 5);
+}
+
+TEST(JitCompilerTest, LeavesOtherFunctionsToInterpreter)
+{
+  if(!JitCompiler::isSupported())
+    GTEST_SKIP() << "JIT is not supported on this platform";
+
+  std::string source = R"SRC(
+  let offset: f32 = 10;
+
+  fn square(x: f32): f32 { ret x * x; }
+  fn shifted(x: f32): f32 { ret square(x) + offset; }
+  fn loud(x: f32): f32 { print("called"); ret x; }
+  fn twice(x: f32): f32 { let y: f32 = x * 2; ret y; }
+  fn viaLoud(x: f32): f32 { ret loud(x) + square(x); }
+  fn second(a: f32, b: f32): f32 { ret b; }
+  fn hang(): f32 { ret hang(); }
+
+  fn main(): f32
+  {
+    let lazy: f32 = hang();
+    print("" : shifted(3) : " " : twice(4) : " " : viaLoud(2) : " " : second(lazy, 5));
+    ret square(3);
+  }
+  )SRC";
+
+  // Only square and hang are numeric, pure, strict and return an expression straight away.
+  EXPECT_EQ(testJitProgram(source, "called\n19.000000 8.000000 6.000000 5.000000\n", 9), 2);
+}
+
+TEST(JitCompilerTest, MemoizationTakesPrecedence)
+{
+  if(!JitCompiler::isSupported())
+    GTEST_SKIP() << "JIT is not supported on this platform";
+
+  std::stringstream stream{R"SRC(
+  fn fib(n: f32): f32 { ret if(n < 2, n, fib(n - 1) + fib(n - 2)); }
+  fn main(): f32 { ret fib(30); }
+  )SRC"};
+  Parser parser{stream};
+  auto program = parser.parseProgram();
+
+  auto options = jitOptions();
+  options.memoize = true;
+  Executor executor{options};
+  program->accept(executor);
+
+  EXPECT_EQ(executor.getExitCode(), 832040);
+  EXPECT_EQ(executor.getJit()->getCompiled(), 2);
+  EXPECT_GT(executor.getMemoTable()->getHits(), 0);
+}
+
+TEST(JitCompilerTest, LooksUpOnlyCompiledBodies)
+{
+  std::stringstream stream{R"SRC(
+  fn add(a: f32, b: f32): f32 { ret a + b; }
+  fn main(): f32 { print("main"); ret add(1, 2); }
+  )SRC"};
+  Parser parser{stream};
+  auto program = parser.parseProgram();
+
+  JitCompiler jit{};
+  jit.compile(*program);
+
+  const auto& functions = program->getFunctions();
+  EXPECT_EQ(jit.lookup(functions.back()->getBody().get()), nullptr);
+  if(!JitCompiler::isSupported())
+  {
+    EXPECT_EQ(jit.getCompiled(), 0);
+    return;
+  }
+
+  const auto add = jit.lookup(functions.front()->getBody().get());
+  ASSERT_NE(add, nullptr);
+  const double arguments[] = {1.5, 2.25};
+  EXPECT_EQ(add(arguments), 3.75);
+  EXPECT_GT(jit.getCodeSize(), 0);
+}
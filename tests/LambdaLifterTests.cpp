@@ -0,0 +1,110 @@
+#include <gtest/gtest.h>
+#include <sstream>
+
+#include "AST.hpp"
+#include "Parser.hpp"
+#include "SemanticAnalyser.hpp"
+#include "LambdaLifter.hpp"
+#include "Executor.hpp"
+
+void testLifting(const std::string& source, const std::string& out, std::size_t lifted)
+{
+  std::stringstream stream{source};
+  Parser parser{stream};
+  auto program = parser.parseProgram();
+
+  SemanticAnalyser semantic{};
+  program->accept(semantic);
+
+  LambdaLifter lifter{};
+  auto transformed = lifter.clone(*program);
+  EXPECT_EQ(lifter.getLifted(), lifted);
+  EXPECT_EQ(transformed->getFunctions().size(), program->getFunctions().size() + lifted);
+
+  Executor original{};
+  program->accept(original);
+
+  Executor executor{};
+  transformed->accept(executor);
+
+  EXPECT_EQ(original.getStandardOut(), out);
+  EXPECT_EQ(executor.getStandardOut(), out);
+  EXPECT_EQ(executor.getExitCode(), original.getExitCode());
+}
+
+TEST(LambdaLifterTest, CalledLambdaIsLifted)
+{
+  std::string source = R"SRC(
+  fn square(x: f32): f32 { ret x * x; }
+
+  fn f(a: f32): f32
+  {
+    let k: f32 = a * 2;
+    let g: function = \(x: f32): f32 = { let y: f32 = square(x); ret y + k; };
+    ret g(1) + g(2);
+  }
+
+  fn main(): f32
+  {
+    print("" : f(3));
+    ret 0;
+  }
+  )SRC";
+
+  testLifting(source, "17.000000\n", 1);
+}
+
+TEST(LambdaLifterTest, EscapingLambdaIsNotLifted)
+{
+  std::string source = R"SRC(
+  fn makeMul(m: f32): function
+  {
+    let mul: function = \(x: f32): f32 = { ret m * x; };
+    ret mul;
+  }
+
+  fn apply(f: function): f32 { ret f(4); }
+
+  fn main(): f32
+  {
+    let inc: function = \(x: f32): f32 = { ret x + 1; };
+    print("" : makeMul(2)(4));
+    print("" : apply(inc));
+    ret 0;
+  }
+  )SRC";
+
+  testLifting(source, "8.000000\n5.000000\n", 0);
+}
+
+TEST(LambdaLifterTest, LambdaCapturingAssignedVariableIsNotLifted)
+{
+  std::string source = R"SRC(
+  fn main(): f32
+  {
+    let k: f32 = 1;
+    let g: function = \(x: f32): f32 = { ret x + k; };
+    k += 10;
+    print("" : g(1) : " " : k);
+    ret 0;
+  }
+  )SRC";
+
+  testLifting(source, "2.000000 11.000000\n", 0);
+}
+
+TEST(LambdaLifterTest, LambdaCallingImpureFunctionIsNotLifted)
+{
+  std::string source = R"SRC(
+  fn show(x: f32): void { print("" : x); }
+
+  fn main(): f32
+  {
+    let g: function = \(x: f32): void = { show(x * 2); };
+    g(4);
+    ret 0;
+  }
+  )SRC";
+
+  testLifting(source, "8.000000\n", 0);
+}
@@ -0,0 +1,156 @@
+#include <gtest/gtest.h>
+#include <sstream>
+
+#include "AST.hpp"
+#include "Parser.hpp"
+#include "SemanticAnalyser.hpp"
+#include "LoopRecognizer.hpp"
+#include "PassManager.hpp"
+#include "Executor.hpp"
+#include "StackExecutor.hpp"
+#include "ClosureExecutor.hpp"
+#include "StgExecutor.hpp"
+
+std::unique_ptr<ProgramNode> recognizeLoops(const std::string& source, std::size_t recognized)
+{
+  std::stringstream stream{source};
+  Parser parser{stream};
+  auto program = parser.parseProgram();
+
+  SemanticAnalyser semantic{};
+  program->accept(semantic);
+
+  LoopRecognizer recognizer{};
+  auto transformed = recognizer.clone(*program);
+  EXPECT_EQ(recognizer.getRecognized(), recognized);
+  return transformed;
+}
+
+void testLoops(const std::string& source, const std::string& out, std::size_t recognized)
+{
+  std::stringstream stream{source};
+  Parser parser{stream};
+  auto program = parser.parseProgram();
+
+  Executor original{};
+  program->accept(original);
+
+  const auto loops = recognizeLoops(source, recognized);
+  Executor executor{};
+  loops->accept(executor);
+  StackExecutor stackExecutor{};
+  loops->accept(stackExecutor);
+  ClosureExecutor closureExecutor{};
+  loops->accept(closureExecutor);
+  StgExecutor stgExecutor{};
+  loops->accept(stgExecutor);
+
+  EXPECT_EQ(original.getStandardOut(), out);
+  EXPECT_EQ(executor.getStandardOut(), out);
+  EXPECT_EQ(stackExecutor.getStandardOut(), out);
+  EXPECT_EQ(closureExecutor.getStandardOut(), out);
+  EXPECT_EQ(stgExecutor.getStandardOut(), out);
+  EXPECT_EQ(executor.getExitCode(), original.getExitCode());
+  EXPECT_EQ(stackExecutor.getExitCode(), original.getExitCode());
+  EXPECT_EQ(closureExecutor.getExitCode(), original.getExitCode());
+  EXPECT_EQ(stgExecutor.getExitCode(), original.getExitCode());
+}
+
+TEST(LoopRecognizerTest, AccumulatorRecursionBecomesLoop)
+{
+  std::string source = R"SRC(
+  fn sum(n: f32, acc: f32): f32 { ret if(n == 0, acc, sum(n - 1, acc + n)); }
+  fn count(i: f32, n: f32, step: f32): f32 { ret if(i < n, count(i + step, n, step * 2), i * 1000 + step); }
+
+  fn main(): f32
+  {
+    print("sum " : sum(100, 0));
+    print("count " : count(1, 100, 1));
+    ret sum(3, 0) - 6;
+  }
+  )SRC";
+
+  testLoops(source, "sum 5050.000000\ncount 128128.000000\n", 2);
+}
+
+TEST(LoopRecognizerTest, LoopsDoNotGrowTheStack)
+{
+  std::string source = R"SRC(
+  fn sum(n: f32, acc: f32): f32 { ret if(n == 0, acc, sum(n - 1, acc + n)); }
+
+  fn main(): f32
+  {
+    print("" : sum(1000000, 0));
+    ret 0;
+  }
+  )SRC";
+
+  const auto loops = recognizeLoops(source, 1);
+  Executor executor{};
+  loops->accept(executor);
+  EXPECT_EQ(executor.getStandardOut(), "500000500000.000000\n");
+
+  ClosureExecutor closureExecutor{};
+  loops->accept(closureExecutor);
+  EXPECT_EQ(closureExecutor.getStandardOut(), "500000500000.000000\n");
+
+  // Engines with their own stacks do not push a frame per iteration either.
+  StackExecutor stackExecutor{};
+  loops->accept(stackExecutor);
+  EXPECT_EQ(stackExecutor.getStandardOut(), "500000500000.000000\n");
+  EXPECT_LT(stackExecutor.getMaxDepth(), 100);
+
+  StgExecutor stgExecutor{};
+  loops->accept(stgExecutor);
+  EXPECT_EQ(stgExecutor.getStandardOut(), "500000500000.000000\n");
+  EXPECT_LT(stgExecutor.getMaxDepth(), 100);
+}
+
+TEST(LoopRecognizerTest, LoopsAreKeptByLaterPasses)
+{
+  std::string source = R"SRC(
+  fn sum(n: f32, acc: f32): f32 { ret if(n == 0, acc, sum(n - 1, acc + n)); }
+
+  fn main(): f32
+  {
+    print("" : sum(1000000, 0));
+    ret 0;
+  }
+  )SRC";
+
+  std::stringstream stream{source};
+  Parser parser{stream};
+  auto program = parser.parseProgram();
+
+  PassManager passes{};
+  const auto names = PassManager::getLevel(2).value();
+  for(const auto& name : names)
+    ASSERT_TRUE(passes.add(name));
+  passes.getAnalyses().get<SemanticAnalyser>(*program);
+  program = passes.run(std::move(program));
+
+  Executor executor{};
+  program->accept(executor);
+  EXPECT_EQ(executor.getStandardOut(), "500000500000.000000\n");
+}
+
+TEST(LoopRecognizerTest, OnlyStrictTailRecursionBecomesLoop)
+{
+  std::string source = R"SRC(
+  fn fact(n: f32): f32 { ret if(n == 0, 1, n * fact(n - 1)); }
+  fn skip(n: f32, unused: f32): f32 { ret if(n == 0, 0, skip(n - 1, unused + 1)); }
+  fn both(n: f32): f32 { ret if(n > 10, both(n - 1), both(n + 1)); }
+  fn free(n: f32): f32 { ret if(n == 0, 0, free(n - k)); }
+  let k: f32 = 1;
+
+  fn main(): f32
+  {
+    print("" : fact(5));
+    print("" : skip(3, 7));
+    print("" : free(4));
+    ret 0;
+  }
+  )SRC";
+
+  testLoops(source, "120.000000\n0.000000\n0.000000\n", 0);
+}
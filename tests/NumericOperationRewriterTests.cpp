@@ -0,0 +1,148 @@
+#include <gtest/gtest.h>
+#include <sstream>
+
+#include "AST.hpp"
+#include "Parser.hpp"
+#include "SemanticAnalyser.hpp"
+#include "NumericOperationRewriter.hpp"
+#include "Executor.hpp"
+
+void testRewriting(const std::string& source, const std::string& out, std::size_t rewritten)
+{
+  std::stringstream stream{source};
+  Parser parser{stream};
+  auto program = parser.parseProgram();
+
+  SemanticAnalyser semantic{};
+  program->accept(semantic);
+
+  NumericOperationRewriter rewriter{semantic.getTypes()};
+  auto transformed = rewriter.clone(*program);
+  EXPECT_EQ(rewriter.getRewritten(), rewritten);
+
+  Executor original{};
+  program->accept(original);
+
+  Executor executor{};
+  transformed->accept(executor);
+
+  EXPECT_EQ(original.getStandardOut(), out);
+  EXPECT_EQ(executor.getStandardOut(), out);
+  EXPECT_EQ(executor.getExitCode(), original.getExitCode());
+}
+
+TEST(NumericOperationRewriterTest, NumericOperationsAreRewritten)
+{
+  std::string source = R"SRC(
+  fn fib(n: f32): f32
+  {
+    ret if(n < 2, n, fib(n - 1) + fib(n - 2));
+  }
+
+  fn main(): f32
+  {
+    let x: f32 = 7 % 4;
+    print("fib: " : fib(10) : " " : (x << 2 | 1));
+    ret 0;
+  }
+  )SRC";
+
+  testRewriting(source, "fib: 55.000000 13.000000\n", 7);
+}
+
+TEST(NumericOperationRewriterTest, UnknownTypesUseGenericOperation)
+{
+  std::string source = R"SRC(
+  fn main(): f32
+  {
+    let g: function = \(x: f32): f32 = { ret x * 2; };
+    print("" : g(2) + 1 : " " : (\(y: f32): f32 = { ret y - 1; })(3) * 2);
+    ret 0;
+  }
+  )SRC";
+
+  testRewriting(source, "5.000000 4.000000\n", 3);
+}
+
+TEST(NumericOperationRewriterTest, DynamicallyScopedFunctionFallsBack)
+{
+  std::string source = R"SRC(
+  let v: f32 = 1;
+
+  fn next(): f32 { ret v + 1; }
+  fn wrap(v: function): f32 { ret next(); }
+
+  fn main(): f32
+  {
+    print("" : wrap(next));
+    ret 0;
+  }
+  )SRC";
+
+  std::stringstream stream{source};
+  Parser parser{stream};
+  auto program = parser.parseProgram();
+
+  SemanticAnalyser semantic{};
+  program->accept(semantic);
+
+  NumericOperationRewriter rewriter{semantic.getTypes()};
+  auto transformed = rewriter.clone(*program);
+  EXPECT_EQ(rewriter.getRewritten(), 1);
+
+  const auto runtimeError = [](const ProgramNode& node) {
+    try
+    {
+      Executor executor{};
+      node.accept(executor);
+    }
+    catch(std::runtime_error& error)
+    {
+      return std::string{error.what()};
+    }
+    return std::string{};
+  };
+
+  EXPECT_FALSE(runtimeError(*program).empty());
+  EXPECT_EQ(runtimeError(*transformed), runtimeError(*program));
+}
+
+TEST(NumericOperationRewriterTest, IntegerOperationsMatchNumericOnes)
+{
+  std::string source = R"SRC(
+  fn bits(x: f32): f32 { ret ((x & 255) << 3 | 5) ^ (x >> 2 & 7); }
+  fn sign(x: f32): f32 { ret (x & 1) * -1; }
+
+  fn main(): f32
+  {
+    let top: f32 = (1 << 31) << 1;
+    print("" : bits(1000) : " " : bits(7.5) : " " : sign(2) : " " : top : " " : (~0 >> 28) + 7 % 4 * 2);
+    ret (3 > 2) + (2 ^ 7) * 3;
+  }
+  )SRC";
+
+  std::stringstream stream{source};
+  Parser parser{stream};
+  auto program = parser.parseProgram();
+
+  SemanticAnalyser semantic{};
+  program->accept(semantic);
+
+  NumericOperationRewriter rewriter{semantic.getTypes()};
+  auto transformed = rewriter.clone(*program);
+  EXPECT_EQ(rewriter.getRewritten(), 18);
+  EXPECT_EQ(rewriter.getIntegers(), 14);
+
+  Executor original{};
+  program->accept(original);
+
+  Executor executor{};
+  transformed->accept(executor);
+
+  // Negative zero is not an integer, so the sign is kept.
+  const auto out = "1863.000000 60.000000 -0.000000 0.000000 6.000000\n";
+  EXPECT_EQ(original.getStandardOut(), out);
+  EXPECT_EQ(executor.getStandardOut(), out);
+  EXPECT_EQ(original.getExitCode(), 16);
+  EXPECT_EQ(executor.getExitCode(), 16);
+}
@@ -0,0 +1,118 @@
+#include <gtest/gtest.h>
+#include <sstream>
+
+#include "AST.hpp"
+#include "Parser.hpp"
+#include "SemanticAnalyser.hpp"
+#include "Executor.hpp"
+#include "PassManager.hpp"
+
+namespace
+{
+
+const std::string Source = R"SRC(
+  let unused: f32 = 42;
+
+  fn sq(x: f32): f32 { ret x * x; }
+  fn unreachable(): f32 { ret 1; }
+
+  fn main(): f32
+  {
+    let n: f32 = 5;
+    let add: function = \(a: f32, b: f32): f32 = { ret a + b; };
+    print("" : add(sq(n) * 2, sq(n) * 2));
+    print("" : sq(3));
+    ret 0;
+  }
+  )SRC";
+
+std::unique_ptr<ProgramNode> parseProgram(const std::string& source)
+{
+  std::stringstream stream{source};
+  Parser parser{stream};
+  return parser.parseProgram();
+}
+
+}
+
+TEST(PassManagerTest, LevelsRunTheirPassesInOrder)
+{
+  Executor original{};
+  parseProgram(Source)->accept(original);
+  EXPECT_EQ(original.getStandardOut(), "100.000000\n9.000000\n");
+
+  for(int level = 0; level <= 3; ++level)
+  {
+    PassManager passes{};
+    const auto names = PassManager::getLevel(level).value();
+    for(const auto& name : names)
+      EXPECT_TRUE(passes.add(name));
+
+    auto program = parseProgram(Source);
+    passes.getAnalyses().get<SemanticAnalyser>(*program);
+    program = passes.run(std::move(program));
+
+    const auto& reports = passes.getReports();
+    ASSERT_EQ(reports.size(), names.size());
+    for(std::size_t i = 0; i < reports.size(); ++i)
+    {
+      EXPECT_EQ(reports[i].name, names[i]);
+      EXPECT_GE(reports[i].milliseconds, 0.0);
+      if(i > 0)
+      {
+        EXPECT_EQ(reports[i].nodesBefore, reports[i - 1].nodesAfter);
+      }
+    }
+    if(!reports.empty())
+    {
+      EXPECT_EQ(reports.back().nodesAfter, countNodes(*program));
+    }
+
+    Executor executor{};
+    program->accept(executor);
+    EXPECT_EQ(executor.getStandardOut(), original.getStandardOut());
+    EXPECT_EQ(executor.getExitCode(), original.getExitCode());
+  }
+
+  EXPECT_EQ(PassManager::getLevel(3).value().back(), "dce");
+  EXPECT_FALSE(PassManager::getLevel(4).has_value());
+}
+
+TEST(PassManagerTest, DeadCodeEliminationShrinksProgram)
+{
+  PassManager passes{};
+  ASSERT_TRUE(passes.add("dce"));
+  EXPECT_FALSE(passes.add("unknown"));
+  EXPECT_FALSE(passes.add("numeric"));
+
+  auto program = parseProgram(Source);
+  const auto nodes = countNodes(*program);
+  program = passes.run(std::move(program));
+
+  const auto& report = passes.getReports().front();
+  EXPECT_EQ(report.nodesBefore, nodes);
+  EXPECT_LT(report.nodesAfter, nodes);
+  EXPECT_EQ(report.summary, "1 functions, 0 variables, 0 statements removed");
+}
+
+TEST(PassManagerTest, AnalysesAreKeptUntilProgramChanges)
+{
+  std::string source = R"SRC(
+  fn sq(x: f32): f32 { ret x * x; }
+  fn main(): f32 { ret sq(2) + 1; }
+  )SRC";
+
+  PassManager passes{};
+  for(const auto& name : {"numeric", "lift-lambdas", "cse"})
+    ASSERT_TRUE(passes.add(name));
+
+  auto program = parseProgram(source);
+  passes.getAnalyses().get<SemanticAnalyser>(*program);
+  program = passes.run(std::move(program));
+
+  // Rewriter reuses semantic analysis, purity analysed for the rewritten program is reused by cse,
+  // since lifting found nothing to lift.
+  EXPECT_EQ(passes.getAnalyses().getComputed(), 2);
+  EXPECT_EQ(passes.getAnalyses().getReused(), 2);
+  EXPECT_EQ(passes.getReports()[1].summary, "0 lambdas lifted");
+}
@@ -0,0 +1,217 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+#include "AST.hpp"
+#include "Parser.hpp"
+#include "SemanticAnalyser.hpp"
+#include "Executor.hpp"
+#include "Inliner.hpp"
+#include "Profile.hpp"
+#include "Specializer.hpp"
+
+namespace
+{
+
+std::unique_ptr<ProgramNode> parseProgram(const std::string& source)
+{
+  std::stringstream stream{source};
+  Parser parser{stream};
+  auto program = parser.parseProgram();
+
+  SemanticAnalyser semantic{};
+  program->accept(semantic);
+  return program;
+}
+
+// Runs the program with the tree engine and loads the profile it recorded back from a file.
+std::shared_ptr<Profile> recordProfile(const ProgramNode& program, const std::string& path)
+{
+  ExecutorOptions options{};
+  options.profile = std::make_shared<Profile>();
+  Executor executor{options};
+  program.accept(executor);
+  EXPECT_TRUE(options.profile->save(path));
+
+  auto profile = std::make_shared<Profile>();
+  EXPECT_TRUE(profile->load(path));
+  return profile;
+}
+
+std::string readFile(const std::string& path)
+{
+  std::ifstream file{path};
+  std::stringstream content{};
+  content << file.rdbuf();
+  return content.str();
+}
+
+std::string findLine(const std::string& content, const std::string& prefix)
+{
+  std::stringstream lines{content};
+  std::string line{};
+  while(std::getline(lines, line))
+  {
+    if(line.rfind(prefix, 0) == 0)
+      return line;
+  }
+  return "";
+}
+
+void expectSameResult(const ProgramNode& original, const ProgramNode& transformed, const ExecutorOptions& options)
+{
+  Executor expected{};
+  original.accept(expected);
+
+  Executor executor{options};
+  transformed.accept(executor);
+
+  EXPECT_EQ(executor.getStandardOut(), expected.getStandardOut());
+  EXPECT_EQ(executor.getExitCode(), expected.getExitCode());
+}
+
+}
+
+TEST(ProfileTest, ProfileIsStableAndSurvivesEdits)
+{
+  std::string source = R"SRC(
+  fn sq(x: f32): f32 { ret x * x; }
+  fn sum(n: f32): f32 { ret if(n == 0, 0, sq(n) + sum(n - 1)); }
+  fn apply(f: function, x: f32): f32 { ret f(3) + x; }
+
+  fn main(): f32
+  {
+    let n: f32 = 10;
+    print("" : apply(sq, sum(n)));
+    ret 0;
+  }
+  )SRC";
+
+  // Reformatted, with the body of main changed and a function added.
+  std::string edited = R"SRC(
+  fn sq(x: f32): f32
+  {
+    ret x * x;
+  }
+
+  fn cube(x: f32): f32 { ret x * x * x; }
+
+  fn sum(n: f32): f32 { ret if(n == 0, 0, sq(n) + sum(n - 1)); }
+  fn apply(f: function, x: f32): f32 { ret f(3) + x; }
+
+  fn main(): f32
+  {
+    print("" : apply(cube, 3));
+    ret 0;
+  }
+  )SRC";
+
+  const auto path = testing::TempDir() + "lil_profile_test";
+  const auto program = parseProgram(source);
+
+  recordProfile(*program, path);
+  const auto first = readFile(path);
+  auto profile = recordProfile(*program, path);
+  EXPECT_EQ(readFile(path), first);
+
+  // sum runs for 10 down to 0, calling sq on each way down and apply calls sq once.
+  EXPECT_NE(findLine(first, "if sum "), "");
+  EXPECT_EQ(findLine(first, "if sum ").substr(findLine(first, "if sum ").size() - 5), " 1 10");
+  EXPECT_NE(findLine(first, "target apply "), "");
+  EXPECT_EQ(findLine(first, "target apply ").substr(findLine(first, "target apply ").size() - 5), " sq 1");
+
+  profile->addProgram(*program);
+  EXPECT_EQ(profile->getMatched(), profile->getSites());
+
+  // Only the three sites of main do not match anymore.
+  const auto editedProgram = parseProgram(edited);
+  profile->addProgram(*editedProgram);
+  EXPECT_EQ(profile->getSites(), 10);
+  EXPECT_EQ(profile->getMatched(), 7);
+
+  std::remove(path.c_str());
+}
+
+TEST(ProfileTest, ProfileGuidesInliningAndSpecialization)
+{
+  std::string source = R"SRC(
+  fn sq(x: f32): f32 { ret x * x; }
+  fn scale(k: f32, x: f32): f32 { ret k * x; }
+  fn sum(n: f32): f32 { ret if(n == 0, 0, sq(n) + sum(n - 1)); }
+
+  fn main(): f32
+  {
+    let n: f32 = 10;
+    let total: f32 = sum(n);
+    print("" : total);
+    print("" : scale(3, total));
+    ret if(total > 1000, scale(2, total), 1);
+  }
+  )SRC";
+
+  const auto path = testing::TempDir() + "lil_profile_inlining_test";
+  const auto program = parseProgram(source);
+  auto profile = recordProfile(*program, path);
+
+  // Only sq(n) ran often enough, sum calls itself.
+  Inliner inliner{profile, 4};
+  const auto inlined = inliner.clone(*program);
+  EXPECT_EQ(inliner.getInlined(), 1);
+  expectSameResult(*program, *inlined, ExecutorOptions{});
+
+  // Call of scale in the branch which was never taken is not specialized.
+  Specializer unguided{};
+  unguided.clone(*inlined);
+  EXPECT_EQ(unguided.getSpecialized(), 2);
+
+  Specializer specializer{64, profile};
+  const auto specialized = specializer.clone(*inlined);
+  EXPECT_EQ(specializer.getSpecialized(), 1);
+  expectSameResult(*program, *specialized, ExecutorOptions{});
+
+  std::remove(path.c_str());
+}
+
+TEST(ProfileTest, ProfileGuidesSpeculationAndBranchLayout)
+{
+  std::string source = R"SRC(
+  fn pick(c: f32, a: f32, b: f32): f32 { ret if(c, a, b); }
+  fn count(n: f32): f32 { ret if(n == 0, 0, pick(1, n + 1, n * 2) + count(n - 1)); }
+  fn sum(n: f32): f32 { ret if(n == 0, 0, n + sum(n - 1)); }
+  fn positive(x: f32): f32 { ret if(x / x, 1, 2); }
+
+  fn main(): f32
+  {
+    print("" : count(20));
+    print("" : sum(20));
+    ret positive(0);
+  }
+  )SRC";
+
+  const auto path = testing::TempDir() + "lil_profile_speculation_test";
+  const auto program = parseProgram(source);
+  auto profile = recordProfile(*program, path);
+
+  ExecutorOptions options{};
+  options.speculate = true;
+  options.jit = true;
+
+  Executor unguided{options};
+  program->accept(unguided);
+  EXPECT_EQ(unguided.getSpeculator()->getDisabled(), 0);
+
+  // Argument b of pick is never forced.
+  options.feedback = profile;
+  Executor executor{options};
+  program->accept(executor);
+  EXPECT_EQ(executor.getSpeculator()->getDisabled(), 1);
+  EXPECT_LT(executor.getSpeculator()->getAttempts(), unguided.getSpeculator()->getAttempts());
+
+  // Compiled ifs with their false branch laid out first, including the one with NaN condition.
+  EXPECT_EQ(executor.getStandardOut(), "230.000000\n210.000000\n");
+  EXPECT_EQ(executor.getExitCode(), 2);
+  expectSameResult(*program, *program, options);
+
+  std::remove(path.c_str());
+}
@@ -0,0 +1,201 @@
+#include <gtest/gtest.h>
+#include <sstream>
+
+#include "AST.hpp"
+#include "Parser.hpp"
+#include "PurityAnalyser.hpp"
+
+void analyse(const std::string& source, PurityAnalyser& analyser)
+{
+  std::stringstream ss{source};
+  Parser parser{ss};
+
+  auto node = parser.parseProgram();
+  node->accept(analyser);
+}
+
+TEST(PurityAnalyserTest, RecursiveNumericFunctionIsMemoizable)
+{
+  std::string source = R"SRC(
+  fn fib(n: f32): f32
+  {
+    ret if(n < 2, n, fib(n - 1) + fib(n - 2));
+  }
+
+  fn main(): f32
+  {
+    print("" : fib(10));
+    ret 0;
+  }
+  )SRC";
+
+  PurityAnalyser analyser{};
+  analyse(source, analyser);
+
+  EXPECT_TRUE(analyser.isPure("fib"));
+  EXPECT_TRUE(analyser.isMemoizable("fib"));
+  EXPECT_FALSE(analyser.isMemoizable("main"));
+}
+
+TEST(PurityAnalyserTest, PrintingMakesFunctionImpure)
+{
+  std::string source = R"SRC(
+  fn log(x: f32): f32
+  {
+    print("" : x);
+    ret x;
+  }
+
+  fn twice(x: f32): f32
+  {
+    ret log(x) * 2;
+  }
+
+  fn main(): f32
+  {
+    ret twice(1);
+  }
+  )SRC";
+
+  PurityAnalyser analyser{};
+  analyse(source, analyser);
+
+  EXPECT_FALSE(analyser.isPure("log"));
+  EXPECT_FALSE(analyser.isPure("twice"));
+}
+
+TEST(PurityAnalyserTest, FunctionArgumentsAreNotMemoizable)
+{
+  std::string source = R"SRC(
+  fn apply(f: function, x: f32): f32
+  {
+    ret x;
+  }
+
+  fn main(): f32
+  {
+    ret 0;
+  }
+  )SRC";
+
+  PurityAnalyser analyser{};
+  analyse(source, analyser);
+
+  EXPECT_TRUE(analyser.isPure("apply"));
+  EXPECT_FALSE(analyser.isMemoizable("apply"));
+}
+
+TEST(PurityAnalyserTest, GlobalVariablesMakeFunctionImpure)
+{
+  std::string source = R"SRC(
+  let g: f32 = 2;
+
+  fn scale(x: f32): f32
+  {
+    ret x * g;
+  }
+
+  fn main(): f32
+  {
+    ret scale(2);
+  }
+  )SRC";
+
+  PurityAnalyser analyser{};
+  analyse(source, analyser);
+
+  EXPECT_FALSE(analyser.isPure("scale"));
+}
+
+TEST(PurityAnalyserTest, ShadowedCalleeMakesFunctionImpure)
+{
+  std::string source = R"SRC(
+  fn sq(x: f32): f32 { ret x * x; }
+  fn quad(x: f32): f32 { ret sq(sq(x)); }
+
+  fn main(): f32
+  {
+    let sq: function = \(y: f32): f32 = { ret y; };
+    ret quad(2);
+  }
+  )SRC";
+
+  PurityAnalyser analyser{};
+  analyse(source, analyser);
+
+  EXPECT_TRUE(analyser.isShadowed("sq"));
+  EXPECT_FALSE(analyser.isPure("quad"));
+}
+
+TEST(PurityAnalyserTest, ClosedFunctionsDoNotReadCallerScope)
+{
+  std::string source = R"SRC(
+  fn show(x: f32): void { print("" : x); }
+  fn scaled(x: f32): f32 { ret x * factor; }
+  fn twice(x: f32): f32 { ret scaled(x) * 2; }
+
+  fn main(): f32
+  {
+    let factor: f32 = 3;
+    show(twice(1));
+    ret 0;
+  }
+  )SRC";
+
+  PurityAnalyser analyser{};
+  analyse(source, analyser);
+
+  EXPECT_TRUE(analyser.isClosed("show"));
+  EXPECT_FALSE(analyser.isPure("show"));
+  EXPECT_FALSE(analyser.isClosed("scaled"));
+  EXPECT_FALSE(analyser.isClosed("twice"));
+  EXPECT_FALSE(analyser.isClosed("main"));
+}
+
+TEST(PurityAnalyserTest, StrictnessFollowsBothBranchesOfIf)
+{
+  std::string source = R"SRC(
+  fn pick(c: f32, a: f32, b: f32): f32 { ret if(c, a, b); }
+  fn both(c: f32, a: f32): f32 { ret if(c, a, a + 1); }
+  fn first(x: f32, y: f32): f32 { let z: f32 = x; ret z; }
+
+  fn main(): f32
+  {
+    ret 0;
+  }
+  )SRC";
+
+  PurityAnalyser analyser{};
+  analyse(source, analyser);
+
+  EXPECT_EQ(analyser.getStrictArguments("pick"), (std::vector<bool>{true, false, false}));
+  EXPECT_EQ(analyser.getStrictArguments("both"), (std::vector<bool>{true, true}));
+  EXPECT_EQ(analyser.getStrictArguments("first"), (std::vector<bool>{true, false}));
+  EXPECT_FALSE(analyser.isMemoizable("pick"));
+}
+
+TEST(PurityAnalyserTest, StrictnessOfAccumulatorRecursion)
+{
+  std::string source = R"SRC(
+  fn sum(n: f32, acc: f32): f32
+  {
+    ret if(n == 0, acc, sum(n - 1, acc + n));
+  }
+
+  fn lazy(n: f32, x: f32): f32
+  {
+    ret if(n == 0, 0, lazy(n - 1, x));
+  }
+
+  fn main(): f32
+  {
+    ret 0;
+  }
+  )SRC";
+
+  PurityAnalyser analyser{};
+  analyse(source, analyser);
+
+  EXPECT_EQ(analyser.getStrictArguments("sum"), (std::vector<bool>{true, true}));
+  EXPECT_EQ(analyser.getStrictArguments("lazy"), (std::vector<bool>{true, false}));
+}
@@ -647,4 +647,37 @@ TEST(SemanticAnalyserTest, InvalidBinaryOperationsThrow)
   }
   )SRC";
   throwTest(source);
-}
\ No newline at end of file
+}
+TEST(SemanticAnalyserTest, ExpressionTypesAreRecorded)
+{
+  std::string source = R"SRC(  
+  fn main(): f32
+  {
+    let g: function = \(x: f32): f32 = { ret x; };
+    print("sum: " : 1 + 2 * 3);
+    ret g(1);
+  }
+  )SRC";
+
+  std::stringstream ss{source};
+  Parser parser{ss};
+
+  auto node = parser.parseProgram();
+  SemanticAnalyser semantic{};
+  node->accept(semantic);
+
+  const auto& statements = node->getFunctions().front()->getBody()->getStatements();
+  auto it = statements.begin();
+  const auto& declaration = static_cast<const VariableDeclarationNode&>(**it++);
+  const auto& print = static_cast<const FunctionCallNode&>(
+    static_cast<const FunctionCallStatementNode&>(**it++).getFunctionCall());
+  const auto& concatenation = static_cast<const BinaryOpNode&>(*print.getArguments().front());
+  const auto& ret = static_cast<const ReturnNode&>(**it);
+
+  TypeChecker checker{semantic.getTypes()};
+  EXPECT_EQ(checker.getType(*declaration.getValue()), TypeName::Function);
+  EXPECT_EQ(checker.getType(print), TypeName::Void);
+  EXPECT_EQ(checker.getType(concatenation), TypeName::String);
+  EXPECT_EQ(checker.getType(concatenation.getRightOperand()), TypeName::F32);
+  EXPECT_FALSE(checker.getType(ret.getValue()).has_value());
+}
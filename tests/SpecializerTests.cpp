@@ -0,0 +1,156 @@
+#include <gtest/gtest.h>
+#include <sstream>
+
+#include "AST.hpp"
+#include "Parser.hpp"
+#include "SemanticAnalyser.hpp"
+#include "Specializer.hpp"
+#include "Executor.hpp"
+
+void testSpecialization(const std::string& source, const std::string& out, std::size_t specialized,
+  std::size_t capacity = 64)
+{
+  std::stringstream stream{source};
+  Parser parser{stream};
+  auto program = parser.parseProgram();
+
+  SemanticAnalyser semantic{};
+  program->accept(semantic);
+
+  Specializer specializer{capacity};
+  auto transformed = specializer.clone(*program);
+  EXPECT_EQ(specializer.getSpecialized(), specialized);
+
+  Executor original{};
+  program->accept(original);
+
+  Executor executor{};
+  transformed->accept(executor);
+
+  EXPECT_EQ(original.getStandardOut(), out);
+  EXPECT_EQ(executor.getStandardOut(), out);
+  EXPECT_EQ(executor.getExitCode(), original.getExitCode());
+}
+
+TEST(SpecializerTest, ConstantIsFoldedIntoReturnedLambda)
+{
+  std::string source = R"SRC(
+  fn makeMul(m: f32): function
+  {
+    ret \(x: f32): f32 = { ret m * x; };
+  }
+
+  fn main(): f32
+  {
+    let double: function = makeMul(2);
+    print("" : double(4) : " " : makeMul(2)(5) : " " : makeMul(3)(5));
+    ret 0;
+  }
+  )SRC";
+
+  testSpecialization(source, "8.000000 10.000000 15.000000\n", 2);
+}
+
+TEST(SpecializerTest, RecursionIsNotUnrolled)
+{
+  std::string source = R"SRC(
+  fn fact(n: f32): f32
+  {
+    ret if(n == 0, 1, n * fact(n - 1));
+  }
+
+  fn sum(n: f32, acc: f32): f32 { ret if(n == 0, acc, sum(n - 1, acc + n)); }
+
+  fn main(): f32
+  {
+    print("" : fact(6));
+    print("" : sum(400, 0));
+    ret 0;
+  }
+  )SRC";
+
+  testSpecialization(source, "720.000000\n80200.000000\n", 2);
+
+  std::stringstream stream{source};
+  Parser parser{stream};
+  auto program = parser.parseProgram();
+  SemanticAnalyser semantic{};
+  program->accept(semantic);
+
+  Specializer specializer{};
+  auto transformed = specializer.clone(*program);
+  std::size_t residuals = 0;
+  for(const auto& function : transformed->getFunctions())
+  {
+    if(function->getName().rfind("sum$", 0) == 0)
+      ++residuals;
+  }
+  EXPECT_EQ(residuals, 1u);
+}
+
+TEST(SpecializerTest, SpecializationsAreLimitedByCapacity)
+{
+  std::string source = R"SRC(
+  fn sq(n: f32): f32 { ret n * n; }
+
+  fn main(): f32
+  {
+    print("" : sq(1) : " " : sq(2) : " " : sq(3) : " " : sq(2));
+    ret 0;
+  }
+  )SRC";
+
+  testSpecialization(source, "1.000000 4.000000 9.000000 4.000000\n", 3);
+  testSpecialization(source, "1.000000 4.000000 9.000000 4.000000\n", 2, 2);
+}
+
+TEST(SpecializerTest, AssignedParameterIsNotSpecialized)
+{
+  std::string source = R"SRC(
+  fn next(x: f32, step: f32): f32
+  {
+    x += step;
+    ret x;
+  }
+
+  fn main(): f32
+  {
+    print("" : next(1, 2));
+    ret 0;
+  }
+  )SRC";
+
+  testSpecialization(source, "3.000000\n", 1);
+}
+
+TEST(SpecializerTest, ParameterVisibleToCalleeIsNotSpecialized)
+{
+  std::string source = R"SRC(
+  let base: f32 = 10;
+
+  fn offset(): f32 { ret base + 1; }
+  fn shifted(base: f32): f32 { ret offset() * 2; }
+
+  fn main(): f32
+  {
+    print("" : shifted(3));
+    ret 0;
+  }
+  )SRC";
+
+  testSpecialization(source, "8.000000\n", 0);
+}
+
+TEST(SpecializerTest, LambdaCallWithConstantIsSpecialized)
+{
+  std::string source = R"SRC(
+  fn main(): f32
+  {
+    let y: f32 = 4;
+    print("" : (\(x: f32, z: f32): f32 = { ret x * x + z; })(3, y));
+    ret 0;
+  }
+  )SRC";
+
+  testSpecialization(source, "13.000000\n", 1);
+}
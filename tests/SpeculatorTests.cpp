@@ -0,0 +1,160 @@
+#include <gtest/gtest.h>
+#include <sstream>
+
+#include "AST.hpp"
+#include "Parser.hpp"
+#include "Executor.hpp"
+#include "ClosureExecutor.hpp"
+#include "Speculator.hpp"
+
+namespace
+{
+
+ExecutorOptions speculateOptions()
+{
+  ExecutorOptions options{};
+  options.speculate = true;
+  return options;
+}
+
+// Runs the program lazily and speculating, returns statistics of the tree engine.
+std::shared_ptr<Speculator> testSpeculatedProgram(const std::string& source, const std::string& out, int status)
+{
+  std::stringstream stream{source};
+  Parser parser{stream};
+  auto program = parser.parseProgram();
+
+  Executor original{};
+  program->accept(original);
+
+  Executor executor{speculateOptions()};
+  program->accept(executor);
+
+  ClosureExecutor closureExecutor{speculateOptions()};
+  program->accept(closureExecutor);
+
+  EXPECT_EQ(original.getStandardOut(), out);
+  EXPECT_EQ(executor.getStandardOut(), out);
+  EXPECT_EQ(closureExecutor.getStandardOut(), out);
+  EXPECT_EQ(original.getExitCode(), status);
+  EXPECT_EQ(executor.getExitCode(), status);
+  EXPECT_EQ(closureExecutor.getExitCode(), status);
+  EXPECT_EQ(executor.getSpeculator()->getAttempts(), closureExecutor.getSpeculator()->getAttempts());
+  EXPECT_EQ(executor.getSpeculator()->getAborted(), closureExecutor.getSpeculator()->getAborted());
+
+  return executor.getSpeculator();
+}
+
+std::shared_ptr<ExpressionNode> parseExpression(const std::string& source)
+{
+  std::stringstream stream{source};
+  Parser parser{stream};
+  return parser.parseLogicalExpression();
+}
+
+}
+
+TEST(SpeculatorTest, EvaluatesLikeExecutor)
+{
+  std::string source = R"SRC(
+  let base: f32 = 2;
+
+  fn scale(x: f32, factor: f32): f32 { ret x * factor; }
+  fn show(label: f32, x: f32): void { print("" : label : x); }
+
+  fn main(): f32
+  {
+    let x: f32 = 3;
+    let y: f32 = x * 2 + 2 * (3 - 1);
+    let f: function = \(a: f32): f32 = { ret a + x; };
+    x = 10;
+    print("" : y : " " : scale(y - base, -base) : " " : f(1));
+    show("value " : y : " ", if(y > 5, y, 0));
+    ret y;
+  }
+  )SRC";
+
+  const auto speculator = testSpeculatedProgram(source,
+    "10.000000 -16.000000 4.000000\nvalue 10.000000 10.000000\n", 10);
+  // Only the lambda is left lazy.
+  EXPECT_EQ(speculator->getAborted(), 1);
+  EXPECT_GT(speculator->getAttempts(), 5);
+}
+
+TEST(SpeculatorTest, DivergentBindingsStayLazy)
+{
+  std::string source = R"SRC(
+  fn hang(): f32 { ret hang(); }
+  fn second(a: f32, b: f32): f32 { ret b; }
+  fn twice(s: f32): f32 { let doubled: f32 = s * 2; ret 0; }
+
+  fn main(): f32
+  {
+    let test: f32 = hang();
+    let result: f32 = if(2 == 2, 42, test);
+    print("Result: " : result : " " : second(test + 1, result) : " " : twice("text"));
+    ret 0;
+  }
+  )SRC";
+
+  const auto speculator = testSpeculatedProgram(source, "Result: 42.000000 42.000000 0.000000\n", 0);
+  // Call, failing operation and operand depending on call are aborted.
+  EXPECT_EQ(speculator->getAborted(), 3);
+}
+
+TEST(SpeculatorTest, SitesWhichKeepAbortingAreDisabled)
+{
+  std::string source = R"SRC(
+  fn one(): f32 { ret 1; }
+  fn count(n: f32, acc: f32): f32 { ret if(n == 0, acc, count(n - 1, acc + one())); }
+
+  fn main(): f32
+  {
+    ret count(20, 0);
+  }
+  )SRC";
+
+  const auto speculator = testSpeculatedProgram(source, "", 20);
+  EXPECT_EQ(speculator->getDisabled(), 1);
+  EXPECT_LT(speculator->getAborted(), 10);
+}
+
+TEST(SpeculatorTest, ReassignedBindingsKeepTheirContext)
+{
+  std::string source = R"SRC(
+  fn reset(): void { n = limit * 2; }
+  fn check(n: f32): f32 { reset(); ret n; }
+
+  fn main(): f32
+  {
+    let limit: f32 = 3;
+    let a: f32 = 1;
+    a = limit + 1;
+    print("" : a : " " : check(5));
+    ret a;
+  }
+  )SRC";
+
+  testSpeculatedProgram(source, "4.000000 6.000000\n", 4);
+}
+
+TEST(SpeculatorTest, AbortsWhenBudgetIsExceeded)
+{
+  Context context{};
+  context.addSymbol("x", std::make_unique<RuntimeVariableSymbol>("x", TypeName::F32, parseExpression("2 + 3"), Context{}));
+  const auto expression = parseExpression("x * (1 + 1)");
+
+  Speculator small{5};
+  EXPECT_EQ(small.speculate(expression, context), nullptr);
+  EXPECT_EQ(small.getAborted(), 1);
+
+  Speculator speculator{16};
+  const auto literal = speculator.speculate(expression, context);
+  ASSERT_NE(literal, nullptr);
+
+  Executor executor{};
+  literal->accept(executor);
+  ASSERT_EQ(executor.getValue()->getType(), TypeName::F32);
+  EXPECT_EQ(static_cast<const Number&>(*executor.getValue()).getValue(), 10);
+  EXPECT_EQ(speculator.speculate(parseExpression("missing + 1"), context), nullptr);
+}
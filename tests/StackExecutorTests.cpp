@@ -0,0 +1,199 @@
+#include <gtest/gtest.h>
+#include <sstream>
+#include <chrono>
+
+#include "AST.hpp"
+#include "Parser.hpp"
+#include "Executor.hpp"
+#include "StackExecutor.hpp"
+
+void testStackProgram(const std::string& source, const std::string& out, int status,
+  const ExecutorOptions& options = {})
+{
+  std::stringstream stream{source};
+  Parser parser{stream};
+  auto program = parser.parseProgram();
+
+  Executor original{options};
+  program->accept(original);
+
+  StackExecutor executor{options};
+  program->accept(executor);
+
+  EXPECT_EQ(original.getStandardOut(), out);
+  EXPECT_EQ(executor.getStandardOut(), out);
+  EXPECT_EQ(original.getExitCode(), status);
+  EXPECT_EQ(executor.getExitCode(), status);
+}
+
+TEST(StackExecutorTest, EvaluatesLikeExecutor)
+{
+  std::string source = R"SRC(
+  let base: f32 = 2;
+
+  fn fact(n: f32): f32 { ret if(n < 2, 1, n * fact(n - 1)); }
+  fn show(x: f32): void { print("value " : x); }
+  fn second(a: f32, b: f32): f32 { ret b; }
+  fn hang(): f32 { ret hang(); }
+
+  fn main(): f32
+  {
+    let a: f32 = 10;
+    let lazy: f32 = hang();
+    print("" : fact(5) : " " : second(1, a) : " " : -base);
+    show(3 + (\(x: f32, y: f32): f32 = { ret x * y; ret 0; })(2, 3));
+    a += 5;
+    a <<= 1;
+    print("" : a);
+    ret base + 1;
+  }
+  )SRC";
+
+  testStackProgram(source, "120.000000 10.000000 -2.000000\nvalue 9.000000\n30.000000\n", 3);
+}
+
+TEST(StackExecutorTest, ClosuresKeepTheirContext)
+{
+  std::string source = R"SRC(
+  fn makeAdder(n: f32): function
+  {
+    let add: function = \(x: f32): f32 = { print("adding"); ret x + n; };
+    ret add;
+  }
+
+  fn apply(f: function): f32 { ret f(5); }
+
+  fn main(): f32
+  {
+    let m: f32 = 1;
+    let g: function = \(y: f32): f32 = { ret y + m; };
+    m = 2;
+    let add: function = makeAdder(10);
+    print("" : g(1) : " " : add(1) : " " : makeAdder(3)(4) : " " : apply(g));
+    ret 0;
+  }
+  )SRC";
+
+  testStackProgram(source, "adding\nadding\n2.000000 11.000000 7.000000 6.000000\n", 0);
+}
+
+TEST(StackExecutorTest, CompoundAssignmentKeepsCapturedValues)
+{
+  std::string source = R"SRC(
+  fn main(): f32
+  {
+    let m: f32 = 1;
+    m += 1;
+    m += 1;
+    let seen: f32 = m;
+    let g: function = \(y: f32): f32 = { ret y + m; };
+    m += 10;
+    m *= 2;
+    print("" : seen : " " : g(0) : " " : m);
+    ret m;
+  }
+  )SRC";
+
+  testStackProgram(source, "3.000000 3.000000 26.000000\n", 26);
+}
+
+TEST(StackExecutorTest, MemoizedCallsMatchExecutor)
+{
+  std::string source = R"SRC(
+  fn fib(n: f32): f32 { ret if(n < 2, n, fib(n - 1) + fib(n - 2)); }
+
+  fn main(): f32
+  {
+    print("" : fib(30));
+    ret 0;
+  }
+  )SRC";
+
+  ExecutorOptions options{};
+  options.memoize = true;
+  testStackProgram(source, "832040.000000\n", 0, options);
+}
+
+TEST(StackExecutorTest, DeepRecursionDoesNotUseNativeStack)
+{
+  std::string source = R"SRC(
+  fn sum(n: f32): f32 { ret if(n == 0, 0, n + sum(n - 1)); }
+
+  fn main(): f32
+  {
+    print("" : sum(8000));
+    ret 0;
+  }
+  )SRC";
+
+  std::stringstream stream{source};
+  Parser parser{stream};
+  auto program = parser.parseProgram();
+
+  ExecutorOptions options{};
+  options.memoize = true;
+  StackExecutor executor{options};
+  program->accept(executor);
+
+  EXPECT_EQ(executor.getStandardOut(), "32004000.000000\n");
+  EXPECT_GT(executor.getMaxDepth(), 8000);
+}
+
+TEST(StackExecutorTest, FramesCostTheSameAtEveryDepth)
+{
+  std::string source = R"SRC(
+  fn cnt(n: f32): f32 { ret if(n == 0, 0, 1 + cnt(n - 1)); }
+
+  fn main(): f32
+  {
+    print("" : cnt(100000));
+    ret 0;
+  }
+  )SRC";
+
+  std::stringstream stream{source};
+  Parser parser{stream};
+  auto program = parser.parseProgram();
+
+  ExecutorOptions options{};
+  options.memoize = true;
+  StackExecutor executor{options};
+
+  // Calls which copied the context of the caller took minutes here.
+  const auto start = std::chrono::steady_clock::now();
+  program->accept(executor);
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+
+  EXPECT_EQ(executor.getStandardOut(), "100000.000000\n");
+  EXPECT_LT(std::chrono::duration_cast<std::chrono::seconds>(elapsed).count(), 5);
+}
+
+TEST(StackExecutorTest, StackLimitIsReportedWithTrace)
+{
+  std::string source = R"SRC(
+  fn down(n: f32): f32 { ret if(n == 0, 0, down(n - 1)); }
+  fn twice(n: f32): f32 { ret 2 * down(n); }
+
+  fn main(): f32
+  {
+    print("" : twice(100000));
+    ret 0;
+  }
+  )SRC";
+
+  std::stringstream stream{source};
+  Parser parser{stream};
+  auto program = parser.parseProgram();
+
+  ExecutorOptions options{};
+  options.memoize = true;
+  options.stackLimit = 1;
+  StackExecutor executor{options};
+  EXPECT_THROW(program->accept(executor), std::runtime_error);
+
+  const auto trace = executor.getStackTrace();
+  ASSERT_GT(trace.size(), 3);
+  EXPECT_EQ(trace.front(), "down (Ln: 1, Col: 48)");
+  EXPECT_EQ(trace[trace.size() - 2], "twice (Ln: 6, Col: 21)");
+  EXPECT_EQ(trace.back(), "main (Ln: 6, Col: 0)");
+}
@@ -0,0 +1,214 @@
+#include <gtest/gtest.h>
+#include <sstream>
+
+#include "AST.hpp"
+#include "Parser.hpp"
+#include "Executor.hpp"
+#include "StgExecutor.hpp"
+
+void testStgProgram(const std::string& source, const std::string& out, int status,
+  const ExecutorOptions& options = {})
+{
+  std::stringstream stream{source};
+  Parser parser{stream};
+  auto program = parser.parseProgram();
+
+  Executor original{options};
+  program->accept(original);
+
+  StgExecutor executor{options};
+  program->accept(executor);
+
+  EXPECT_EQ(original.getStandardOut(), out);
+  EXPECT_EQ(executor.getStandardOut(), out);
+  EXPECT_EQ(original.getExitCode(), status);
+  EXPECT_EQ(executor.getExitCode(), status);
+}
+
+TEST(StgExecutorTest, EvaluatesLikeExecutor)
+{
+  std::string source = R"SRC(
+  let base: f32 = 2;
+
+  fn fact(n: f32): f32 { ret if(n < 2, 1, n * fact(n - 1)); }
+  fn show(x: f32): void { print("value " : x); }
+  fn second(a: f32, b: f32): f32 { ret b; }
+  fn hang(): f32 { ret hang(); }
+
+  fn main(): f32
+  {
+    let a: f32 = 10;
+    let lazy: f32 = hang();
+    print("" : fact(5) : " " : second(1, a) : " " : -base : " " : !a);
+    show(3 + (\(x: f32, y: f32): f32 = { ret x * y; ret 0; })(2, 3));
+    a += 5;
+    a <<= 1;
+    print("" : a);
+    ret base + 1;
+  }
+  )SRC";
+
+  testStgProgram(source, "120.000000 10.000000 -2.000000 0.000000\nvalue 9.000000\n30.000000\n", 3);
+}
+
+TEST(StgExecutorTest, ClosuresKeepTheirEnvironment)
+{
+  std::string source = R"SRC(
+  fn makeAdder(n: f32): function
+  {
+    let add: function = \(x: f32): f32 = { print("adding"); ret x + n; };
+    ret add;
+  }
+
+  fn apply(f: function): f32 { ret f(5); }
+
+  fn main(): f32
+  {
+    let m: f32 = 1;
+    let g: function = \(y: f32): f32 = { ret y + m; };
+    m = 2;
+    let add: function = makeAdder(10);
+    print("" : g(1) : " " : add(1) : " " : makeAdder(3)(4) : " " : apply(g));
+    ret 0;
+  }
+  )SRC";
+
+  testStgProgram(source, "adding\nadding\n2.000000 11.000000 7.000000 6.000000\n", 0);
+}
+
+TEST(StgExecutorTest, AssignmentsAreSeenOnlyByLiveEnvironment)
+{
+  std::string source = R"SRC(
+  fn setM(): void { m = 5; }
+
+  fn main(): f32
+  {
+    let m: f32 = 1;
+    let before: f32 = m;
+    let f: function = \(): f32 = { ret m; };
+    setM();
+    m += 1;
+    print("" : before : " " : m : " " : f());
+    ret m;
+  }
+  )SRC";
+
+  testStgProgram(source, "1.000000 6.000000 1.000000\n", 6);
+}
+
+TEST(StgExecutorTest, ForcedThunksAreShared)
+{
+  std::string source = R"SRC(
+  fn twice(x: f32): f32 { ret x + x; }
+
+  fn main(): f32
+  {
+    let y: f32 = twice(twice(twice(twice(twice(twice(twice(twice(twice(twice(1))))))))));
+    print("" : y : " " : y);
+    ret 0;
+  }
+  )SRC";
+
+  std::stringstream stream{source};
+  Parser parser{stream};
+  auto program = parser.parseProgram();
+
+  StgExecutor executor{};
+  program->accept(executor);
+
+  EXPECT_EQ(executor.getStandardOut(), "1024.000000 1024.000000\n");
+  // Argument of every call and y are evaluated once, Executor evaluates the innermost argument 1024 times.
+  EXPECT_EQ(executor.getUpdated(), 11);
+  EXPECT_GT(executor.getShared(), 10);
+}
+
+TEST(StgExecutorTest, RecursesBeyondNativeStack)
+{
+  std::string source = R"SRC(
+  fn count(n: f32, acc: f32): f32 { ret if(n == 0, acc, count(n - 1, acc + 1)); }
+
+  fn main(): f32
+  {
+    print("" : count(100000, 0));
+    ret 0;
+  }
+  )SRC";
+
+  std::stringstream stream{source};
+  Parser parser{stream};
+  auto program = parser.parseProgram();
+
+  StgExecutor executor{};
+  program->accept(executor);
+
+  EXPECT_EQ(executor.getStandardOut(), "100000.000000\n");
+  EXPECT_GT(executor.getMaxDepth(), 100000);
+}
+
+TEST(StgExecutorTest, MemoizedCallsMatchExecutor)
+{
+  std::string source = R"SRC(
+  fn fib(n: f32): f32 { ret if(n < 2, n, fib(n - 1) + fib(n - 2)); }
+
+  fn main(): f32
+  {
+    print("" : fib(30));
+    ret 0;
+  }
+  )SRC";
+
+  ExecutorOptions options{};
+  options.memoize = true;
+  testStgProgram(source, "832040.000000\n", 0, options);
+}
+
+TEST(StgExecutorTest, ReportsErrorsLikeExecutor)
+{
+  std::string source = R"SRC(
+  fn main(): f32
+  {
+    let f: function = \(x: f32): f32 = { ret x; };
+    ret f(1, 2);
+  }
+  )SRC";
+
+  std::stringstream stream{source};
+  Parser parser{stream};
+  auto program = parser.parseProgram();
+
+  Executor original{};
+  StgExecutor executor{};
+  std::string expected{};
+  try
+  {
+    program->accept(original);
+  }
+  catch(std::runtime_error& error)
+  {
+    expected = error.what();
+  }
+
+  ASSERT_FALSE(expected.empty());
+  try
+  {
+    program->accept(executor);
+    FAIL();
+  }
+  catch(std::runtime_error& error)
+  {
+    EXPECT_EQ(error.what(), expected);
+  }
+}
+
+TEST(StgExecutorTest, EvaluatesExpressions)
+{
+  std::stringstream stream{"2 * (3 + 4) - 1"};
+  Parser parser{stream};
+  auto expression = parser.parseLogicalExpression();
+
+  StgExecutor executor{};
+  expression->accept(executor);
+
+  ASSERT_EQ(executor.getValue()->getType(), TypeName::F32);
+  EXPECT_EQ(static_cast<const Number&>(*executor.getValue()).getValue(), 13);
+}
@@ -0,0 +1,105 @@
+#include <gtest/gtest.h>
+#include <sstream>
+
+#include "AST.hpp"
+#include "Parser.hpp"
+#include "StrictModeChecker.hpp"
+
+std::vector<std::string> checkStrictMode(const std::string& source)
+{
+  std::stringstream stream{source};
+  Parser parser{stream};
+  auto program = parser.parseProgram();
+
+  StrictModeChecker checker{};
+  program->accept(checker);
+  return checker.getWarnings();
+}
+
+TEST(StrictModeCheckerTest, AcceptsProgramsWhichForceEverything)
+{
+  std::string source = R"SRC(
+  let base: f32 = square(2);
+
+  fn square(x: f32): f32 { ret x * x; }
+  fn fib(n: f32): f32 { ret if(n < 2, n, fib(n - 1) + fib(n - 2)); }
+
+  fn main(): f32
+  {
+    let a: f32 = fib(10);
+    let b: f32 = if(a > 5, 1, 2);
+    print("" : square(a) : " " : b : " " : (\(x: f32): f32 = { ret x + 1; })(square(3)));
+    ret base;
+  }
+  )SRC";
+
+  EXPECT_TRUE(checkStrictMode(source).empty());
+}
+
+TEST(StrictModeCheckerTest, WarnsAboutUnusedVariables)
+{
+  std::string source = R"SRC(
+  let unused: f32 = hang();
+
+  fn hang(): f32 { ret hang(); }
+
+  fn main(): f32
+  {
+    let test: f32 = hang();
+    let result: f32 = if(2 == 2, 42, test);
+    let cheap: f32 = 1 + 2;
+    print("Result: " : result);
+    ret 0;
+  }
+  )SRC";
+
+  const auto warnings = checkStrictMode(source);
+  ASSERT_EQ(warnings.size(), 2);
+  EXPECT_NE(warnings[0].find("Global variable unused"), std::string::npos);
+  EXPECT_NE(warnings[1].find("Variable test"), std::string::npos);
+}
+
+TEST(StrictModeCheckerTest, WarnsAboutLazyArguments)
+{
+  std::string source = R"SRC(
+  fn hang(): f32 { ret hang(); }
+  fn first(a: f32, b: f32): f32 { ret a; }
+  fn choose(c: f32, a: f32, b: f32): f32 { ret if(c, a, b); }
+
+  fn main(): f32
+  {
+    let f: function = \(x: f32): f32 = { ret 1; };
+    print("" : first(hang(), hang()) : " " : choose(1, 2, hang()) : " " : choose(hang(), 1, 2) : " " : f(hang()));
+    ret first(1, 2);
+  }
+  )SRC";
+
+  const auto warnings = checkStrictMode(source);
+  ASSERT_EQ(warnings.size(), 3);
+  EXPECT_NE(warnings[0].find("Argument 2 of first"), std::string::npos);
+  EXPECT_NE(warnings[1].find("Argument 3 of choose"), std::string::npos);
+  EXPECT_NE(warnings[2].find("Argument 1 of f"), std::string::npos);
+}
+
+TEST(StrictModeCheckerTest, WarnsAboutArgumentsReadingReassignedVariable)
+{
+  std::string source = R"SRC(
+  fn ignore(y: f32): f32 { ret 1; }
+  fn keep(y: f32): f32 { ret y; }
+
+  fn main(): f32
+  {
+    let x: f32 = 2;
+    x = ignore(x);
+    x = keep(x);
+    x += ignore(x);
+    print("" : x);
+    ret 0;
+  }
+  )SRC";
+
+  const auto warnings = checkStrictMode(source);
+  ASSERT_EQ(warnings.size(), 1);
+  EXPECT_NE(warnings[0].find("Argument 1 of ignore"), std::string::npos);
+  EXPECT_NE(warnings[0].find("reads x"), std::string::npos);
+}
@@ -1,5 +1,8 @@
 #include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
 #include <sstream>
+#include <vector>
 
 #include "Tokenizer.hpp"
 
@@ -341,3 +344,48 @@ TEST(TokenizerTest, LogicalOperators)
   EXPECT_EQ(tokenizer.peek(), Token());
   EXPECT_TRUE(tokenizer.end());
 }
+
+// Tokens with their marks, up to and including the end of text.
+std::vector<std::pair<Token, std::string>> tokenize(Tokenizer& tokenizer)
+{
+  std::vector<std::pair<Token, std::string>> tokens{};
+  while(!tokenizer.end())
+  {
+    tokens.emplace_back(tokenizer.peek(), tokenizer.peek().mark.to_string());
+    tokenizer.nextToken();
+  }
+  tokens.emplace_back(tokenizer.peek(), tokenizer.peek().mark.to_string());
+  return tokens;
+}
+
+TEST(TokenizerTest, SourcesGiveSameTokens)
+{
+  const std::string source = "fn main(): f32 // comment\n{\n  let s: f32 = 0.25 / 12;\n"
+    "  print(\"a\\tb\" : s);\n  s <<= 1; ret s >= 0 && !x_1;\n}";
+  const auto path = testing::TempDir() + "lil_tokenizer_source.lil";
+  std::ofstream{path} << source;
+
+  std::stringstream stream{source};
+  Tokenizer fromStream{stream};
+  const auto tokens = tokenize(fromStream);
+  EXPECT_EQ(tokens.size(), 37u);
+
+  Tokenizer fromText{source};
+  EXPECT_EQ(tokenize(fromText), tokens);
+
+  {
+    SourceFile file{path};
+    EXPECT_TRUE(file.isOpen());
+    Tokenizer fromFile{file.getText()};
+    EXPECT_EQ(tokenize(fromFile), tokens);
+  }
+  std::remove(path.c_str());
+
+  std::ofstream{path};
+  SourceFile empty{path};
+  EXPECT_TRUE(empty.isOpen());
+  EXPECT_TRUE(empty.getText().empty());
+  std::remove(path.c_str());
+
+  EXPECT_FALSE(SourceFile{path}.isOpen());
+}